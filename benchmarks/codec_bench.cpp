@@ -0,0 +1,184 @@
+// benchmarks/codec_bench.cpp
+// 文本协议的解析开销（ns/请求、内存分配次数/请求）：
+// 指向缓冲区的 RequestView、拷贝出 Request 的 parseRequest，
+// 以及原来的 std::string 整行 + istringstream 分词 + toUpper 的实现
+
+#include "protocol/codec.h"
+#include "base/timestamp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+std::atomic<size_t> g_allocations(0);
+
+}  // namespace
+
+// 统计内存分配次数
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+/// 原来的解析方式：整行拷贝成 std::string，istringstream 分词，命令名 toUpper 后比较
+bool legacyParse(Buffer* buf, Request* request) {
+    const char* lf = static_cast<const char*>(memchr(buf->peek(), '\n', buf->readableBytes()));
+    if (lf == nullptr) {
+        return false;
+    }
+    std::string line(buf->peek(), lf - buf->peek());
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    buf->retrieve(lf + 1 - buf->peek());
+
+    std::vector<std::string> parts;
+    std::istringstream iss(line);
+    std::string token;
+    while (iss >> token) {
+        parts.push_back(token);
+    }
+    if (parts.empty()) {
+        request->command = CommandType::kUnknown;
+        return true;
+    }
+    std::string cmd = parts[0];
+    std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::toupper);
+    if ((cmd == "PUT" || cmd == "SET") && parts.size() >= 3) {
+        request->command = CommandType::kPut;
+        request->key = parts[1];
+        size_t valueStart = line.find(parts[1]) + parts[1].size();
+        while (valueStart < line.size() && std::isspace(line[valueStart])) {
+            valueStart++;
+        }
+        request->value = line.substr(valueStart);
+    } else if (cmd == "GET" && parts.size() >= 2) {
+        request->command = CommandType::kGet;
+        request->key = parts[1];
+    } else if (cmd == "MGET" && parts.size() >= 2) {
+        request->command = CommandType::kMGet;
+        request->keys.assign(parts.begin() + 1, parts.end());
+    } else {
+        request->command = CommandType::kUnknown;
+    }
+    return true;
+}
+
+/// count 个请求：key 为 key:000123 形式，value 为 valueSize 字节
+std::string makeRequests(const char* command, size_t count, size_t valueSize) {
+    std::string value(valueSize, 'v');
+    std::string data;
+    char key[32];
+    for (size_t i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "key:%06zu", i);
+        data += command;
+        data += ' ';
+        data += key;
+        if (valueSize > 0) {
+            data += ' ';
+            data += value;
+        } else if (command[0] == 'M') {
+            data += " key:a key:b";
+        }
+        data += "\r\n";
+    }
+    return data;
+}
+
+template <typename ParseFn>
+void benchParser(const char* name, const std::string& data, size_t count, int rounds,
+                 ParseFn parse) {
+    double bestNs = 0;
+    size_t allocations = 0;
+    for (int r = 0; r < rounds; r++) {
+        Buffer buf;
+        buf.append(data);
+        size_t parsed = 0;
+        size_t before = g_allocations.load(std::memory_order_relaxed);
+        Timestamp start = Timestamp::now();
+        while (parse(&buf)) {
+            parsed++;
+        }
+        double ns = timeDifference(Timestamp::now(), start) * 1e9 / static_cast<double>(count);
+        allocations = g_allocations.load(std::memory_order_relaxed) - before;
+        if (parsed != count) {
+            std::cerr << name << ": parsed " << parsed << " of " << count << std::endl;
+        }
+        if (r == 0 || ns < bestNs) {
+            bestNs = ns;
+        }
+    }
+    std::cout << "  " << std::left << std::setw(14) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << bestNs << " ns/req  " << std::setw(5)
+              << static_cast<double>(allocations) / static_cast<double>(count) << " allocs/req"
+              << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = 200000;
+    if (argc > 1) {
+        count = static_cast<size_t>(atol(argv[1]));
+    }
+    const int rounds = 5;
+
+    struct Workload {
+        const char* title;
+        const char* command;
+        size_t valueSize;
+    };
+    const Workload workloads[] = {
+        {"PUT key value(16B)", "PUT", 16},
+        {"PUT key value(100B)", "PUT", 100},
+        {"GET key", "GET", 0},
+        {"MGET key key key", "MGET", 0},
+    };
+
+    for (const Workload& w : workloads) {
+        std::string data = makeRequests(w.command, count, w.valueSize);
+        std::cout << w.title << ", " << count << " requests" << std::endl;
+
+        RequestView view;
+        benchParser("view", data, count, rounds, [&view](Buffer* buf) {
+            if (!Codec::peekRequest(*buf, &view)) {
+                return false;
+            }
+            buf->retrieve(view.length);
+            return true;
+        });
+        benchParser("parseRequest", data, count, rounds, [](Buffer* buf) {
+            Request request;
+            return Codec::parseRequest(buf, &request);
+        });
+        benchParser("legacy", data, count, rounds, [](Buffer* buf) {
+            Request request;
+            return legacyParse(buf, &request);
+        });
+    }
+    return 0;
+}
@@ -3,6 +3,8 @@
 
 #include "base/timestamp.h"
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
@@ -91,6 +93,36 @@ public:
         return true;
     }
 
+    /// 一次发出整批请求（流水线）
+    bool sendAll(const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = ::send(sockfd_, data.data() + sent, data.size() - sent, 0);
+            if (n <= 0) {
+                return false;
+            }
+            sent += n;
+        }
+        return true;
+    }
+
+    /// 读到 count 行应答为止（每个文本协议应答一行）
+    bool readLines(int count) {
+        char buf[65536];
+        while (count > 0) {
+            ssize_t n = ::recv(sockfd_, buf, sizeof(buf), 0);
+            if (n <= 0) {
+                return false;
+            }
+            for (ssize_t i = 0; i < n; i++) {
+                if (buf[i] == '\n') {
+                    count--;
+                }
+            }
+        }
+        return true;
+    }
+
 private:
     std::string host_;
     uint16_t port_;
@@ -161,11 +193,80 @@ void runBenchmark(const std::string& host, uint16_t port,
               << std::endl;
 }
 
+// 读取 /proc/<pid>/io 中服务端累计的读 / 写类系统调用次数（read/readv、write/writev，
+// 包括 shard-per-core 模式下跨线程转发时 eventfd 的唤醒）
+bool readSyscalls(int pid, long long* reads, long long* writes) {
+    std::ifstream in("/proc/" + std::to_string(pid) + "/io");
+    std::string name;
+    long long count = 0;
+    int found = 0;
+    while (in >> name >> count) {
+        if (name == "syscr:") {
+            *reads = count;
+            found++;
+        } else if (name == "syscw:") {
+            *writes = count;
+            found++;
+        }
+    }
+    return found == 2;
+}
+
+// 单连接流水线测试：每轮一次发出 depth 条 PUT，收齐 depth 条应答后再发下一轮
+// 指定服务端 pid 时统计每个请求平均的服务端读 / 写系统调用次数
+void runPipelineBenchmark(const std::string& host, uint16_t port,
+                          int requests, int depth, int serverPid) {
+    SyncClient client(host, port);
+    if (!client.connect()) {
+        std::cerr << "Pipeline client connect failed!" << std::endl;
+        return;
+    }
+
+    const int rounds = std::max(1, requests / depth);
+    std::vector<std::string> batches(rounds);
+    for (int r = 0; r < rounds; r++) {
+        for (int i = 0; i < depth; i++) {
+            batches[r] += "PUT pipe_" + std::to_string(r * depth + i) + " value_" +
+                          std::to_string(i) + "\n";
+        }
+    }
+
+    long long reads0 = 0, writes0 = 0, reads1 = 0, writes1 = 0;
+    bool syscalls = serverPid > 0 && readSyscalls(serverPid, &reads0, &writes0);
+
+    Timestamp start = Timestamp::now();
+    int total = 0;
+    for (int r = 0; r < rounds; r++) {
+        if (!client.sendAll(batches[r]) || !client.readLines(depth)) {
+            std::cerr << "Pipeline depth " << depth << " failed at round " << r << std::endl;
+            break;
+        }
+        total += depth;
+    }
+    Timestamp end = Timestamp::now();
+
+    syscalls = syscalls && readSyscalls(serverPid, &reads1, &writes1);
+    double seconds = timeDifference(end, start);
+    double qps = (seconds > 0) ? (total / seconds) : 0;
+
+    std::cout << "PIPELINE depth " << std::setw(3) << depth << ", "
+              << std::setw(10) << total << " ops, "
+              << std::fixed << std::setprecision(3) << std::setw(8) << seconds << " sec, "
+              << std::setprecision(0) << std::setw(10) << qps << " QPS";
+    if (syscalls && total > 0) {
+        std::cout << std::setprecision(3)
+                  << ", read/req " << std::setw(6) << double(reads1 - reads0) / total
+                  << ", write/req " << std::setw(6) << double(writes1 - writes0) / total;
+    }
+    std::cout << std::endl;
+}
+
 int main(int argc, char* argv[]) {
     std::string host = "127.0.0.1";
     uint16_t port = 6379;
     int numClients = 10;
     int requestsPerClient = 1000;
+    int serverPid = 0;
 
     // 解析参数
     for (int i = 1; i < argc; i++) {
@@ -177,13 +278,17 @@ int main(int argc, char* argv[]) {
             numClients = atoi(argv[++i]);
         } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
             requestsPerClient = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            serverPid = atoi(argv[++i]);
         } else if (strcmp(argv[i], "--help") == 0) {
             std::cout << "Usage: " << argv[0] << " [options]\n"
                       << "Options:\n"
                       << "  -h HOST     Server host (default: 127.0.0.1)\n"
                       << "  -p PORT     Server port (default: 6379)\n"
                       << "  -c NUM      Number of clients (default: 10)\n"
-                      << "  -n NUM      Requests per client (default: 1000)\n";
+                      << "  -n NUM      Requests per client (default: 1000)\n"
+                      << "  -s PID      Server pid, report server syscalls per request\n"
+                      << "              in the pipeline test (reads /proc/PID/io)\n";
             return 0;
         }
     }
@@ -205,6 +310,12 @@ int main(int argc, char* argv[]) {
     // 混合测试
     runBenchmark(host, port, numClients, requestsPerClient / 2, "MIXED");
 
+    // 流水线测试（单连接，深度 1 ~ 256）
+    std::cout << "----------------------------------------\n";
+    for (int depth = 1; depth <= 256; depth *= 2) {
+        runPipelineBenchmark(host, port, numClients * requestsPerClient, depth, serverPid);
+    }
+
     std::cout << "========================================\n";
 
     return 0;
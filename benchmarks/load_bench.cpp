@@ -0,0 +1,107 @@
+// benchmarks/load_bench.cpp
+// 启动加载快照的耗时随加载线程数的变化
+
+#include "storage/kvstore.h"
+#include "base/logger.h"
+#include "base/timestamp.h"
+
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+const char* kDataFile = "/tmp/load_bench.db";
+
+/// 写一份 count 条记录的快照，值长度 8~120 字节不等
+bool makeSnapshot(int count) {
+    KVStoreOptions options;
+    options.shards = 8;
+    KVStore store(options);
+    char key[32];
+    for (int i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "user:%010d", i);
+        store.put(key, std::string(8 + (i * 7) % 113, static_cast<char>('a' + i % 26)));
+    }
+    return store.save(kDataFile);
+}
+
+/// 用给定的分片数和线程数加载一次，返回耗时（秒）
+double loadOnce(int shards, int threads, bool mmapValues, int expected) {
+    KVStoreOptions options;
+    options.shards = shards;
+    options.loadThreads = threads;
+    options.mmapValues = mmapValues;
+    KVStore store(options);
+
+    Timestamp start = Timestamp::now();
+    bool ok = store.load(kDataFile);
+    double seconds = timeDifference(Timestamp::now(), start);
+    if (!ok || store.size() != expected) {
+        std::cerr << "load failed: size=" << store.size() << " expected=" << expected << "\n";
+    }
+    return seconds;
+}
+
+void benchThreads(const std::string& name, int shards, bool mmapValues,
+                  const std::vector<int>& threadCounts, int count) {
+    std::cout << name << "\n";
+    double base = 0;
+    for (int threads : threadCounts) {
+        int listShards = shards > 0 ? shards : threads;
+        double seconds = loadOnce(listShards, threads, mmapValues, count);
+        if (threads == 1) {
+            base = seconds;
+        }
+        std::cout << "  threads=" << std::setw(2) << threads << " shards=" << std::setw(2)
+                  << listShards << "  " << std::fixed << std::setprecision(3) << seconds
+                  << " sec  " << std::setprecision(0) << std::setw(10) << count / seconds
+                  << " keys/s";
+        if (base > 0) {
+            std::cout << "  x" << std::setprecision(2) << base / seconds;
+        }
+        std::cout << std::endl;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int count = 2000000;
+    if (argc > 1) {
+        count = atoi(argv[1]);
+    }
+    Logger::setLogLevel(LogLevel::WARN);
+
+    std::vector<int> threadCounts = {1, 2, 4, 8};
+    int cores = static_cast<int>(std::thread::hardware_concurrency());
+    if (cores > 8) {
+        threadCounts.push_back(cores);
+    }
+
+    std::cout << "========================================\n";
+    std::cout << "    Snapshot Load Benchmark\n";
+    std::cout << "========================================\n";
+    std::cout << "Keys: " << count << ", CPU cores: " << cores << "\n";
+    if (!makeSnapshot(count)) {
+        std::cerr << "failed to write " << kDataFile << "\n";
+        return 1;
+    }
+    std::cout << "----------------------------------------\n";
+
+    // 分片数跟随线程数：构建也能完全并行
+    benchThreads("Shards = threads", 0, false, threadCounts, count);
+    // 单个分片：只有解码并行，构建仍在一个线程中
+    benchThreads("Single shard", 1, false, threadCounts, count);
+    // 长值引用文件映射，构建时不分配值的内存
+    benchThreads("Shards = threads, mapped values", 0, true, threadCounts, count);
+
+    std::cout << "----------------------------------------\n";
+    std::remove(kDataFile);
+    return 0;
+}
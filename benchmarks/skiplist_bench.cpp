@@ -2,14 +2,19 @@
 // SkipList 存储引擎性能测试
 
 #include "storage/skiplist.h"
+#include "storage/lockfree_skiplist.h"
 #include "base/timestamp.h"
 
+#include <malloc.h>
+
 #include <iostream>
 #include <string>
 #include <random>
 #include <vector>
 #include <iomanip>
 #include <thread>
+#include <algorithm>
+#include <chrono>
 
 using namespace kvstore;
 
@@ -141,6 +146,162 @@ void benchConcurrentInsert(int numThreads, int countPerThread) {
                 total, timeDifference(end, start));
 }
 
+/**
+ * @brief 每个 key 的节点内存与 GET 延迟
+ *
+ * 节点内存取自 SkipList::memoryUsage()（Arena 已申请字节数，含哈希索引），
+ * 延迟逐次用 steady_clock 计时，输出平均值与 P50/P99。
+ */
+void benchMemoryAndGetLatency(int count, bool hashIndex) {
+    SkipList<std::string, std::string> sl(16, hashIndex);
+    const std::string suffix = hashIndex ? " (hash index)" : "";
+    for (int i = 0; i < count; i++) {
+        sl.insert("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<> dis(0, count - 1);
+    for (int i = 0; i < count; i++) {
+        keys.push_back("key" + std::to_string(dis(gen)));
+    }
+
+    std::vector<int64_t> latencies;
+    latencies.reserve(count);
+    std::string value;
+    for (const auto& key : keys) {
+        auto begin = std::chrono::steady_clock::now();
+        sl.search(key, value);
+        auto end = std::chrono::steady_clock::now();
+        latencies.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    int64_t sum = 0;
+    for (int64_t ns : latencies) {
+        sum += ns;
+    }
+
+    std::cout << std::left << std::setw(30) << "Node Memory" + suffix
+              << std::right << std::setw(10) << sl.memoryUsage() << " bytes, "
+              << std::fixed << std::setprecision(1) << std::setw(8)
+              << static_cast<double>(sl.memoryUsage()) / count << " bytes/key"
+              << std::endl;
+    std::cout << std::left << std::setw(30) << "GET Latency" + suffix
+              << std::right << "avg " << std::setprecision(0) << std::setw(6)
+              << static_cast<double>(sum) / latencies.size() << " ns, "
+              << "p50 " << std::setw(6) << latencies[latencies.size() / 2] << " ns, "
+              << "p99 " << std::setw(6) << latencies[latencies.size() * 99 / 100] << " ns"
+              << std::endl;
+}
+
+/**
+ * @brief 共享长前缀的 key：常驻内存与 GET 延迟（是否开启前缀压缩）
+ *
+ * key 形如 "tenant:1234:user:00012345"，完整 key 超出 std::string 的 SSO 缓冲，
+ * 压缩后的后缀通常放得下。常驻内存取 mallinfo2 的已分配字节增量，
+ * 包含 Arena 块和 key/value 在堆上的额外分配。
+ */
+void benchPrefixCompression(int count, bool prefixCompression) {
+    const std::string suffix = prefixCompression ? " (prefix)" : "";
+    auto makeKey = [](int i) {
+        char key[48];
+        snprintf(key, sizeof(key), "tenant:%04d:user:%08d", i % 64, i);
+        return std::string(key);
+    };
+
+    size_t before = mallinfo2().uordblks;
+    SkipList<std::string, std::string> sl(16, false, prefixCompression);
+    for (int i = 0; i < count; i++) {
+        sl.insert(makeKey(i), "v");
+    }
+    size_t resident = mallinfo2().uordblks - before;
+
+    std::vector<std::string> keys;
+    keys.reserve(count);
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<> dis(0, count - 1);
+    for (int i = 0; i < count; i++) {
+        keys.push_back(makeKey(dis(gen)));
+    }
+
+    std::string value;
+    Timestamp start = Timestamp::now();
+    for (const auto& key : keys) {
+        sl.search(key, value);
+    }
+    Timestamp end = Timestamp::now();
+
+    std::cout << std::left << std::setw(30) << "Resident Memory" + suffix
+              << std::right << std::setw(10) << resident << " bytes, "
+              << std::fixed << std::setprecision(1) << std::setw(8)
+              << static_cast<double>(resident) / count << " bytes/key"
+              << std::endl;
+    printResult("Random Search" + suffix, count, timeDifference(end, start));
+}
+
+/**
+ * @brief 多线程扩展性测试
+ *
+ * 预先写入 keyCount 个 key，然后用 1/2/4/8 个线程执行混合读写，
+ * 输出每个线程数下的总 QPS 以及相对单线程的加速比。
+ */
+template <typename SkipListT>
+void benchScaling(const std::string& name, int keyCount, int opsPerThread, int readRatio) {
+    SkipListT sl;
+    for (int i = 0; i < keyCount; i++) {
+        sl.insert("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+
+    std::cout << name << " (" << readRatio << "% read, " << opsPerThread
+              << " ops/thread)\n";
+
+    double baseQps = 0;
+    const int threadCounts[] = {1, 2, 4, 8};
+    for (int numThreads : threadCounts) {
+        std::vector<std::thread> threads;
+
+        Timestamp start = Timestamp::now();
+        for (int t = 0; t < numThreads; t++) {
+            threads.emplace_back([&sl, t, keyCount, opsPerThread, readRatio]() {
+                std::mt19937 gen(t * 7919 + 1);
+                std::uniform_int_distribution<> opDis(1, 100);
+                std::uniform_int_distribution<> keyDis(0, keyCount - 1);
+                std::string value;
+                for (int i = 0; i < opsPerThread; i++) {
+                    std::string key = "key" + std::to_string(keyDis(gen));
+                    if (opDis(gen) <= readRatio) {
+                        sl.search(key, value);
+                    } else {
+                        sl.insert(key, "value");
+                    }
+                }
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        Timestamp end = Timestamp::now();
+
+        int total = numThreads * opsPerThread;
+        double seconds = timeDifference(end, start);
+        double qps = total / seconds;
+        if (numThreads == 1) {
+            baseQps = qps;
+        }
+
+        std::cout << "  " << std::left << std::setw(12)
+                  << (std::to_string(numThreads) + " threads")
+                  << std::right << std::setw(10) << total << " ops, "
+                  << std::fixed << std::setprecision(3) << std::setw(8) << seconds << " sec, "
+                  << std::setprecision(0) << std::setw(12) << qps << " QPS, "
+                  << std::setprecision(2) << std::setw(6) << (qps / baseQps) << "x"
+                  << std::endl;
+    }
+}
+
 int main(int argc, char* argv[]) {
     int count = 100000;
     if (argc > 1) {
@@ -176,6 +337,11 @@ int main(int argc, char* argv[]) {
         benchMixedReadWrite(sl, count, 50);  // 50% 读
     }
 
+    benchMemoryAndGetLatency(count, false);
+    benchMemoryAndGetLatency(count, true);
+    benchPrefixCompression(count, false);
+    benchPrefixCompression(count, true);
+
     std::cout << "----------------------------------------\n";
 
     // 多线程测试
@@ -183,6 +349,16 @@ int main(int argc, char* argv[]) {
     benchConcurrentInsert(4, count / 4);
     benchConcurrentInsert(8, count / 8);
 
+    std::cout << "----------------------------------------\n";
+
+    // 多线程扩展性：互斥锁跳表 vs 无锁跳表
+    benchScaling<SkipList<std::string, std::string>>("Mutex SkipList", count, count, 95);
+    benchScaling<LockFreeSkipList<std::string, std::string>>("LockFree SkipList", count, count,
+                                                             95);
+    benchScaling<SkipList<std::string, std::string>>("Mutex SkipList", count, count, 50);
+    benchScaling<LockFreeSkipList<std::string, std::string>>("LockFree SkipList", count, count,
+                                                             50);
+
     std::cout << "========================================\n";
 
     return 0;
@@ -0,0 +1,171 @@
+// benchmarks/timer_bench.cpp
+// 大量定时器的添加、取消、触发开销：分层时间轮 vs 有序集合（std::set，O(log n)），
+// 以及经 EventLoop（timerfd）跨线程添加的端到端吞吐和触发延迟
+
+#include "net/eventloop.h"
+#include "net/eventloop_thread.h"
+#include "net/timer_wheel.h"
+#include "base/logger.h"
+#include "base/timestamp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+const int64_t kStart = 1700000000000000;  // 模拟时钟的起点（微秒）
+
+double nsPerOp(Timestamp start, size_t ops) {
+    return timeDifference(Timestamp::now(), start) * 1e9 / static_cast<double>(ops);
+}
+
+void printRow(const char* name, const char* op, double ns) {
+    std::cout << "  " << std::left << std::setw(8) << name << std::setw(10) << op << std::right
+              << std::fixed << std::setprecision(1) << std::setw(8) << ns << " ns/op" << std::endl;
+}
+
+/// count 个定时器，到期时刻在 [0, spanMs) 毫秒内均匀分布
+std::vector<int64_t> makeDelays(size_t count, int64_t spanMs) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int64_t> dist(0, spanMs * 1000 - 1);
+    std::vector<int64_t> delays(count);
+    for (int64_t& d : delays) {
+        d = dist(rng);
+    }
+    return delays;
+}
+
+/// 时间轮：添加全部、取消一半、推进到最后一个到期
+void benchWheel(const std::vector<int64_t>& delays, int64_t spanMs) {
+    TimerWheel wheel(kStart);
+    size_t fired = 0;
+    std::vector<TimerId> ids;
+    ids.reserve(delays.size());
+
+    Timestamp start = Timestamp::now();
+    for (int64_t d : delays) {
+        ids.push_back(wheel.add(kStart + d, [&fired]() { fired++; }));
+    }
+    printRow("wheel", "add", nsPerOp(start, delays.size()));
+
+    start = Timestamp::now();
+    for (size_t i = 0; i < ids.size(); i += 2) {
+        wheel.cancel(ids[i]);
+    }
+    printRow("wheel", "cancel", nsPerOp(start, ids.size() / 2));
+
+    start = Timestamp::now();
+    for (int64_t ms = 1; ms <= spanMs + 1; ms++) {
+        wheel.advance(kStart + ms * 1000);
+    }
+    printRow("wheel", "fire", nsPerOp(start, std::max<size_t>(fired, 1)));
+    if (fired != delays.size() - (delays.size() + 1) / 2) {
+        std::cerr << "wheel: fired " << fired << std::endl;
+    }
+}
+
+/// 有序集合：与 muduo 等实现的 TimerQueue 相同的数据结构
+void benchSet(const std::vector<int64_t>& delays, int64_t spanMs) {
+    struct Timer {
+        TimerCallback callback;
+    };
+    using Entry = std::pair<int64_t, Timer*>;
+    std::set<Entry> timers;
+    size_t fired = 0;
+    std::vector<Entry> ids;
+    ids.reserve(delays.size());
+
+    Timestamp start = Timestamp::now();
+    for (int64_t d : delays) {
+        Entry entry(kStart + d, new Timer{[&fired]() { fired++; }});
+        timers.insert(entry);
+        ids.push_back(entry);
+    }
+    printRow("set", "add", nsPerOp(start, delays.size()));
+
+    start = Timestamp::now();
+    for (size_t i = 0; i < ids.size(); i += 2) {
+        timers.erase(ids[i]);
+        delete ids[i].second;
+    }
+    printRow("set", "cancel", nsPerOp(start, ids.size() / 2));
+
+    start = Timestamp::now();
+    for (int64_t ms = 1; ms <= spanMs + 1; ms++) {
+        const int64_t now = kStart + ms * 1000;
+        while (!timers.empty() && timers.begin()->first <= now) {
+            Timer* timer = timers.begin()->second;
+            timers.erase(timers.begin());
+            timer->callback();
+            delete timer;
+        }
+    }
+    printRow("set", "fire", nsPerOp(start, std::max<size_t>(fired, 1)));
+}
+
+/// EventLoop：另一个线程用 runAt 添加 count 个定时器，等全部触发。
+/// 延迟（lateness）= 回调执行时刻 - 到期时刻，添加期间任务队列的积压也计入其中
+void benchEventLoop(size_t count, int64_t spanMs) {
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    std::vector<int64_t> delays = makeDelays(count, spanMs);
+    std::atomic<size_t> fired(0);
+    std::atomic<int64_t> maxLateUs(0);
+    std::atomic<int64_t> totalLateUs(0);
+
+    Timestamp start = Timestamp::now();
+    for (int64_t d : delays) {
+        const int64_t due = Timestamp::now().microSecondsSinceEpoch() + d;
+        loop->runAt(Timestamp(due), [&fired, &maxLateUs, &totalLateUs, due]() {
+            int64_t late = Timestamp::now().microSecondsSinceEpoch() - due;
+            totalLateUs.fetch_add(late, std::memory_order_relaxed);
+            if (late > maxLateUs.load(std::memory_order_relaxed)) {
+                maxLateUs.store(late, std::memory_order_relaxed);
+            }
+            fired.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+    double addNs = nsPerOp(start, count);
+    while (fired.load() < count) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    double seconds = timeDifference(Timestamp::now(), start);
+    std::cout << "  eventloop runAt (cross-thread) " << std::fixed << std::setprecision(1)
+              << addNs << " ns/op, " << count << " timers fired in " << std::setprecision(3)
+              << seconds << " s\n  lateness avg " << std::setprecision(3)
+              << totalLateUs.load() / 1000.0 / static_cast<double>(count) << " ms, max "
+              << maxLateUs.load() / 1000.0 << " ms" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    size_t count = 2000000;
+    if (argc > 1) {
+        count = static_cast<size_t>(atol(argv[1]));
+    }
+    Logger::setLogLevel(LogLevel::WARN);
+
+    for (int64_t spanMs : {1000, 600000}) {
+        std::cout << count << " timers over " << spanMs / 1000 << " s (simulated clock)"
+                  << std::endl;
+        std::vector<int64_t> delays = makeDelays(count, spanMs);
+        benchWheel(delays, spanMs);
+        benchSet(delays, spanMs);
+    }
+
+    std::cout << count << " timers over 10 s (real clock)" << std::endl;
+    benchEventLoop(count, 10000);
+    return 0;
+}
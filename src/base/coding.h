@@ -0,0 +1,91 @@
+// src/base/coding.h
+#ifndef KVSTORE_BASE_CODING_H
+#define KVSTORE_BASE_CODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace kvstore {
+
+/**
+ * @brief 持久化文件使用的整数编码
+ *
+ * 定长整数一律小端；变长整数（varint）每字节 7 位有效数据，最高位表示后面还有字节。
+ * WAL、快照等格式共用这些函数，保证同一种字段在不同文件里的编码一致。
+ */
+
+// ==================== 定长 ====================
+
+inline void encodeFixed32(char* dst, uint32_t v) {
+    dst[0] = static_cast<char>(v & 0xFF);
+    dst[1] = static_cast<char>((v >> 8) & 0xFF);
+    dst[2] = static_cast<char>((v >> 16) & 0xFF);
+    dst[3] = static_cast<char>((v >> 24) & 0xFF);
+}
+
+inline void encodeFixed64(char* dst, uint64_t v) {
+    encodeFixed32(dst, static_cast<uint32_t>(v));
+    encodeFixed32(dst + 4, static_cast<uint32_t>(v >> 32));
+}
+
+inline void putFixed32(std::string* dst, uint32_t v) {
+    char buf[4];
+    encodeFixed32(buf, v);
+    dst->append(buf, 4);
+}
+
+inline void putFixed64(std::string* dst, uint64_t v) {
+    char buf[8];
+    encodeFixed64(buf, v);
+    dst->append(buf, 8);
+}
+
+inline uint32_t decodeFixed32(const char* p) {
+    const uint8_t* u = reinterpret_cast<const uint8_t*>(p);
+    return static_cast<uint32_t>(u[0]) | (static_cast<uint32_t>(u[1]) << 8) |
+           (static_cast<uint32_t>(u[2]) << 16) | (static_cast<uint32_t>(u[3]) << 24);
+}
+
+inline uint64_t decodeFixed64(const char* p) {
+    return static_cast<uint64_t>(decodeFixed32(p)) |
+           (static_cast<uint64_t>(decodeFixed32(p + 4)) << 32);
+}
+
+// ==================== 变长 ====================
+
+/// uint32_t 的 varint 编码最多 5 字节
+const size_t kMaxVarint32Bytes = 5;
+
+inline void putVarint32(std::string* dst, uint32_t v) {
+    char buf[kMaxVarint32Bytes];
+    size_t n = 0;
+    while (v >= 0x80) {
+        buf[n++] = static_cast<char>(v | 0x80);
+        v >>= 7;
+    }
+    buf[n++] = static_cast<char>(v);
+    dst->append(buf, n);
+}
+
+/**
+ * @brief 解码 [p, limit) 开头的 varint
+ * @return 解码后的下一个位置；数据不完整或超过 5 字节时返回 nullptr
+ */
+inline const char* getVarint32(const char* p, const char* limit, uint32_t* v) {
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift <= 28 && p < limit; shift += 7) {
+        uint32_t byte = static_cast<uint8_t>(*p++);
+        result |= (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            *v = result;
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_BASE_CODING_H
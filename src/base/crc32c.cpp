@@ -0,0 +1,75 @@
+// src/base/crc32c.cpp
+#include "base/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define KVSTORE_CRC32C_HARDWARE 1
+#endif
+
+namespace kvstore {
+namespace crc32c {
+
+namespace {
+
+const uint32_t kPolynomial = 0x82F63B78;  // 反射形式的 Castagnoli 多项式
+
+struct Table {
+    uint32_t entries[256];
+
+    Table() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; bit++) {
+                crc = (crc >> 1) ^ ((crc & 1) ? kPolynomial : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+const Table kTable;
+
+uint32_t extendSoftware(uint32_t crc, const uint8_t* p, size_t n) {
+    uint32_t l = ~crc;
+    for (size_t i = 0; i < n; i++) {
+        l = kTable.entries[(l ^ p[i]) & 0xFF] ^ (l >> 8);
+    }
+    return ~l;
+}
+
+#ifdef KVSTORE_CRC32C_HARDWARE
+/// SSE4.2 的 crc32 指令，每条处理 8 字节，比查表快一个数量级
+__attribute__((target("sse4.2")))
+uint32_t extendHardware(uint32_t crc, const uint8_t* p, size_t n) {
+    uint64_t l = ~crc;
+    for (; n >= 8; n -= 8, p += 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        l = _mm_crc32_u64(l, word);
+    }
+    uint32_t l32 = static_cast<uint32_t>(l);
+    for (; n > 0; n--, p++) {
+        l32 = _mm_crc32_u8(l32, *p);
+    }
+    return ~l32;
+}
+
+const bool kHasHardware = __builtin_cpu_supports("sse4.2");
+#endif
+
+}  // namespace
+
+uint32_t extend(uint32_t crc, const char* data, size_t n) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+#ifdef KVSTORE_CRC32C_HARDWARE
+    if (kHasHardware) {
+        return extendHardware(crc, p, n);
+    }
+#endif
+    return extendSoftware(crc, p, n);
+}
+
+}  // namespace crc32c
+}  // namespace kvstore
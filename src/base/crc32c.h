@@ -0,0 +1,33 @@
+// src/base/crc32c.h
+#ifndef KVSTORE_BASE_CRC32C_H
+#define KVSTORE_BASE_CRC32C_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace kvstore {
+namespace crc32c {
+
+/**
+ * @brief CRC-32C（Castagnoli）校验和
+ *
+ * 用于持久化文件（WAL、快照）中的记录校验。x86-64 上 CPU 支持 SSE4.2 时
+ * 使用 crc32 指令，否则查表计算，两者结果相同。
+ *
+ * 使用示例：
+ *   uint32_t crc = crc32c::value(data, n);
+ *   crc = crc32c::extend(crc, more, m);  // 等价于对 data+more 整体计算
+ */
+
+/// 在已有校验和 crc 的基础上继续计算 data[0, n)
+uint32_t extend(uint32_t crc, const char* data, size_t n);
+
+/// data[0, n) 的校验和
+inline uint32_t value(const char* data, size_t n) {
+    return extend(0, data, n);
+}
+
+}  // namespace crc32c
+}  // namespace kvstore
+
+#endif  // KVSTORE_BASE_CRC32C_H
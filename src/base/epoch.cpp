@@ -0,0 +1,139 @@
+// src/base/epoch.cpp
+#include "base/epoch.h"
+
+#include <limits>
+
+namespace kvstore {
+
+namespace {
+
+/// 线程退出时归还记录
+struct RecordHolder {
+    void* record = nullptr;
+    void (*release)(void*) = nullptr;
+
+    ~RecordHolder() {
+        if (record != nullptr && release != nullptr) {
+            release(record);
+        }
+    }
+};
+
+thread_local RecordHolder t_recordHolder;
+__thread bool t_quiescentThread = false;  // 是否为静默状态线程
+__thread int t_guardDepth = 0;            // EpochGuard 嵌套深度
+
+}  // namespace
+
+EpochManager& EpochManager::instance() {
+    // 进程生命周期内不析构，避免线程退出时访问已析构的单例
+    static EpochManager* manager = new EpochManager;
+    return *manager;
+}
+
+EpochManager::EpochManager() : globalEpoch_(1), records_(nullptr) {}
+
+EpochManager::~EpochManager() {
+    ThreadRecord* record = records_.load();
+    while (record != nullptr) {
+        ThreadRecord* next = record->next;
+        delete record;
+        record = next;
+    }
+}
+
+EpochManager::ThreadRecord* EpochManager::localRecord() {
+    if (t_recordHolder.record != nullptr) {
+        return static_cast<ThreadRecord*>(t_recordHolder.record);
+    }
+
+    // 先尝试复用已退出线程留下的记录
+    ThreadRecord* record = nullptr;
+    for (ThreadRecord* r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        bool expected = false;
+        if (!r->inUse.load(std::memory_order_relaxed) &&
+            r->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            record = r;
+            break;
+        }
+    }
+
+    if (record == nullptr) {
+        record = new ThreadRecord;
+        ThreadRecord* head = records_.load(std::memory_order_relaxed);
+        do {
+            record->next = head;
+        } while (!records_.compare_exchange_weak(head, record, std::memory_order_release,
+                                                 std::memory_order_relaxed));
+    }
+
+    t_recordHolder.record = record;
+    t_recordHolder.release = [](void* p) {
+        ThreadRecord* r = static_cast<ThreadRecord*>(p);
+        r->epoch.store(0, std::memory_order_release);
+        r->inUse.store(false, std::memory_order_release);
+    };
+    return record;
+}
+
+void EpochManager::publish(ThreadRecord* record) {
+    record->epoch.store(globalEpoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+    // 保证 epoch 对写者可见之后，才开始读取共享数据
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochManager::registerThread() {
+    t_quiescentThread = true;
+    publish(localRecord());
+}
+
+void EpochManager::unregisterThread() {
+    offline();
+    t_quiescentThread = false;
+}
+
+void EpochManager::online() {
+    publish(localRecord());
+}
+
+void EpochManager::offline() {
+    localRecord()->epoch.store(0, std::memory_order_release);
+}
+
+bool EpochManager::isRegisteredThread() const {
+    return t_quiescentThread;
+}
+
+uint64_t EpochManager::retireEpoch() {
+    return globalEpoch_.fetch_add(1, std::memory_order_seq_cst);
+}
+
+uint64_t EpochManager::minActiveEpoch() const {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    uint64_t result = std::numeric_limits<uint64_t>::max();
+    for (ThreadRecord* r = records_.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        uint64_t epoch = r->epoch.load(std::memory_order_acquire);
+        if (epoch != 0 && epoch < result) {
+            result = epoch;
+        }
+    }
+    return result;
+}
+
+// ==================== EpochGuard ====================
+
+EpochGuard::EpochGuard() : active_(!t_quiescentThread) {
+    if (active_ && t_guardDepth++ == 0) {
+        EpochManager& manager = EpochManager::instance();
+        manager.publish(manager.localRecord());
+    }
+}
+
+EpochGuard::~EpochGuard() {
+    if (active_ && --t_guardDepth == 0) {
+        EpochManager::instance().localRecord()->epoch.store(0, std::memory_order_release);
+    }
+}
+
+}  // namespace kvstore
@@ -0,0 +1,113 @@
+// src/base/epoch.h
+#ifndef KVSTORE_BASE_EPOCH_H
+#define KVSTORE_BASE_EPOCH_H
+
+#include "base/noncopyable.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace kvstore {
+
+/**
+ * @brief 基于 epoch 的延迟回收（RCU 风格）
+ *
+ * 读者无锁遍历共享数据结构时，写者摘除的节点不能立即释放。
+ * EpochManager 维护一个全局 epoch 和每个线程观察到的 epoch：
+ * - 写者摘除节点后调用 retireEpoch() 推进全局 epoch，并记下推进前的值 R
+ * - 当所有线程要么不在读临界区，要么观察到的 epoch > R 时，节点可以安全释放
+ *
+ * 两类读者线程：
+ * 1. 静默状态线程（QSBR）：EventLoop 线程在 loop() 中注册，每轮事件循环
+ *    poll 前 offline()、poll 返回后 online()。读路径上不做任何操作，
+ *    只要求不跨事件循环迭代持有节点指针。
+ * 2. 其他线程：读操作外包一层 EpochGuard，进入时发布当前 epoch，退出时清零。
+ *    EpochGuard 在静默状态线程中是空操作。
+ *
+ * 使用示例（写者，持有写锁）：
+ *   unlink(node);
+ *   retired.push_back({EpochManager::instance().retireEpoch(), node});
+ *   ...
+ *   uint64_t safe = EpochManager::instance().minActiveEpoch();
+ *   // 释放所有 epoch < safe 的节点
+ */
+class EpochManager : noncopyable {
+public:
+    static EpochManager& instance();
+
+    // ==================== 静默状态线程（QSBR） ====================
+
+    /// 将当前线程注册为静默状态线程，注册后处于 online 状态
+    void registerThread();
+
+    /// 注销当前线程
+    void unregisterThread();
+
+    /// 进入 online 状态（同时也是一次静默点：之前持有的节点引用全部失效）
+    void online();
+
+    /// 进入 offline 状态（如阻塞在 poll 中），不阻碍任何回收
+    void offline();
+
+    /// 当前线程是否为静默状态线程
+    bool isRegisteredThread() const;
+
+    // ==================== 写者 ====================
+
+    /// 推进全局 epoch，返回推进前的值，作为被摘除对象的退休 epoch
+    uint64_t retireEpoch();
+
+    /**
+     * @brief 所有活跃线程观察到的最小 epoch
+     *
+     * 退休 epoch 小于该值的对象可以安全释放。
+     * 没有任何活跃线程时返回 UINT64_MAX。
+     */
+    uint64_t minActiveEpoch() const;
+
+    /// 当前全局 epoch
+    uint64_t currentEpoch() const { return globalEpoch_.load(std::memory_order_acquire); }
+
+private:
+    friend class EpochGuard;
+
+    /// 每个线程一条记录，线程退出后记录可被复用
+    struct ThreadRecord {
+        std::atomic<uint64_t> epoch;  // 0 表示不在读临界区 / offline
+        std::atomic<bool> inUse;
+        ThreadRecord* next;
+
+        ThreadRecord() : epoch(0), inUse(true), next(nullptr) {}
+    };
+
+    EpochManager();
+    ~EpochManager();
+
+    /// 获取当前线程的记录，首次调用时分配
+    ThreadRecord* localRecord();
+
+    /// 发布当前全局 epoch 到本线程记录
+    void publish(ThreadRecord* record);
+
+    std::atomic<uint64_t> globalEpoch_;
+    std::atomic<ThreadRecord*> records_;
+};
+
+/**
+ * @brief 读临界区守卫
+ *
+ * 非静默状态线程在无锁读之前创建，析构时退出临界区；支持嵌套。
+ * 静默状态线程中构造/析构都是空操作。
+ */
+class EpochGuard : noncopyable {
+public:
+    EpochGuard();
+    ~EpochGuard();
+
+private:
+    bool active_;
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_BASE_EPOCH_H
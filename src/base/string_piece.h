@@ -0,0 +1,57 @@
+// src/base/string_piece.h
+#ifndef KVSTORE_BASE_STRING_PIECE_H
+#define KVSTORE_BASE_STRING_PIECE_H
+
+#include <strings.h>
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+
+namespace kvstore {
+
+/**
+ * @brief 指向一段字节的只读视图，不拥有内存（C++14 没有 std::string_view）
+ *
+ * 只在被指向的内存有效期间可用：指向 Buffer 时，Buffer 被 retrieve / append 之后失效。
+ */
+class StringPiece {
+public:
+    StringPiece() : data_(nullptr), size_(0) {}
+    StringPiece(const char* data, size_t size) : data_(data), size_(size) {}
+    StringPiece(const char* str) : data_(str), size_(strlen(str)) {}  // NOLINT
+    StringPiece(const std::string& str) : data_(str.data()), size_(str.size()) {}  // NOLINT
+
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const char* begin() const { return data_; }
+    const char* end() const { return data_ + size_; }
+    char operator[](size_t i) const { return data_[i]; }
+
+    /// 去掉开头的 n 个字节
+    void removePrefix(size_t n) {
+        data_ += n;
+        size_ -= n;
+    }
+
+    std::string toString() const { return std::string(data_, size_); }
+
+    /// 忽略大小写比较（ASCII）
+    bool equalsIgnoreCase(StringPiece other) const {
+        return size_ == other.size_ && strncasecmp(data_, other.data_, size_) == 0;
+    }
+
+    bool operator==(StringPiece other) const {
+        return size_ == other.size_ && memcmp(data_, other.data_, size_) == 0;
+    }
+    bool operator!=(StringPiece other) const { return !(*this == other); }
+
+private:
+    const char* data_;
+    size_t size_;
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_BASE_STRING_PIECE_H
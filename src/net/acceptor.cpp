@@ -4,6 +4,7 @@
 #include "net/inet_address.h"
 #include "base/logger.h"
 
+#include <errno.h>
 #include <unistd.h>
 #include <fcntl.h>
 
@@ -37,20 +38,31 @@ void Acceptor::listen() {
 
 void Acceptor::handleRead() {
     loop_->assertInLoopThread();
-    InetAddress peerAddr;
-    int connfd = acceptSocket_.accept(&peerAddr);
+    // ET 模式下同时到达的多个连接只通知一次，需要一直 accept 到 EAGAIN，
+    // 否则剩下的连接留在 backlog 中，要等下一个新连接到达才会被接受
+    while (true) {
+        InetAddress peerAddr;
+        int connfd = acceptSocket_.accept(&peerAddr);
 
-    if (connfd >= 0) {
-        if (newConnectionCallback_) {
-            newConnectionCallback_(connfd, peerAddr);
+        if (connfd >= 0) {
+            if (newConnectionCallback_) {
+                newConnectionCallback_(connfd, peerAddr);
+            } else {
+                ::close(connfd);
+            }
         } else {
-            ::close(connfd);
-        }
-    } else {
-        LOG_ERROR << "Acceptor::handleRead accept failed";
-        // 如果 fd 用尽，需要特殊处理
-        if (errno == EMFILE) {
-            LOG_ERROR << "File descriptors exhausted!";
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            LOG_ERROR << "Acceptor::handleRead accept failed";
+            // 如果 fd 用尽，需要特殊处理
+            if (errno == EMFILE) {
+                LOG_ERROR << "File descriptors exhausted!";
+            }
+            break;
         }
     }
 }
@@ -24,7 +24,7 @@ const char Buffer::kCRLF[] = "\r\n";
  */
 ssize_t Buffer::readFd(int fd, int* savedErrno) {
     // 栈上的临时缓冲区，64KB
-    char extrabuf[65536];
+    char extrabuf[kExtraBufferSize];
 
     struct iovec vec[2];
     const size_t writable = writableBytes();
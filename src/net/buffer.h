@@ -31,6 +31,7 @@ class Buffer {
 public:
     static const size_t kCheapPrepend = 8;    // 预留 8 字节用于 prepend
     static const size_t kInitialSize = 1024;  // 初始缓冲区大小
+    static const size_t kExtraBufferSize = 65536;  // readFd 栈上临时缓冲区的大小
 
     explicit Buffer(size_t initialSize = kInitialSize)
         : buffer_(kCheapPrepend + initialSize),
@@ -129,6 +130,12 @@ public:
     /// 从 fd 读取数据
     ssize_t readFd(int fd, int* savedErrno);
 
+    /// readFd 一次最多读取的字节数，读满时 fd 中可能还有数据
+    size_t readFdCapacity() const {
+        return writableBytes() < kExtraBufferSize ? writableBytes() + kExtraBufferSize
+                                                  : writableBytes();
+    }
+
     /// 向 fd 写入数据
     ssize_t writeFd(int fd, int* savedErrno);
 
@@ -3,6 +3,8 @@
 #include "net/channel.h"
 #include "net/poller.h"
 #include "net/epoll_poller.h"
+#include "net/timer_queue.h"
+#include "base/epoch.h"
 #include "base/logger.h"
 
 #include <sys/eventfd.h>
@@ -34,6 +36,7 @@ EventLoop::EventLoop()
       poller_(new EpollPoller(this)),
       wakeupFd_(createEventfd()),
       wakeupChannel_(new Channel(this, wakeupFd_)),
+      timerQueue_(new TimerQueue(this)),
       currentActiveChannel_(nullptr) {
     LOG_DEBUG << "EventLoop created " << this << " in thread " << threadId_;
 
@@ -63,9 +66,16 @@ void EventLoop::loop() {
 
     LOG_INFO << "EventLoop " << this << " start looping";
 
+    // 注册为静默状态线程：无锁读者（如 SkipList::search）在本线程中无需任何同步，
+    // 每轮循环阻塞在 poll 期间处于 offline，不阻碍延迟回收
+    EpochManager& epoch = EpochManager::instance();
+    epoch.registerThread();
+
     while (!quit_) {
         activeChannels_.clear();
+        epoch.offline();
         pollReturnTime_ = poller_->poll(kPollTimeMs, &activeChannels_);
+        epoch.online();
 
         eventHandling_ = true;
         for (Channel* channel : activeChannels_) {
@@ -79,6 +89,8 @@ void EventLoop::loop() {
         doPendingFunctors();
     }
 
+    epoch.unregisterThread();
+
     LOG_INFO << "EventLoop " << this << " stop looping";
     looping_ = false;
 }
@@ -123,6 +135,22 @@ void EventLoop::wakeup() {
     }
 }
 
+TimerId EventLoop::runAt(Timestamp time, TimerCallback cb) {
+    return timerQueue_->addTimer(std::move(cb), time, 0.0);
+}
+
+TimerId EventLoop::runAfter(double delay, TimerCallback cb) {
+    return runAt(addTime(Timestamp::now(), delay), std::move(cb));
+}
+
+TimerId EventLoop::runEvery(double interval, TimerCallback cb) {
+    return timerQueue_->addTimer(std::move(cb), addTime(Timestamp::now(), interval), interval);
+}
+
+void EventLoop::cancel(TimerId timerId) {
+    timerQueue_->cancel(timerId);
+}
+
 void EventLoop::handleRead() {
     uint64_t one = 1;
     ssize_t n = ::read(wakeupFd_, &one, sizeof(one));
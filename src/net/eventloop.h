@@ -6,6 +6,8 @@
 #include "base/mutex.h"
 #include "base/current_thread.h"
 #include "base/timestamp.h"
+#include "net/callbacks.h"
+#include "net/timer_wheel.h"
 
 #include <atomic>
 #include <functional>
@@ -16,6 +18,7 @@ namespace kvstore {
 
 class Channel;
 class Poller;
+class TimerQueue;
 
 /**
  * @brief 事件循环 (Reactor 核心)
@@ -33,6 +36,15 @@ class Poller;
  * wakeup 机制：
  * - 使用 eventfd 唤醒可能阻塞在 poll() 中的线程
  * - 当有跨线程任务提交时，需要唤醒以及时执行
+ *
+ * 定时器：
+ * - 每个 EventLoop 一个 TimerQueue：分层时间轮 + timerfd，timerfd 和其他 Channel 一样
+ *   由 Poller 监听，到期的回调在 EventLoop 线程中执行
+ * - runAt/runAfter/runEvery/cancel 可以跨线程调用
+ *
+ * 延迟回收：
+ * - loop() 期间本线程注册为 EpochManager 的静默状态线程，
+ *   每轮循环的 poll 调用即为一次静默点（见 base/epoch.h）
  */
 class EventLoop : noncopyable {
 public:
@@ -70,6 +82,20 @@ public:
     /// 唤醒阻塞在 poll() 中的 EventLoop
     void wakeup();
 
+    // ==================== 定时器 ====================
+
+    /// 在 time 时刻执行 cb
+    TimerId runAt(Timestamp time, TimerCallback cb);
+
+    /// delay 秒之后执行 cb
+    TimerId runAfter(double delay, TimerCallback cb);
+
+    /// 每隔 interval 秒执行一次 cb，直到 cancel
+    TimerId runEvery(double interval, TimerCallback cb);
+
+    /// 取消尚未触发的定时器（周期定时器不再重复）
+    void cancel(TimerId timerId);
+
     // ==================== Channel 管理 ====================
 
     void updateChannel(Channel* channel);
@@ -111,6 +137,8 @@ private:
     int wakeupFd_;  // eventfd，用于唤醒
     std::unique_ptr<Channel> wakeupChannel_;
 
+    std::unique_ptr<TimerQueue> timerQueue_;
+
     ChannelList activeChannels_;
     Channel* currentActiveChannel_;
 
@@ -19,7 +19,9 @@ TcpConnection::TcpConnection(EventLoop* loop, const std::string& name, int sockf
       channel_(new Channel(loop, sockfd)),
       localAddr_(localAddr),
       peerAddr_(peerAddr),
-      highWaterMark_(64 * 1024 * 1024) {  // 64MB
+      highWaterMark_(64 * 1024 * 1024),  // 64MB
+      reading_(false),
+      flushPending_(false) {
     // 设置 Channel 的回调
     channel_->setReadCallback(std::bind(&TcpConnection::handleRead, this, std::placeholders::_1));
     channel_->setWriteCallback(std::bind(&TcpConnection::handleWrite, this));
@@ -70,6 +72,13 @@ void TcpConnection::sendInLoop(const void* data, size_t len) {
         return;
     }
 
+    // messageCallback 中发送的数据与 flush 一样攒到这次读事件处理完
+    if (reading_ && !channel_->isWriting()) {
+        outputBuffer_.append(static_cast<const char*>(data), len);
+        flush();
+        return;
+    }
+
     ssize_t nwrote = 0;
     size_t remaining = len;
     bool faultError = false;
@@ -108,6 +117,50 @@ void TcpConnection::sendInLoop(const void* data, size_t len) {
     }
 }
 
+void TcpConnection::flush() {
+    loop_->assertInLoopThread();
+    if (reading_ && outputBuffer_.readableBytes() < kDeferredFlushBytes) {
+        flushPending_ = true;
+        return;
+    }
+    writeOutput();
+}
+
+void TcpConnection::writeOutput() {
+    flushPending_ = false;
+    // 正在等待可写事件时，缓冲区中的数据由 handleWrite 发送
+    if (state_ == kDisconnected || channel_->isWriting() || outputBuffer_.readableBytes() == 0) {
+        return;
+    }
+
+    int savedErrno = 0;
+    ssize_t n = outputBuffer_.writeFd(channel_->fd(), &savedErrno);
+    if (n > 0) {
+        outputBuffer_.retrieve(n);
+    } else if (n < 0 && savedErrno != EWOULDBLOCK) {
+        LOG_ERROR << "TcpConnection::writeOutput error";
+        if (savedErrno == EPIPE || savedErrno == ECONNRESET) {
+            outputBuffer_.retrieveAll();
+            return;
+        }
+    }
+
+    size_t remaining = outputBuffer_.readableBytes();
+    if (remaining == 0) {
+        if (writeCompleteCallback_) {
+            loop_->queueInLoop(std::bind(writeCompleteCallback_, shared_from_this()));
+        }
+        if (state_ == kDisconnecting) {
+            socket_->shutdownWrite();
+        }
+        return;
+    }
+    if (remaining >= highWaterMark_ && highWaterMarkCallback_) {
+        loop_->queueInLoop(std::bind(highWaterMarkCallback_, shared_from_this(), remaining));
+    }
+    channel_->enableWriting();
+}
+
 void TcpConnection::shutdown() {
     if (state_ == kConnected) {
         setState(kDisconnecting);
@@ -117,8 +170,15 @@ void TcpConnection::shutdown() {
 
 void TcpConnection::shutdownInLoop() {
     loop_->assertInLoopThread();
-    if (!channel_->isWriting()) {
+    if (channel_->isWriting()) {
+        return;  // handleWrite 写完后关闭
+    }
+    if (outputBuffer_.readableBytes() == 0) {
         socket_->shutdownWrite();
+    } else if (!reading_) {
+        writeOutput();  // 写完后关闭
+    } else {
+        flushPending_ = true;  // handleRead 中：读完后统一写出，写完后关闭
     }
 }
 
@@ -165,20 +225,43 @@ void TcpConnection::connectDestroyed() {
 
 void TcpConnection::handleRead(Timestamp receiveTime) {
     loop_->assertInLoopThread();
-    int savedErrno = 0;
-    ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
+    // ET 模式下新数据到达只通知一次：读满了 readFd 一次能读的空间时 socket 中可能还有数据，
+    // 处理完这一块后继续读，直到读到的比能读的少或 EAGAIN，否则剩下的数据要等下一次到达才会处理
+    reading_ = true;
+    bool peerClosed = false;
+    while (state_ != kDisconnected) {
+        int savedErrno = 0;
+        const size_t capacity = inputBuffer_.readFdCapacity();
+        ssize_t n = inputBuffer_.readFd(channel_->fd(), &savedErrno);
 
-    if (n > 0) {
-        if (messageCallback_) {
-            messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+        if (n > 0) {
+            if (messageCallback_) {
+                messageCallback_(shared_from_this(), &inputBuffer_, receiveTime);
+            }
+            if (static_cast<size_t>(n) < capacity) {
+                break;
+            }
+        } else if (n == 0) {
+            // 对端关闭连接
+            peerClosed = true;
+            break;
+        } else {
+            if (savedErrno != EAGAIN && savedErrno != EWOULDBLOCK) {
+                errno = savedErrno;
+                LOG_ERROR << "TcpConnection::handleRead error";
+                handleError();
+            }
+            break;
         }
-    } else if (n == 0) {
-        // 对端关闭连接
+    }
+    reading_ = false;
+
+    // 这次读事件中所有请求的应答一次写出（对端只关闭了写端时也能收到）
+    if (flushPending_) {
+        writeOutput();
+    }
+    if (peerClosed) {
         handleClose();
-    } else {
-        errno = savedErrno;
-        LOG_ERROR << "TcpConnection::handleRead error";
-        handleError();
     }
 }
 
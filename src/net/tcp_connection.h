@@ -55,6 +55,26 @@ public:
     void send(const std::string& message);
     void send(Buffer* buf);
 
+    /**
+     * @brief 输出缓冲区（只能在连接所在线程中使用）
+     *
+     * 应答可以直接编码到这里，不经过临时字符串；追加的数据与 send 的数据按调用顺序发送。
+     * 追加之后调用 flush 才会写 socket，一批请求的应答攒在一起用一次 write 发出。
+     */
+    Buffer* outputBuffer() { return &outputBuffer_; }
+
+    /**
+     * @brief 把输出缓冲区中的数据写入 socket，写不完的部分等待可写事件（只能在连接所在线程中调用）
+     *
+     * 在 messageCallback 中调用时推迟到这次读事件处理完：一次读到的所有请求
+     * （ET 模式下可能分几块回调）的应答只用一次 write 发出。
+     * 攒到 kDeferredFlushBytes 以上时立即写，不让大结果占用太多内存。
+     * 只追加到输出缓冲区而没有调用 flush 的数据，读事件处理完也不会写出。
+     */
+    void flush();
+
+    static const size_t kDeferredFlushBytes = 64 * 1024;
+
     // ==================== 连接控制 ====================
 
     /// 关闭连接（半关闭，等待对端关闭）
@@ -85,6 +105,12 @@ public:
         closeCallback_ = cb;
     }
 
+    // ==================== 上下文 ====================
+
+    /// 绑定上层协议的连接状态（只应在连接所属的 IO 线程中访问）
+    void setContext(const std::shared_ptr<void>& context) { context_ = context; }
+    const std::shared_ptr<void>& getContext() const { return context_; }
+
     // ==================== 内部使用 ====================
 
     /// 连接建立，由 TcpServer 调用
@@ -96,9 +122,6 @@ public:
     /// 获取输入缓冲区
     Buffer* inputBuffer() { return &inputBuffer_; }
 
-    /// 获取输出缓冲区
-    Buffer* outputBuffer() { return &outputBuffer_; }
-
 private:
     enum StateE { kDisconnected, kConnecting, kConnected, kDisconnecting };
 
@@ -108,6 +131,8 @@ private:
     void handleError();
 
     void sendInLoop(const void* data, size_t len);
+    /// 立即写出输出缓冲区；shutdown 之后写完时关闭写端
+    void writeOutput();
     void shutdownInLoop();
     void forceCloseInLoop();
 
@@ -131,8 +156,11 @@ private:
     CloseCallback closeCallback_;
 
     size_t highWaterMark_;
+    bool reading_;       // 正在 handleRead 中回调，flush 推迟到读完
+    bool flushPending_;  // 读事件处理期间调用过 flush，读完后写出
     Buffer inputBuffer_;
     Buffer outputBuffer_;
+    std::shared_ptr<void> context_;
 };
 
 }  // namespace kvstore
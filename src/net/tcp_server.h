@@ -53,6 +53,9 @@ public:
     const std::string& name() const { return name_; }
     EventLoop* getLoop() const { return loop_; }
 
+    /// IO 线程池（start() 之后才包含已创建的 IO 线程）
+    std::shared_ptr<EventLoopThreadPool> threadPool() const { return threadPool_; }
+
     // ==================== 配置 ====================
 
     /// 设置 IO 线程数量（必须在 start() 前调用）
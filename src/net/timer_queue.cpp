@@ -0,0 +1,131 @@
+// src/net/timer_queue.cpp
+#include "net/timer_queue.h"
+#include "net/eventloop.h"
+#include "base/logger.h"
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace kvstore {
+
+namespace {
+
+int createTimerfd() {
+    int timerfd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd < 0) {
+        LOG_FATAL << "Failed to create timerfd";
+    }
+    return timerfd;
+}
+
+/// 设置 timerfd 在 delay 微秒后触发一次，delay 为 0 时停止
+void setTimerfd(int timerfd, int64_t delayMicroSeconds) {
+    struct itimerspec spec;
+    memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = static_cast<time_t>(delayMicroSeconds / 1000000);
+    spec.it_value.tv_nsec = static_cast<long>(delayMicroSeconds % 1000000 * 1000);
+    if (::timerfd_settime(timerfd, 0, &spec, nullptr) != 0) {
+        LOG_ERROR << "timerfd_settime failed, errno=" << errno;
+    }
+}
+
+}  // namespace
+
+TimerQueue::TimerQueue(EventLoop* loop)
+    : loop_(loop),
+      timerfd_(createTimerfd()),
+      timerfdChannel_(loop, timerfd_),
+      wheel_(Timestamp::now().microSecondsSinceEpoch()),
+      armedMicroSeconds_(0) {
+    timerfdChannel_.setReadCallback(std::bind(&TimerQueue::handleRead, this));
+    timerfdChannel_.enableReading();
+}
+
+TimerQueue::~TimerQueue() {
+    timerfdChannel_.disableAll();
+    timerfdChannel_.remove();
+    ::close(timerfd_);
+}
+
+TimerId TimerQueue::addTimer(TimerCallback cb, Timestamp when, double interval) {
+    TimerId timerId = wheel_.newId();
+    int64_t intervalMicroSeconds =
+        interval > 0 ? static_cast<int64_t>(interval * Timestamp::kMicroSecondsPerSecond) : 0;
+    int64_t expire = when.microSecondsSinceEpoch();
+    if (loop_->isInLoopThread()) {
+        insertInLoop(timerId, expire, std::move(cb), intervalMicroSeconds);
+    } else {
+        loop_->queueInLoop([this, timerId, expire, cb, intervalMicroSeconds]() {
+            insertInLoop(timerId, expire, cb, intervalMicroSeconds);
+        });
+    }
+    return timerId;
+}
+
+void TimerQueue::cancel(TimerId timerId) {
+    loop_->runInLoop(std::bind(&TimerQueue::cancelInLoop, this, timerId));
+}
+
+void TimerQueue::insertInLoop(TimerId timerId, int64_t expireMicroSeconds, TimerCallback cb,
+                              int64_t intervalMicroSeconds) {
+    loop_->assertInLoopThread();
+    int64_t now = Timestamp::now().microSecondsSinceEpoch();
+    if (wheel_.size() == 0) {
+        // 空闲期间时间轮没有推进，先跳到当前时刻，新定时器才能落在正确的层
+        wheel_.advance(now);
+    }
+    wheel_.insert(timerId, expireMicroSeconds, std::move(cb), intervalMicroSeconds);
+    if (armedMicroSeconds_ == 0) {
+        armAt(now + wheel_.nextTimeout(now));
+    } else {
+        // 已经设置过：设置的时刻不晚于第 0 层的下一个定时器和下一次下放，只需和新定时器比较。
+        // 定时器在到期时刻所在 tick 结束时才执行，timerfd 对齐到 tick 的边界
+        const int64_t tick = TimerWheel::kTickMicroSeconds;
+        int64_t deadline = (std::max(expireMicroSeconds, now) + tick - 1) / tick * tick;
+        armAt(deadline);
+    }
+}
+
+void TimerQueue::cancelInLoop(TimerId timerId) {
+    loop_->assertInLoopThread();
+    if (wheel_.cancel(timerId) && wheel_.size() == 0) {
+        disarm();
+    }
+}
+
+void TimerQueue::handleRead() {
+    loop_->assertInLoopThread();
+    uint64_t howmany = 0;
+    ssize_t n = ::read(timerfd_, &howmany, sizeof(howmany));
+    if (n != sizeof(howmany) && errno != EAGAIN) {
+        LOG_ERROR << "TimerQueue::handleRead() reads " << n << " bytes instead of 8";
+    }
+
+    armedMicroSeconds_ = 0;
+    wheel_.advance(Timestamp::now().microSecondsSinceEpoch());
+    // 回调中可能添加或取消了定时器，按推进之后的时间轮重新设置
+    if (wheel_.size() > 0) {
+        int64_t now = Timestamp::now().microSecondsSinceEpoch();
+        armAt(now + wheel_.nextTimeout(now));
+    }
+}
+
+void TimerQueue::armAt(int64_t deadlineMicroSeconds) {
+    if (armedMicroSeconds_ != 0 && armedMicroSeconds_ <= deadlineMicroSeconds) {
+        return;
+    }
+    armedMicroSeconds_ = deadlineMicroSeconds;
+    int64_t delay = deadlineMicroSeconds - Timestamp::now().microSecondsSinceEpoch();
+    // it_value 为 0 会停止 timerfd，已经到期的也至少等 1 微秒
+    setTimerfd(timerfd_, std::max<int64_t>(delay, 1));
+}
+
+void TimerQueue::disarm() {
+    armedMicroSeconds_ = 0;
+    setTimerfd(timerfd_, 0);
+}
+
+}  // namespace kvstore
@@ -0,0 +1,75 @@
+// src/net/timer_queue.h
+#ifndef KVSTORE_NET_TIMER_QUEUE_H
+#define KVSTORE_NET_TIMER_QUEUE_H
+
+#include "base/noncopyable.h"
+#include "base/timestamp.h"
+#include "net/callbacks.h"
+#include "net/channel.h"
+#include "net/timer_wheel.h"
+
+namespace kvstore {
+
+class EventLoop;
+
+/**
+ * @brief EventLoop 的定时器队列
+ *
+ * 定时器保存在分层时间轮（TimerWheel）中，添加、取消都是 O(1)。
+ * 用一个 timerfd 唤醒 EventLoop：它和其他 fd 一样注册在 Poller 上，
+ * 可读时推进时间轮、执行到期的回调，再按下一个到期时刻重新设置 timerfd。
+ *
+ * timerfd 只在新的定时器比已设置的时刻更早时才重新设置，
+ * 大量添加的定时器（如每个连接一个的超时）大多不需要系统调用。
+ * 时间轮上层的定时器需要在第 0 层转完一圈时下放，只有上层有定时器时
+ * timerfd 最长 256 毫秒触发一次。
+ *
+ * 线程安全：addTimer/cancel 可以在任意线程调用，id 立即返回，
+ * 实际的添加和取消经 runInLoop 在 EventLoop 线程中执行。
+ * 同一个线程先 addTimer 再 cancel，只要 cancel 执行时定时器还没到期就有效
+ * （很快到期的定时器可能在 cancel 执行之前触发）；不同线程之间没有先后保证，
+ * cancel 先执行时不起作用。回调在 EventLoop 线程中执行。
+ */
+class TimerQueue : noncopyable {
+public:
+    explicit TimerQueue(EventLoop* loop);
+    ~TimerQueue();
+
+    /**
+     * @brief 添加定时器
+     * @param when 到期时刻，已经过去时尽快执行
+     * @param interval 大于 0 时每隔 interval 秒重复执行
+     * @return 定时器 id，用于 cancel
+     */
+    TimerId addTimer(TimerCallback cb, Timestamp when, double interval);
+
+    /// 取消定时器，已经触发（非周期）或已经取消时什么也不做
+    void cancel(TimerId timerId);
+
+    /// 定时器个数（只能在 EventLoop 线程中调用）
+    size_t size() const { return wheel_.size(); }
+
+private:
+    void insertInLoop(TimerId timerId, int64_t expireMicroSeconds, TimerCallback cb,
+                      int64_t intervalMicroSeconds);
+    void cancelInLoop(TimerId timerId);
+
+    /// timerfd 可读：执行到期的定时器
+    void handleRead();
+
+    /// deadline（微秒）早于已设置的时刻时重新设置 timerfd
+    void armAt(int64_t deadlineMicroSeconds);
+
+    /// 停止 timerfd
+    void disarm();
+
+    EventLoop* loop_;
+    const int timerfd_;
+    Channel timerfdChannel_;
+    TimerWheel wheel_;
+    int64_t armedMicroSeconds_;  // timerfd 设置的到期时刻，0 表示没有设置
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_NET_TIMER_QUEUE_H
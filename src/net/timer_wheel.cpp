@@ -0,0 +1,184 @@
+// src/net/timer_wheel.cpp
+#include "net/timer_wheel.h"
+
+#include <algorithm>
+
+namespace kvstore {
+
+namespace {
+
+/// 微秒向上取整到 tick
+int64_t ticksCeil(int64_t microSeconds) {
+    return (microSeconds + TimerWheel::kTickMicroSeconds - 1) / TimerWheel::kTickMicroSeconds;
+}
+
+}  // namespace
+
+TimerWheel::TimerWheel(int64_t nowMicroSeconds)
+    : currentTick_(nowMicroSeconds / kTickMicroSeconds), nextId_(1), rootCount_(0) {
+    std::fill(std::begin(slots_), std::end(slots_), nullptr);
+}
+
+TimerWheel::~TimerWheel() {
+    for (const auto& entry : timers_) {
+        delete entry.second;
+    }
+}
+
+TimerId TimerWheel::add(int64_t expireMicroSeconds, TimerCallback cb,
+                        int64_t intervalMicroSeconds) {
+    TimerId id = newId();
+    insert(id, expireMicroSeconds, std::move(cb), intervalMicroSeconds);
+    return id;
+}
+
+void TimerWheel::insert(TimerId id, int64_t expireMicroSeconds, TimerCallback cb,
+                        int64_t intervalMicroSeconds) {
+    Timer* timer = new Timer;
+    timer->id = id;
+    // 当前 tick 已经执行过，最早在下一个 tick 触发
+    timer->expireTick = std::max(ticksCeil(expireMicroSeconds), currentTick_ + 1);
+    timer->intervalMicroSeconds = intervalMicroSeconds;
+    timer->callback = std::move(cb);
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    timer->slot = nullptr;
+    place(timer);
+    timers_.emplace(timer->id, timer);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+    Timer* timer = it->second;
+    timers_.erase(it);
+    if (timer->slot == nullptr) {
+        // 正在执行自己的回调：由 expire 在回调返回后释放，周期定时器不再重新添加
+        timer->intervalMicroSeconds = 0;
+        return true;
+    }
+    unlink(timer);
+    delete timer;
+    return true;
+}
+
+size_t TimerWheel::advance(int64_t nowMicroSeconds) {
+    const int64_t target = nowMicroSeconds / kTickMicroSeconds;
+    size_t count = 0;
+    while (currentTick_ < target) {
+        if (timers_.empty()) {
+            currentTick_ = target;
+            break;
+        }
+        currentTick_++;
+        const int index = static_cast<int>(currentTick_ & (kRootSlots - 1));
+        // 第 0 层转完一圈：下放第 1 层的下一个槽；它也转完一圈时继续下放更上层
+        if (index == 0) {
+            for (int level = 1; level < kLevels; level++) {
+                const int shift = kRootBits + (level - 1) * kLevelBits;
+                const int slot = static_cast<int>((currentTick_ >> shift) & (kLevelSlots - 1));
+                cascade(level, slot);
+                if (slot != 0) {
+                    break;
+                }
+            }
+        }
+        count += expire(&slots_[index]);
+    }
+    return count;
+}
+
+int64_t TimerWheel::nextTimeout(int64_t nowMicroSeconds) const {
+    if (timers_.empty()) {
+        return -1;
+    }
+    // 上层的定时器都不早于第 0 层下一次转完一圈的时刻；第 0 层的定时器都在 256 个 tick 之内
+    const bool upper = rootCount_ < timers_.size();
+    int64_t ticks = upper ? kRootSlots - (currentTick_ & (kRootSlots - 1)) : kRootSlots;
+    for (int64_t i = 1; rootCount_ > 0 && i <= ticks; i++) {
+        if (slots_[(currentTick_ + i) & (kRootSlots - 1)] != nullptr) {
+            ticks = i;
+            break;
+        }
+    }
+    return std::max<int64_t>((currentTick_ + ticks) * kTickMicroSeconds - nowMicroSeconds, 0);
+}
+
+void TimerWheel::place(Timer* timer) {
+    const int64_t delta = timer->expireTick - currentTick_;
+    Timer** slot;
+    if (delta < kRootSlots) {
+        // 下放时可能正好是当前 tick（delta 为 0），advance 随后执行这个槽
+        slot = &slots_[timer->expireTick & (kRootSlots - 1)];
+        rootCount_++;
+    } else {
+        int level = 1;
+        int shift = kRootBits;
+        while (level < kLevels - 1 && delta >= (int64_t(1) << (shift + kLevelBits))) {
+            level++;
+            shift += kLevelBits;
+        }
+        // 超出范围的定时器放在最高层能表示的最远处，下放时再重新计算
+        const int64_t range = int64_t(1) << (shift + kLevelBits);
+        const int64_t tick = delta < range ? timer->expireTick : currentTick_ + range - 1;
+        slot = &levelSlots(level)[(tick >> shift) & (kLevelSlots - 1)];
+    }
+    timer->slot = slot;
+    timer->prev = nullptr;
+    timer->next = *slot;
+    if (*slot != nullptr) {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+}
+
+void TimerWheel::unlink(Timer* timer) {
+    if (timer->prev != nullptr) {
+        timer->prev->next = timer->next;
+    } else {
+        *timer->slot = timer->next;
+    }
+    if (timer->next != nullptr) {
+        timer->next->prev = timer->prev;
+    }
+    if (timer->slot < slots_ + kRootSlots) {
+        rootCount_--;
+    }
+    timer->prev = nullptr;
+    timer->next = nullptr;
+    timer->slot = nullptr;
+}
+
+void TimerWheel::cascade(int level, int index) {
+    Timer** slot = &levelSlots(level)[index];
+    Timer* timer = *slot;
+    *slot = nullptr;
+    while (timer != nullptr) {
+        Timer* next = timer->next;
+        place(timer);
+        timer = next;
+    }
+}
+
+size_t TimerWheel::expire(Timer** slot) {
+    size_t count = 0;
+    // 每次从槽头取：回调可能取消同一个槽中的其他定时器
+    while (Timer* timer = *slot) {
+        unlink(timer);
+        timer->callback();
+        count++;
+        if (timer->intervalMicroSeconds > 0) {
+            timer->expireTick =
+                currentTick_ + std::max<int64_t>(ticksCeil(timer->intervalMicroSeconds), 1);
+            place(timer);
+        } else {
+            timers_.erase(timer->id);  // 回调中取消过自己时已经不在表中
+            delete timer;
+        }
+    }
+    return count;
+}
+
+}  // namespace kvstore
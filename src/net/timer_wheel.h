@@ -0,0 +1,127 @@
+// src/net/timer_wheel.h
+#ifndef KVSTORE_NET_TIMER_WHEEL_H
+#define KVSTORE_NET_TIMER_WHEEL_H
+
+#include "base/noncopyable.h"
+#include "net/callbacks.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+namespace kvstore {
+
+/// 定时器标识，0 表示无效
+using TimerId = uint64_t;
+
+/**
+ * @brief 分层时间轮
+ *
+ * 每个 tick 1 毫秒，共 5 层：第 0 层 256 个槽，每槽 1 tick；之后每层 64 个槽，
+ * 每槽跨度是上一层一整圈。定时器按到期时刻与当前时刻之差放进对应的层，
+ * 上层的槽在下层转完一圈时整体下放（cascade），到第 0 层后按 tick 触发。
+ * 覆盖范围 2^32 tick（约 49 天），更远的定时器放在最高层，到时再重新计算位置。
+ *
+ *   层 0: 256 槽 × 1 tick
+ *   层 1:  64 槽 × 256 tick
+ *   层 2:  64 槽 × 2^14 tick
+ *   层 3:  64 槽 × 2^20 tick
+ *   层 4:  64 槽 × 2^26 tick
+ *
+ * 添加、取消都是 O(1)：每个槽是侵入式双向链表，取消按 id 找到节点直接摘下。
+ * 推进时间的开销与经过的 tick 数和到期（或下放）的定时器数成正比，与定时器总数无关；
+ * 没有定时器时直接跳到当前时刻。
+ *
+ * 精度：到期时刻向上取整到 tick，回调在到期的那个 tick 被推进到时执行，不会提前。
+ *
+ * 除 newId 外不是线程安全的，由所属 EventLoop 的线程使用（见 TimerQueue）。
+ */
+class TimerWheel : noncopyable {
+public:
+    static const int64_t kTickMicroSeconds = 1000;
+
+    /// now 为当前时刻（微秒），作为时间轮的起点
+    explicit TimerWheel(int64_t nowMicroSeconds);
+    ~TimerWheel();
+
+    /**
+     * @brief 添加定时器
+     * @param expireMicroSeconds 到期时刻（微秒），已经过去时在下一个 tick 触发
+     * @param intervalMicroSeconds 大于 0 时为周期定时器，每次触发后按间隔重新添加
+     * @return 定时器 id，用于 cancel
+     */
+    TimerId add(int64_t expireMicroSeconds, TimerCallback cb, int64_t intervalMicroSeconds = 0);
+
+    /// 分配一个定时器 id，可以在任意线程调用（先返回 id、再到所属线程中 insert）
+    TimerId newId() { return nextId_.fetch_add(1, std::memory_order_relaxed); }
+
+    /// 用 newId 分配的 id 添加定时器，参数同 add
+    void insert(TimerId id, int64_t expireMicroSeconds, TimerCallback cb,
+                int64_t intervalMicroSeconds = 0);
+
+    /**
+     * @brief 取消定时器，可以在回调中调用（包括取消自己）
+     * @return false 定时器不存在（已经触发或已取消）
+     */
+    bool cancel(TimerId id);
+
+    /**
+     * @brief 推进到 now，依次执行到期的回调
+     * @return 执行的回调数
+     */
+    size_t advance(int64_t nowMicroSeconds);
+
+    /**
+     * @brief 距离下一次需要推进的时刻还有多少微秒
+     *
+     * 第 0 层有定时器时是最早的那个的到期时刻；只有上层有定时器时是第 0 层转完一圈
+     * 的时刻（届时下放）。没有定时器时返回 -1。
+     */
+    int64_t nextTimeout(int64_t nowMicroSeconds) const;
+
+    /// 定时器个数
+    size_t size() const { return timers_.size(); }
+
+private:
+    static const int kLevels = 5;
+    static const int kRootBits = 8;  // 第 0 层 256 个槽
+    static const int kLevelBits = 6;  // 之后每层 64 个槽
+    static const int kRootSlots = 1 << kRootBits;
+    static const int kLevelSlots = 1 << kLevelBits;
+
+    struct Timer {
+        TimerId id;
+        int64_t expireTick;
+        int64_t intervalMicroSeconds;
+        TimerCallback callback;
+        Timer* prev;
+        Timer* next;
+        Timer** slot;  // 所在槽的链表头，回调执行期间为 nullptr
+    };
+
+    /// 按到期 tick 放进对应的槽
+    void place(Timer* timer);
+
+    /// 从所在的槽中摘下
+    void unlink(Timer* timer);
+
+    /// 把第 level 层（>= 1）的第 index 个槽中的定时器按当前 tick 重新放置
+    void cascade(int level, int index);
+
+    /// 执行第 0 层 slot 槽中的全部定时器（都在当前 tick 到期）
+    size_t expire(Timer** slot);
+
+    /// 第 level 层（>= 1）的槽数组
+    Timer** levelSlots(int level) { return &slots_[kRootSlots + (level - 1) * kLevelSlots]; }
+
+    int64_t currentTick_;  // 已经推进到的 tick，该 tick 的定时器已执行
+    std::atomic<TimerId> nextId_;
+    size_t rootCount_;     // 第 0 层的定时器数
+    Timer* slots_[kRootSlots + (kLevels - 1) * kLevelSlots];
+    std::unordered_map<TimerId, Timer*> timers_;
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_NET_TIMER_WHEEL_H
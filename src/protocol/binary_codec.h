@@ -0,0 +1,216 @@
+// src/protocol/binary_codec.h
+#ifndef KVSTORE_PROTOCOL_BINARY_CODEC_H
+#define KVSTORE_PROTOCOL_BINARY_CODEC_H
+
+#include "protocol/message.h"
+#include "net/buffer.h"
+
+#include <endian.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace kvstore {
+
+/**
+ * @brief 二进制协议的一帧（请求），key / value 指向输入缓冲区，不拷贝
+ *
+ * 只在缓冲区被修改（retrieve / append）之前有效。
+ */
+struct BinaryFrame {
+    uint8_t opcode;        // 与 CommandType 的取值相同
+    uint32_t requestId;    // 客户端自定义，原样带回应答
+    uint32_t extra;        // PUT / EXPIRE 的过期秒数
+    const char* key;
+    size_t keyLength;
+    const char* value;
+    size_t valueLength;
+
+    /// 整帧的字节数（含头部）
+    size_t size() const;
+};
+
+/**
+ * @brief 二进制协议编解码器
+ *
+ * 长度前缀的定长头部，key 和 value 按字节原样传输，可以包含空格、\r\n 和任意字节。
+ * 与文本协议共用端口：连接的第一个字节为 kRequestMagic 时按二进制协议处理
+ * （文本命令总是以字母开头），之后不再改变。
+ *
+ * 头部 16 字节，整数为网络字节序：
+ *   偏移  长度  请求           应答
+ *   0     1     magic 0x80     magic 0x81
+ *   1     1     opcode         status（StatusCode）
+ *   2     2     key 长度       0
+ *   4     4     value 长度     value 长度
+ *   8     4     request id     request id（原样带回）
+ *   12    4     extra          0
+ * 头部之后依次是 key 和 value。
+ *
+ * opcode 与 CommandType 的取值相同。支持 PUT（extra 为过期秒数，0 表示不过期）、
+ * GET、DEL、EXISTS、EXPIRE（extra 为秒数）、TTL、SIZE、CLEAR、PING、QUIT、BGSAVE、STATS；
+ * 其余命令的应答为 kError。应答的 value 即文本协议中 +OK / -ERROR 之后的内容
+ * （GET 为值本身）。
+ *
+ * 连接建立时服务器发送的欢迎行（+WELCOME ...\r\n）是文本，二进制客户端应先读掉这一行。
+ * 头部不合法（magic 不对或 value 超过 kMaxValueLength）时无法再找到帧边界，
+ * 服务器回复一个 request id 为 0 的 kError 后关闭连接。
+ */
+class BinaryCodec {
+public:
+    static constexpr uint8_t kRequestMagic = 0x80;
+    static constexpr uint8_t kResponseMagic = 0x81;
+    static constexpr size_t kHeaderSize = 16;
+    static constexpr uint32_t kMaxValueLength = 64 * 1024 * 1024;  // 与连接的高水位相同
+
+    /// 解析结果
+    enum class ParseResult {
+        kComplete,    // 得到一帧
+        kIncomplete,  // 数据不完整，等待更多数据
+        kInvalid,     // 头部不合法
+    };
+
+    /// 连接的第一个字节是否表示二进制协议
+    static bool isBinary(char firstByte) {
+        return static_cast<uint8_t>(firstByte) == kRequestMagic;
+    }
+
+    /**
+     * @brief 查看缓冲区开头的一帧，不取走数据
+     *
+     * 成功时 frame 指向 buf 内部，处理完后调用方 buf->retrieve(frame->size())。
+     */
+    static ParseResult peekFrame(const Buffer& buf, BinaryFrame* frame);
+
+    /**
+     * @brief 转换为 Request（拷贝 key / value，用于需要跨线程转发的请求）
+     * @return false opcode 不支持，request->command 为 kUnknown
+     */
+    static bool toRequest(const BinaryFrame& frame, Request* request);
+
+    /**
+     * @brief 从缓冲区取出一个请求
+     * @param requestId 输出请求 id
+     * @return 同 peekFrame；kInvalid 时不取走数据
+     */
+    static ParseResult parseRequest(Buffer* buf, Request* request, uint32_t* requestId);
+
+    /// 将应答编码到 output
+    static void encodeResponse(uint32_t requestId, const Response& response, Buffer* output);
+
+    /// 将 value 为 [data, data + len) 的应答直接编码到 output，不经过 Response
+    static void encodeValue(uint32_t requestId, StatusCode status, const char* data, size_t len,
+                            Buffer* output);
+
+private:
+    static uint16_t readUint16(const char* p) {
+        uint16_t be16 = 0;
+        ::memcpy(&be16, p, sizeof(be16));
+        return be16toh(be16);
+    }
+
+    static uint32_t readUint32(const char* p) {
+        uint32_t be32 = 0;
+        ::memcpy(&be32, p, sizeof(be32));
+        return be32toh(be32);
+    }
+
+    static void writeUint32(char* p, uint32_t x) {
+        uint32_t be32 = htobe32(x);
+        ::memcpy(p, &be32, sizeof(be32));
+    }
+};
+
+// ==================== 实现 ====================
+
+inline size_t BinaryFrame::size() const {
+    return BinaryCodec::kHeaderSize + keyLength + valueLength;
+}
+
+inline BinaryCodec::ParseResult BinaryCodec::peekFrame(const Buffer& buf, BinaryFrame* frame) {
+    if (buf.readableBytes() < kHeaderSize) {
+        return ParseResult::kIncomplete;
+    }
+    const char* header = buf.peek();
+    if (static_cast<uint8_t>(header[0]) != kRequestMagic) {
+        return ParseResult::kInvalid;
+    }
+    frame->opcode = static_cast<uint8_t>(header[1]);
+    frame->keyLength = readUint16(header + 2);
+    frame->valueLength = readUint32(header + 4);
+    frame->requestId = readUint32(header + 8);
+    frame->extra = readUint32(header + 12);
+    if (frame->valueLength > kMaxValueLength) {
+        return ParseResult::kInvalid;
+    }
+    if (buf.readableBytes() < frame->size()) {
+        return ParseResult::kIncomplete;
+    }
+    frame->key = header + kHeaderSize;
+    frame->value = frame->key + frame->keyLength;
+    return ParseResult::kComplete;
+}
+
+inline bool BinaryCodec::toRequest(const BinaryFrame& frame, Request* request) {
+    request->command = CommandType::kUnknown;
+    CommandType command = static_cast<CommandType>(frame.opcode);
+    switch (command) {
+        case CommandType::kPut:
+            request->value.assign(frame.value, frame.valueLength);
+            request->limit = frame.extra;
+            break;
+        case CommandType::kExpire:
+            request->limit = frame.extra;
+            break;
+        case CommandType::kGet:
+        case CommandType::kDel:
+        case CommandType::kExists:
+        case CommandType::kTtl:
+        case CommandType::kSize:
+        case CommandType::kClear:
+        case CommandType::kPing:
+        case CommandType::kQuit:
+        case CommandType::kBgSave:
+        case CommandType::kStats:
+            break;
+        default:
+            return false;
+    }
+    request->command = command;
+    request->key.assign(frame.key, frame.keyLength);
+    return true;
+}
+
+inline BinaryCodec::ParseResult BinaryCodec::parseRequest(Buffer* buf, Request* request,
+                                                          uint32_t* requestId) {
+    BinaryFrame frame;
+    ParseResult result = peekFrame(*buf, &frame);
+    if (result == ParseResult::kComplete) {
+        toRequest(frame, request);
+        *requestId = frame.requestId;
+        buf->retrieve(frame.size());
+    }
+    return result;
+}
+
+inline void BinaryCodec::encodeResponse(uint32_t requestId, const Response& response,
+                                        Buffer* output) {
+    encodeValue(requestId, response.status, response.message.data(), response.message.size(),
+                output);
+}
+
+inline void BinaryCodec::encodeValue(uint32_t requestId, StatusCode status, const char* data,
+                                     size_t len, Buffer* output) {
+    char header[kHeaderSize] = {};
+    header[0] = static_cast<char>(kResponseMagic);
+    header[1] = static_cast<char>(status);
+    writeUint32(header + 4, static_cast<uint32_t>(len));
+    writeUint32(header + 8, requestId);
+    output->ensureWritableBytes(kHeaderSize + len);
+    output->append(header, kHeaderSize);
+    output->append(data, len);
+}
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_PROTOCOL_BINARY_CODEC_H
@@ -3,17 +3,32 @@
 #define KVSTORE_PROTOCOL_CODEC_H
 
 #include "protocol/message.h"
+#include "base/string_piece.h"
 #include "net/buffer.h"
 #include "net/tcp_connection.h"
 
+#include <cstring>
 #include <string>
 #include <vector>
-#include <sstream>
-#include <algorithm>
-#include <cctype>
 
 namespace kvstore {
 
+/**
+ * @brief 文本协议的一个请求，key / value 指向输入缓冲区，不拷贝
+ *
+ * 与 BinaryFrame 一样只在缓冲区被修改（retrieve / append）之前有效。
+ * 同一个 RequestView 可以反复用于解析，tokens 的容量在请求之间复用。
+ * 各字段的含义同 Request；批量命令的 key / value 不单独拆出，从 tokens[1] 开始依次排列。
+ */
+struct RequestView {
+    CommandType command = CommandType::kUnknown;
+    StringPiece key;
+    StringPiece value;
+    size_t limit = 0;
+    std::vector<StringPiece> tokens;  // 空白分隔的各个词，tokens[0] 为命令名
+    size_t length = 0;                // 整行（含换行符）的字节数，处理完后 retrieve
+};
+
 /**
  * @brief 协议编解码器
  *
@@ -26,9 +41,25 @@ namespace kvstore {
  * 响应格式：
  *   +OK [value]\r\n    成功
  *   -ERROR message\r\n 失败
+ *
+ * SCAN 的 cursor：0 表示从头开始；服务器返回的 cursor 形如 "@key"，
+ * 表示下一次从 key（包含）继续。
  */
 class Codec {
 public:
+    static constexpr size_t kDefaultScanCount = 10;  // SCAN 未指定 COUNT 时的默认值
+
+    /**
+     * @brief 解析缓冲区开头的一行，不取走数据也不拷贝
+     *
+     * 处理完后调用方 buf->retrieve(view->length)。
+     * @return true 解析成功（命令不合法时 command 为 kUnknown），false 数据不完整需要继续等待
+     */
+    static bool peekRequest(const Buffer& buf, RequestView* view);
+
+    /// 转换为 Request（拷贝 key / value，用于需要跨线程转发或保存的请求）
+    static void toRequest(const RequestView& view, Request* request);
+
     /**
      * @brief 尝试从 Buffer 解析一个请求
      * @param buf 输入缓冲区
@@ -44,6 +75,12 @@ public:
      */
     static std::string encodeResponse(const Response& response);
 
+    /// 将响应直接编码到 output（通常是连接的输出缓冲区），不经过临时字符串
+    static void encodeResponse(const Response& response, Buffer* output);
+
+    /// 将值为 [data, data + len) 的成功响应（+OK value）直接编码到 output，不经过 Response
+    static void encodeValue(const char* data, size_t len, Buffer* output);
+
     /**
      * @brief 发送响应
      * @param conn TCP 连接
@@ -52,177 +89,303 @@ public:
     static void sendResponse(const TcpConnectionPtr& conn, const Response& response);
 
 private:
-    /// 解析命令行
-    static bool parseLine(const std::string& line, Request* request);
-
-    /// 分割字符串
-    static std::vector<std::string> split(const std::string& str);
+    /// 状态对应的前缀，withMessage 表示后面是否跟 message
+    static const char* statusPrefix(StatusCode status, bool* withMessage);
 
-    /// 转换为大写
-    static std::string toUpper(const std::string& str);
-};
+    /// 解析命令行（不含换行符）
+    static void parseLine(StringPiece line, RequestView* view);
 
-// ==================== 实现 ====================
+    /// 只带一个 key 的命令
+    static void parseKey(CommandType command, RequestView* view);
 
-inline bool Codec::parseRequest(Buffer* buf, Request* request) {
-    // 查找行结束符：支持 \r\n 和 \n
-    const char* lineEnd = nullptr;
-    const char* crlf = buf->findCRLF();
+    /// PUT key value [EX seconds]
+    static void parsePut(StringPiece line, RequestView* view);
 
-    // 也查找单独的 \n（兼容 nc 等工具）
-    const char* lf = static_cast<const char*>(
-        memchr(buf->peek(), '\n', buf->readableBytes()));
+    /// 按空白分割
+    static void split(StringPiece str, std::vector<StringPiece>* tokens);
 
-    // 取最早出现的换行符
-    if (crlf && lf) {
-        lineEnd = (crlf < lf) ? crlf : lf;
-    } else if (crlf) {
-        lineEnd = crlf;
-    } else if (lf) {
-        lineEnd = lf;
+    /// 与 isspace 相同的空白字符，不依赖 locale
+    static bool isSpace(char c) {
+        return c == ' ' || (c >= '\t' && c <= '\r');
     }
 
-    if (lineEnd == nullptr) {
+    /// 解析正整数（RANGE 的 LIMIT / SCAN 的 COUNT / 过期秒数）
+    static bool parseCount(StringPiece str, size_t* count);
+};
+
+// ==================== 实现 ====================
+
+inline bool Codec::peekRequest(const Buffer& buf, RequestView* view) {
+    // 支持 \r\n 和单独的 \n（兼容 nc 等工具）
+    const char* begin = buf.peek();
+    const char* lf = static_cast<const char*>(memchr(begin, '\n', buf.readableBytes()));
+    if (lf == nullptr) {
         // 没有找到完整的一行
         return false;
     }
+    const char* lineEnd = lf;
+    if (lineEnd > begin && lineEnd[-1] == '\r') {
+        lineEnd--;
+    }
+    view->length = lf + 1 - begin;
+    parseLine(StringPiece(begin, lineEnd - begin), view);
+    return true;
+}
 
-    // 提取一行（去掉可能的 \r）
-    size_t lineLen = lineEnd - buf->peek();
-    std::string line(buf->peek(), lineLen);
-
-    // 去掉行尾的 \r（如果有）
-    if (!line.empty() && line.back() == '\r') {
-        line.pop_back();
+inline bool Codec::parseRequest(Buffer* buf, Request* request) {
+    // tokens 的容量在同一线程的多次调用之间复用
+    static thread_local RequestView view;
+    if (!peekRequest(*buf, &view)) {
+        return false;
     }
+    toRequest(view, request);
+    buf->retrieve(view.length);
+    return true;
+}
 
-    // 计算需要跳过的字节数
-    // 如果 lineEnd 指向 \r，且下一个字符是 \n，跳过 2 字节
-    // 否则只跳过 1 字节（lineEnd 指向 \n）
-    size_t bytesToSkip = lineLen + 1;  // 默认跳过到 lineEnd 后一个字符
-    if (*lineEnd == '\r') {
-        // lineEnd 指向 \r，检查是否还有 \n
-        if (lineEnd + 1 < buf->peek() + buf->readableBytes() && *(lineEnd + 1) == '\n') {
-            bytesToSkip = lineLen + 2;  // 跳过 \r\n
+inline void Codec::toRequest(const RequestView& view, Request* request) {
+    request->command = view.command;
+    request->key.assign(view.key.data(), view.key.size());
+    request->value.assign(view.value.data(), view.value.size());
+    request->limit = view.limit;
+    request->keys.clear();
+    request->values.clear();
+    if (view.command == CommandType::kMGet || view.command == CommandType::kMDel) {
+        for (size_t i = 1; i < view.tokens.size(); i++) {
+            request->keys.push_back(view.tokens[i].toString());
+        }
+    } else if (view.command == CommandType::kMPut) {
+        for (size_t i = 1; i < view.tokens.size(); i += 2) {
+            request->keys.push_back(view.tokens[i].toString());
+            request->values.push_back(view.tokens[i + 1].toString());
         }
     }
-    buf->retrieve(bytesToSkip);
-
-    return parseLine(line, request);
 }
 
-inline bool Codec::parseLine(const std::string& line, Request* request) {
-    if (line.empty()) {
-        request->command = CommandType::kUnknown;
-        return true;
+inline void Codec::parseLine(StringPiece line, RequestView* view) {
+    view->command = CommandType::kUnknown;
+    view->key = StringPiece();
+    view->value = StringPiece();
+    view->limit = 0;
+    split(line, &view->tokens);
+    if (view->tokens.empty()) {
+        return;
     }
 
-    std::vector<std::string> parts = split(line);
-    if (parts.empty()) {
-        request->command = CommandType::kUnknown;
-        return true;
-    }
+    // 先按命令名的长度分支，再忽略大小写比较，不拷贝命令名
+    const std::vector<StringPiece>& parts = view->tokens;
+    const StringPiece cmd = parts[0];
+    const size_t n = parts.size();
+    switch (cmd.size()) {
+        case 3:
+            if (cmd.equalsIgnoreCase("PUT") || cmd.equalsIgnoreCase("SET")) {
+                parsePut(line, view);
+            } else if (cmd.equalsIgnoreCase("GET")) {
+                parseKey(CommandType::kGet, view);
+            } else if (cmd.equalsIgnoreCase("DEL")) {
+                parseKey(CommandType::kDel, view);
+            } else if (cmd.equalsIgnoreCase("TTL")) {
+                parseKey(CommandType::kTtl, view);
+            }
+            break;
 
-    std::string cmd = toUpper(parts[0]);
+        case 4:
+            if (cmd.equalsIgnoreCase("SIZE")) {
+                view->command = CommandType::kSize;
+            } else if (cmd.equalsIgnoreCase("PING")) {
+                view->command = CommandType::kPing;
+            } else if (cmd.equalsIgnoreCase("QUIT") || cmd.equalsIgnoreCase("EXIT")) {
+                view->command = CommandType::kQuit;
+            } else if (cmd.equalsIgnoreCase("INFO")) {
+                view->command = CommandType::kStats;
+            } else if (cmd.equalsIgnoreCase("MGET") || cmd.equalsIgnoreCase("MDEL")) {
+                // MGET / MDEL key [key ...]
+                if (n >= 2) {
+                    view->command = cmd.equalsIgnoreCase("MGET") ? CommandType::kMGet
+                                                                 : CommandType::kMDel;
+                }
+            } else if (cmd.equalsIgnoreCase("MPUT") || cmd.equalsIgnoreCase("MSET")) {
+                // MPUT key value [key value ...]
+                if (n >= 3 && n % 2 == 1) {
+                    view->command = CommandType::kMPut;
+                }
+            } else if (cmd.equalsIgnoreCase("SCAN")) {
+                // SCAN cursor [COUNT n]
+                view->limit = kDefaultScanCount;
+                bool countOk = n == 2 || (n == 4 && parts[2].equalsIgnoreCase("COUNT") &&
+                                          parseCount(parts[3], &view->limit));
+                if (countOk && (parts[1] == "0" || parts[1][0] == '@')) {
+                    view->command = CommandType::kScan;
+                    if (parts[1] != "0") {
+                        view->key = StringPiece(parts[1].data() + 1, parts[1].size() - 1);
+                    }
+                }
+            }
+            break;
 
-    if (cmd == "PUT" || cmd == "SET") {
-        if (parts.size() >= 3) {
-            request->command = CommandType::kPut;
-            request->key = parts[1];
-            // value 可能包含空格，取剩余所有部分
-            size_t valueStart = line.find(parts[1]) + parts[1].size();
-            while (valueStart < line.size() && std::isspace(line[valueStart])) {
-                valueStart++;
+        case 5:
+            if (cmd.equalsIgnoreCase("CLEAR")) {
+                view->command = CommandType::kClear;
+            } else if (cmd.equalsIgnoreCase("STATS")) {
+                view->command = CommandType::kStats;
+            } else if (cmd.equalsIgnoreCase("RANGE")) {
+                // RANGE start end [LIMIT n]
+                if (n == 3 || (n == 5 && parts[3].equalsIgnoreCase("LIMIT") &&
+                               parseCount(parts[4], &view->limit))) {
+                    view->command = CommandType::kRange;
+                    view->key = parts[1];
+                    view->value = parts[2];
+                }
             }
-            request->value = line.substr(valueStart);
-        } else {
-            request->command = CommandType::kUnknown;
-        }
-    } else if (cmd == "GET") {
-        if (parts.size() >= 2) {
-            request->command = CommandType::kGet;
-            request->key = parts[1];
-        } else {
-            request->command = CommandType::kUnknown;
-        }
-    } else if (cmd == "DEL" || cmd == "DELETE") {
-        if (parts.size() >= 2) {
-            request->command = CommandType::kDel;
-            request->key = parts[1];
-        } else {
-            request->command = CommandType::kUnknown;
-        }
-    } else if (cmd == "EXISTS") {
-        if (parts.size() >= 2) {
-            request->command = CommandType::kExists;
-            request->key = parts[1];
-        } else {
-            request->command = CommandType::kUnknown;
-        }
-    } else if (cmd == "SIZE" || cmd == "DBSIZE") {
-        request->command = CommandType::kSize;
-    } else if (cmd == "CLEAR" || cmd == "FLUSHDB") {
-        request->command = CommandType::kClear;
-    } else if (cmd == "PING") {
-        request->command = CommandType::kPing;
-    } else if (cmd == "QUIT" || cmd == "EXIT") {
-        request->command = CommandType::kQuit;
-    } else {
-        request->command = CommandType::kUnknown;
+            break;
+
+        case 6:
+            if (cmd.equalsIgnoreCase("DELETE")) {
+                parseKey(CommandType::kDel, view);
+            } else if (cmd.equalsIgnoreCase("EXISTS")) {
+                parseKey(CommandType::kExists, view);
+            } else if (cmd.equalsIgnoreCase("DBSIZE")) {
+                view->command = CommandType::kSize;
+            } else if (cmd.equalsIgnoreCase("BGSAVE")) {
+                view->command = CommandType::kBgSave;
+            } else if (cmd.equalsIgnoreCase("EXPIRE")) {
+                // EXPIRE key seconds，0 表示立即删除
+                if (n == 3 && (parts[2] == "0" || parseCount(parts[2], &view->limit))) {
+                    view->command = CommandType::kExpire;
+                    view->key = parts[1];
+                }
+            }
+            break;
+
+        case 7:
+            if (cmd.equalsIgnoreCase("FLUSHDB")) {
+                view->command = CommandType::kClear;
+            }
+            break;
+
+        default:
+            break;
     }
+}
 
-    return true;
+inline void Codec::parseKey(CommandType command, RequestView* view) {
+    if (view->tokens.size() >= 2) {
+        view->command = command;
+        view->key = view->tokens[1];
+    }
 }
 
-inline std::string Codec::encodeResponse(const Response& response) {
-    std::ostringstream oss;
+inline void Codec::parsePut(StringPiece line, RequestView* view) {
+    const std::vector<StringPiece>& parts = view->tokens;
+    const size_t n = parts.size();
+    if (n < 3) {
+        return;
+    }
+    view->command = CommandType::kPut;
+    view->key = parts[1];
+    // value 可能包含空格，取 key 之后的剩余部分
+    const char* valueEnd = line.end();
+    // PUT key value EX seconds：最后两个词是过期时间，不属于 value
+    if (n >= 5 && parts[n - 2].equalsIgnoreCase("EX") && parseCount(parts[n - 1], &view->limit)) {
+        valueEnd = parts[n - 2].data();
+        while (valueEnd > parts[2].data() && isSpace(valueEnd[-1])) {
+            valueEnd--;
+        }
+    }
+    view->value = StringPiece(parts[2].data(), valueEnd - parts[2].data());
+}
 
-    switch (response.status) {
+inline const char* Codec::statusPrefix(StatusCode status, bool* withMessage) {
+    *withMessage = false;
+    switch (status) {
         case StatusCode::kOk:
-            oss << "+OK";
-            if (!response.message.empty()) {
-                oss << " " << response.message;
-            }
-            break;
+            *withMessage = true;
+            return "+OK";
         case StatusCode::kNotFound:
-            oss << "-NOT_FOUND";
-            break;
+            return "-NOT_FOUND";
         case StatusCode::kError:
-            oss << "-ERROR";
-            if (!response.message.empty()) {
-                oss << " " << response.message;
-            }
-            break;
+            *withMessage = true;
+            return "-ERROR";
         case StatusCode::kPong:
-            oss << "+PONG";
-            break;
+            return "+PONG";
         case StatusCode::kBye:
-            oss << "+BYE";
-            break;
+            return "+BYE";
     }
+    return "-ERROR";
+}
 
-    oss << "\r\n";
-    return oss.str();
+inline std::string Codec::encodeResponse(const Response& response) {
+    bool withMessage = false;
+    std::string result = statusPrefix(response.status, &withMessage);
+    if (withMessage && !response.message.empty()) {
+        result.reserve(result.size() + response.message.size() + 3);
+        result += ' ';
+        result += response.message;
+    }
+    result += "\r\n";
+    return result;
+}
+
+inline void Codec::encodeResponse(const Response& response, Buffer* output) {
+    bool withMessage = false;
+    const char* prefix = statusPrefix(response.status, &withMessage);
+    output->append(prefix, strlen(prefix));
+    if (withMessage && !response.message.empty()) {
+        output->append(" ", 1);
+        output->append(response.message);
+    }
+    output->append("\r\n", 2);
+}
+
+inline void Codec::encodeValue(const char* data, size_t len, Buffer* output) {
+    output->ensureWritableBytes(len + 6);
+    if (len == 0) {
+        output->append("+OK\r\n", 5);
+        return;
+    }
+    output->append("+OK ", 4);
+    output->append(data, len);
+    output->append("\r\n", 2);
 }
 
 inline void Codec::sendResponse(const TcpConnectionPtr& conn, const Response& response) {
     conn->send(encodeResponse(response));
 }
 
-inline std::vector<std::string> Codec::split(const std::string& str) {
-    std::vector<std::string> result;
-    std::istringstream iss(str);
-    std::string token;
-    while (iss >> token) {
-        result.push_back(token);
+inline void Codec::split(StringPiece str, std::vector<StringPiece>* tokens) {
+    tokens->clear();
+    const char* p = str.begin();
+    const char* end = str.end();
+    while (p < end) {
+        while (p < end && isSpace(*p)) {
+            p++;
+        }
+        const char* token = p;
+        while (p < end && !isSpace(*p)) {
+            p++;
+        }
+        if (p > token) {
+            tokens->emplace_back(token, p - token);
+        }
     }
-    return result;
 }
 
-inline std::string Codec::toUpper(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(), ::toupper);
-    return result;
+inline bool Codec::parseCount(StringPiece str, size_t* count) {
+    if (str.empty() || str.size() > 9) {
+        return false;
+    }
+    size_t n = 0;
+    for (char c : str) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        n = n * 10 + (c - '0');
+    }
+    if (n == 0) {
+        return false;
+    }
+    *count = n;
+    return true;
 }
 
 }  // namespace kvstore
@@ -3,6 +3,8 @@
 #define KVSTORE_PROTOCOL_MESSAGE_H
 
 #include <string>
+#include <vector>
+#include <cstddef>
 #include <cstdint>
 
 namespace kvstore {
@@ -20,6 +22,25 @@ enum class CommandType : uint8_t {
     kClear = 6,    // CLEAR
     kPing = 7,     // PING
     kQuit = 8,     // QUIT
+    kRange = 9,    // RANGE start end [LIMIT n]
+    kScan = 10,    // SCAN cursor [COUNT n]
+    kBgSave = 11,  // BGSAVE
+    kStats = 12,   // STATS
+    kExpire = 13,  // EXPIRE key seconds
+    kTtl = 14,     // TTL key
+    kMGet = 15,    // MGET key [key ...]
+    kMPut = 16,    // MPUT key value [key value ...]
+    kMDel = 17,    // MDEL key [key ...]
+};
+
+/**
+ * @brief 连接使用的协议，由连接的第一个字节决定
+ */
+enum class WireProtocol : uint8_t {
+    kUnknown = 0,  // 还没有收到数据
+    kText = 1,     // 文本协议（见 Codec）
+    kBinary = 2,   // 长度前缀的二进制协议（见 BinaryCodec）
+    kResp = 3,     // Redis 序列化协议（见 RespCodec）
 };
 
 /**
@@ -37,7 +58,7 @@ enum class StatusCode : uint8_t {
  * @brief 请求消息
  *
  * 协议格式（文本协议，类似 Redis）：
- *   PUT key value\r\n
+ *   PUT key value [EX seconds]\r\n  // 带 EX 时 seconds 秒后过期
  *   GET key\r\n
  *   DEL key\r\n
  *   EXISTS key\r\n
@@ -45,16 +66,32 @@ enum class StatusCode : uint8_t {
  *   CLEAR\r\n
  *   PING\r\n
  *   QUIT\r\n
+ *   RANGE start end [LIMIT n]\r\n   // key 在 [start, end] 内，按 key 升序
+ *   SCAN cursor [COUNT n]\r\n       // cursor 为 0 表示从头开始
+ *   BGSAVE\r\n                      // 在后台保存快照
+ *   STATS\r\n                       // 运行统计，一行 name=value
+ *   EXPIRE key seconds\r\n          // 设置过期时间，0 表示立即删除
+ *   TTL key\r\n                     // 剩余秒数，-1 表示没有过期时间
+ *   MGET key [key ...]\r\n          // 批量读取
+ *   MPUT key value [key value ...]\r\n  // 批量写入（value 不能含空格）
+ *   MDEL key [key ...]\r\n          // 批量删除
+ *
+ * RANGE 解析后 key 为 start，value 为 end；SCAN 解析后 key 为起始 key
+ * （从头开始时为空），limit 为 COUNT。PUT ... EX 和 EXPIRE 的秒数也放在 limit 中
+ * （PUT 没有 EX 时为 0）。批量命令的 key 和 value 放在 keys / values 中，一一对应。
  */
 struct Request {
     CommandType command;
     std::string key;
     std::string value;
+    size_t limit;  // RANGE 的 LIMIT（0 表示不限）/ SCAN 的 COUNT / PUT、EXPIRE 的秒数
+    std::vector<std::string> keys;    // MGET / MPUT / MDEL 的 key
+    std::vector<std::string> values;  // MPUT 的 value
 
-    Request() : command(CommandType::kUnknown) {}
+    Request() : command(CommandType::kUnknown), limit(0) {}
 
     Request(CommandType cmd, const std::string& k = "", const std::string& v = "")
-        : command(cmd), key(k), value(v) {}
+        : command(cmd), key(k), value(v), limit(0) {}
 };
 
 /**
@@ -67,6 +104,17 @@ struct Request {
  *   -ERROR message\r\n        // 错误
  *   +PONG\r\n                 // PING 响应
  *   +BYE\r\n                  // QUIT 响应
+ *
+ * RANGE / SCAN 的响应是多行的，每个键值对一行，最后一行是状态：
+ *   =key value\r\n            // 每个键值对一行，按 key 升序
+ *   +OK count\r\n             // RANGE：返回的条数
+ *   +OK cursor\r\n            // SCAN：下一次的 cursor，0 表示遍历结束
+ *
+ * MGET 按请求中 key 的顺序每个 key 一行，最后一行是状态：
+ *   =key value\r\n            // key 存在
+ *   _key\r\n                  // key 不存在
+ *   +OK count\r\n             // 存在的 key 数
+ * MPUT / MDEL 只有一行：+OK count（新增 / 删除的 key 数）。
  */
 struct Response {
     StatusCode status;
@@ -112,6 +160,15 @@ inline const char* commandToString(CommandType cmd) {
         case CommandType::kClear: return "CLEAR";
         case CommandType::kPing: return "PING";
         case CommandType::kQuit: return "QUIT";
+        case CommandType::kRange: return "RANGE";
+        case CommandType::kScan: return "SCAN";
+        case CommandType::kBgSave: return "BGSAVE";
+        case CommandType::kStats: return "STATS";
+        case CommandType::kExpire: return "EXPIRE";
+        case CommandType::kTtl: return "TTL";
+        case CommandType::kMGet: return "MGET";
+        case CommandType::kMPut: return "MPUT";
+        case CommandType::kMDel: return "MDEL";
         default: return "UNKNOWN";
     }
 }
@@ -0,0 +1,589 @@
+// src/protocol/resp_codec.h
+#ifndef KVSTORE_PROTOCOL_RESP_CODEC_H
+#define KVSTORE_PROTOCOL_RESP_CODEC_H
+
+#include "protocol/message.h"
+#include "base/timestamp.h"
+#include "net/buffer.h"
+
+#include <strings.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kvstore {
+
+/**
+ * @brief RESP 命令的应答方式
+ *
+ * 同一个 CommandType 在 RESP 中的应答可能不同（如 DEL 返回整数、SET 返回 +OK），
+ * 解析时记下原来的命令，编码应答时使用。
+ */
+enum class RespCommand : uint8_t {
+    kUnknown = 0,
+    kGet,      // GET key                  -> 批量字符串 / null
+    kSet,      // SET key value [EX s]     -> +OK
+    kDel,      // DEL key [key ...]        -> 删除的个数
+    kExists,   // EXISTS key [key ...]     -> 存在的个数（重复的 key 重复计数）
+    kMGet,     // MGET key [key ...]       -> 数组
+    kMSet,     // MSET key value [...]     -> +OK
+    kDbSize,   // DBSIZE                   -> 整数
+    kFlushDb,  // FLUSHDB / FLUSHALL       -> +OK
+    kPing,     // PING                     -> +PONG
+    kExpire,   // EXPIRE key seconds       -> 1 / 0
+    kTtl,      // TTL key                  -> 秒数，-1 没有过期时间，-2 不存在
+    kInfo,     // INFO                     -> 批量字符串
+    kBgSave,   // BGSAVE                   -> 状态字符串
+    kQuit,     // QUIT                     -> +OK 后关闭连接
+};
+
+/**
+ * @brief RESP（Redis 序列化协议）编解码器
+ *
+ * 让 redis-cli、redis-benchmark 和现有的 Redis 客户端库可以直接访问服务器。
+ * 请求可以是批量字符串数组（*N\r\n$len\r\n...\r\n），也可以是内联命令
+ * （一行，空白分隔，不支持引号）。value 按字节原样传输。
+ *
+ * 支持 GET、SET（可带 EX）、DEL、EXISTS、MGET、MSET、DBSIZE、FLUSHDB/FLUSHALL、PING、ECHO、
+ * EXPIRE、TTL、INFO、BGSAVE、QUIT，映射到 KVStore 的对应操作。
+ * 为了兼容客户端的握手，HELLO、COMMAND、CONFIG GET、CLIENT、SELECT 0 直接应答：
+ * HELLO 2 / HELLO 3 切换连接的协议版本，RESP3 下 null 编码为 _，HELLO 的应答为 map；
+ * COMMAND 和 CONFIG GET 返回空集合。
+ *
+ * 请求格式错误时无法再找到命令的边界，服务器回复 -ERR Protocol error 后关闭连接。
+ */
+class RespCodec {
+public:
+    static constexpr size_t kMaxInlineLength = 64 * 1024;          // 内联命令一行的上限
+    static constexpr int64_t kMaxBulkLength = 64 * 1024 * 1024;    // 与连接的高水位相同
+    static constexpr int64_t kMaxArguments = 1024 * 1024;
+
+    /// 解析结果
+    enum class ParseResult {
+        kComplete,    // 得到一条命令
+        kIncomplete,  // 数据不完整，等待更多数据
+        kInvalid,     // 格式错误
+    };
+
+    /**
+     * @brief 从 Buffer 取出一条命令（跳过空命令）
+     *
+     * 数据不完整时不取走任何数据；数组只在整条命令到齐后才拷贝参数。
+     */
+    static ParseResult parseCommand(Buffer* buf, std::vector<std::string>* args);
+
+    /**
+     * @brief 把命令转换为 Request
+     *
+     * @param resp3 连接当前是否使用 RESP3，HELLO 会修改它
+     * @param command 输出应答方式
+     * @param reply 不需要访问存储的命令（HELLO、ECHO、参数错误等）直接把应答写入 reply
+     * @return true 需要执行 request，false 应答已经写入 reply
+     */
+    static bool toRequest(const std::vector<std::string>& args, bool* resp3, Request* request,
+                          RespCommand* command, Buffer* reply);
+
+    /// 按命令的应答方式编码 Response
+    static void encodeResponse(RespCommand command, bool resp3, const Response& response,
+                               Buffer* output);
+
+    /**
+     * @brief 编码批量命令的应答（MGET、MSET 和多个 key 的 DEL / EXISTS）
+     * @tparam V 有 data() / size() 的值类型（如 Value）
+     */
+    template <typename V>
+    static void encodeBatch(RespCommand command, bool resp3, const std::vector<V>& values,
+                            const std::vector<bool>& found, size_t count, Buffer* output);
+
+    // ==================== 基本类型 ====================
+
+    static void appendSimple(const char* str, Buffer* output) {
+        output->append("+", 1);
+        output->append(str, strlen(str));
+        output->append("\r\n", 2);
+    }
+
+    static void appendError(const std::string& message, Buffer* output) {
+        output->append("-ERR ", 5);
+        output->append(message);
+        output->append("\r\n", 2);
+    }
+
+    static void appendInteger(int64_t n, Buffer* output) {
+        output->append(":", 1);
+        appendDecimal(n, output);
+        output->append("\r\n", 2);
+    }
+
+    static void appendBulk(const char* data, size_t len, Buffer* output) {
+        output->append("$", 1);
+        appendDecimal(static_cast<int64_t>(len), output);
+        output->append("\r\n", 2);
+        output->append(data, len);
+        output->append("\r\n", 2);
+    }
+
+    static void appendNull(bool resp3, Buffer* output) {
+        if (resp3) {
+            output->append("_\r\n", 3);
+        } else {
+            output->append("$-1\r\n", 5);
+        }
+    }
+
+    /// 数组头部，之后跟 n 个元素
+    static void appendArray(size_t n, Buffer* output) {
+        output->append("*", 1);
+        appendDecimal(n, output);
+        output->append("\r\n", 2);
+    }
+
+    /// map 头部（RESP2 为 2n 个元素的数组），之后跟 n 对键值
+    static void appendMap(size_t n, bool resp3, Buffer* output) {
+        output->append(resp3 ? "%" : "*", 1);
+        appendDecimal(static_cast<int64_t>(resp3 ? n : n * 2), output);
+        output->append("\r\n", 2);
+    }
+
+    /// 十进制整数，直接写入 output，不经过 std::string
+    static void appendDecimal(int64_t n, Buffer* output) {
+        char buf[24];
+        char* end = buf + sizeof(buf);
+        char* p = end;
+        uint64_t u = n < 0 ? 0 - static_cast<uint64_t>(n) : static_cast<uint64_t>(n);
+        do {
+            *--p = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u != 0);
+        if (n < 0) {
+            *--p = '-';
+        }
+        output->append(p, end - p);
+    }
+
+private:
+    /// 内联命令：一行，空白分隔
+    static ParseResult parseInline(Buffer* buf, std::vector<std::string>* args);
+
+    /// 解析 [begin, end) 内的十进制整数（可以有负号）
+    static bool parseInteger(const char* begin, const char* end, int64_t* n);
+
+    /// 过期秒数换算成绝对时刻（当前毫秒 + seconds * 1000）不会溢出 int64
+    static bool validExpireSeconds(int64_t seconds);
+
+    /// [begin, end) 内第一个 \r\n 的位置
+    static const char* findCRLF(const char* begin, const char* end);
+
+    /// 命令名是否等于 name（name 为大写，忽略大小写比较）
+    static bool commandIs(const std::string& arg, const char* name);
+
+    /// HELLO [protover ...]
+    static void hello(const std::vector<std::string>& args, bool* resp3, Buffer* reply);
+
+    /// 参数个数错误
+    static void appendArityError(const std::string& name, Buffer* output) {
+        appendError("wrong number of arguments for '" + name + "' command", output);
+    }
+};
+
+// ==================== 实现 ====================
+
+inline RespCodec::ParseResult RespCodec::parseCommand(Buffer* buf,
+                                                      std::vector<std::string>* args) {
+    while (buf->readableBytes() > 0) {
+        args->clear();
+        if (*buf->peek() != '*') {
+            ParseResult result = parseInline(buf, args);
+            if (result != ParseResult::kComplete || !args->empty()) {
+                return result;
+            }
+            continue;  // 空行
+        }
+
+        const char* begin = buf->peek();
+        const char* end = begin + buf->readableBytes();
+        const char* lineEnd = findCRLF(begin, end);
+        if (lineEnd == nullptr) {
+            return buf->readableBytes() > kMaxInlineLength ? ParseResult::kInvalid
+                                                           : ParseResult::kIncomplete;
+        }
+        int64_t count = 0;
+        if (!parseInteger(begin + 1, lineEnd, &count) || count > kMaxArguments) {
+            return ParseResult::kInvalid;
+        }
+
+        // 先定位所有参数，整条命令到齐之后再拷贝
+        std::vector<std::pair<const char*, size_t>> spans;
+        spans.reserve(static_cast<size_t>(count > 0 ? std::min<int64_t>(count, 64) : 0));
+        const char* p = lineEnd + 2;
+        for (int64_t i = 0; i < count; i++) {
+            if (p == end) {
+                return ParseResult::kIncomplete;
+            }
+            if (*p != '$') {
+                return ParseResult::kInvalid;
+            }
+            lineEnd = findCRLF(p, end);
+            if (lineEnd == nullptr) {
+                return end - p > 32 ? ParseResult::kInvalid : ParseResult::kIncomplete;
+            }
+            int64_t len = 0;
+            if (!parseInteger(p + 1, lineEnd, &len) || len < 0 || len > kMaxBulkLength) {
+                return ParseResult::kInvalid;
+            }
+            p = lineEnd + 2;
+            if (end - p < len + 2) {
+                return ParseResult::kIncomplete;
+            }
+            if (p[len] != '\r' || p[len + 1] != '\n') {
+                return ParseResult::kInvalid;
+            }
+            spans.emplace_back(p, static_cast<size_t>(len));
+            p += len + 2;
+        }
+
+        args->reserve(spans.size());
+        for (const auto& span : spans) {
+            args->emplace_back(span.first, span.second);
+        }
+        buf->retrieve(p - begin);
+        if (!args->empty()) {
+            return ParseResult::kComplete;
+        }
+        // *0 / *-1：空命令，跳过
+    }
+    return ParseResult::kIncomplete;
+}
+
+inline RespCodec::ParseResult RespCodec::parseInline(Buffer* buf,
+                                                     std::vector<std::string>* args) {
+    const char* begin = buf->peek();
+    const char* lf = static_cast<const char*>(memchr(begin, '\n', buf->readableBytes()));
+    if (lf == nullptr) {
+        return buf->readableBytes() > kMaxInlineLength ? ParseResult::kInvalid
+                                                       : ParseResult::kIncomplete;
+    }
+    const char* p = begin;
+    while (p < lf) {
+        while (p < lf && (*p == ' ' || *p == '\t' || *p == '\r')) {
+            p++;
+        }
+        const char* token = p;
+        while (p < lf && *p != ' ' && *p != '\t' && *p != '\r') {
+            p++;
+        }
+        if (p > token) {
+            args->emplace_back(token, p - token);
+        }
+    }
+    buf->retrieve(lf + 1 - begin);
+    return ParseResult::kComplete;
+}
+
+inline bool RespCodec::validExpireSeconds(int64_t seconds) {
+    const int64_t nowMs = Timestamp::now().microSecondsSinceEpoch() / 1000;
+    return seconds <= (std::numeric_limits<int64_t>::max() - nowMs) / 1000;
+}
+
+inline bool RespCodec::parseInteger(const char* begin, const char* end, int64_t* n) {
+    bool negative = begin < end && *begin == '-';
+    if (negative) {
+        begin++;
+    }
+    if (begin == end || end - begin > 18) {
+        return false;
+    }
+    int64_t value = 0;
+    for (const char* p = begin; p < end; p++) {
+        if (*p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    *n = negative ? -value : value;
+    return true;
+}
+
+inline const char* RespCodec::findCRLF(const char* begin, const char* end) {
+    const char* p = begin;
+    while (p < end) {
+        const char* cr = static_cast<const char*>(memchr(p, '\r', end - p));
+        if (cr == nullptr || cr + 1 == end) {
+            return nullptr;
+        }
+        if (cr[1] == '\n') {
+            return cr;
+        }
+        p = cr + 1;
+    }
+    return nullptr;
+}
+
+inline bool RespCodec::commandIs(const std::string& arg, const char* name) {
+    return strcasecmp(arg.c_str(), name) == 0;
+}
+
+inline bool RespCodec::toRequest(const std::vector<std::string>& args, bool* resp3,
+                                 Request* request, RespCommand* command, Buffer* reply) {
+    const std::string& name = args[0];
+    const size_t argc = args.size();
+    request->command = CommandType::kUnknown;
+    *command = RespCommand::kUnknown;
+
+    // 需要访问存储的命令
+    if (commandIs(name, "GET")) {
+        if (argc != 2) {
+            appendArityError(name, reply);
+            return false;
+        }
+        *command = RespCommand::kGet;
+        request->command = CommandType::kGet;
+        request->key = args[1];
+        return true;
+    }
+    if (commandIs(name, "SET")) {
+        int64_t seconds = 0;
+        if (argc == 5 && commandIs(args[3], "EX")) {
+            if (!parseInteger(args[4].data(), args[4].data() + args[4].size(), &seconds) ||
+                seconds <= 0 || !validExpireSeconds(seconds)) {
+                appendError("invalid expire time in 'set' command", reply);
+                return false;
+            }
+        } else if (argc != 3) {
+            appendError(argc < 3 ? "wrong number of arguments for 'set' command"
+                                 : "syntax error",
+                        reply);
+            return false;
+        }
+        *command = RespCommand::kSet;
+        request->command = CommandType::kPut;
+        request->key = args[1];
+        request->value = args[2];
+        request->limit = static_cast<size_t>(seconds);
+        return true;
+    }
+    if (commandIs(name, "DEL") || commandIs(name, "EXISTS")) {
+        if (argc < 2) {
+            appendArityError(name, reply);
+            return false;
+        }
+        const bool del = commandIs(name, "DEL");
+        *command = del ? RespCommand::kDel : RespCommand::kExists;
+        if (argc == 2) {
+            request->command = del ? CommandType::kDel : CommandType::kExists;
+            request->key = args[1];
+        } else {
+            // 多个 key：批量删除，或批量读取后计数
+            request->command = del ? CommandType::kMDel : CommandType::kMGet;
+            request->keys.assign(args.begin() + 1, args.end());
+        }
+        return true;
+    }
+    if (commandIs(name, "MGET")) {
+        if (argc < 2) {
+            appendArityError(name, reply);
+            return false;
+        }
+        *command = RespCommand::kMGet;
+        request->command = CommandType::kMGet;
+        request->keys.assign(args.begin() + 1, args.end());
+        return true;
+    }
+    if (commandIs(name, "MSET")) {
+        if (argc < 3 || argc % 2 == 0) {
+            appendArityError(name, reply);
+            return false;
+        }
+        *command = RespCommand::kMSet;
+        request->command = CommandType::kMPut;
+        for (size_t i = 1; i < argc; i += 2) {
+            request->keys.push_back(args[i]);
+            request->values.push_back(args[i + 1]);
+        }
+        return true;
+    }
+    if (commandIs(name, "DBSIZE")) {
+        *command = RespCommand::kDbSize;
+        request->command = CommandType::kSize;
+        return true;
+    }
+    if (commandIs(name, "FLUSHDB") || commandIs(name, "FLUSHALL")) {
+        *command = RespCommand::kFlushDb;
+        request->command = CommandType::kClear;
+        return true;
+    }
+    if (commandIs(name, "EXPIRE")) {
+        int64_t seconds = 0;
+        if (argc != 3) {
+            appendArityError(name, reply);
+            return false;
+        }
+        if (!parseInteger(args[2].data(), args[2].data() + args[2].size(), &seconds)) {
+            appendError("value is not an integer or out of range", reply);
+            return false;
+        }
+        if (!validExpireSeconds(seconds)) {
+            appendError("invalid expire time in 'expire' command", reply);
+            return false;
+        }
+        *command = RespCommand::kExpire;
+        request->command = CommandType::kExpire;
+        request->key = args[1];
+        request->limit = static_cast<size_t>(seconds > 0 ? seconds : 0);  // 非正数立即删除
+        return true;
+    }
+    if (commandIs(name, "TTL")) {
+        if (argc != 2) {
+            appendArityError(name, reply);
+            return false;
+        }
+        *command = RespCommand::kTtl;
+        request->command = CommandType::kTtl;
+        request->key = args[1];
+        return true;
+    }
+    if (commandIs(name, "INFO")) {
+        *command = RespCommand::kInfo;
+        request->command = CommandType::kStats;
+        return true;
+    }
+    if (commandIs(name, "BGSAVE")) {
+        *command = RespCommand::kBgSave;
+        request->command = CommandType::kBgSave;
+        return true;
+    }
+    if (commandIs(name, "QUIT")) {
+        *command = RespCommand::kQuit;
+        request->command = CommandType::kQuit;
+        return true;
+    }
+    if (commandIs(name, "PING") && argc == 1) {
+        *command = RespCommand::kPing;
+        request->command = CommandType::kPing;
+        return true;
+    }
+
+    // 直接应答的命令
+    if (commandIs(name, "PING") || commandIs(name, "ECHO")) {
+        if (argc != 2) {
+            appendArityError(name, reply);
+        } else {
+            appendBulk(args[1].data(), args[1].size(), reply);
+        }
+    } else if (commandIs(name, "HELLO")) {
+        hello(args, resp3, reply);
+    } else if (commandIs(name, "COMMAND")) {
+        appendArray(0, reply);
+    } else if (commandIs(name, "CONFIG") && argc >= 2 && commandIs(args[1], "GET")) {
+        appendMap(0, *resp3, reply);
+    } else if (commandIs(name, "CLIENT")) {
+        appendSimple("OK", reply);
+    } else if (commandIs(name, "SELECT")) {
+        if (argc == 2 && args[1] == "0") {
+            appendSimple("OK", reply);
+        } else {
+            appendError("DB index is out of range", reply);
+        }
+    } else {
+        appendError("unknown command '" + name + "'", reply);
+    }
+    return false;
+}
+
+inline void RespCodec::hello(const std::vector<std::string>& args, bool* resp3, Buffer* reply) {
+    if (args.size() >= 2) {
+        if (args[1] != "2" && args[1] != "3") {
+            reply->append("-NOPROTO unsupported protocol version\r\n");
+            return;
+        }
+        *resp3 = args[1] == "3";
+    }
+    appendMap(3, *resp3, reply);
+    appendBulk("server", 6, reply);
+    appendBulk("reactorkv", 9, reply);
+    appendBulk("proto", 5, reply);
+    appendInteger(*resp3 ? 3 : 2, reply);
+    appendBulk("mode", 4, reply);
+    appendBulk("standalone", 10, reply);
+}
+
+inline void RespCodec::encodeResponse(RespCommand command, bool resp3, const Response& response,
+                                      Buffer* output) {
+    if (response.status == StatusCode::kError) {
+        appendError(response.message, output);
+        return;
+    }
+    const bool found = response.status != StatusCode::kNotFound;
+    switch (command) {
+        case RespCommand::kGet:
+            if (found) {
+                appendBulk(response.message.data(), response.message.size(), output);
+            } else {
+                appendNull(resp3, output);
+            }
+            break;
+        case RespCommand::kDel:
+        case RespCommand::kExpire:
+            appendInteger(found ? 1 : 0, output);
+            break;
+        case RespCommand::kExists:
+        case RespCommand::kDbSize:
+            output->append(":", 1);
+            output->append(response.message);
+            output->append("\r\n", 2);
+            break;
+        case RespCommand::kTtl:
+            if (found) {
+                output->append(":", 1);
+                output->append(response.message);
+                output->append("\r\n", 2);
+            } else {
+                appendInteger(-2, output);
+            }
+            break;
+        case RespCommand::kPing:
+            appendSimple("PONG", output);
+            break;
+        case RespCommand::kInfo:
+            appendBulk(response.message.data(), response.message.size(), output);
+            break;
+        case RespCommand::kBgSave:
+            appendSimple(response.message.c_str(), output);
+            break;
+        default:
+            appendSimple("OK", output);
+            break;
+    }
+}
+
+template <typename V>
+void RespCodec::encodeBatch(RespCommand command, bool resp3, const std::vector<V>& values,
+                            const std::vector<bool>& found, size_t count, Buffer* output) {
+    switch (command) {
+        case RespCommand::kMGet:
+            appendArray(found.size(), output);
+            for (size_t i = 0; i < found.size(); i++) {
+                if (found[i]) {
+                    appendBulk(values[i].data(), values[i].size(), output);
+                } else {
+                    appendNull(resp3, output);
+                }
+            }
+            break;
+        case RespCommand::kMSet:
+            appendSimple("OK", output);
+            break;
+        default:
+            appendInteger(static_cast<int64_t>(count), output);
+            break;
+    }
+}
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_PROTOCOL_RESP_CODEC_H
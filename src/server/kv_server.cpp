@@ -1,31 +1,243 @@
 // src/server/kv_server.cpp
 #include "server/kv_server.h"
+#include "net/eventloop_thread_pool.h"
 #include "base/logger.h"
 
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <limits>
+#include <map>
+
 namespace kvstore {
 
-KVServer::KVServer(EventLoop* loop, uint16_t port, const std::string& name)
+namespace {
+
+/// 将当前线程绑定到指定 CPU
+void pinCurrentThread(int cpu) {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(cpu, &cpuset);
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset);
+    if (ret != 0) {
+        LOG_WARN << "pthread_setaffinity_np cpu=" << cpu << " failed, errno=" << ret;
+    } else {
+        LOG_INFO << "IO thread pinned to cpu " << cpu;
+    }
+}
+
+/// 会修改数据、需要写 WAL 的命令
+bool isWriteCommand(CommandType command) {
+    return command == CommandType::kPut || command == CommandType::kDel ||
+           command == CommandType::kClear || command == CommandType::kExpire ||
+           command == CommandType::kMPut || command == CommandType::kMDel;
+}
+
+/// WAL 写入失败时写请求的应答
+const char kLogFailedError[] = "Write-ahead log failed, write not persisted";
+
+/// 主动过期：定时器间隔、每批检查的 key 数和每个分片每次最多检查的批数
+const double kExpiryIntervalSeconds = 0.1;
+const size_t kExpiryBatchKeys = 200;
+const int kExpiryRounds = 16;
+
+/// shard-per-core：RANGE/SCAN 每次从一个分片取回的条数
+const size_t kScanPartKeys = 256;
+
+/// shard-per-core 下 RANGE/SCAN 的一个分片：所属线程遍历出的一批结果，由连接所在线程归并
+struct ScanPart {
+    std::vector<std::pair<std::string, Value>> entries;  // 按 key 升序
+    size_t next = 0;    // 下一条要归并的
+    bool done = false;  // 分片中已经没有更多结果
+};
+
+/// 批量命令：结果直接编码进输出缓冲，不经过 Response
+bool isBatchCommand(CommandType command) {
+    return command == CommandType::kMGet || command == CommandType::kMPut ||
+           command == CommandType::kMDel;
+}
+
+/// 按 format 编码一个应答
+void appendResponse(const ReplyFormat& format, const Response& response, Buffer* output) {
+    switch (format.protocol) {
+        case WireProtocol::kBinary:
+            BinaryCodec::encodeResponse(format.requestId, response, output);
+            break;
+        case WireProtocol::kResp:
+            RespCodec::encodeResponse(format.respCommand, format.resp3, response, output);
+            break;
+        default:
+            Codec::encodeResponse(response, output);
+            break;
+    }
+}
+
+/// 批量命令的应答：文本协议中 MGET 每个 key 一行（=key value 或 _key），最后是 +OK count
+void appendBatchResponse(const Request& request, const ReplyFormat& format,
+                         const std::vector<Value>& values, const std::vector<bool>& found,
+                         size_t count, Buffer* output) {
+    if (format.protocol == WireProtocol::kResp) {
+        RespCodec::encodeBatch(format.respCommand, format.resp3, values, found, count, output);
+        return;
+    }
+    if (request.command == CommandType::kMGet) {
+        for (size_t i = 0; i < request.keys.size(); i++) {
+            if (found[i]) {
+                output->append("=", 1);
+                output->append(request.keys[i]);
+                output->append(" ", 1);
+                output->append(values[i].data(), values[i].size());
+            } else {
+                output->append("_", 1);
+                output->append(request.keys[i]);
+            }
+            output->append("\r\n", 2);
+        }
+    }
+    Codec::encodeResponse(Response::ok(std::to_string(count)), output);
+}
+
+}  // namespace
+
+/**
+ * @brief 进行中的 RANGE/SCAN，只在连接所在线程中访问
+ *
+ * 遍历因输出缓冲区积压而暂停后，从 last 之后继续。
+ */
+struct KVServer::ScanState {
+    ScanState(uint64_t scanSeq, const Request& scanRequest) : seq(scanSeq), request(scanRequest) {}
+
+    uint64_t seq;        // 请求序号，shard-per-core 下丢弃遍历结束之后才返回的分片结果
+    Request request;
+    std::string last;    // 已经输出的最后一个 key
+    size_t emitted = 0;  // 已经输出的条数
+    std::vector<ScanPart> parts;  // shard-per-core：每个分片取回的一批结果
+    size_t fetching = 0;          // shard-per-core：已经请求、还没有返回的分片数
+};
+
+/**
+ * @brief 每个连接的状态，只在连接所在线程中访问
+ *
+ * protocol 在收到第一个字节时确定，resp3 由 HELLO 切换。其余字段只用于 shard-per-core 模式：
+ * 每个请求按到达顺序分配序号；响应就绪后先放入 ready，
+ * 只有序号等于 nextToSend 的响应才能发出，从而保证转发后响应仍然有序。
+ */
+struct KVServer::ConnectionState {
+    WireProtocol protocol = WireProtocol::kUnknown;
+    bool resp3 = false;
+    std::deque<ReplyFormat> formats;                 // 二进制协议 / RESP：尚未应答的请求的编码方式
+    size_t loopIndex = 0;                            // 连接所在 IO 线程下标
+    uint64_t nextSeq = 0;                            // 下一个请求的序号
+    uint64_t nextToSend = 0;                         // 下一个待发送响应的序号
+    uint64_t quitSeq = std::numeric_limits<uint64_t>::max();  // QUIT 请求的序号
+    std::map<uint64_t, Response> ready;              // 已就绪、尚未发送的响应
+    std::map<uint64_t, Request> scans;               // 屏障已完成、轮到时再执行的 RANGE/SCAN
+    std::map<uint64_t, std::string> encoded;         // 已经编码好的应答（批量命令、不需要执行的请求）
+    std::unique_ptr<ScanState> scan;                 // 正在输出的 RANGE/SCAN（两种执行模型都用）
+};
+
+KVServer::KVServer(EventLoop* loop, uint16_t port, const std::string& name,
+                   const KVStoreOptions& storeOptions)
     : loop_(loop),
       server_(loop, InetAddress(port), name),
-      store_() {
+      store_(storeOptions),
+      defaultProtocol_(WireProtocol::kText),
+      shardPerLoop_(false),
+      pinThreads_(false),
+      saveInterval_(0),
+      autoSaveTimer_(0) {
     // 设置回调
     server_.setConnectionCallback(
         std::bind(&KVServer::onConnection, this, std::placeholders::_1));
     server_.setMessageCallback(
         std::bind(&KVServer::onMessage, this, std::placeholders::_1,
                   std::placeholders::_2, std::placeholders::_3));
+    expiryCursors_.resize(store_.shardCount());
 }
 
 KVServer::~KVServer() {
-    // 保存数据
-    if (!dataFile_.empty()) {
+    if (autoSaveTimer_ != 0) {
+        loop_->cancel(autoSaveTimer_);
+    }
+    for (const auto& timer : expiryTimers_) {
+        timer.first->cancel(timer.second);
+    }
+    // 保存数据（等待进行中的后台保存结束）；开启磁盘层时刷盘即是检查点
+    if (store_.hasTables()) {
+        store_.flush();
+    } else if (!dataFile_.empty()) {
         store_.save(dataFile_);
     }
 }
 
 void KVServer::start() {
     LOG_INFO << "KVServer starting...";
+    if (pinThreads_) {
+        int numCpus = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+        std::shared_ptr<std::atomic<int>> nextCpu = std::make_shared<std::atomic<int>>(0);
+        server_.setThreadInitCallback([nextCpu, numCpus](EventLoop*) {
+            pinCurrentThread(nextCpu->fetch_add(1) % std::max(numCpus, 1));
+        });
+    }
     server_.start();
+
+    if (saveInterval_ > 0) {
+        if (dataFile_.empty()) {
+            LOG_WARN << "save interval ignored: no data file";
+        } else {
+            autoSaveTimer_ = loop_->runEvery(saveInterval_, std::bind(&KVServer::autoSave, this));
+            LOG_INFO << "auto save to " << dataFile_ << " every " << saveInterval_ << "s";
+        }
+    }
+
+    if (shardPerLoop_) {
+        loops_ = server_.threadPool()->getAllLoops();
+        if (store_.shardCount() < static_cast<int>(loops_.size())) {
+            LOG_WARN << "shard-per-core: only " << store_.shardCount() << " shards for "
+                     << loops_.size() << " IO threads, some threads own no data";
+        }
+        LOG_INFO << "shard-per-core mode: " << store_.shardCount() << " shards over "
+                 << loops_.size() << " IO threads";
+        // 分片只在所属线程中读写，写操作不再加锁；保存快照时由所属线程固定各自的分片
+        store_.setShardOwners([this](int shard, const std::function<void()>& task) {
+            EventLoop* owner = loops_[ownerOf(shard)];
+            if (owner->isInLoopThread()) {
+                task();
+            } else {
+                owner->queueInLoop(task);
+            }
+        });
+    }
+
+    // 主动过期：shard-per-core 模式下每个 IO 线程扫描自己的分片，否则由主线程扫描全部分片
+    if (store_.activeExpiry()) {
+        if (shardPerLoop_) {
+            for (size_t i = 0; i < loops_.size(); i++) {
+                int first = static_cast<int>(i);
+                int step = static_cast<int>(loops_.size());
+                expiryTimers_.emplace_back(
+                    loops_[i], loops_[i]->runEvery(kExpiryIntervalSeconds, [this, first, step]() {
+                        expireShards(first, step);
+                    }));
+            }
+        } else {
+            expiryTimers_.emplace_back(
+                loop_, loop_->runEvery(kExpiryIntervalSeconds, [this]() { expireShards(0, 1); }));
+        }
+    }
+}
+
+void KVServer::setDefaultProtocol(WireProtocol protocol) {
+    if (protocol != WireProtocol::kText && protocol != WireProtocol::kResp) {
+        LOG_WARN << "default protocol must be text or resp, ignored";
+        return;
+    }
+    defaultProtocol_ = protocol;
 }
 
 bool KVServer::loadData(const std::string& filepath) {
@@ -38,37 +250,261 @@ bool KVServer::saveData(const std::string& filepath) {
     return store_.save(filepath);
 }
 
+void KVServer::autoSave() {
+    // 上一次保存还没结束时跳过本轮
+    if (store_.hasUnsavedChanges()) {
+        store_.saveInBackground(dataFile_);
+    }
+}
+
 void KVServer::onConnection(const TcpConnectionPtr& conn) {
     if (conn->connected()) {
         LOG_INFO << "Client connected: " << conn->peerAddress().toIpPort();
-        // 发送欢迎消息
-        conn->send("+WELCOME ReactorKV Server\r\n");
+        std::shared_ptr<ConnectionState> state = std::make_shared<ConnectionState>();
+        if (shardPerLoop_) {
+            state->loopIndex = static_cast<size_t>(
+                std::find(loops_.begin(), loops_.end(), conn->getLoop()) - loops_.begin());
+        }
+        conn->setContext(state);
+        // 发送欢迎消息（RESP 客户端不认识这一行）
+        if (defaultProtocol_ != WireProtocol::kResp) {
+            conn->send("+WELCOME ReactorKV Server\r\n");
+        }
     } else {
         LOG_INFO << "Client disconnected: " << conn->peerAddress().toIpPort();
     }
 }
 
 void KVServer::onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp time) {
-    // 可能一次收到多个请求
-    while (buf->readableBytes() > 0) {
+    ConnectionState* state = static_cast<ConnectionState*>(conn->getContext().get());
+    if (state->protocol == WireProtocol::kUnknown) {
+        const char first = *buf->peek();
+        if (BinaryCodec::isBinary(first)) {
+            state->protocol = WireProtocol::kBinary;
+        } else if (first == '*') {
+            state->protocol = WireProtocol::kResp;
+        } else {
+            state->protocol = defaultProtocol_;
+        }
+    }
+    if (shardPerLoop_) {
+        onMessageSharded(conn, buf);
+        return;
+    }
+    if (state->scan) {
+        // RANGE/SCAN 暂停中：新请求留在输入缓冲区，遍历结束后再处理
+        return;
+    }
+    if (state->protocol == WireProtocol::kBinary) {
+        onBinaryMessage(conn, buf);
+        return;
+    }
+    if (state->protocol == WireProtocol::kResp) {
+        onRespMessage(conn, state, buf);
+        return;
+    }
+
+    // 同一批请求的响应直接编码进连接的输出缓冲区，最后一次 write 发出；
+    // 其中有写操作时，发送前等待 WAL 落盘一次
+    Buffer* output = conn->outputBuffer();
+    bool dirty = false;
+    size_t writeMark = 0;  // 本批第一个写请求的应答在输出缓冲区中的位置
+    auto markWrite = [output, &dirty, &writeMark]() {
+        if (!dirty) {
+            writeMark = output->readableBytes();
+            dirty = true;
+        }
+    };
+    auto flushOutput = [this, &conn, &dirty, &writeMark]() {
+        bool synced = !dirty || syncWrites(conn, writeMark, ReplyFormat());
+        dirty = false;
+        conn->flush();
+        return synced;
+    };
+
+    // 可能一次收到多个请求；view 指向 buf，处理完一个请求才 retrieve
+    RequestView view;
+    while (Codec::peekRequest(*buf, &view)) {
+        // GET / PUT 直接使用缓冲区中的 key 和 value，不经过 Request 和 Response
+        if (view.command == CommandType::kGet) {
+            Value value;
+            if (store_.get(view.key.toString(), value)) {
+                Codec::encodeValue(value.data(), value.size(), output);
+            } else {
+                Codec::encodeResponse(Response::notFound(), output);
+            }
+            buf->retrieve(view.length);
+            continue;
+        }
+        if (view.command == CommandType::kPut) {
+            Response response = handlePut(view.key.toString(),
+                                          Value(view.value.data(), view.value.size()), view.limit);
+            buf->retrieve(view.length);
+            markWrite();
+            Codec::encodeResponse(response, output);
+            continue;
+        }
         Request request;
-        if (!Codec::parseRequest(buf, &request)) {
-            // 数据不完整，等待更多数据
-            break;
+        Codec::toRequest(view, &request);
+        buf->retrieve(view.length);
+
+        // RANGE / SCAN 的结果直接分块写入连接，不经过 Response
+        if (request.command == CommandType::kRange || request.command == CommandType::kScan) {
+            if (!flushOutput()) {
+                buf->retrieveAll();
+                return;
+            }
+            state->scan.reset(new ScanState(0, request));
+            if (!streamScan(conn, state)) {
+                return;
+            }
+            continue;
         }
 
-        // 处理请求
-        Response response = handleRequest(request);
+        if (isWriteCommand(request.command)) {
+            markWrite();
+        }
+        if (isBatchCommand(request.command)) {
+            executeBatch(request, ReplyFormat(), output);
+            continue;
+        }
 
-        // 发送响应
-        Codec::sendResponse(conn, response);
+        // 处理请求
+        Codec::encodeResponse(handleRequest(request), output);
 
         // QUIT 命令：关闭连接
         if (request.command == CommandType::kQuit) {
-            conn->shutdown();
+            if (flushOutput()) {
+                conn->shutdown();
+            }
             break;
         }
     }
+    if (!flushOutput()) {
+        buf->retrieveAll();
+    }
+}
+
+void KVServer::onBinaryMessage(const TcpConnectionPtr& conn, Buffer* buf) {
+    Buffer* output = conn->outputBuffer();
+    bool dirty = false;
+    bool quit = false;
+    // 本批第一个写请求：WAL 写入失败时从它的应答开始撤回
+    size_t writeMark = 0;
+    ReplyFormat writeFormat;
+    writeFormat.protocol = WireProtocol::kBinary;
+    while (!quit) {
+        BinaryFrame frame;
+        BinaryCodec::ParseResult result = BinaryCodec::peekFrame(*buf, &frame);
+        if (result == BinaryCodec::ParseResult::kIncomplete) {
+            break;
+        }
+        if (result == BinaryCodec::ParseResult::kInvalid) {
+            // 找不到下一帧的边界，只能关闭连接
+            LOG_WARN << "Malformed binary frame from " << conn->peerAddress().toIpPort();
+            BinaryCodec::encodeResponse(0, Response::error("Malformed frame"), output);
+            buf->retrieveAll();
+            quit = true;
+            break;
+        }
+
+        // GET / PUT 直接使用缓冲区中的 key 和 value；短 key 构造 std::string 时不分配内存
+        CommandType command = static_cast<CommandType>(frame.opcode);
+        if (!dirty && isWriteCommand(command)) {
+            writeMark = output->readableBytes();
+            writeFormat.requestId = frame.requestId;
+            dirty = true;
+        }
+        if (command == CommandType::kGet) {
+            Value value;
+            if (store_.get(std::string(frame.key, frame.keyLength), value)) {
+                BinaryCodec::encodeValue(frame.requestId, StatusCode::kOk, value.data(),
+                                         value.size(), output);
+            } else {
+                BinaryCodec::encodeResponse(frame.requestId, Response::notFound(), output);
+            }
+        } else if (command == CommandType::kPut) {
+            Response response = handlePut(std::string(frame.key, frame.keyLength),
+                                          Value(frame.value, frame.valueLength), frame.extra);
+            BinaryCodec::encodeResponse(frame.requestId, response, output);
+        } else {
+            Request request;
+            BinaryCodec::toRequest(frame, &request);
+            BinaryCodec::encodeResponse(frame.requestId, handleRequest(request), output);
+            quit = request.command == CommandType::kQuit;
+        }
+        buf->retrieve(frame.size());
+    }
+
+    if (dirty && !syncWrites(conn, writeMark, writeFormat)) {
+        buf->retrieveAll();
+        return;
+    }
+    conn->flush();
+    if (quit) {
+        conn->shutdown();
+    }
+}
+
+void KVServer::onRespMessage(const TcpConnectionPtr& conn, ConnectionState* state, Buffer* buf) {
+    Buffer* output = conn->outputBuffer();
+    bool dirty = false;
+    bool quit = false;
+    // 本批第一个写请求：WAL 写入失败时从它的应答开始撤回
+    size_t writeMark = 0;
+    ReplyFormat writeFormat;
+    std::vector<std::string> args;
+    while (!quit) {
+        RespCodec::ParseResult result = RespCodec::parseCommand(buf, &args);
+        if (result == RespCodec::ParseResult::kIncomplete) {
+            break;
+        }
+        if (result == RespCodec::ParseResult::kInvalid) {
+            // 找不到下一条命令的边界，只能关闭连接
+            LOG_WARN << "Malformed RESP request from " << conn->peerAddress().toIpPort();
+            RespCodec::appendError("Protocol error", output);
+            buf->retrieveAll();
+            quit = true;
+            break;
+        }
+
+        Request request;
+        ReplyFormat format;
+        format.protocol = WireProtocol::kResp;
+        if (!RespCodec::toRequest(args, &state->resp3, &request, &format.respCommand, output)) {
+            continue;
+        }
+        format.resp3 = state->resp3;
+        if (!dirty && isWriteCommand(request.command)) {
+            writeMark = output->readableBytes();
+            writeFormat = format;
+            dirty = true;
+        }
+
+        if (request.command == CommandType::kGet) {
+            // GET 直接从 Value 编码，不拷贝成 Response
+            Value value;
+            if (store_.get(request.key, value)) {
+                RespCodec::appendBulk(value.data(), value.size(), output);
+            } else {
+                RespCodec::appendNull(format.resp3, output);
+            }
+        } else if (isBatchCommand(request.command)) {
+            executeBatch(request, format, output);
+        } else {
+            appendResponse(format, handleRequest(request), output);
+            quit = request.command == CommandType::kQuit;
+        }
+    }
+
+    if (dirty && !syncWrites(conn, writeMark, writeFormat)) {
+        buf->retrieveAll();
+        return;
+    }
+    conn->flush();
+    if (quit) {
+        conn->shutdown();
+    }
 }
 
 Response KVServer::handleRequest(const Request& request) {
@@ -77,17 +513,13 @@ Response KVServer::handleRequest(const Request& request) {
 
     switch (request.command) {
         case CommandType::kPut: {
-            if (request.key.empty()) {
-                return Response::error("Key cannot be empty");
-            }
-            bool isNew = store_.put(request.key, request.value);
-            return Response::ok(isNew ? "CREATED" : "UPDATED");
+            return handlePut(request.key, Value(request.value), request.limit);
         }
 
         case CommandType::kGet: {
-            std::string value;
+            Value value;
             if (store_.get(request.key, value)) {
-                return Response::ok(value);
+                return Response::ok(value.toString());
             } else {
                 return Response::notFound();
             }
@@ -109,6 +541,27 @@ Response KVServer::handleRequest(const Request& request) {
             }
         }
 
+        case CommandType::kExpire: {
+            int64_t expireAt = KVStore::nowMs() + static_cast<int64_t>(request.limit) * 1000;
+            if (!store_.expire(request.key, expireAt)) {
+                return Response::notFound();
+            }
+            return Response::ok();
+        }
+
+        case CommandType::kTtl: {
+            int64_t expireAt = store_.expireAt(request.key);
+            if (expireAt < 0) {
+                return Response::notFound();
+            }
+            if (expireAt == 0) {
+                return Response::ok("-1");
+            }
+            // 剩余时间向上取整到秒
+            int64_t remaining = std::max<int64_t>(expireAt - KVStore::nowMs(), 0);
+            return Response::ok(std::to_string((remaining + 999) / 1000));
+        }
+
         case CommandType::kSize: {
             return Response::ok(std::to_string(store_.size()));
         }
@@ -118,6 +571,20 @@ Response KVServer::handleRequest(const Request& request) {
             return Response::ok("CLEARED");
         }
 
+        case CommandType::kBgSave: {
+            if (dataFile_.empty()) {
+                return Response::error("No data file configured");
+            }
+            if (!store_.saveInBackground(dataFile_)) {
+                return Response::error("Background save already in progress");
+            }
+            return Response::ok("Background saving started");
+        }
+
+        case CommandType::kStats: {
+            return Response::ok(formatStats());
+        }
+
         case CommandType::kPing: {
             return Response::pong();
         }
@@ -132,4 +599,622 @@ Response KVServer::handleRequest(const Request& request) {
     }
 }
 
+Response KVServer::handlePut(const std::string& key, const Value& value, size_t ttlSeconds) {
+    if (key.empty()) {
+        return Response::error("Key cannot be empty");
+    }
+    if (ttlSeconds == 0) {
+        bool isNew = store_.put(key, value);
+        return Response::ok(isNew ? "CREATED" : "UPDATED");
+    }
+    int64_t expireAt = KVStore::nowMs() + static_cast<int64_t>(ttlSeconds) * 1000;
+    bool isNew = store_.put(key, Value(value).withExpiry(expireAt));
+    return Response::ok(isNew ? "CREATED" : "UPDATED");
+}
+
+void KVServer::expireShards(int first, int step) {
+    for (int shard = first; shard < store_.shardCount(); shard += step) {
+        for (int round = 0; round < kExpiryRounds; round++) {
+            size_t removed = store_.expireShard(shard, &expiryCursors_[shard], kExpiryBatchKeys);
+            if (removed * 4 <= kExpiryBatchKeys) {
+                break;
+            }
+        }
+    }
+}
+
+void KVServer::executeBatch(const Request& request, const ReplyFormat& format, Buffer* output) {
+    LOG_DEBUG << "Handling command: " << commandToString(request.command)
+              << " keys=" << request.keys.size();
+
+    std::vector<Value> values;
+    std::vector<bool> found;
+    size_t count = 0;
+    switch (request.command) {
+        case CommandType::kMGet:
+            count = store_.multiGet(request.keys, &values, &found);
+            break;
+
+        case CommandType::kMPut:
+            values.reserve(request.values.size());
+            for (const std::string& value : request.values) {
+                values.emplace_back(value);
+            }
+            count = store_.multiPut(request.keys, values);
+            break;
+
+        case CommandType::kMDel:
+            count = store_.multiDel(request.keys);
+            break;
+
+        default:
+            break;
+    }
+    appendBatchResponse(request, format, values, found, count, output);
+}
+
+bool KVServer::syncWrites(const TcpConnectionPtr& conn, size_t writeMark,
+                          const ReplyFormat& format) {
+    if (store_.syncLog()) {
+        return true;
+    }
+    // 之后的应答里可能有对没落盘的写操作的确认，也可能有读到这些写入的结果，
+    // 无法逐条更正：全部撤回，以一条错误应答结束并关闭连接
+    Buffer* output = conn->outputBuffer();
+    output->unwrite(output->readableBytes() - writeMark);
+    appendResponse(format, Response::error(kLogFailedError), output);
+    LOG_ERROR << "Write-ahead log failed, closing " << conn->peerAddress().toIpPort();
+    conn->flush();
+    conn->shutdown();
+    return false;
+}
+
+std::string KVServer::formatStats() const {
+    MemtableFilter::Stats filter = store_.filterStats();
+    char rate[32];
+    snprintf(rate, sizeof(rate), "%.4f", filter.falsePositiveRate());
+    std::string stats = "filter_negatives=" + std::to_string(filter.negatives) +
+                        " filter_false_positives=" + std::to_string(filter.falsePositives) +
+                        " filter_fp_rate=" + rate +
+                        " filter_rebuilds=" + std::to_string(filter.rebuilds) +
+                        " filter_bytes=" + std::to_string(filter.bytes) +
+                        " used_memory=" + std::to_string(store_.memoryUsed()) +
+                        " maxmemory=" + std::to_string(store_.maxMemory()) +
+                        " maxmemory_policy=" + evictionPolicyName(store_.evictionPolicy()) +
+                        " evicted_keys=" + std::to_string(store_.evictedKeys());
+    if (const TableSet* tables = store_.tables()) {
+        stats += " tables=" + std::to_string(tables->tableCount()) +
+                 " compactions=" + std::to_string(tables->compactions()) +
+                 " memtable_bytes=" + std::to_string(store_.memtableBytes());
+    }
+    return stats;
+}
+
+// ==================== shard-per-core 模式 ====================
+
+void KVServer::onMessageSharded(const TcpConnectionPtr& conn, Buffer* buf) {
+    ConnectionState* state = static_cast<ConnectionState*>(conn->getContext().get());
+    if (state->quitSeq != std::numeric_limits<uint64_t>::max()) {
+        // 已收到 QUIT，丢弃之后的数据
+        buf->retrieveAll();
+        return;
+    }
+
+    // 本批次中发往各线程的请求，按所属线程合并后一次转发
+    std::vector<SequencedRequests> forwards(loops_.size());
+    // 广播之后，本线程的请求也要排在广播任务之后执行
+    bool deferLocal = false;
+    // 本线程执行过的写操作，应答前需要等待 WAL 落盘
+    std::vector<uint64_t> localWrites;
+
+    while (buf->readableBytes() > 0) {
+        Request request;
+        Buffer reply;
+        bool malformed = false;
+        if (!nextRequest(state, buf, &request, &reply, &malformed)) {
+            // 数据不完整，等待更多数据
+            break;
+        }
+
+        uint64_t seq = state->nextSeq++;
+        if (reply.readableBytes() > 0) {
+            // 不需要执行的请求：应答已经编码好；格式错误时应答后关闭连接
+            state->encoded.emplace(seq, reply.retrieveAllAsString());
+            if (malformed) {
+                state->quitSeq = seq;
+                buf->retrieveAll();
+                break;
+            }
+            continue;
+        }
+        switch (request.command) {
+            case CommandType::kPut:
+            case CommandType::kGet:
+            case CommandType::kDel:
+            case CommandType::kExists:
+            case CommandType::kExpire:
+            case CommandType::kTtl: {
+                size_t owner = ownerOf(store_.shardIndex(request.key));
+                if (owner == state->loopIndex && !deferLocal) {
+                    state->ready.emplace(seq, handleRequest(request));
+                    if (isWriteCommand(request.command)) {
+                        localWrites.push_back(seq);
+                    }
+                } else {
+                    forwards[owner].emplace_back(seq, std::move(request));
+                }
+                break;
+            }
+
+            case CommandType::kSize:
+            case CommandType::kClear:
+            case CommandType::kRange:
+            case CommandType::kScan:
+            case CommandType::kMGet:
+            case CommandType::kMPut:
+            case CommandType::kMDel:
+                // 每个线程的任务队列是 FIFO 的：先发出积攒的请求，
+                // 广播任务就会在本连接之前的请求之后执行
+                dispatchForwards(conn, &forwards);
+                broadcastRequest(conn, seq, request,
+                                 state->formats.empty() ? ReplyFormat() : state->formats.back());
+                deferLocal = true;
+                break;
+
+            default:
+                // PING/QUIT 与数据无关，在本线程处理；BGSAVE 自己固定所有分片的快照
+                state->ready.emplace(seq, handleRequest(request));
+                if (request.command == CommandType::kQuit) {
+                    state->quitSeq = seq;
+                }
+                break;
+        }
+
+        if (state->quitSeq != std::numeric_limits<uint64_t>::max()) {
+            buf->retrieveAll();
+            break;
+        }
+    }
+
+    dispatchForwards(conn, &forwards);
+    if (!localWrites.empty() && !store_.syncLog()) {
+        for (uint64_t seq : localWrites) {
+            state->ready[seq] = Response::error(kLogFailedError);
+        }
+    }
+    flushResponses(conn, state);
+}
+
+bool KVServer::nextRequest(ConnectionState* state, Buffer* buf, Request* request, Buffer* reply,
+                           bool* malformed) {
+    ReplyFormat format;
+    format.protocol = state->protocol;
+    if (state->protocol == WireProtocol::kBinary) {
+        BinaryCodec::ParseResult result =
+            BinaryCodec::parseRequest(buf, request, &format.requestId);
+        if (result == BinaryCodec::ParseResult::kIncomplete) {
+            return false;
+        }
+        if (result == BinaryCodec::ParseResult::kInvalid) {
+            BinaryCodec::encodeResponse(0, Response::error("Malformed frame"), reply);
+            *malformed = true;
+        }
+    } else if (state->protocol == WireProtocol::kResp) {
+        std::vector<std::string> args;
+        RespCodec::ParseResult result = RespCodec::parseCommand(buf, &args);
+        if (result == RespCodec::ParseResult::kIncomplete) {
+            return false;
+        }
+        if (result == RespCodec::ParseResult::kInvalid) {
+            RespCodec::appendError("Protocol error", reply);
+            *malformed = true;
+        } else {
+            RespCodec::toRequest(args, &state->resp3, request, &format.respCommand, reply);
+        }
+        format.resp3 = state->resp3;
+    } else {
+        return Codec::parseRequest(buf, request);
+    }
+    state->formats.push_back(format);
+    return true;
+}
+
+void KVServer::sendResponse(const TcpConnectionPtr& conn, ConnectionState* state,
+                            const Response& response) {
+    if (state->protocol == WireProtocol::kText) {
+        Codec::encodeResponse(response, conn->outputBuffer());
+        return;
+    }
+    appendResponse(state->formats.front(), response, conn->outputBuffer());
+}
+
+void KVServer::dispatchForwards(const TcpConnectionPtr& conn,
+                                std::vector<SequencedRequests>* forwards) {
+    for (size_t i = 0; i < forwards->size(); i++) {
+        SequencedRequests& pending = (*forwards)[i];
+        if (pending.empty()) {
+            continue;
+        }
+        std::shared_ptr<SequencedRequests> requests =
+            std::make_shared<SequencedRequests>(std::move(pending));
+        pending.clear();
+        loops_[i]->queueInLoop([this, conn, requests]() {
+            executeForwarded(conn, *requests);
+        });
+    }
+}
+
+void KVServer::executeForwarded(const TcpConnectionPtr& conn,
+                                const SequencedRequests& requests) {
+    std::shared_ptr<SequencedResponses> responses = std::make_shared<SequencedResponses>();
+    responses->reserve(requests.size());
+    bool dirty = false;
+    for (const auto& request : requests) {
+        responses->emplace_back(request.first, handleRequest(request.second));
+        dirty = dirty || isWriteCommand(request.second.command);
+    }
+    // 同一批转发的写操作共享一次 WAL 落盘；日志写入失败时写操作都应答错误
+    if (dirty && !store_.syncLog()) {
+        for (size_t i = 0; i < requests.size(); i++) {
+            if (isWriteCommand(requests[i].second.command)) {
+                (*responses)[i].second = Response::error(kLogFailedError);
+            }
+        }
+    }
+    conn->getLoop()->queueInLoop([this, conn, responses]() {
+        completeRequests(conn, *responses);
+    });
+}
+
+void KVServer::broadcastRequest(const TcpConnectionPtr& conn, uint64_t seq,
+                                const Request& request, const ReplyFormat& format) {
+    size_t owners = std::min(loops_.size(), static_cast<size_t>(store_.shardCount()));
+    std::shared_ptr<std::atomic<size_t>> remaining =
+        std::make_shared<std::atomic<size_t>>(owners);
+    std::shared_ptr<std::atomic<int>> total = std::make_shared<std::atomic<int>>(0);
+    std::shared_ptr<std::atomic<bool>> logFailed = std::make_shared<std::atomic<bool>>(false);
+    std::shared_ptr<Request> shared = std::make_shared<Request>(request);
+    // 批量命令：每个线程执行属于自己分片的 key，结果各写各的槽位
+    std::shared_ptr<std::vector<BatchPart>> parts;
+    if (isBatchCommand(request.command)) {
+        parts = std::make_shared<std::vector<BatchPart>>(owners);
+    }
+
+    for (size_t i = 0; i < owners; i++) {
+        loops_[i]->queueInLoop([this, conn, seq, shared, format, parts, i, remaining, total,
+                                logFailed]() {
+            CommandType command = shared->command;
+            if (parts) {
+                executeBatchPart(*shared, i, &(*parts)[i]);
+            }
+            int count = 0;
+            for (int shard = static_cast<int>(i); shard < store_.shardCount();
+                 shard += static_cast<int>(loops_.size())) {
+                if (command == CommandType::kClear) {
+                    store_.clearShard(shard);
+                } else if (command == CommandType::kSize) {
+                    count += store_.shardSize(shard);
+                }
+                // RANGE/SCAN：只作为屏障，保证之前转发的写操作都已执行
+            }
+            if (isWriteCommand(command) && !store_.syncLog()) {
+                logFailed->store(true);
+            }
+            total->fetch_add(count);
+
+            // 最后一个完成的线程负责应答
+            if (remaining->fetch_sub(1) != 1) {
+                return;
+            }
+            if (logFailed->load()) {
+                Buffer error;
+                appendResponse(format, Response::error(kLogFailedError), &error);
+                std::string encoded = error.retrieveAllAsString();
+                conn->getLoop()->queueInLoop([this, conn, seq, encoded]() {
+                    ConnectionState* state =
+                        static_cast<ConnectionState*>(conn->getContext().get());
+                    state->encoded.emplace(seq, encoded);
+                    flushResponses(conn, state);
+                });
+            } else if (parts) {
+                std::string encoded = mergeBatchParts(*shared, format, *parts);
+                conn->getLoop()->queueInLoop([this, conn, seq, encoded]() {
+                    ConnectionState* state =
+                        static_cast<ConnectionState*>(conn->getContext().get());
+                    state->encoded.emplace(seq, encoded);
+                    flushResponses(conn, state);
+                });
+            } else if (command != CommandType::kSize && command != CommandType::kClear) {
+                conn->getLoop()->queueInLoop([this, conn, seq, shared]() {
+                    ConnectionState* state =
+                        static_cast<ConnectionState*>(conn->getContext().get());
+                    state->scans.emplace(seq, *shared);
+                    flushResponses(conn, state);
+                });
+            } else {
+                Response response = command == CommandType::kClear
+                                        ? Response::ok("CLEARED")
+                                        : Response::ok(std::to_string(total->load()));
+                conn->getLoop()->queueInLoop([this, conn, seq, response]() {
+                    completeRequests(conn, SequencedResponses(1, {seq, response}));
+                });
+            }
+        });
+    }
+}
+
+void KVServer::executeBatchPart(const Request& request, size_t loopIndex, BatchPart* part) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < request.keys.size(); i++) {
+        if (ownerOf(store_.shardIndex(request.keys[i])) == loopIndex) {
+            part->indices.push_back(i);
+            keys.push_back(request.keys[i]);
+        }
+    }
+    if (keys.empty()) {
+        return;
+    }
+
+    switch (request.command) {
+        case CommandType::kMGet:
+            part->count = store_.multiGet(keys, &part->values, &part->found);
+            break;
+
+        case CommandType::kMPut: {
+            std::vector<Value> values;
+            values.reserve(keys.size());
+            for (size_t i : part->indices) {
+                values.emplace_back(request.values[i]);
+            }
+            part->count = store_.multiPut(keys, values);
+            break;
+        }
+
+        case CommandType::kMDel:
+            part->count = store_.multiDel(keys);
+            break;
+
+        default:
+            break;
+    }
+}
+
+std::string KVServer::mergeBatchParts(const Request& request, const ReplyFormat& format,
+                                      const std::vector<BatchPart>& parts) {
+    std::vector<Value> values(request.command == CommandType::kMGet ? request.keys.size() : 0);
+    std::vector<bool> found(values.size(), false);
+    size_t count = 0;
+    for (const BatchPart& part : parts) {
+        count += part.count;
+        for (size_t j = 0; j < part.found.size(); j++) {
+            values[part.indices[j]] = part.values[j];
+            found[part.indices[j]] = part.found[j];
+        }
+    }
+    Buffer output;
+    appendBatchResponse(request, format, values, found, count, &output);
+    return output.retrieveAllAsString();
+}
+
+void KVServer::completeRequests(const TcpConnectionPtr& conn,
+                                const SequencedResponses& responses) {
+    ConnectionState* state = static_cast<ConnectionState*>(conn->getContext().get());
+    for (const auto& response : responses) {
+        state->ready.emplace(response.first, response.second);
+    }
+    flushResponses(conn, state);
+}
+
+void KVServer::flushResponses(const TcpConnectionPtr& conn, ConnectionState* state) {
+    while (true) {
+        auto it = state->ready.begin();
+        auto scan = state->scans.begin();
+        auto encoded = state->encoded.begin();
+        if (state->scan) {
+            // 正在输出的 RANGE/SCAN 暂停时，之后的应答等它输出完再发送
+            if (!streamScan(conn, state)) {
+                return;
+            }
+        } else if (it != state->ready.end() && it->first == state->nextToSend) {
+            sendResponse(conn, state, it->second);
+            state->ready.erase(it);
+        } else if (scan != state->scans.end() && scan->first == state->nextToSend) {
+            // 轮到 RANGE/SCAN 时才遍历，结果直接写入连接
+            state->scan.reset(new ScanState(scan->first, scan->second));
+            state->scans.erase(scan);
+            continue;
+        } else if (encoded != state->encoded.end() && encoded->first == state->nextToSend) {
+            conn->outputBuffer()->append(encoded->second);
+            state->encoded.erase(encoded);
+        } else {
+            break;
+        }
+        if (!state->formats.empty()) {
+            state->formats.pop_front();
+        }
+        if (state->nextToSend == state->quitSeq) {
+            // QUIT 或格式错误：发出之前的应答后关闭连接
+            conn->flush();
+            conn->shutdown();
+        }
+        state->nextToSend++;
+    }
+    // 还有转发出去的请求没有应答时先攒着，等这批请求全部就绪后一次写出：
+    // 否则一批流水线请求的应答会拆成几个小包，后面的包被 Nagle 压到对端的延迟 ACK 之后
+    if (state->nextToSend == state->nextSeq ||
+        conn->outputBuffer()->readableBytes() >= TcpConnection::kDeferredFlushBytes) {
+        conn->flush();
+    }
+}
+
+bool KVServer::streamScan(const TcpConnectionPtr& conn, ConnectionState* state) {
+    ScanState* scan = state->scan.get();
+    const Request& request = scan->request;
+    const bool isScan = request.command == CommandType::kScan;
+    // RANGE 的 limit 为 0 表示不限；SCAN 多看一条，用它的 key 作为下一次的 cursor
+    const bool limited = isScan || request.limit > 0;
+
+    // 结果直接编码进连接的输出缓冲区，攒够一块就写出；写不下去时暂停，不在内存中拼出完整结果
+    Buffer* output = conn->outputBuffer();
+    auto backlogged = [&conn, output]() {
+        if (output->readableBytes() < kScanChunkSize) {
+            return false;
+        }
+        conn->flush();
+        return output->readableBytes() >= kScanChunkSize;
+    };
+    bool paused = backlogged();
+    bool limitReached = false;
+    std::string cursor = "0";
+    // 输出一条结果，返回是否继续；到达条数上限时不输出
+    auto emit = [&](const std::string& key, const Value& value) {
+        if (limited && scan->emitted == request.limit) {
+            if (isScan) {
+                cursor = "@" + key;
+            }
+            limitReached = true;
+            return false;
+        }
+        output->append("=", 1);
+        output->append(key);
+        output->append(" ", 1);
+        output->append(value.data(), value.size());
+        output->append("\r\n", 2);
+        scan->emitted++;
+
+        paused = backlogged();
+        if (paused) {
+            scan->last = key;
+        }
+        return !paused && conn->connected();
+    };
+
+    if (!paused && !store_.hasShardOwners()) {
+        // 继续时从上次输出的最后一个 key 开始，它还在的话跳过
+        bool skipLast = scan->emitted > 0;
+        store_.scan(skipLast ? scan->last : request.key, isScan ? std::string() : request.value, 0,
+                    [&](const std::string& key, const Value& value) {
+                        if (skipLast) {
+                            skipLast = false;
+                            if (key == scan->last) {
+                                return true;
+                            }
+                        }
+                        return emit(key, value);
+                    });
+    } else if (!paused) {
+        // 分片只由所属线程访问：归并各分片取回的一批结果。某个分片这一批已经归并完、
+        // 还有更多时，要等它的下一批取回来才能确定下一个最小的 key
+        if (scan->parts.empty()) {
+            scan->parts.resize(store_.shardCount());
+        }
+        while (scan->fetching == 0) {
+            ScanPart* min = nullptr;
+            bool starving = false;
+            for (ScanPart& part : scan->parts) {
+                if (part.next == part.entries.size()) {
+                    starving = starving || !part.done;
+                } else if (min == nullptr ||
+                           part.entries[part.next].first < min->entries[min->next].first) {
+                    min = &part;
+                }
+            }
+            if (starving) {
+                fetchScanParts(conn, state);
+                break;
+            }
+            if (min == nullptr) {
+                break;  // 所有分片都遍历完了
+            }
+            const std::pair<std::string, Value>& entry = min->entries[min->next];
+            bool more = emit(entry.first, entry.second);
+            if (!limitReached) {
+                min->next++;
+            }
+            if (!more) {
+                break;
+            }
+        }
+    }
+    if (paused && conn->connected()) {
+        conn->setWriteCompleteCallback(
+            std::bind(&KVServer::onScanWritable, this, std::placeholders::_1));
+        return false;
+    }
+    if (scan->fetching > 0 && !limitReached && conn->connected()) {
+        // 分片的结果取回来后再继续（见 fetchScanParts）
+        return false;
+    }
+
+    // 结尾和之后的应答由调用方一起写出
+    Codec::encodeResponse(Response::ok(isScan ? cursor : std::to_string(scan->emitted)), output);
+    state->scan.reset();
+    return true;
+}
+
+void KVServer::fetchScanParts(const TcpConnectionPtr& conn, ConnectionState* state) {
+    ScanState* scan = state->scan.get();
+    const uint64_t seq = scan->seq;
+    const std::string end =
+        scan->request.command == CommandType::kScan ? std::string() : scan->request.value;
+    for (int shard = 0; shard < store_.shardCount(); shard++) {
+        const ScanPart& part = scan->parts[shard];
+        if (part.next < part.entries.size() || part.done) {
+            continue;
+        }
+        // 第一批从请求的起点开始，之后从上一批的最后一个 key 开始，它还在的话跳过
+        const bool resumed = !part.entries.empty();
+        const std::string start = resumed ? part.entries.back().first : scan->request.key;
+        scan->fetching++;
+        loops_[ownerOf(shard)]->queueInLoop([this, conn, seq, shard, start, end, resumed]() {
+            std::shared_ptr<ScanPart> fetched = std::make_shared<ScanPart>();
+            std::vector<std::pair<std::string, Value>>& entries = fetched->entries;
+            store_.scanShard(shard, start, end, 0, [&](const std::string& key, const Value& value) {
+                if (!resumed || key != start) {
+                    entries.emplace_back(key, value);
+                }
+                return entries.size() < kScanPartKeys;
+            });
+            fetched->done = entries.size() < kScanPartKeys;
+
+            conn->getLoop()->queueInLoop([this, conn, seq, shard, fetched]() {
+                ConnectionState* state = static_cast<ConnectionState*>(conn->getContext().get());
+                ScanState* scan = state->scan.get();
+                if (scan == nullptr || scan->seq != seq) {
+                    return;  // 连接已经断开，遍历提前结束了
+                }
+                ScanPart& part = scan->parts[shard];
+                part.entries.swap(fetched->entries);
+                part.next = 0;
+                part.done = fetched->done;
+                if (--scan->fetching == 0) {
+                    flushResponses(conn, state);
+                }
+            });
+        });
+    }
+}
+
+void KVServer::onScanWritable(const TcpConnectionPtr& conn) {
+    conn->setWriteCompleteCallback(WriteCompleteCallback());
+    ConnectionState* state = static_cast<ConnectionState*>(conn->getContext().get());
+    if (!state->scan) {
+        return;
+    }
+    if (shardPerLoop_) {
+        flushResponses(conn, state);
+        return;
+    }
+    if (!streamScan(conn, state)) {
+        return;
+    }
+    // 暂停期间到达的请求还在输入缓冲区中，接着处理；没有时写出结尾
+    Buffer* input = conn->inputBuffer();
+    if (input->readableBytes() > 0) {
+        onMessage(conn, input, Timestamp::now());
+    } else {
+        conn->flush();
+    }
+}
+
 }  // namespace kvstore
@@ -8,27 +8,71 @@
 #include "storage/kvstore.h"
 #include "protocol/message.h"
 #include "protocol/codec.h"
+#include "protocol/binary_codec.h"
+#include "protocol/resp_codec.h"
 
 #include <string>
 #include <memory>
+#include <utility>
+#include <vector>
 
 namespace kvstore {
 
+/**
+ * @brief 一个请求的应答编码方式，解析请求时确定
+ *
+ * shard-per-core 模式下应答可能在之后的请求解析完才发送，编码方式随请求保存。
+ */
+struct ReplyFormat {
+    WireProtocol protocol = WireProtocol::kText;
+    uint32_t requestId = 0;                           // 二进制协议
+    RespCommand respCommand = RespCommand::kUnknown;  // RESP
+    bool resp3 = false;                               // RESP：连接已经通过 HELLO 3 切换到 RESP3
+};
+
 /**
  * @brief KV 存储服务器
  *
  * 整合 TcpServer 和 KVStore，提供完整的 KV 存储服务。
  *
  * 支持的命令：
- *   PUT key value   - 存储键值对
+ *   PUT key value [EX seconds] - 存储键值对，可选过期时间
  *   GET key         - 获取值
  *   DEL key         - 删除键
  *   EXISTS key      - 判断键是否存在
+ *   EXPIRE key seconds - 设置过期时间，0 表示立即删除
+ *   TTL key         - 剩余秒数，-1 表示没有过期时间
+ *   MGET key [key ...] - 批量读取，每个分片一次 finger search
+ *   MPUT key value [key value ...] - 批量写入，每个分片只加一次锁
+ *   MDEL key [key ...] - 批量删除
  *   SIZE            - 获取存储数量
  *   CLEAR           - 清空所有数据
+ *   RANGE s e [LIMIT n] - 按 key 升序返回 [s, e] 内的键值对
+ *   SCAN cursor [COUNT n] - 基于 cursor 的分批遍历
+ *   BGSAVE          - 在后台把数据保存到数据文件，不阻塞其他请求
+ *   STATS           - 运行统计（布隆过滤器误判率、内存与淘汰、磁盘层状态），空格分隔的 name=value
  *   PING            - 心跳检测
  *   QUIT            - 断开连接
  *
+ * 协议：同一个端口上支持文本协议（Codec）、长度前缀的二进制协议（BinaryCodec）和
+ * RESP（RespCodec），由连接的第一个字节决定：0x80 为二进制，'*' 为 RESP 数组，
+ * 其余按默认协议（setDefaultProtocol）处理。二进制协议的 key / value 可以是任意字节；
+ * 默认执行模型下 GET / PUT 直接从输入缓冲区读取 key 和 value，不经过 Request。
+ *
+ * 过期：已经过期的 key 对所有读操作都不存在；使用互斥锁跳表时，时间轮上的周期定时器
+ * 每 100ms 分批扫描分片中节点保存的过期时刻，把已经过期的 key 从内存中摘除
+ * （见 KVStore::expireShard），不为每个 key 另外登记定时器。默认模型下由主线程扫描
+ * 所有分片，shard-per-core 模式下每个 IO 线程只扫描自己的分片。
+ *
+ * 两种执行模型：
+ * - 默认：任意 IO 线程都可以直接读写任意 key，由 KVStore 内部的锁保证线程安全
+ * - shard-per-core（setShardPerLoop）：每个 IO 线程独占一部分分片，其他线程收到的请求
+ *   通过 queueInLoop 转发给所属线程执行，线程之间只传递消息。分片只在所属线程中读写，
+ *   写操作不取跳表的写锁和分片的日志锁（见 KVStore::setShardOwners）；RANGE/SCAN 由各
+ *   所属线程分批遍历自己的分片，在连接所在线程归并；保存快照时各分片的快照也由所属线程固定。
+ *   开启 WAL 时日志文件是共用的，追加仍在 WAL 内部的锁下进行；开启磁盘层或内存上限时
+ *   后台刷盘和淘汰要跨线程写分片，写操作保持加锁
+ *
  * 使用示例：
  *   EventLoop loop;
  *   KVServer server(&loop, 8080);
@@ -39,12 +83,49 @@ namespace kvstore {
 class KVServer : noncopyable {
 public:
     KVServer(EventLoop* loop, uint16_t port,
-             const std::string& name = "KVServer");
+             const std::string& name = "KVServer",
+             const KVStoreOptions& storeOptions = KVStoreOptions());
     ~KVServer();
 
     /// 设置 IO 线程数量
     void setThreadNum(int numThreads) { server_.setThreadNum(numThreads); }
 
+    /**
+     * @brief 开启 shard-per-core 模式（必须在 start() 前调用）
+     *
+     * 分片 i 归第 i % N 个 IO 线程所有（N 为 IO 线程数），单 key 请求只在该线程中执行；
+     * RANGE/SCAN 等所有线程执行完之前的请求后，每次从各分片的所属线程取回一批结果归并。
+     * 连接收到属于其他线程的请求时，同一批次按所属线程合并，经 queueInLoop 转发，
+     * 执行结果再投递回连接所在线程；每个连接的响应严格按请求顺序写回。
+     * 分片数最好等于 IO 线程数（见 KVStoreOptions::shards）。
+     *
+     * @param enable 是否开启
+     * @param pinThreads 是否将每个 IO 线程绑定到一个 CPU 核
+     */
+    void setShardPerLoop(bool enable, bool pinThreads = false) {
+        shardPerLoop_ = enable;
+        pinThreads_ = pinThreads;
+    }
+
+    /**
+     * @brief 设置默认协议：kText（默认）或 kResp（必须在 start() 前调用）
+     *
+     * kText 时连接建立后服务器先发送一行欢迎消息（+WELCOME ...），RESP 客户端会把它
+     * 当作第一条命令的应答，因此 redis-benchmark 等工具需要使用 kResp：不发送欢迎消息，
+     * 内联命令也按 RESP 应答。两种模式下二进制协议和 RESP 数组都可以直接使用。
+     */
+    void setDefaultProtocol(WireProtocol protocol);
+
+    /**
+     * @brief 定期在后台保存数据文件（必须在 start() 前调用）
+     *
+     * 每隔 seconds 秒检查一次（主线程 EventLoop 上的周期定时器），有新的写操作时执行一次 BGSAVE。
+     * 需要先通过 loadData/saveData 指定数据文件。
+     *
+     * @param seconds 间隔秒数，<= 0 表示关闭
+     */
+    void setSaveInterval(double seconds) { saveInterval_ = seconds; }
+
     /// 启动服务器
     void start();
 
@@ -57,16 +138,170 @@ public:
     /// 保存数据文件
     bool saveData(const std::string& filepath);
 
+    /// 只指定 SAVE/BGSAVE 写入的数据文件，不加载
+    void setDataFile(const std::string& filepath) { dataFile_ = filepath; }
+
+    /**
+     * @brief 开启磁盘层（在 loadData、openLog 之前调用）
+     *
+     * 开启后内存中只保留最近的写入，超过 memtable 阈值的数据刷成 SSTable，
+     * 目录中已有的表和 WAL 一起构成完整的数据，数据文件只作为导出使用。
+     */
+    bool openTables(const std::string& dir, const TableOptions& options) {
+        return store_.openTables(dir, options);
+    }
+
+    /**
+     * @brief 重放并开启预写日志（在 loadData 之后、start 之前调用）
+     *
+     * 开启后写请求的响应在日志按策略落盘之后才发出（见 WalSyncPolicy），
+     * saveData 成为检查点，删除快照已包含的日志。
+     */
+    bool openLog(const std::string& path, const WalOptions& options) {
+        return store_.openLog(path, options);
+    }
+
 private:
     void onConnection(const TcpConnectionPtr& conn);
     void onMessage(const TcpConnectionPtr& conn, Buffer* buf, Timestamp time);
 
     Response handleRequest(const Request& request);
 
+    /// PUT：ttlSeconds 为 0 表示不过期
+    Response handlePut(const std::string& key, const Value& value, size_t ttlSeconds);
+
+    /// 二进制协议连接的 onMessage（默认执行模型）
+    void onBinaryMessage(const TcpConnectionPtr& conn, Buffer* buf);
+
+    struct ConnectionState;
+
+    /// RESP 连接的 onMessage（默认执行模型）
+    void onRespMessage(const TcpConnectionPtr& conn, ConnectionState* state, Buffer* buf);
+
+    /**
+     * @brief 主动过期的周期定时器回调：扫描下标为 first、first + step、... 的分片
+     *
+     * 每个分片从上次的进度继续检查一批 key；这一批中过期的超过四分之一时接着再查一批，
+     * 最多 kExpiryRounds 批，过期的 key 很多时也不会长时间占住线程。
+     */
+    void expireShards(int first, int step);
+
+    /// STATS 的内容
+    std::string formatStats() const;
+
+    /// 执行 MGET/MPUT/MDEL，整批的应答按 format 编码进 output
+    void executeBatch(const Request& request, const ReplyFormat& format, Buffer* output);
+
+    /**
+     * @brief 应答一批写请求之前等待 WAL 落盘
+     *
+     * 日志写入失败时撤回输出缓冲区中 writeMark（本批第一个写请求的应答）之后的内容，
+     * 换成一条按 format 编码的错误应答并关闭连接。
+     * @return false 日志写入失败，调用方丢弃本批剩余的请求
+     */
+    bool syncWrites(const TcpConnectionPtr& conn, size_t writeMark, const ReplyFormat& format);
+
+    struct ScanState;
+
+    /**
+     * @brief 输出 state->scan 的 RANGE/SCAN 结果，直接编码进连接的输出缓冲区
+     *
+     * 输出缓冲区积压到 kScanChunkSize 以上、写一次也写不下去（对端读得慢）时暂停：
+     * 登记写完成回调，缓冲区写空后从最后输出的 key 之后继续，内存中最多积压一块结果。
+     * 暂停期间连接之后的应答不会发出；默认执行模型下之后的请求留在输入缓冲区中，不执行。
+     * 分片只由所属线程访问时（shard-per-core），归并各分片取回的一批结果，
+     * 某个分片的一批用完时暂停，等 fetchScanParts 取回下一批后继续。
+     *
+     * @return true 遍历结束，结尾的 +OK 已编码、state->scan 已清空；false 已暂停
+     */
+    bool streamScan(const TcpConnectionPtr& conn, ConnectionState* state);
+
+    /// 暂停的 RANGE/SCAN 所在连接的输出缓冲区写空了：继续遍历，结束后处理积压的请求
+    void onScanWritable(const TcpConnectionPtr& conn);
+
+    /// shard-per-core：向一批结果已经用完的分片的所属线程取下一批，全部返回后继续 streamScan
+    void fetchScanParts(const TcpConnectionPtr& conn, ConnectionState* state);
+
+    static const size_t kScanChunkSize = 64 * 1024;  // RANGE/SCAN 暂停的输出积压阈值
+
+    // ==================== shard-per-core 模式 ====================
+
+    using SequencedRequests = std::vector<std::pair<uint64_t, Request>>;
+    using SequencedResponses = std::vector<std::pair<uint64_t, Response>>;
+
+    void onMessageSharded(const TcpConnectionPtr& conn, Buffer* buf);
+
+    /**
+     * @brief 按连接的协议从 buf 取出一个请求
+     *
+     * 二进制协议和 RESP 的应答编码方式按序号排入连接状态，发送应答时依次取出。
+     * 不需要执行的请求（格式错误、RESP 的握手命令和参数错误）应答直接写入 reply；
+     * 格式错误时 *malformed 为 true，调用方发送 reply 后关闭连接。
+     * @return false 数据不完整
+     */
+    bool nextRequest(ConnectionState* state, Buffer* buf, Request* request, Buffer* reply,
+                     bool* malformed);
+
+    /// 按连接的协议把一个应答编码进连接的输出缓冲区（由 flushResponses 统一写出）
+    void sendResponse(const TcpConnectionPtr& conn, ConnectionState* state,
+                      const Response& response);
+
+    /// 将积攒的请求批量转发给各自所属线程
+    void dispatchForwards(const TcpConnectionPtr& conn, std::vector<SequencedRequests>* forwards);
+
+    /// 在分片所属线程中执行一批转发来的请求，结果投递回连接所在线程
+    void executeForwarded(const TcpConnectionPtr& conn, const SequencedRequests& requests);
+
+    /**
+     * @brief 向所有分片所属线程广播跨分片请求，全部完成后再应答
+     *
+     * SIZE/CLEAR 和批量命令在各线程中处理自己的分片；RANGE/SCAN 只作为屏障，
+     * 等之前转发的请求都执行完后，轮到它发送时再开始遍历（见 streamScan）。
+     */
+    void broadcastRequest(const TcpConnectionPtr& conn, uint64_t seq, const Request& request,
+                          const ReplyFormat& format);
+
+    /// 批量命令在一个线程中的执行结果，indices 为这部分 key 在请求中的下标
+    struct BatchPart {
+        std::vector<size_t> indices;
+        std::vector<Value> values;  // 仅 MGET
+        std::vector<bool> found;    // 仅 MGET
+        size_t count = 0;
+    };
+
+    /// 执行批量命令中属于 loopIndex 线程分片的 key
+    void executeBatchPart(const Request& request, size_t loopIndex, BatchPart* part);
+
+    /// 合并各线程的结果并编码应答
+    static std::string mergeBatchParts(const Request& request, const ReplyFormat& format,
+                                       const std::vector<BatchPart>& parts);
+
+    /// 收到执行结果（连接所在线程）
+    void completeRequests(const TcpConnectionPtr& conn, const SequencedResponses& responses);
+
+    /// 按请求顺序把已就绪的响应编码进输出缓冲区，最后一次写出
+    void flushResponses(const TcpConnectionPtr& conn, ConnectionState* state);
+
+    /// 分片所属的 IO 线程下标
+    size_t ownerOf(int shard) const { return static_cast<size_t>(shard) % loops_.size(); }
+
+    /// 定期保存的定时器回调
+    void autoSave();
+
     EventLoop* loop_;
     TcpServer server_;
     KVStore store_;
     std::string dataFile_;
+    WireProtocol defaultProtocol_;     // 第一个字节既不是二进制也不是 RESP 数组时的协议
+
+    bool shardPerLoop_;
+    bool pinThreads_;
+    std::vector<EventLoop*> loops_;  // IO 线程，start() 后有效
+    std::vector<std::string> expiryCursors_;  // 每个存储分片的主动过期进度，只由扫描它的线程访问
+    std::vector<std::pair<EventLoop*, TimerId>> expiryTimers_;  // 主动过期的周期定时器
+
+    double saveInterval_;              // 定期保存的间隔秒数，<= 0 表示关闭
+    TimerId autoSaveTimer_;            // 0 表示没有开启
 };
 
 }  // namespace kvstore
@@ -32,6 +32,35 @@ void printUsage(const char* progname) {
               << "  -p, --port PORT      Server port (default: 6379)\n"
               << "  -t, --threads NUM    IO threads (default: 4)\n"
               << "  -d, --data FILE      Data file path (default: data.db)\n"
+              << "  -e, --engine TYPE    SkipList engine: mutex | lockfree (default: mutex)\n"
+              << "  -s, --shards NUM     Store shards, one skiplist each (default: 1)\n"
+              << "  -c, --shard-per-core Each IO thread owns its shards, foreign keys are forwarded\n"
+              << "                       (shards default to the IO thread count)\n"
+              << "  -a, --pin-threads    Pin each IO thread to a CPU core\n"
+              << "  -i, --hash-index     Keep a hash index for GET/EXISTS/DEL (mutex engine)\n"
+              << "  -z, --prefix-compress Store skiplist keys prefix-compressed (mutex engine,\n"
+              << "                       not combined with --hash-index)\n"
+              << "  -m, --mmap-values    Long values loaded from the data file reference its\n"
+              << "                       mapping instead of being copied to the heap\n"
+              << "  -b, --bloom-bits NUM Bloom filter bits per key for each shard, 0 disables\n"
+              << "                       (default: 10)\n"
+              << "  -L, --load-threads NUM Threads decoding the data file at startup\n"
+              << "                       (default: CPU cores, 1 loads serially)\n"
+              << "  -T, --table-dir DIR  Keep data beyond memory in SSTables under DIR\n"
+              << "                       (mutex engine; the data file becomes an export)\n"
+              << "  -M, --memtable-mb MB In-memory data flushed to a table past MB (default: 64)\n"
+              << "  -x, --maxmemory-mb MB Evict keys when data would exceed MB (mutex engine,\n"
+              << "                       without --table-dir; default: unlimited)\n"
+              << "  -v, --eviction POLICY Eviction policy: lru | lfu (default: lru)\n"
+              << "  -w, --wal FILE       Write-ahead log replayed at startup (default: off)\n"
+              << "  -f, --fsync POLICY   WAL fsync policy: always | never | N (every N ms,\n"
+              << "                       default: 1000)\n"
+              << "  -S, --save-interval SECONDS\n"
+              << "                       Background save (BGSAVE) every SECONDS when there\n"
+              << "                       were writes (default: off)\n"
+              << "  -P, --protocol TYPE  Protocol of connections that start with neither a binary\n"
+              << "                       frame nor a RESP array: text | resp (default: text;\n"
+              << "                       resp skips the welcome line, for redis-cli/benchmark)\n"
               << "  -h, --help           Show this help\n";
 }
 
@@ -39,18 +68,45 @@ int main(int argc, char* argv[]) {
     int port = 6379;
     int threads = 4;
     std::string dataFile = "data.db";
+    KVStoreOptions storeOptions;
+    bool shardsSet = false;
+    bool shardPerCore = false;
+    bool pinThreads = false;
+    std::string walFile;
+    WalOptions walOptions;
+    double saveInterval = 0;
+    std::string tableDir;
+    TableOptions tableOptions;
+    WireProtocol protocol = WireProtocol::kText;
 
     // 解析命令行参数
     static struct option longOptions[] = {
         {"port", required_argument, nullptr, 'p'},
         {"threads", required_argument, nullptr, 't'},
         {"data", required_argument, nullptr, 'd'},
+        {"engine", required_argument, nullptr, 'e'},
+        {"shards", required_argument, nullptr, 's'},
+        {"shard-per-core", no_argument, nullptr, 'c'},
+        {"pin-threads", no_argument, nullptr, 'a'},
+        {"hash-index", no_argument, nullptr, 'i'},
+        {"prefix-compress", no_argument, nullptr, 'z'},
+        {"mmap-values", no_argument, nullptr, 'm'},
+        {"bloom-bits", required_argument, nullptr, 'b'},
+        {"load-threads", required_argument, nullptr, 'L'},
+        {"table-dir", required_argument, nullptr, 'T'},
+        {"memtable-mb", required_argument, nullptr, 'M'},
+        {"maxmemory-mb", required_argument, nullptr, 'x'},
+        {"eviction", required_argument, nullptr, 'v'},
+        {"wal", required_argument, nullptr, 'w'},
+        {"fsync", required_argument, nullptr, 'f'},
+        {"save-interval", required_argument, nullptr, 'S'},
+        {"protocol", required_argument, nullptr, 'P'},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, 0, nullptr, 0}
     };
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "p:t:d:h", longOptions, nullptr)) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:t:d:e:s:caizmb:L:T:M:x:v:w:f:S:P:h", longOptions, nullptr)) != -1) {
         switch (opt) {
             case 'p':
                 port = atoi(optarg);
@@ -61,6 +117,123 @@ int main(int argc, char* argv[]) {
             case 'd':
                 dataFile = optarg;
                 break;
+            case 'e':
+                if (std::string(optarg) == "lockfree") {
+                    storeOptions.skipListType = SkipListType::kLockFree;
+                } else if (std::string(optarg) == "mutex") {
+                    storeOptions.skipListType = SkipListType::kMutex;
+                } else {
+                    std::cerr << "Unknown engine: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 's':
+                storeOptions.shards = atoi(optarg);
+                if (storeOptions.shards < 1) {
+                    std::cerr << "Invalid shards: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                shardsSet = true;
+                break;
+            case 'c':
+                shardPerCore = true;
+                break;
+            case 'a':
+                pinThreads = true;
+                break;
+            case 'i':
+                storeOptions.hashIndex = true;
+                break;
+            case 'z':
+                storeOptions.prefixCompression = true;
+                break;
+            case 'm':
+                storeOptions.mmapValues = true;
+                break;
+            case 'b':
+                storeOptions.bloomBitsPerKey = atoi(optarg);
+                if (storeOptions.bloomBitsPerKey < 0 || storeOptions.bloomBitsPerKey > 64) {
+                    std::cerr << "Invalid bloom bits: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'L':
+                storeOptions.loadThreads = atoi(optarg);
+                if (storeOptions.loadThreads < 1) {
+                    std::cerr << "Invalid load threads: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'T':
+                tableDir = optarg;
+                break;
+            case 'M':
+                if (atoi(optarg) < 1) {
+                    std::cerr << "Invalid memtable size: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                tableOptions.memtableBytes = static_cast<size_t>(atoi(optarg)) * 1024 * 1024;
+                break;
+            case 'x':
+                if (atoi(optarg) < 1) {
+                    std::cerr << "Invalid maxmemory: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                storeOptions.maxMemory = static_cast<size_t>(atoi(optarg)) * 1024 * 1024;
+                break;
+            case 'v':
+                if (std::string(optarg) == "lru") {
+                    storeOptions.evictionPolicy = EvictionPolicy::kLru;
+                } else if (std::string(optarg) == "lfu") {
+                    storeOptions.evictionPolicy = EvictionPolicy::kLfu;
+                } else {
+                    std::cerr << "Unknown eviction policy: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'w':
+                walFile = optarg;
+                break;
+            case 'f':
+                if (std::string(optarg) == "always") {
+                    walOptions.syncPolicy = WalSyncPolicy::kAlways;
+                } else if (std::string(optarg) == "never") {
+                    walOptions.syncPolicy = WalSyncPolicy::kNever;
+                } else if (atoi(optarg) > 0) {
+                    walOptions.syncPolicy = WalSyncPolicy::kInterval;
+                    walOptions.syncIntervalMs = atoi(optarg);
+                } else {
+                    std::cerr << "Unknown fsync policy: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'S':
+                saveInterval = atof(optarg);
+                if (saveInterval <= 0) {
+                    std::cerr << "Invalid save interval: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
+            case 'P':
+                if (std::string(optarg) == "text") {
+                    protocol = WireProtocol::kText;
+                } else if (std::string(optarg) == "resp") {
+                    protocol = WireProtocol::kResp;
+                } else {
+                    std::cerr << "Unknown protocol: " << optarg << "\n";
+                    printUsage(argv[0]);
+                    return 1;
+                }
+                break;
             case 'h':
             default:
                 printUsage(argv[0]);
@@ -68,6 +241,10 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (shardPerCore && !shardsSet) {
+        storeOptions.shards = threads > 0 ? threads : 1;
+    }
+
     // 保存全局数据文件路径
     g_dataFile = dataFile;
 
@@ -82,19 +259,59 @@ int main(int argc, char* argv[]) {
     std::cout << "  Port:      " << port << "\n";
     std::cout << "  Threads:   " << threads << "\n";
     std::cout << "  Data File: " << dataFile << "\n";
+    std::cout << "  Engine:    "
+              << (storeOptions.skipListType == SkipListType::kLockFree ? "lockfree" : "mutex")
+              << (storeOptions.hashIndex ? " + hash index" : "")
+              << (storeOptions.prefixCompression ? " + prefix compression" : "")
+              << (storeOptions.mmapValues ? " + mapped values" : "") << "\n";
+    std::cout << "  Protocol:  " << (protocol == WireProtocol::kResp ? "resp" : "text")
+              << " (binary and RESP arrays auto-detected)\n";
+    std::cout << "  Shards:    " << storeOptions.shards
+              << (shardPerCore ? " (shard-per-core)" : "") << "\n";
+    if (!walFile.empty()) {
+        std::cout << "  WAL:       " << walFile << " (fsync "
+                  << (walOptions.syncPolicy == WalSyncPolicy::kAlways
+                          ? "always"
+                          : walOptions.syncPolicy == WalSyncPolicy::kNever
+                                ? "never"
+                                : "every " + std::to_string(walOptions.syncIntervalMs) + "ms")
+                  << ")\n";
+    }
+    if (!tableDir.empty()) {
+        std::cout << "  Tables:    " << tableDir << " (memtable "
+                  << tableOptions.memtableBytes / (1024 * 1024) << "MB)\n";
+    }
+    if (storeOptions.maxMemory > 0) {
+        std::cout << "  Maxmemory: " << storeOptions.maxMemory / (1024 * 1024) << "MB ("
+                  << evictionPolicyName(storeOptions.evictionPolicy) << ")\n";
+    }
+    if (saveInterval > 0) {
+        std::cout << "  Auto Save: every " << saveInterval << "s\n";
+    }
     std::cout << "========================================\n";
     std::cout << "Press Ctrl+C to stop\n\n";
 
     EventLoop loop;
     g_loop = &loop;
 
-    KVServer server(&loop, static_cast<uint16_t>(port), "ReactorKV");
+    KVServer server(&loop, static_cast<uint16_t>(port), "ReactorKV", storeOptions);
     g_server = &server;
 
     server.setThreadNum(threads);
+    server.setShardPerLoop(shardPerCore, pinThreads);
+    server.setSaveInterval(saveInterval);
+    server.setDefaultProtocol(protocol);
+
+    if (!tableDir.empty() && !server.openTables(tableDir, tableOptions)) {
+        std::cerr << "Failed to open tables in " << tableDir << "\n";
+        return 1;
+    }
 
-    // 尝试加载数据
-    if (!dataFile.empty()) {
+    // 尝试加载数据；磁盘层已有表时数据在表中，数据文件只是导出
+    if (server.store().hasTables() && server.store().tables()->tableCount() > 0) {
+        server.setDataFile(dataFile);
+        LOG_INFO << "Data in " << tableDir << ", " << dataFile << " not loaded";
+    } else if (!dataFile.empty()) {
         if (server.loadData(dataFile)) {
             LOG_INFO << "Loaded " << server.store().size() << " keys from " << dataFile;
         } else {
@@ -102,12 +319,24 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // 快照之后的写操作从 WAL 重放，必须在开始接受请求之前完成
+    if (!walFile.empty() && !server.openLog(walFile, walOptions)) {
+        std::cerr << "Failed to open WAL " << walFile << "\n";
+        return 1;
+    }
+
     server.start();
     loop.loop();
 
     // 主循环退出后保存数据（这里是安全的）
     std::cout << "\nShutting down...\n";
-    if (g_server && !g_dataFile.empty()) {
+    if (g_server && g_server->store().hasTables()) {
+        if (g_server->store().flush()) {
+            std::cout << "Memtable flushed to " << tableDir << "\n";
+        } else {
+            std::cerr << "Failed to flush memtable\n";
+        }
+    } else if (g_server && !g_dataFile.empty()) {
         if (g_server->saveData(g_dataFile)) {
             std::cout << "Data saved to " << g_dataFile << "\n";
         } else {
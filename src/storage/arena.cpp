@@ -0,0 +1,62 @@
+// src/storage/arena.cpp
+#include "storage/arena.h"
+
+#include <cstdint>
+
+namespace kvstore {
+
+Arena::Arena()
+    : allocPtr_(nullptr),
+      allocBytesRemaining_(0),
+      memoryUsage_(0) {}
+
+Arena::~Arena() {
+    for (char* block : blocks_) {
+        delete[] block;
+    }
+}
+
+char* Arena::allocateFallback(size_t bytes) {
+    if (bytes > kBlockSize / 4) {
+        // 大对象单独分配一块，避免浪费当前块的剩余空间
+        return allocateNewBlock(bytes);
+    }
+
+    // 当前块剩余空间直接丢弃，重新申请一个标准块
+    allocPtr_ = allocateNewBlock(kBlockSize);
+    allocBytesRemaining_ = kBlockSize;
+
+    char* result = allocPtr_;
+    allocPtr_ += bytes;
+    allocBytesRemaining_ -= bytes;
+    return result;
+}
+
+char* Arena::allocateAligned(size_t bytes) {
+    const size_t align = (sizeof(void*) > 8) ? sizeof(void*) : 8;
+    static_assert((align & (align - 1)) == 0, "Pointer size should be a power of 2");
+
+    size_t currentMod = reinterpret_cast<uintptr_t>(allocPtr_) & (align - 1);
+    size_t slop = (currentMod == 0 ? 0 : align - currentMod);
+    size_t needed = bytes + slop;
+
+    char* result;
+    if (needed <= allocBytesRemaining_) {
+        result = allocPtr_ + slop;
+        allocPtr_ += needed;
+        allocBytesRemaining_ -= needed;
+    } else {
+        // new[] 返回的内存总是满足对齐要求
+        result = allocateFallback(bytes);
+    }
+    return result;
+}
+
+char* Arena::allocateNewBlock(size_t blockBytes) {
+    char* result = new char[blockBytes];
+    blocks_.push_back(result);
+    memoryUsage_.fetch_add(blockBytes + sizeof(char*), std::memory_order_relaxed);
+    return result;
+}
+
+}  // namespace kvstore
@@ -0,0 +1,63 @@
+// src/storage/arena.h
+#ifndef KVSTORE_STORAGE_ARENA_H
+#define KVSTORE_STORAGE_ARENA_H
+
+#include "base/noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace kvstore {
+
+/**
+ * @brief 内存池（Arena）
+ *
+ * 按块（默认 4KB）向系统申请内存，再从块中顺序切分小对象。
+ * 切出去的内存不单独归还，Arena 析构时整体释放。
+ *
+ * 用途：为跳表节点提供连续、低开销的内存分配，
+ * 避免每个节点一次 malloc 带来的元数据开销和内存碎片。
+ *
+ * 线程安全：allocate 不是线程安全的，由调用方加锁；
+ * memoryUsage 可以在任意线程读取。
+ */
+class Arena : noncopyable {
+public:
+    Arena();
+    ~Arena();
+
+    /// 分配 bytes 字节（不保证对齐）
+    char* allocate(size_t bytes);
+
+    /// 分配 bytes 字节，按指针大小对齐
+    char* allocateAligned(size_t bytes);
+
+    /// 已向系统申请的总内存（含块内未用完的部分）
+    size_t memoryUsage() const { return memoryUsage_.load(std::memory_order_relaxed); }
+
+private:
+    char* allocateFallback(size_t bytes);
+    char* allocateNewBlock(size_t blockBytes);
+
+    static const size_t kBlockSize = 4096;
+
+    char* allocPtr_;                  // 当前块中下一个可用位置
+    size_t allocBytesRemaining_;      // 当前块剩余字节
+    std::vector<char*> blocks_;       // 所有已申请的块
+    std::atomic<size_t> memoryUsage_;
+};
+
+inline char* Arena::allocate(size_t bytes) {
+    if (bytes <= allocBytesRemaining_) {
+        char* result = allocPtr_;
+        allocPtr_ += bytes;
+        allocBytesRemaining_ -= bytes;
+        return result;
+    }
+    return allocateFallback(bytes);
+}
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_ARENA_H
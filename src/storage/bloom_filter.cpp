@@ -0,0 +1,276 @@
+// src/storage/bloom_filter.cpp
+#include "storage/bloom_filter.h"
+
+#include "base/coding.h"
+#include "base/epoch.h"
+
+#include <algorithm>
+
+namespace kvstore {
+
+namespace {
+
+/// k 的上限，超过后误判率几乎不再下降，只是增加探测的开销
+const int kMaxProbes = 30;
+
+/// 每块的 64 位字数
+const size_t kWordsPerBlock = BloomFilter::kBlockBytes / 8;
+
+/// memtable 过滤器至少按这么多 key 分配，空的分片也能先插入一批再重建
+const size_t kMinFilterKeys = 1024;
+
+}  // namespace
+
+uint32_t BloomFilter::hash(const char* data, size_t n) {
+    const uint32_t m = 0xc6a4a793;
+    const uint32_t seed = 0xbc9f1d34;
+    uint32_t h = seed ^ static_cast<uint32_t>(n * m);
+
+    // 每次处理 4 字节
+    const char* limit = data + n;
+    while (data + 4 <= limit) {
+        h += decodeFixed32(data);
+        h *= m;
+        h ^= (h >> 16);
+        data += 4;
+    }
+
+    // 剩余不足 4 字节
+    switch (limit - data) {
+        case 3:
+            h += static_cast<uint32_t>(static_cast<uint8_t>(data[2])) << 16;
+            // fall through
+        case 2:
+            h += static_cast<uint32_t>(static_cast<uint8_t>(data[1])) << 8;
+            // fall through
+        case 1:
+            h += static_cast<uint32_t>(static_cast<uint8_t>(data[0]));
+            h *= m;
+            h ^= (h >> 24);
+            break;
+    }
+    return h;
+}
+
+int BloomFilter::probes(int bitsPerKey) {
+    // k = bitsPerKey * ln2 时误判率最低
+    int k = static_cast<int>(bitsPerKey * 0.69);
+    if (k < 1) {
+        k = 1;
+    }
+    if (k > kMaxProbes) {
+        k = kMaxProbes;
+    }
+    return k;
+}
+
+size_t BloomFilter::blockCount(size_t keys, int bitsPerKey) {
+    if (bitsPerKey < 1) {
+        bitsPerKey = 1;
+    }
+    size_t bits = keys * static_cast<size_t>(bitsPerKey);
+    size_t blocks = (bits + kBlockBits - 1) / kBlockBits;
+    return blocks > 0 ? blocks : 1;
+}
+
+void BloomFilter::build(const std::vector<uint32_t>& hashes, int bitsPerKey, std::string* out) {
+    const int k = probes(bitsPerKey);
+    const size_t blocks = blockCount(hashes.size(), bitsPerKey);
+
+    const size_t start = out->size();
+    out->resize(start + blocks * kBlockBytes, 0);
+    out->push_back(static_cast<char>(k));
+    char* array = &(*out)[start];
+    for (uint32_t h : hashes) {
+        char* block = array + blockOf(h, blocks) * kBlockBytes;
+        const uint32_t delta = (h >> 17) | (h << 15);  // 右旋 17 位
+        for (int j = 0; j < k; j++) {
+            const uint32_t pos = h % kBlockBits;
+            block[pos / 8] |= static_cast<char>(1 << (pos % 8));
+            h += delta;
+        }
+    }
+}
+
+bool BloomFilter::mayContain(const char* filter, size_t len, uint32_t hash) {
+    if (len < 1 + kBlockBytes || (len - 1) % kBlockBytes != 0) {
+        return true;
+    }
+    const size_t blocks = (len - 1) / kBlockBytes;
+    const int k = static_cast<uint8_t>(filter[len - 1]);
+    if (k < 1 || k > kMaxProbes) {
+        return true;
+    }
+
+    const char* block = filter + blockOf(hash, blocks) * kBlockBytes;
+    const uint32_t delta = (hash >> 17) | (hash << 15);
+    for (int j = 0; j < k; j++) {
+        const uint32_t pos = hash % kBlockBits;
+        if ((block[pos / 8] & (1 << (pos % 8))) == 0) {
+            return false;
+        }
+        hash += delta;
+    }
+    return true;
+}
+
+// ==================== MemtableFilter ====================
+
+MemtableFilter::Bits::Bits(size_t keys, int bitsPerKey) {
+    // 留出一倍的余量，memtable 增长到两倍之前不用重建
+    const size_t capacity = std::max(keys * 2, kMinFilterKeys);
+    blocks = BloomFilter::blockCount(capacity, bitsPerKey);
+    budget = capacity - keys;
+    const size_t count = blocks * kWordsPerBlock;
+    words.reset(new std::atomic<uint64_t>[count]);
+    for (size_t i = 0; i < count; i++) {
+        words[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void MemtableFilter::Bits::add(uint32_t hash, int k) {
+    std::atomic<uint64_t>* block = &words[BloomFilter::blockOf(hash, blocks) * kWordsPerBlock];
+    const uint32_t delta = (hash >> 17) | (hash << 15);
+    // 同一个字上的位先合并，减少原子操作的次数
+    uint64_t masks[kWordsPerBlock] = {};
+    for (int j = 0; j < k; j++) {
+        const uint32_t pos = hash % BloomFilter::kBlockBits;
+        masks[pos / 64] |= uint64_t(1) << (pos % 64);
+        hash += delta;
+    }
+    for (size_t i = 0; i < kWordsPerBlock; i++) {
+        if (masks[i] != 0 && (block[i].load(std::memory_order_relaxed) & masks[i]) != masks[i]) {
+            block[i].fetch_or(masks[i], std::memory_order_release);
+        }
+    }
+}
+
+bool MemtableFilter::Bits::mayContain(uint32_t hash, int k) const {
+    const std::atomic<uint64_t>* block =
+        &words[BloomFilter::blockOf(hash, blocks) * kWordsPerBlock];
+    const uint32_t delta = (hash >> 17) | (hash << 15);
+    for (int j = 0; j < k; j++) {
+        const uint32_t pos = hash % BloomFilter::kBlockBits;
+        if ((block[pos / 64].load(std::memory_order_acquire) & (uint64_t(1) << (pos % 64))) == 0) {
+            return false;
+        }
+        hash += delta;
+    }
+    return true;
+}
+
+MemtableFilter::MemtableFilter(int bitsPerKey)
+    : bitsPerKey_(bitsPerKey),
+      k_(BloomFilter::probes(bitsPerKey)),
+      active_(new Bits(0, bitsPerKey)),
+      building_(nullptr),
+      added_(0),
+      removed_(0),
+      budget_(0),
+      rebuilding_(false),
+      rebuilds_(0),
+      negatives_(0),
+      falsePositives_(0) {
+    budget_.store(active_.load(std::memory_order_relaxed)->budget, std::memory_order_relaxed);
+}
+
+MemtableFilter::~MemtableFilter() {
+    delete active_.load(std::memory_order_relaxed);
+    delete building_.load(std::memory_order_relaxed);
+    for (auto& retired : retired_) {
+        delete retired.second;
+    }
+}
+
+uint64_t MemtableFilter::add(uint32_t hash) {
+    EpochGuard guard;
+    const uint64_t generation = rebuilds_.load(std::memory_order_acquire);
+    active_.load(std::memory_order_acquire)->add(hash, k_);
+    if (Bits* building = building_.load(std::memory_order_acquire)) {
+        building->add(hash, k_);
+    }
+    return generation;
+}
+
+void MemtableFilter::inserted(uint32_t hash, bool isNew, uint64_t generation) {
+    if (isNew) {
+        added_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 与 beginRebuild 配对：要么重建的遍历看到了这次插入，要么这里看到了新的位数组
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    EpochGuard guard;
+    Bits* building = building_.load(std::memory_order_acquire);
+    if (building != nullptr) {
+        building->add(hash, k_);
+    } else if (rebuilds_.load(std::memory_order_acquire) != generation) {
+        // 重建在 add 之后已经结束，此时 active_ 是新的位数组
+        active_.load(std::memory_order_acquire)->add(hash, k_);
+    }
+}
+
+void MemtableFilter::noteRemove() {
+    removed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool MemtableFilter::mayContain(uint32_t hash) const {
+    EpochGuard guard;
+    if (active_.load(std::memory_order_acquire)->mayContain(hash, k_)) {
+        return true;
+    }
+    negatives_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool MemtableFilter::needsRebuild() const {
+    const size_t budget = budget_.load(std::memory_order_relaxed);
+    return added_.load(std::memory_order_relaxed) > budget ||
+           removed_.load(std::memory_order_relaxed) > budget;
+}
+
+bool MemtableFilter::beginRebuild(size_t keys) {
+    bool expected = false;
+    if (!rebuilding_.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+        return false;
+    }
+    // 先清零计数：遍历期间的插入计入下一轮
+    added_.store(0, std::memory_order_relaxed);
+    removed_.store(0, std::memory_order_relaxed);
+    building_.store(new Bits(keys, bitsPerKey_), std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    return true;
+}
+
+void MemtableFilter::addRebuilt(uint32_t hash) {
+    building_.load(std::memory_order_relaxed)->add(hash, k_);
+}
+
+void MemtableFilter::endRebuild() {
+    Bits* rebuilt = building_.load(std::memory_order_relaxed);
+    budget_.store(rebuilt->budget, std::memory_order_relaxed);
+    Bits* old = active_.exchange(rebuilt, std::memory_order_acq_rel);
+    rebuilds_.fetch_add(1, std::memory_order_release);
+    building_.store(nullptr, std::memory_order_seq_cst);
+    retired_.emplace_back(EpochManager::instance().retireEpoch(), old);
+    reclaim();
+    rebuilding_.store(false, std::memory_order_release);
+}
+
+void MemtableFilter::reclaim() {
+    uint64_t safeEpoch = EpochManager::instance().minActiveEpoch();
+    while (!retired_.empty() && retired_.front().first < safeEpoch) {
+        delete retired_.front().second;
+        retired_.pop_front();
+    }
+}
+
+MemtableFilter::Stats MemtableFilter::stats() const {
+    Stats stats;
+    stats.negatives = negatives_.load(std::memory_order_relaxed);
+    stats.falsePositives = falsePositives_.load(std::memory_order_relaxed);
+    stats.rebuilds = rebuilds_.load(std::memory_order_relaxed);
+    EpochGuard guard;
+    stats.bytes = active_.load(std::memory_order_acquire)->blocks * BloomFilter::kBlockBytes;
+    return stats;
+}
+
+}  // namespace kvstore
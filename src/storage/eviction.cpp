@@ -0,0 +1,68 @@
+// src/storage/eviction.cpp
+#include "storage/eviction.h"
+
+#include <time.h>
+
+#include <random>
+
+namespace kvstore {
+
+const int AccessTracker::kLfuInitial;
+const int AccessTracker::kLfuLogFactor;
+const int AccessTracker::kLfuDecayMinutes;
+
+namespace {
+
+/// 粗粒度单调时钟（秒）
+uint32_t coarseSeconds() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    return static_cast<uint32_t>(ts.tv_sec);
+}
+
+/// [0, 1) 内的随机数，决定 LFU 计数是否增加
+double randomUnit() {
+    thread_local std::mt19937 gen(std::random_device{}());
+    thread_local std::uniform_real_distribution<> dis(0.0, 1.0);
+    return dis(gen);
+}
+
+}  // namespace
+
+const char* evictionPolicyName(EvictionPolicy policy) {
+    return policy == EvictionPolicy::kLfu ? "lfu" : "lru";
+}
+
+uint16_t AccessTracker::touch(uint16_t access, bool created) const {
+    const uint32_t now = coarseSeconds();
+    if (policy_ == EvictionPolicy::kLru) {
+        return static_cast<uint16_t>(now);
+    }
+    const uint32_t minutes = now / 60;
+    uint32_t counter = created ? kLfuInitial : decayedCounter(access, minutes);
+    if (!created && counter < 255) {
+        const int base = static_cast<int>(counter) - kLfuInitial;
+        const double p = 1.0 / ((base > 0 ? base : 0) * kLfuLogFactor + 1);
+        if (randomUnit() < p) {
+            counter++;
+        }
+    }
+    return static_cast<uint16_t>(counter << 8 | (minutes & 0xff));
+}
+
+uint32_t AccessTracker::score(uint16_t access) const {
+    const uint32_t now = coarseSeconds();
+    if (policy_ == EvictionPolicy::kLru) {
+        return static_cast<uint16_t>(now - access);
+    }
+    return 255 - decayedCounter(access, now / 60);
+}
+
+uint32_t AccessTracker::decayedCounter(uint16_t access, uint32_t nowMinutes) {
+    const uint32_t counter = access >> 8;
+    const uint32_t elapsed = (nowMinutes - access) & 0xff;
+    const uint32_t periods = elapsed / kLfuDecayMinutes;
+    return counter > periods ? counter - periods : 0;
+}
+
+}  // namespace kvstore
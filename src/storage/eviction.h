@@ -0,0 +1,65 @@
+// src/storage/eviction.h
+#ifndef KVSTORE_STORAGE_EVICTION_H
+#define KVSTORE_STORAGE_EVICTION_H
+
+#include <cstdint>
+
+namespace kvstore {
+
+/**
+ * @brief 内存超过上限时的淘汰策略
+ */
+enum class EvictionPolicy {
+    kLru,  // 近似 LRU：淘汰最久没有访问的 key（默认）
+    kLfu,  // 近似 LFU：淘汰访问频率最低的 key，频率随时间衰减
+};
+
+/// 策略名（"lru" / "lfu"）
+const char* evictionPolicyName(EvictionPolicy policy);
+
+/**
+ * @brief 淘汰用的访问记录
+ *
+ * 每个跳表节点有一个 16 位的访问字，读命中和写入时由 touch 算出新值。
+ * 访问字很小，记录的是近似值；淘汰时随机采样一批 key，按 score 选出最该淘汰的（见 KVStore）。
+ * 时钟取 CLOCK_MONOTONIC_COARSE，不进入内核，精度为一个调度 tick。
+ *
+ * - kLru：访问字为最近一次访问的时刻（秒，对 2^16 取模）。空闲超过约 18 小时后回绕，
+ *   这样的 key 可能被当成刚访问过，只影响它被选中的先后。
+ * - kLfu：高 8 位为对数计数器，低 8 位为计数上次衰减的时刻（分钟，对 256 取模）。
+ *   计数为 c 时每次访问以 1 / ((c - kLfuInitial) * kLfuLogFactor + 1) 的概率加 1，
+ *   访问上百万次才会饱和；每经过 kLfuDecayMinutes 分钟计数减 1，过去的热点会逐渐冷却。
+ *   新 key 的计数从 kLfuInitial 开始，刚写入的 key 不会马上被淘汰。
+ *
+ * 无状态，可以在任意线程调用。
+ */
+class AccessTracker {
+public:
+    static const int kLfuInitial = 5;
+    static const int kLfuLogFactor = 10;
+    static const int kLfuDecayMinutes = 1;
+
+    explicit AccessTracker(EvictionPolicy policy) : policy_(policy) {}
+
+    EvictionPolicy policy() const { return policy_; }
+
+    /**
+     * @brief 一次访问之后的访问字
+     * @param access 原来的访问字
+     * @param created 是否为新写入的 key（原来的访问字无意义）
+     */
+    uint16_t touch(uint16_t access, bool created) const;
+
+    /// 淘汰的优先级，越大越应该淘汰：LRU 为空闲的秒数，LFU 为 255 减去衰减后的计数
+    uint32_t score(uint16_t access) const;
+
+private:
+    /// 衰减到 nowMinutes 之后的计数
+    static uint32_t decayedCounter(uint16_t access, uint32_t nowMinutes);
+
+    EvictionPolicy policy_;
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_EVICTION_H
@@ -0,0 +1,253 @@
+// src/storage/hash_index.h
+#ifndef KVSTORE_STORAGE_HASH_INDEX_H
+#define KVSTORE_STORAGE_HASH_INDEX_H
+
+#include "base/epoch.h"
+#include "base/noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace kvstore {
+
+/**
+ * @brief 开放寻址哈希索引（key -> 节点指针）
+ *
+ * 作为跳表的辅助索引：跳表负责有序遍历，点查询（GET/EXISTS）直接在这里探测，
+ * 不再逐层做字符串比较。索引只保存指针，不拥有被索引的对象。
+ *
+ * 实现：
+ * - 线性探测，容量为 2 的幂；槽位保存 key 的哈希值和对象指针
+ * - 删除留下墓碑，插入时复用；墓碑和占用槽位超过 70% 时整体重建
+ * - 重建 / clear 时换上新表，旧表交给 EpochManager，宽限期后释放
+ *
+ * 线程安全：
+ * - find() 无锁，调用方需处于 epoch 保护中（EventLoop 线程或 EpochGuard 内），
+ *   且返回的对象本身也由调用方按 epoch 延迟回收
+ * - insert/erase/clear 需要调用方串行化（持有写锁）
+ *
+ * @tparam K 键类型，需要 std::hash<K> 和 ==
+ * @tparam T 被索引的对象类型，需要有成员 key
+ */
+template <typename K, typename T>
+class HashIndex : noncopyable {
+public:
+    explicit HashIndex(size_t initialCapacity = kMinCapacity);
+    ~HashIndex();
+
+    /// 查找 key 对应的对象，不存在返回 nullptr（无锁）
+    T* find(const K& key) const;
+
+    /// 插入或替换 key 对应的对象
+    void insert(const K& key, T* item);
+
+    /// 删除 key，返回是否存在
+    bool erase(const K& key);
+
+    /// 清空索引
+    void clear();
+
+    /// 索引中的 key 数量
+    size_t size() const { return live_; }
+
+    /// 当前哈希表占用的内存
+    size_t memoryUsage() const {
+        return sizeof(Table) + capacity_.load(std::memory_order_relaxed) * sizeof(Slot);
+    }
+
+private:
+    struct Slot {
+        std::atomic<size_t> hash;
+        std::atomic<T*> item;  // nullptr 表示从未使用，tombstone() 表示已删除
+
+        Slot() : hash(0), item(nullptr) {}
+    };
+
+    struct Table {
+        size_t mask;
+        Slot* slots;
+
+        explicit Table(size_t capacity) : mask(capacity - 1), slots(new Slot[capacity]) {}
+        ~Table() { delete[] slots; }
+    };
+
+    static constexpr size_t kMinCapacity = 16;
+
+    static T* tombstone() { return reinterpret_cast<T*>(static_cast<uintptr_t>(1)); }
+    static size_t hashOf(const K& key) { return std::hash<K>()(key); }
+
+    /// 换上新表并延迟释放旧表
+    void replaceTable(Table* table);
+
+    /// 按当前元素数重建（丢弃墓碑，必要时扩容）
+    void rehash();
+
+    void reclaim();
+
+    std::atomic<Table*> table_;
+    std::atomic<size_t> capacity_;
+    size_t live_;  // 有效 key 数
+    size_t used_;  // 有效 key + 墓碑
+    std::deque<std::pair<uint64_t, Table*>> retired_;
+};
+
+// ==================== 模板类实现 ====================
+
+template <typename K, typename T>
+HashIndex<K, T>::HashIndex(size_t initialCapacity)
+    : table_(nullptr), capacity_(kMinCapacity), live_(0), used_(0) {
+    size_t capacity = kMinCapacity;
+    while (capacity < initialCapacity) {
+        capacity <<= 1;
+    }
+    capacity_.store(capacity, std::memory_order_relaxed);
+    table_.store(new Table(capacity), std::memory_order_release);
+}
+
+template <typename K, typename T>
+HashIndex<K, T>::~HashIndex() {
+    delete table_.load(std::memory_order_relaxed);
+    for (const auto& retired : retired_) {
+        delete retired.second;
+    }
+}
+
+template <typename K, typename T>
+T* HashIndex<K, T>::find(const K& key) const {
+    const size_t hash = hashOf(key);
+    const Table* table = table_.load(std::memory_order_acquire);
+
+    for (size_t i = hash & table->mask, probes = 0; probes <= table->mask;
+         i = (i + 1) & table->mask, probes++) {
+        const Slot& slot = table->slots[i];
+        T* item = slot.item.load(std::memory_order_acquire);
+        if (item == nullptr) {
+            return nullptr;
+        }
+        // hash 在 item 之前写入，acquire 读到 item 后 hash 一定可见
+        if (item != tombstone() && slot.hash.load(std::memory_order_relaxed) == hash &&
+            item->key == key) {
+            return item;
+        }
+    }
+    return nullptr;
+}
+
+template <typename K, typename T>
+void HashIndex<K, T>::insert(const K& key, T* item) {
+    const size_t hash = hashOf(key);
+    Table* table = table_.load(std::memory_order_relaxed);
+
+    Slot* target = nullptr;  // 第一个可复用的墓碑
+    for (size_t i = hash & table->mask;; i = (i + 1) & table->mask) {
+        Slot& slot = table->slots[i];
+        T* current = slot.item.load(std::memory_order_relaxed);
+        if (current == nullptr) {
+            if (target == nullptr) {
+                target = &slot;
+                used_++;
+            }
+            break;
+        }
+        if (current == tombstone()) {
+            if (target == nullptr) {
+                target = &slot;
+            }
+        } else if (slot.hash.load(std::memory_order_relaxed) == hash && current->key == key) {
+            // 已存在：原地替换指针
+            slot.item.store(item, std::memory_order_release);
+            return;
+        }
+    }
+
+    target->hash.store(hash, std::memory_order_relaxed);
+    target->item.store(item, std::memory_order_release);
+    live_++;
+
+    if (used_ * 10 > (table->mask + 1) * 7) {
+        rehash();
+    }
+}
+
+template <typename K, typename T>
+bool HashIndex<K, T>::erase(const K& key) {
+    const size_t hash = hashOf(key);
+    Table* table = table_.load(std::memory_order_relaxed);
+
+    for (size_t i = hash & table->mask, probes = 0; probes <= table->mask;
+         i = (i + 1) & table->mask, probes++) {
+        Slot& slot = table->slots[i];
+        T* current = slot.item.load(std::memory_order_relaxed);
+        if (current == nullptr) {
+            return false;
+        }
+        if (current != tombstone() && slot.hash.load(std::memory_order_relaxed) == hash &&
+            current->key == key) {
+            slot.item.store(tombstone(), std::memory_order_release);
+            live_--;
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename K, typename T>
+void HashIndex<K, T>::clear() {
+    live_ = 0;
+    used_ = 0;
+    replaceTable(new Table(kMinCapacity));
+}
+
+template <typename K, typename T>
+void HashIndex<K, T>::rehash() {
+    // 保证重建后负载不超过 50%
+    size_t capacity = kMinCapacity;
+    while (capacity < live_ * 2) {
+        capacity <<= 1;
+    }
+
+    const Table* oldTable = table_.load(std::memory_order_relaxed);
+    Table* newTable = new Table(capacity);
+    for (size_t i = 0; i <= oldTable->mask; i++) {
+        T* item = oldTable->slots[i].item.load(std::memory_order_relaxed);
+        if (item == nullptr || item == tombstone()) {
+            continue;
+        }
+        size_t hash = oldTable->slots[i].hash.load(std::memory_order_relaxed);
+        size_t j = hash & newTable->mask;
+        while (newTable->slots[j].item.load(std::memory_order_relaxed) != nullptr) {
+            j = (j + 1) & newTable->mask;
+        }
+        newTable->slots[j].hash.store(hash, std::memory_order_relaxed);
+        newTable->slots[j].item.store(item, std::memory_order_relaxed);
+    }
+
+    used_ = live_;
+    replaceTable(newTable);
+}
+
+template <typename K, typename T>
+void HashIndex<K, T>::replaceTable(Table* table) {
+    // release：读者看到新表时，表内容已经填好
+    Table* oldTable = table_.exchange(table, std::memory_order_acq_rel);
+    capacity_.store(table->mask + 1, std::memory_order_relaxed);
+    retired_.emplace_back(EpochManager::instance().retireEpoch(), oldTable);
+    reclaim();
+}
+
+template <typename K, typename T>
+void HashIndex<K, T>::reclaim() {
+    uint64_t safeEpoch = EpochManager::instance().minActiveEpoch();
+    while (!retired_.empty() && retired_.front().first < safeEpoch) {
+        delete retired_.front().second;
+        retired_.pop_front();
+    }
+}
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_HASH_INDEX_H
@@ -1,42 +1,569 @@
 // src/storage/kvstore.cpp
 #include "storage/kvstore.h"
 
+#include "base/count_down_latch.h"
 #include "base/logger.h"
+#include "base/threadpool.h"
+#include "base/timestamp.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <queue>
+#include <thread>
 
 namespace kvstore {
 
-KVStore::KVStore(int maxLevel) : skiplist_(maxLevel) {
-    LOG_INFO << "KVStore initialized with maxLevel=" << maxLevel;
+namespace {
+
+const char* skipListTypeName(SkipListType type) {
+    return type == SkipListType::kLockFree ? "lockfree" : "mutex";
+}
+
+KVStoreOptions makeOptions(int maxLevel) {
+    KVStoreOptions options;
+    options.maxLevel = maxLevel;
+    return options;
+}
+
+/// 解析旧版文本快照的一行，格式 "key:value"（与 SkipList::dumpFile 一致）
+bool parseLine(const std::string& line, std::string& key, std::string& value) {
+    size_t pos = line.find(':');
+    if (pos == std::string::npos || pos == 0) {
+        return false;
+    }
+    key.assign(line, 0, pos);
+    value.assign(line, pos + 1, std::string::npos);
+    return true;
+}
+
+/// 保存快照时每遍历这么多条记录重建一次迭代器，避免长时间持有 epoch 推迟内存回收
+const size_t kSnapshotScanBatch = 4096;
+
+/// memtable 每条记录在 key/value 之外的近似开销（节点头和各层指针）
+const size_t kMemtableEntryOverhead = 64;
+
+/// 每次淘汰从一个分片采样的 key 数
+const size_t kEvictionSamples = 5;
+
+/// 淘汰候选池的容量
+const size_t kEvictionPoolSize = 16;
+
+/// 连续这么多次没能删除任何 key 时放弃本次淘汰（候选都已被并发删除）
+const int kEvictionMaxMisses = 64;
+
+/// 已经过期的 key 的淘汰优先级，高于任何访问记录
+const uint32_t kExpiredScore = UINT32_MAX;
+
+/// 并行加载时每段包含的块数（每块约 64KB）
+const size_t kLoadSegmentBlocks = 16;
+
+/// 并行加载时解码出的一条记录，指针指向快照的映射
+struct LoadRecord {
+    const char* key;
+    const char* value;
+    uint32_t keyLen;
+    uint32_t valueLen;
+    int64_t expireAt;
+};
+
+/// 过期时刻 expireAt 在 nowMs 时是否已经过期（0 表示不过期）
+bool expiredAt(int64_t expireAt, int64_t nowMs) {
+    return expireAt != 0 && expireAt <= nowMs;
+}
+
+/// 值是否已经过期；没有过期时间的值不读时钟
+bool isExpired(const Value& value) {
+    return value.expireAt() != 0 && value.expiredAt(KVStore::nowMs());
+}
+
+/// 从快照加载的值：mapped 时引用映射，带上过期时间
+Value loadedValue(const char* data, size_t len, int64_t expireAt, bool mapped) {
+    Value value = mapped ? Value::reference(data, len) : Value(data, len);
+    return expireAt != 0 ? value.withExpiry(expireAt) : value;
+}
+
+/// mutex 非空时在作用域内持有它（分片只由所属线程写时不加日志锁）
+class OptionalLockGuard : noncopyable {
+public:
+    explicit OptionalLockGuard(MutexLock* mutex) : mutex_(mutex) {
+        if (mutex_ != nullptr) {
+            mutex_->lock();
+        }
+    }
+
+    ~OptionalLockGuard() {
+        if (mutex_ != nullptr) {
+            mutex_->unlock();
+        }
+    }
+
+private:
+    MutexLock* mutex_;
+};
+
+/// 并行加载的一段连续的块，解码后按分片归类
+struct LoadSegment {
+    size_t begin = 0;  // 块下标范围 [begin, end)
+    size_t end = 0;
+    std::vector<std::vector<LoadRecord>> runs;  // runs[i] 为属于分片 i 的记录，保持文件中的顺序
+    uint64_t records = 0;
+    uint64_t badBlocks = 0;
+};
+
+/// 统一两种跳表迭代器的接口，供多路归并使用
+class ShardIterator {
+public:
+    virtual ~ShardIterator() = default;
+    virtual bool valid() const = 0;
+    virtual const std::string& key() const = 0;
+    virtual const Value& value() const = 0;
+    virtual void next() = 0;
+    virtual void seek(const std::string& target) = 0;
+    virtual void seekToFirst() = 0;
+
+    /// 当前记录是否为墓碑（开启磁盘层时）
+    virtual bool isTombstone() const { return value().isTombstone(); }
+
+    /// 当前记录的过期时刻，0 表示不过期
+    virtual int64_t expireAt() const { return value().expireAt(); }
+};
+
+template <typename List>
+class ShardIteratorImpl : public ShardIterator {
+public:
+    explicit ShardIteratorImpl(const List* list) : it_(list) {}
+
+    /// 只读快照 snapshot 中的数据（仅 SkipList）
+    ShardIteratorImpl(const List* list, uint64_t snapshot) : it_(list, snapshot) {}
+
+    bool valid() const override { return it_.valid(); }
+    const std::string& key() const override { return it_.key(); }
+    const Value& value() const override { return it_.value(); }
+    void next() override { it_.next(); }
+    void seek(const std::string& target) override { it_.seek(target); }
+    void seekToFirst() override { it_.seekToFirst(); }
+
+private:
+    typename List::Iterator it_;
+};
+
+/// SSTable 的迭代器，值在访问时才拷贝出来
+class TableShardIterator : public ShardIterator {
+public:
+    explicit TableShardIterator(const Table* table) : it_(table) {}
+
+    bool valid() const override { return it_.valid(); }
+    const std::string& key() const override { return it_.key(); }
+    const Value& value() const override {
+        if (it_.isTombstone()) {
+            value_ = Value::tombstone();
+        } else {
+            value_ = Value(it_.valueData(), it_.valueSize());
+            if (it_.expireAt() != 0) {
+                value_ = value_.withExpiry(it_.expireAt());
+            }
+        }
+        return value_;
+    }
+    bool isTombstone() const override { return it_.isTombstone(); }
+    int64_t expireAt() const override { return it_.expireAt(); }
+    void next() override { it_.next(); }
+    void seek(const std::string& target) override { it_.seek(target); }
+    void seekToFirst() override { it_.seekToFirst(); }
+
+private:
+    Table::Iterator it_;
+    mutable Value value_;
+};
+
+}  // namespace
+
+// ==================== Shard ====================
+
+bool KVStore::Shard::insert(const std::string& key, const Value& value) {
+    if (!filter) {
+        return lockFreeList ? lockFreeList->insert(key, value) : skiplist->insert(key, value);
+    }
+    const uint32_t hash = BloomFilter::hash(key.data(), key.size());
+    const uint64_t generation = filter->add(hash);
+    bool isNew = lockFreeList ? lockFreeList->insert(key, value) : skiplist->insert(key, value);
+    filter->inserted(hash, isNew, generation);
+    if (filter->needsRebuild()) {
+        rebuildFilter();
+    }
+    return isNew;
+}
+
+bool KVStore::Shard::search(const std::string& key, Value& value) const {
+    if (filter && !filter->mayContain(BloomFilter::hash(key.data(), key.size()))) {
+        return false;
+    }
+    bool found = lockFreeList ? lockFreeList->search(key, value) : skiplist->search(key, value);
+    if (!found && filter) {
+        filter->noteFalsePositive();
+    }
+    return found;
+}
+
+bool KVStore::Shard::remove(const std::string& key) {
+    bool live = true;
+    bool removed;
+    if (lockFreeList) {
+        Value value;
+        live = lockFreeList->search(key, value) && !isExpired(value);
+        removed = lockFreeList->remove(key);
+    } else {
+        removed = skiplist->removeIf(key, [&live](const Value& value) {
+            live = !isExpired(value);
+            return true;
+        });
+    }
+    if (removed && filter) {
+        filter->noteRemove();
+        if (filter->needsRebuild()) {
+            rebuildFilter();
+        }
+    }
+    return removed && live;
+}
+
+void KVStore::Shard::searchBatch(const std::vector<std::string>& keys,
+                                  const std::vector<size_t>& order,
+                                  const std::function<void(size_t, const Value&)>& visitor) const {
+    // 过滤器判定不存在的 key 不进入跳表
+    std::vector<size_t> candidates;
+    std::vector<const std::string*> sorted;
+    candidates.reserve(order.size());
+    sorted.reserve(order.size());
+    for (size_t i : order) {
+        if (!filter || filter->mayContain(BloomFilter::hash(keys[i].data(), keys[i].size()))) {
+            candidates.push_back(i);
+            sorted.push_back(&keys[i]);
+        }
+    }
+    skiplist->searchSorted(sorted, [&](size_t j, const Value* value) {
+        if (value != nullptr) {
+            visitor(candidates[j], *value);
+        } else if (filter) {
+            filter->noteFalsePositive();
+        }
+    });
+}
+
+void KVStore::Shard::insertBatch(const std::vector<std::string>& keys,
+                                  const std::vector<Value>& values,
+                                  const std::vector<size_t>& order,
+                                  const std::function<void(size_t, bool)>& visitor) {
+    std::vector<std::pair<const std::string*, const Value*>> entries;
+    std::vector<uint32_t> hashes;
+    std::vector<uint64_t> generations;
+    entries.reserve(order.size());
+    for (size_t i : order) {
+        entries.emplace_back(&keys[i], &values[i]);
+        if (filter) {
+            hashes.push_back(BloomFilter::hash(keys[i].data(), keys[i].size()));
+            generations.push_back(filter->add(hashes.back()));
+        }
+    }
+    skiplist->insertSorted(entries, [&](size_t j, bool isNew) {
+        if (filter) {
+            filter->inserted(hashes[j], isNew, generations[j]);
+        }
+        visitor(order[j], isNew);
+    });
+    if (filter && filter->needsRebuild()) {
+        rebuildFilter();
+    }
+}
+
+void KVStore::Shard::removeBatch(const std::vector<std::string>& keys,
+                                  const std::vector<size_t>& order,
+                                  const std::function<void(size_t)>& visitor) {
+    std::vector<const std::string*> sorted;
+    sorted.reserve(order.size());
+    for (size_t i : order) {
+        sorted.push_back(&keys[i]);
+    }
+    const int64_t now = nowMs();
+    skiplist->removeSorted(sorted, [&](size_t j, const Value& value) {
+        if (filter) {
+            filter->noteRemove();
+        }
+        if (!value.expiredAt(now)) {
+            visitor(order[j]);
+        }
+    });
+    if (filter && filter->needsRebuild()) {
+        rebuildFilter();
+    }
+}
+
+bool KVStore::Shard::modify(const std::string& key, const std::function<bool(Value&)>& fn) {
+    return lockFreeList ? lockFreeList->modify(key, fn) : skiplist->modify(key, fn);
+}
+
+bool KVStore::Shard::removeExpired(const std::string& key, int64_t nowMs, bool tombstone) {
+    if (!skiplist) {
+        return false;
+    }
+    if (tombstone) {
+        return skiplist->modify(key, [nowMs](Value& value) {
+            if (!value.expiredAt(nowMs)) {
+                return false;
+            }
+            value = Value::tombstone();
+            return true;
+        });
+    }
+    bool removed = skiplist->removeIf(key, [nowMs](const Value& value) {
+        return value.expiredAt(nowMs);
+    });
+    if (removed && filter) {
+        filter->noteRemove();
+        if (filter->needsRebuild()) {
+            rebuildFilter();
+        }
+    }
+    return removed;
+}
+
+int KVStore::Shard::size() const {
+    return lockFreeList ? lockFreeList->size() : skiplist->size();
+}
+
+void KVStore::Shard::clear() {
+    if (lockFreeList) {
+        lockFreeList->clear();
+    } else {
+        skiplist->clear();
+    }
+    rebuildFilter();
+}
+
+void KVStore::Shard::rebuildFilter() {
+    // 正在重建的线程会处理，这里直接返回
+    if (!filter || !filter->beginRebuild(static_cast<size_t>(size()))) {
+        return;
+    }
+    std::unique_ptr<ShardIterator> it;
+    if (lockFreeList) {
+        it.reset(new ShardIteratorImpl<ConcurrentSkipList>(lockFreeList.get()));
+    } else {
+        it.reset(new ShardIteratorImpl<MutexSkipList>(skiplist.get()));
+    }
+    for (it->seekToFirst(); it->valid(); it->next()) {
+        filter->addRebuilt(BloomFilter::hash(it->key().data(), it->key().size()));
+    }
+    filter->endRebuild();
+}
+
+void KVStore::Shard::display() const {
+    if (lockFreeList) {
+        lockFreeList->displayList();
+    } else {
+        skiplist->displayList();
+    }
+}
+
+// ==================== KVStore ====================
+
+KVStore::KVStore(int maxLevel) : KVStore(makeOptions(maxLevel)) {}
+
+KVStore::KVStore(const KVStoreOptions& options)
+    : options_(options),
+      saveDone_(saveMutex_),
+      saving_(false),
+      savedSequence_(0),
+      memtableBytes_(0),
+      flushPending_(false),
+      tableCond_(tableMutex_),
+      flushRequested_(false),
+      compactRequested_(false),
+      tableStopping_(false),
+      evictionCursor_(0),
+      evictedKeys_(0) {
+    if (options_.shards < 1) {
+        options_.shards = 1;
+    }
+    if (options_.hashIndex && options_.skipListType == SkipListType::kLockFree) {
+        LOG_WARN << "KVStore: hash index is not supported by the lockfree skiplist, ignored";
+        options_.hashIndex = false;
+    }
+    if (options_.prefixCompression && options_.skipListType == SkipListType::kLockFree) {
+        LOG_WARN << "KVStore: prefix compression is not supported by the lockfree skiplist, ignored";
+        options_.prefixCompression = false;
+    }
+    if (options_.prefixCompression && options_.hashIndex) {
+        LOG_WARN << "KVStore: prefix compression conflicts with the hash index, ignored";
+        options_.prefixCompression = false;
+    }
+    if (options_.maxMemory > 0 && options_.skipListType == SkipListType::kLockFree) {
+        LOG_WARN << "KVStore: maxmemory is not supported by the lockfree skiplist, ignored";
+        options_.maxMemory = 0;
+    }
+    if (options_.maxMemory > 0) {
+        accessTracker_.reset(new AccessTracker(options_.evictionPolicy));
+    }
+    shards_.resize(options_.shards);
+    for (Shard& shard : shards_) {
+        shard.logMutex.reset(new MutexLock);
+        shard.liveKeys.reset(new std::atomic<int>(0));
+        if (options_.bloomBitsPerKey > 0) {
+            shard.filter.reset(new MemtableFilter(options_.bloomBitsPerKey));
+        }
+        if (options_.skipListType == SkipListType::kLockFree) {
+            shard.lockFreeList.reset(new ConcurrentSkipList(options_.maxLevel));
+        } else {
+            shard.skiplist.reset(new MutexSkipList(options_.maxLevel, options_.hashIndex,
+                                                   options_.prefixCompression));
+            shard.skiplist->setAccessTracker(accessTracker_.get());
+        }
+    }
+    LOG_INFO << "KVStore initialized with maxLevel=" << options_.maxLevel
+             << " skiplist=" << skipListTypeName(options_.skipListType)
+             << " shards=" << options_.shards
+             << " hashIndex=" << (options_.hashIndex ? "on" : "off")
+             << " prefixCompression=" << (options_.prefixCompression ? "on" : "off")
+             << " mmapValues=" << (options_.mmapValues ? "on" : "off")
+             << " bloomBitsPerKey=" << options_.bloomBitsPerKey
+             << " maxMemory=" << options_.maxMemory << "("
+             << evictionPolicyName(options_.evictionPolicy) << ")";
 }
 
 KVStore::~KVStore() {
-    LOG_INFO << "KVStore destroyed, size=" << skiplist_.size();
+    if (tableWorker_) {
+        {
+            MutexLockGuard lock(tableMutex_);
+            tableStopping_ = true;
+            tableCond_.notifyAll();
+        }
+        tableWorker_->join();
+    }
+    {
+        MutexLockGuard lock(saveMutex_);
+        while (saving_) {
+            saveDone_.wait();
+        }
+    }
+    if (saver_) {
+        saver_->join();
+    }
+    LOG_INFO << "KVStore destroyed, size=" << size();
+}
+
+int KVStore::shardIndex(const std::string& key) const {
+    if (shards_.size() == 1) {
+        return 0;
+    }
+    return static_cast<int>(std::hash<std::string>()(key) % shards_.size());
 }
 
 bool KVStore::put(const std::string& key, const std::string& value) {
+    return put(key, Value(value));
+}
+
+bool KVStore::put(const std::string& key, const Value& value) {
     if (key.empty()) {
         LOG_WARN << "KVStore::put - empty key is not allowed";
         return false;
     }
-    bool isNew = skiplist_.insert(key, value);
+    if (options_.maxMemory > 0) {
+        // 在获取分片的日志锁之前淘汰：淘汰要获取其他分片的日志锁
+        evictFor(MutexSkipList::entryBytes(key, value));
+    }
+    Shard& shard = shardFor(key);
+    bool isNew;
+    {
+        OptionalLockGuard lock(writeLock(shard));
+        isNew = insertKey(shard, key, value);
+        if (wal_) {
+            wal_->appendPut(key, value.data(), value.size(), value.expireAt());
+        }
+    }
+    noteWrite(key.size() + value.size());
     LOG_DEBUG << "KVStore::put key=" << key << " isNew=" << isNew;
     return isNew;
 }
 
 bool KVStore::get(const std::string& key, std::string& value) const {
+    Value result;
+    if (!get(key, result)) {
+        return false;
+    }
+    value.assign(result.data(), result.size());
+    return true;
+}
+
+bool KVStore::get(const std::string& key, Value& value) const {
     if (key.empty()) {
         return false;
     }
-    bool found = skiplist_.search(key, value);
+    bool found = lookup(shardFor(key), key, value);
     LOG_DEBUG << "KVStore::get key=" << key << " found=" << found;
     return found;
 }
 
+bool KVStore::lookup(const Shard& shard, const std::string& key, Value& value) const {
+    if (shard.search(key, value)) {
+        return !value.isTombstone() && !isExpired(value);
+    }
+    // memtable 中没有时查表：刷盘先登记表再从 memtable 删除，这里不会两边都错过
+    return tableSet_ && tableSet_->get(key, &value) == Table::Lookup::kFound &&
+           !isExpired(value);
+}
+
+bool KVStore::insertKey(Shard& shard, const std::string& key, const Value& value) {
+    if (!tableSet_) {
+        return shard.insert(key, value);
+    }
+    // counted 表示计数中已经有这个 key：最新版本不是墓碑（包括过期未摘除的值）。
+    // memtable 中没有时先问表的布隆过滤器，过滤器说可能有才读表
+    Value existing;
+    bool counted = false;
+    if (shard.search(key, existing)) {
+        counted = !existing.isTombstone();
+    } else if (tableSet_->mayContain(key)) {
+        counted = tableSet_->get(key, &existing) == Table::Lookup::kFound;
+    }
+    const bool isNew = !counted || isExpired(existing);
+    shard.insert(key, value);
+    if (!counted) {
+        shard.liveKeys->fetch_add(1, std::memory_order_relaxed);
+    }
+    return isNew;
+}
+
+bool KVStore::eraseKey(Shard& shard, const std::string& key) {
+    if (!tableSet_) {
+        return shard.remove(key);
+    }
+    Value existing;
+    if (!lookup(shard, key, existing)) {
+        return false;
+    }
+    shard.insert(key, Value::tombstone());
+    shard.liveKeys->fetch_sub(1, std::memory_order_relaxed);
+    noteWrite(key.size());
+    return true;
+}
+
 bool KVStore::del(const std::string& key) {
     if (key.empty()) {
         return false;
     }
-    bool removed = skiplist_.remove(key);
+    Shard& shard = shardFor(key);
+    bool removed;
+    {
+        OptionalLockGuard lock(writeLock(shard));
+        removed = eraseKey(shard, key);
+        if (removed && wal_) {
+            wal_->appendDel(key);
+        }
+    }
     LOG_DEBUG << "KVStore::del key=" << key << " removed=" << removed;
     return removed;
 }
@@ -45,27 +572,673 @@ bool KVStore::exists(const std::string& key) const {
     if (key.empty()) {
         return false;
     }
-    return skiplist_.contains(key);
+    // 需要看到值才能判断是否过期：短值拷贝 24 字节，长值加一次引用计数
+    Value value;
+    return lookup(shardFor(key), key, value);
+}
+
+std::vector<std::vector<size_t>> KVStore::groupByShard(
+    const std::vector<std::string>& keys) const {
+    std::vector<std::vector<size_t>> groups(shards_.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+        groups[shardIndex(keys[i])].push_back(i);
+    }
+    for (std::vector<size_t>& group : groups) {
+        std::stable_sort(group.begin(), group.end(),
+                         [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+    }
+    return groups;
+}
+
+size_t KVStore::multiGet(const std::vector<std::string>& keys, std::vector<Value>* values,
+                         std::vector<bool>* found) const {
+    values->assign(keys.size(), Value());
+    found->assign(keys.size(), false);
+    size_t count = 0;
+    if (!batchable()) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (get(keys[i], (*values)[i])) {
+                (*found)[i] = true;
+                count++;
+            }
+        }
+        return count;
+    }
+    const std::vector<std::vector<size_t>> groups = groupByShard(keys);
+    for (size_t s = 0; s < shards_.size(); s++) {
+        if (groups[s].empty()) {
+            continue;
+        }
+        shards_[s].searchBatch(keys, groups[s], [&](size_t i, const Value& value) {
+            if (!value.isTombstone() && !isExpired(value)) {
+                (*values)[i] = value;
+                (*found)[i] = true;
+                count++;
+            }
+        });
+    }
+    LOG_DEBUG << "KVStore::multiGet keys=" << keys.size() << " found=" << count;
+    return count;
+}
+
+size_t KVStore::multiPut(const std::vector<std::string>& keys, const std::vector<Value>& values) {
+    size_t created = 0;
+    if (!batchable()) {
+        for (size_t i = 0; i < keys.size(); i++) {
+            created += put(keys[i], values[i]) ? 1 : 0;
+        }
+        return created;
+    }
+    for (const std::string& key : keys) {
+        if (key.empty()) {
+            LOG_WARN << "KVStore::multiPut - empty key is not allowed";
+            return 0;
+        }
+    }
+    if (options_.maxMemory > 0) {
+        size_t incoming = 0;
+        for (size_t i = 0; i < keys.size(); i++) {
+            incoming += MutexSkipList::entryBytes(keys[i], values[i]);
+        }
+        evictFor(incoming);
+    }
+    const std::vector<std::vector<size_t>> groups = groupByShard(keys);
+    for (size_t s = 0; s < shards_.size(); s++) {
+        if (groups[s].empty()) {
+            continue;
+        }
+        Shard& shard = shards_[s];
+        auto onInserted = [&created](size_t, bool isNew) { created += isNew ? 1 : 0; };
+        OptionalLockGuard lock(writeLock(shard));
+        shard.insertBatch(keys, values, groups[s], onInserted);
+        if (wal_) {
+            // 日志按写入内存的顺序追加（组内按 key 排序，相同 key 保持原来的先后）
+            for (size_t i : groups[s]) {
+                wal_->appendPut(keys[i], values[i].data(), values[i].size(),
+                                values[i].expireAt());
+            }
+        }
+    }
+    LOG_DEBUG << "KVStore::multiPut keys=" << keys.size() << " created=" << created;
+    return created;
+}
+
+size_t KVStore::multiDel(const std::vector<std::string>& keys) {
+    size_t removed = 0;
+    if (!batchable()) {
+        for (const std::string& key : keys) {
+            removed += del(key) ? 1 : 0;
+        }
+        return removed;
+    }
+    const std::vector<std::vector<size_t>> groups = groupByShard(keys);
+    for (size_t s = 0; s < shards_.size(); s++) {
+        if (groups[s].empty()) {
+            continue;
+        }
+        Shard& shard = shards_[s];
+        if (wal_) {
+            // 跳表的写锁释放之后再追加日志
+            std::vector<size_t> deleted;
+            OptionalLockGuard lock(writeLock(shard));
+            shard.removeBatch(keys, groups[s], [&deleted](size_t i) { deleted.push_back(i); });
+            for (size_t i : deleted) {
+                wal_->appendDel(keys[i]);
+            }
+            removed += deleted.size();
+        } else {
+            shard.removeBatch(keys, groups[s], [&removed](size_t) { removed++; });
+        }
+    }
+    LOG_DEBUG << "KVStore::multiDel keys=" << keys.size() << " removed=" << removed;
+    return removed;
+}
+
+int64_t KVStore::nowMs() {
+    return Timestamp::now().microSecondsSinceEpoch() / 1000;
+}
+
+bool KVStore::expire(const std::string& key, int64_t expireAtMs) {
+    if (key.empty()) {
+        return false;
+    }
+    const int64_t now = nowMs();
+    if (expireAtMs != 0 && expireAtMs <= now) {
+        return del(key);
+    }
+    Shard& shard = shardFor(key);
+    bool changed;
+    if (wal_) {
+        OptionalLockGuard lock(writeLock(shard));
+        changed = expireKey(shard, key, expireAtMs, now);
+        if (changed) {
+            wal_->appendExpire(key, expireAtMs);
+        }
+    } else {
+        changed = expireKey(shard, key, expireAtMs, now);
+    }
+    LOG_DEBUG << "KVStore::expire key=" << key << " at=" << expireAtMs << " changed=" << changed;
+    return changed;
+}
+
+bool KVStore::expireKey(Shard& shard, const std::string& key, int64_t expireAtMs,
+                        int64_t nowMs) {
+    // 判断与修改在跳表内原子完成，不会覆盖并发写入的新值
+    bool inMemtable = false;
+    bool changed = shard.modify(key, [&inMemtable, expireAtMs, nowMs](Value& value) {
+        inMemtable = true;
+        if (value.isTombstone() || value.expiredAt(nowMs)) {
+            return false;
+        }
+        value = value.withExpiry(expireAtMs);
+        return true;
+    });
+    if (changed || inMemtable || !tableSet_) {
+        return changed;
+    }
+    // key 只在表中：把表中的值连同新的过期时间写进 memtable
+    Value value;
+    if (tableSet_->get(key, &value) != Table::Lookup::kFound || value.expiredAt(nowMs)) {
+        return false;
+    }
+    shard.insert(key, value.withExpiry(expireAtMs));
+    noteWrite(key.size() + value.size());
+    return true;
+}
+
+int64_t KVStore::expireAt(const std::string& key) const {
+    Value value;
+    if (!get(key, value)) {
+        return -1;
+    }
+    return value.expireAt();
+}
+
+bool KVStore::expireIfDue(const std::string& key) {
+    if (key.empty()) {
+        return false;
+    }
+    bool removed = removeExpired(shardFor(key), key, nowMs());
+    LOG_DEBUG << "KVStore::expireIfDue key=" << key << " removed=" << removed;
+    return removed;
+}
+
+size_t KVStore::expireShard(int index, std::string* cursor, size_t budget) {
+    Shard& shard = shards_[index];
+    if (!shard.skiplist) {
+        return 0;
+    }
+    const int64_t now = nowMs();
+    std::vector<std::string> expired;
+    {
+        // 迭代器不持有写锁，先记下过期的 key，迭代器销毁后再逐个摘除
+        MutexSkipList::Iterator it(shard.skiplist.get());
+        if (cursor->empty()) {
+            it.seekToFirst();
+        } else {
+            it.seek(*cursor);
+        }
+        for (size_t checked = 0; it.valid() && checked < budget; it.next(), checked++) {
+            if (!it.value().isTombstone() && it.value().expiredAt(now)) {
+                expired.push_back(it.key());
+            }
+        }
+        *cursor = it.valid() ? it.key() : std::string();
+    }
+    size_t removed = 0;
+    for (const std::string& key : expired) {
+        removed += removeExpired(shard, key, now) ? 1 : 0;
+    }
+    if (removed > 0) {
+        LOG_DEBUG << "KVStore::expireShard shard=" << index << " removed=" << removed;
+    }
+    return removed;
+}
+
+bool KVStore::removeExpired(Shard& shard, const std::string& key, int64_t now) {
+    // 过期只取决于时间，重放日志时会得到同样的结果，不用写日志
+    if (!tableSet_) {
+        return shard.removeExpired(key, now, false);
+    }
+    MutexLockGuard lock(*shard.logMutex);
+    bool removed = shard.removeExpired(key, now, true);
+    if (removed) {
+        shard.liveKeys->fetch_sub(1, std::memory_order_relaxed);
+    }
+    return removed;
+}
+
+size_t KVStore::scan(const std::string& start, const std::string& end, size_t limit,
+                     const ScanVisitor& visitor) const {
+    if (!tableSet_) {
+        return scanAt(nullptr, nullptr, false, start, end, limit, visitor);
+    }
+    // 刷盘会把 key 从 memtable 移到新表，固定快照保证遍历期间不会错过它们
+    bool rotated = false;
+    TableSet::TableListPtr tables;
+    SnapshotSequences sequences = pinSnapshot(PinPurpose::kScan, &rotated, &tables);
+    size_t visited = scanAt(&sequences, tables.get(), false, start, end, limit, visitor);
+    unpinSnapshot();
+    return visited;
+}
+
+size_t KVStore::scanShard(int index, const std::string& start, const std::string& end,
+                          size_t limit, const ScanVisitor& visitor) const {
+    const Shard& shard = shards_[index];
+    std::unique_ptr<ShardIterator> it;
+    if (shard.lockFreeList) {
+        it.reset(new ShardIteratorImpl<ConcurrentSkipList>(shard.lockFreeList.get()));
+    } else {
+        it.reset(new ShardIteratorImpl<MutexSkipList>(shard.skiplist.get()));
+    }
+    if (start.empty()) {
+        it->seekToFirst();
+    } else {
+        it->seek(start);
+    }
+    const int64_t now = nowMs();
+    size_t visited = 0;
+    for (; it->valid() && (limit == 0 || visited < limit); it->next()) {
+        if (!end.empty() && it->key() > end) {
+            break;
+        }
+        if (it->isTombstone() || expiredAt(it->expireAt(), now)) {
+            continue;
+        }
+        visited++;
+        if (!visitor(it->key(), it->value())) {
+            break;
+        }
+    }
+    return visited;
+}
+
+size_t KVStore::scanAt(const SnapshotSequences* sequences, const TableSet::TableList* tables,
+                       bool tombstones, const std::string& start, const std::string& end,
+                       size_t limit, const ScanVisitor& visitor) const {
+    std::vector<std::unique_ptr<ShardIterator>> iters;
+    iters.reserve(shards_.size() + (tables != nullptr ? tables->size() : 0));
+    for (size_t i = 0; i < shards_.size(); i++) {
+        const Shard& shard = shards_[i];
+        std::unique_ptr<ShardIterator> it;
+        if (shard.lockFreeList) {
+            it.reset(new ShardIteratorImpl<ConcurrentSkipList>(shard.lockFreeList.get()));
+        } else if (sequences != nullptr) {
+            it.reset(new ShardIteratorImpl<MutexSkipList>(shard.skiplist.get(), (*sequences)[i]));
+        } else {
+            it.reset(new ShardIteratorImpl<MutexSkipList>(shard.skiplist.get()));
+        }
+        iters.push_back(std::move(it));
+    }
+    // 表排在分片之后，从新到旧
+    if (tables != nullptr) {
+        for (const TableSet::TablePtr& table : *tables) {
+            iters.emplace_back(new TableShardIterator(table.get()));
+        }
+    }
+    for (const std::unique_ptr<ShardIterator>& it : iters) {
+        if (start.empty()) {
+            it->seekToFirst();
+        } else {
+            it->seek(start);
+        }
+    }
+
+    // 小顶堆保存各迭代器的下标，堆顶是当前最小的 key。不同分片的 key 互不相同；
+    // 与表归并时同一个 key 可能出现多次，下标小的（memtable、较新的表）先出堆，其余的被遮住
+    auto greater = [&iters](size_t a, size_t b) {
+        int cmp = iters[a]->key().compare(iters[b]->key());
+        return cmp != 0 ? cmp > 0 : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+    for (size_t i = 0; i < iters.size(); i++) {
+        if (iters[i]->valid()) {
+            heap.push(i);
+        }
+    }
+
+    const bool merge = tables != nullptr && !tables->empty();
+    const int64_t now = nowMs();
+    std::string key;
+    size_t visited = 0;
+    while (!heap.empty() && (limit == 0 || visited < limit)) {
+        size_t top = heap.top();
+        heap.pop();
+        ShardIterator* it = iters[top].get();
+        if (!end.empty() && it->key() > end) {
+            break;
+        }
+
+        // 过期的值与墓碑一样遮住更旧的表中的同一个 key
+        if (tombstones || (!it->isTombstone() && !expiredAt(it->expireAt(), now))) {
+            visited++;
+            if (!visitor(it->key(), it->value())) {
+                break;
+            }
+        }
+
+        if (merge) {
+            key = it->key();
+        }
+        it->next();
+        if (it->valid()) {
+            heap.push(top);
+        }
+        while (merge && !heap.empty() && iters[heap.top()]->key() == key) {
+            size_t older = heap.top();
+            heap.pop();
+            iters[older]->next();
+            if (iters[older]->valid()) {
+                heap.push(older);
+            }
+        }
+    }
+    return visited;
 }
 
 int KVStore::size() const {
-    return skiplist_.size();
+    int total = 0;
+    for (int i = 0; i < static_cast<int>(shards_.size()); i++) {
+        total += shardSize(i);
+    }
+    return total;
 }
 
 void KVStore::clear() {
-    skiplist_.clear();
+    if (writesLocked()) {
+        lockAllShards();
+    }
+    if (wal_) {
+        wal_->appendClear();
+    }
+    clearData();
+    if (writesLocked()) {
+        unlockAllShards();
+    }
     LOG_INFO << "KVStore cleared";
 }
 
+void KVStore::clearData() {
+    for (Shard& shard : shards_) {
+        shard.clear();
+    }
+    if (tableSet_) {
+        tableSet_->clear();
+        memtableBytes_.store(0, std::memory_order_relaxed);
+        for (Shard& shard : shards_) {
+            shard.liveKeys->store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+int KVStore::shardSize(int index) const {
+    if (!tableSet_) {
+        return shards_[index].size();
+    }
+    return std::max(shards_[index].liveKeys->load(std::memory_order_relaxed), 0);
+}
+
+void KVStore::clearShard(int index) {
+    OptionalLockGuard lock(writeLock(shards_[index]));
+    if (wal_) {
+        wal_->appendClearShard(static_cast<uint32_t>(index), static_cast<uint32_t>(shards_.size()));
+    }
+    clearShardData(index);
+}
+
+void KVStore::clearShardData(int index) {
+    if (!tableSet_) {
+        shards_[index].clear();
+        return;
+    }
+    // 表是所有分片共用的，只能逐个 key 写墓碑
+    std::vector<std::string> keys;
+    scan("", "", 0, [this, index, &keys](const std::string& key, const Value&) {
+        if (shardIndex(key) == index) {
+            keys.push_back(key);
+        }
+        return true;
+    });
+    for (const std::string& key : keys) {
+        eraseKey(shards_[index], key);
+    }
+}
+
 bool KVStore::save(const std::string& filepath) const {
     if (filepath.empty()) {
         LOG_ERROR << "KVStore::save - empty filepath";
         return false;
     }
 
-    bool success = skiplist_.dumpFile(filepath);
+    beginSave();
+    bool rotated = false;
+    TableSet::TableListPtr tables;
+    SnapshotSequences sequences = pinSnapshot(PinPurpose::kSave, &rotated, &tables);
+    bool success = writeSnapshot(filepath, sequences, tables.get(), rotated);
+    unpinSnapshot();
+    endSave();
+    return success;
+}
+
+bool KVStore::saveInBackground(const std::string& filepath) {
+    if (filepath.empty()) {
+        LOG_ERROR << "KVStore::saveInBackground - empty filepath";
+        return false;
+    }
+    MutexLockGuard lock(saveMutex_);
+    if (saving_) {
+        return false;
+    }
+    saving_ = true;
+
+    // 上一个后台线程已经结束了保存，回收它
+    if (saver_) {
+        saver_->join();
+    }
+
+    if (hasShardOwners()) {
+        // 快照由各分片的所属线程固定，调用线程可能就是其中之一，不能在这里等待：交给后台线程
+        saver_.reset(new Thread(
+            [this, filepath] {
+                bool rotated = false;
+                SnapshotSequences sequences = pinSnapshot(PinPurpose::kSave, &rotated, nullptr);
+                writeSnapshot(filepath, sequences, nullptr, rotated);
+                unpinSnapshot();
+                endSave();
+            },
+            "SnapshotSaver"));
+        saver_->start();
+        LOG_INFO << "KVStore background saving to " << filepath << " started";
+        return true;
+    }
+
+    // 在调用线程中固定快照，后台线程只负责遍历和写文件
+    bool rotated = false;
+    TableSet::TableListPtr tables;
+    SnapshotSequences sequences = pinSnapshot(PinPurpose::kSave, &rotated, &tables);
+    saver_.reset(new Thread(
+        [this, filepath, sequences, tables, rotated] {
+            writeSnapshot(filepath, sequences, tables.get(), rotated);
+            unpinSnapshot();
+            endSave();
+        },
+        "SnapshotSaver"));
+    saver_->start();
+    LOG_INFO << "KVStore background saving to " << filepath << " started";
+    return true;
+}
+
+bool KVStore::isSaving() const {
+    MutexLockGuard lock(saveMutex_);
+    return saving_;
+}
+
+bool KVStore::hasUnsavedChanges() const {
+    if (options_.skipListType == SkipListType::kLockFree) {
+        return true;
+    }
+    return writeSequence() != savedSequence_.load(std::memory_order_relaxed);
+}
+
+void KVStore::beginSave() const {
+    MutexLockGuard lock(saveMutex_);
+    while (saving_) {
+        saveDone_.wait();
+    }
+    saving_ = true;
+}
+
+void KVStore::endSave() const {
+    MutexLockGuard lock(saveMutex_);
+    saving_ = false;
+    saveDone_.notifyAll();
+}
+
+uint64_t KVStore::writeSequence() const {
+    uint64_t sequence = 0;
+    for (const Shard& shard : shards_) {
+        if (shard.skiplist) {
+            sequence += shard.skiplist->sequence();
+        }
+    }
+    return sequence;
+}
+
+KVStore::SnapshotSequences KVStore::pinSnapshot(PinPurpose purpose, bool* rotated,
+                                                TableSet::TableListPtr* tables) const {
+    // 同时持有所有分片的写锁，各分片的快照序号对应同一个时刻。
+    // 需要轮换 WAL 时先取日志锁（与 put/del 的加锁顺序一致）并在同一时刻轮换日志：
+    // 此刻之前的写操作都在快照里，之后的写入进入新日志。
+    // 开启磁盘层时日志只在刷盘时轮换：保存的快照文件不参与启动恢复
+    const bool rotate = wal_ && (purpose == PinPurpose::kFlush ||
+                                 (purpose == PinPurpose::kSave && !tableSet_));
+    if (hasShardOwners()) {
+        return pinOwnedSnapshot(rotate, rotated);
+    }
+    if (rotate) {
+        lockAllShards();
+    }
+    for (const Shard& shard : shards_) {
+        if (shard.skiplist) {
+            shard.skiplist->lockWriters();
+        }
+    }
+
+    SnapshotSequences sequences(shards_.size(), MutexSkipList::kLatest);
+    uint64_t total = 0;
+    for (size_t i = 0; i < shards_.size(); i++) {
+        if (shards_[i].skiplist) {
+            sequences[i] = shards_[i].skiplist->pinVersions();
+            total += sequences[i];
+        }
+    }
+    *rotated = rotate && wal_->rotate();
+    if (tables != nullptr && tableSet_) {
+        *tables = tableSet_->current();
+    }
+
+    for (auto it = shards_.rbegin(); it != shards_.rend(); ++it) {
+        if (it->skiplist) {
+            it->skiplist->unlockWriters();
+        }
+    }
+    if (rotate) {
+        unlockAllShards();
+    }
+    if (purpose != PinPurpose::kScan) {
+        savedSequence_.store(total, std::memory_order_relaxed);
+    }
+    return sequences;
+}
+
+KVStore::SnapshotSequences KVStore::pinOwnedSnapshot(bool rotate, bool* rotated) const {
+    // 写操作不加锁，没有办法让所有分片停在同一时刻：先轮换日志，再由各所属线程固定自己的分片。
+    // 轮换之后、固定之前的写入既在快照里也在新日志里，重放日志时再写一遍结果不变
+    *rotated = rotate && wal_->rotate();
+    SnapshotSequences sequences(shards_.size(), MutexSkipList::kLatest);
+    runOnOwners([this, &sequences](int index) {
+        if (shards_[index].skiplist) {
+            sequences[index] = shards_[index].skiplist->pinVersions();
+        }
+    });
+    uint64_t total = 0;
+    for (size_t i = 0; i < shards_.size(); i++) {
+        if (shards_[i].skiplist) {
+            total += sequences[i];
+        }
+    }
+    savedSequence_.store(total, std::memory_order_relaxed);
+    return sequences;
+}
+
+void KVStore::unpinSnapshot() const {
+    if (hasShardOwners()) {
+        runOnOwners([this](int index) {
+            if (shards_[index].skiplist) {
+                shards_[index].skiplist->unpinVersions();
+            }
+        });
+        return;
+    }
+    for (const Shard& shard : shards_) {
+        if (shard.skiplist) {
+            shard.skiplist->unpinVersions();
+        }
+    }
+}
+
+void KVStore::runOnOwners(const std::function<void(int)>& fn) const {
+    CountDownLatch latch(static_cast<int>(shards_.size()));
+    for (int i = 0; i < static_cast<int>(shards_.size()); i++) {
+        shardExecutor_(i, [&fn, &latch, i]() {
+            fn(i);
+            latch.countDown();
+        });
+    }
+    latch.wait();
+}
+
+bool KVStore::writeSnapshot(const std::string& filepath, const SnapshotSequences& sequences,
+                            const TableSet::TableList* tables, bool rotated) const {
+    if (options_.skipListType == SkipListType::kLockFree) {
+        LOG_INFO << "KVStore: the lockfree skiplist keeps no versions, snapshot " << filepath
+                 << " may include writes made while saving";
+    }
+
+    // 先写临时文件并 fsync，再原子替换，崩溃时不会留下半个快照。
+    // 多路归并输出全局有序的记录，加载时可以直接追加构建，与分片数无关。
+    // 分批遍历：每批结束后释放迭代器（及其 epoch），下一批从上一批最后一个 key 之后继续
+    const std::string tmpPath = filepath + ".tmp";
+    SnapshotWriter writer(tmpPath);
+    bool success = writer.open();
+    std::string last;
+    bool resumed = false;
+    while (success) {
+        size_t visited = scanAt(&sequences, tables, false, last, "", kSnapshotScanBatch + 1,
+                                [&](const std::string& key, const Value& value) {
+            if (resumed && key == last) {
+                return true;
+            }
+            success = writer.add(key.data(), key.size(), value.data(), value.size(),
+                                 value.expireAt());
+            last = key;
+            return success;
+        });
+        if (visited <= kSnapshotScanBatch) {
+            break;
+        }
+        resumed = true;
+    }
+    success = success && writer.finish();
+    if (success) {
+        success = ::rename(tmpPath.c_str(), filepath.c_str()) == 0;
+    }
+
     if (success) {
-        LOG_INFO << "KVStore saved to " << filepath << ", size=" << skiplist_.size();
+        if (rotated) {
+            wal_->removeRotated();
+        }
+        LOG_INFO << "KVStore saved to " << filepath << ", size=" << writer.count();
     } else {
         LOG_ERROR << "KVStore save failed: " << filepath;
     }
@@ -77,21 +1250,644 @@ bool KVStore::load(const std::string& filepath) {
         LOG_ERROR << "KVStore::load - empty filepath";
         return false;
     }
+    if (!SnapshotReader::probe(filepath)) {
+        return loadText(filepath);
+    }
+
+    std::unique_ptr<SnapshotReader> reader(new SnapshotReader(filepath));
+    if (!reader->open()) {
+        LOG_ERROR << "KVStore load failed: " << filepath;
+        return false;
+    }
 
     // 先清空现有数据
     clear();
 
-    bool success = skiplist_.loadFile(filepath);
-    if (success) {
-        LOG_INFO << "KVStore loaded from " << filepath << ", size=" << skiplist_.size();
-    } else {
+    const bool mapped = options_.mmapValues;
+    int threads = options_.loadThreads > 0 ? options_.loadThreads
+                                           : static_cast<int>(std::thread::hardware_concurrency());
+    // 每个线程至少分到一段，块数太少时不启动线程
+    size_t segments = (reader->blockCount() + kLoadSegmentBlocks - 1) / kLoadSegmentBlocks;
+    threads = static_cast<int>(std::min(static_cast<size_t>(std::max(threads, 1)), segments));
+    if (threads > 1) {
+        bool complete = loadBlocks(*reader, threads);
+        return finishLoad(filepath, std::move(reader), complete);
+    }
+
+    // 快照全局有序，路由到每个分片的子序列也有序：互斥锁跳表直接追加到表尾
+    std::vector<std::unique_ptr<MutexSkipList::Builder>> builders(shards_.size());
+    for (size_t i = 0; i < shards_.size(); i++) {
+        if (shards_[i].skiplist) {
+            builders[i].reset(new MutexSkipList::Builder(shards_[i].skiplist.get()));
+        }
+    }
+    std::string key;
+    const int64_t now = nowMs();
+    bool complete = reader->read(
+        [this, &builders, &key, mapped, now](const char* k, size_t keyLen, const char* v,
+                                             size_t valueLen, int64_t expireAt) {
+            if (expiredAt(expireAt, now)) {
+                return;  // 保存之后已经过期
+            }
+            key.assign(k, keyLen);
+            int index = shardIndex(key);
+            Value value = loadedValue(v, valueLen, expireAt, mapped);
+            if (builders[index]) {
+                builders[index]->add(key, value);
+            } else {
+                shards_[index].insert(key, value);
+            }
+        },
+        !mapped);
+    builders.clear();
+    return finishLoad(filepath, std::move(reader), complete);
+}
+
+bool KVStore::finishLoad(const std::string& filepath, std::unique_ptr<SnapshotReader> reader,
+                         bool complete) {
+    const bool mapped = options_.mmapValues;
+    const SnapshotInfo& info = reader->info();
+    // 追加构建不经过 Shard::insert，过滤器按加载的数据重建
+    for (Shard& shard : shards_) {
+        shard.rebuildFilter();
+    }
+    recountMemtable();
+    if (!complete) {
+        LOG_ERROR << "KVStore snapshot " << filepath << " is damaged, loaded " << size()
+                  << " of " << info.count << " keys";
+    }
+    LOG_INFO << "KVStore loaded from " << filepath << ", size=" << size()
+             << " keys=[" << info.minKey << ", " << info.maxKey << "]"
+             << (mapped ? " (values mapped)" : "");
+    if (mapped) {
+        mappedSnapshots_.push_back(std::move(reader));
+    }
+    return true;
+}
+
+bool KVStore::loadBlocks(const SnapshotReader& reader, int threads) {
+    const size_t blocks = reader.blockCount();
+    const size_t shardCount = shards_.size();
+    const bool mapped = options_.mmapValues;
+    const size_t builders = std::min(static_cast<size_t>(threads), shardCount);
+
+    ThreadPool pool("SnapshotLoader");
+    pool.start(threads);
+
+    // 两批段轮流使用：解码第 n 批的同时构建第 n-1 批
+    std::vector<LoadSegment> waves[2];
+    std::unique_ptr<CountDownLatch> building;
+    size_t buildingBegin = 0;
+    size_t buildingEnd = 0;
+    uint64_t records = 0;
+    uint64_t badBlocks = 0;
+
+    auto finishBuilding = [&] {
+        if (building) {
+            building->wait();
+            if (!mapped) {
+                // 构建时已经拷贝了值，这批块的页不再需要
+                reader.releaseBlocks(buildingBegin, buildingEnd);
+            }
+        }
+    };
+
+    const int64_t now = nowMs();
+    size_t next = 0;
+    for (int current = 0; next < blocks; current ^= 1) {
+        std::vector<LoadSegment>& wave = waves[current];
+        wave.clear();
+        for (int i = 0; i < threads && next < blocks; i++) {
+            LoadSegment segment;
+            segment.begin = next;
+            segment.end = std::min(next + kLoadSegmentBlocks, blocks);
+            segment.runs.resize(shardCount);
+            next = segment.end;
+            wave.push_back(std::move(segment));
+        }
+
+        // 解码：每段一个任务，记录按分片归类
+        CountDownLatch decoded(static_cast<int>(wave.size()));
+        for (LoadSegment& segment : wave) {
+            pool.run([this, &reader, &segment, &decoded, now] {
+                std::string key;
+                auto visitor = [this, &segment, &key, now](const char* k, size_t keyLen,
+                                                           const char* v, size_t valueLen,
+                                                           int64_t expireAt) {
+                    if (expiredAt(expireAt, now)) {
+                        return;
+                    }
+                    size_t index = 0;
+                    if (segment.runs.size() > 1) {
+                        key.assign(k, keyLen);
+                        index = shardIndex(key);
+                    }
+                    segment.runs[index].push_back(
+                        LoadRecord{k, v, static_cast<uint32_t>(keyLen),
+                                   static_cast<uint32_t>(valueLen), expireAt});
+                };
+                for (size_t i = segment.begin; i < segment.end; i++) {
+                    uint32_t count = 0;
+                    if (reader.readBlock(i, visitor, &count)) {
+                        segment.records += count;
+                    } else {
+                        segment.badBlocks++;
+                    }
+                }
+                decoded.countDown();
+            });
+        }
+        decoded.wait();
+        for (const LoadSegment& segment : wave) {
+            records += segment.records;
+            badBlocks += segment.badBlocks;
+        }
+
+        // 构建：每个任务负责若干分片，同一分片只在一个任务中按段的顺序追加
+        finishBuilding();
+        building.reset(new CountDownLatch(static_cast<int>(builders)));
+        buildingBegin = wave.front().begin;
+        buildingEnd = wave.back().end;
+        for (size_t w = 0; w < builders; w++) {
+            CountDownLatch* latch = building.get();
+            pool.run([this, &wave, w, builders, mapped, latch] {
+                std::string key;
+                for (size_t s = w; s < shards_.size(); s += builders) {
+                    std::unique_ptr<MutexSkipList::Builder> builder;
+                    if (shards_[s].skiplist) {
+                        builder.reset(new MutexSkipList::Builder(shards_[s].skiplist.get()));
+                    }
+                    for (const LoadSegment& segment : wave) {
+                        for (const LoadRecord& record : segment.runs[s]) {
+                            key.assign(record.key, record.keyLen);
+                            Value value = loadedValue(record.value, record.valueLen,
+                                                      record.expireAt, mapped);
+                            if (builder) {
+                                builder->add(key, value);
+                            } else {
+                                shards_[s].insert(key, value);
+                            }
+                        }
+                    }
+                }
+                latch->countDown();
+            });
+        }
+    }
+    finishBuilding();
+    pool.stop();
+
+    if (mapped) {
+        reader.adviseRandomAccess();
+    }
+    return reader.checkComplete(records, badBlocks);
+}
+
+bool KVStore::loadText(const std::string& filepath) {
+    std::ifstream inFile(filepath);
+    if (!inFile.is_open()) {
         LOG_ERROR << "KVStore load failed: " << filepath;
+        return false;
     }
-    return success;
+
+    // 先清空现有数据
+    clear();
+
+    // 逐行按 key 路由到所属分片
+    std::string line;
+    std::string key;
+    std::string value;
+    while (std::getline(inFile, line)) {
+        if (parseLine(line, key, value)) {
+            shardFor(key).insert(key, Value(value));
+        }
+    }
+
+    recountMemtable();
+    LOG_INFO << "KVStore loaded legacy text file " << filepath << ", size=" << size();
+    return true;
 }
 
 void KVStore::dump() const {
-    skiplist_.displayList();
+    for (const Shard& shard : shards_) {
+        shard.display();
+    }
+}
+
+bool KVStore::openLog(const std::string& path, const WalOptions& options) {
+    std::unique_ptr<WriteAheadLog> wal(new WriteAheadLog(path, options));
+    size_t replayed = wal->replay([this](const WalRecord& record) { applyLogRecord(record); });
+    if (!wal->open()) {
+        return false;
+    }
+    wal_ = std::move(wal);
+    recountMemtable();
+    LOG_INFO << "KVStore WAL " << path << " replayed " << replayed
+             << " records, size=" << size();
+    return true;
+}
+
+// ==================== 内存上限 ====================
+
+size_t KVStore::memoryUsed() const {
+    size_t bytes = 0;
+    for (const Shard& shard : shards_) {
+        if (shard.skiplist) {
+            bytes += shard.skiplist->liveBytes();
+        }
+    }
+    return bytes;
+}
+
+void KVStore::evictFor(size_t incoming) {
+    if (memoryUsed() + incoming <= options_.maxMemory) {
+        return;
+    }
+    MutexLockGuard lock(evictionMutex_);
+    int misses = 0;
+    // 等锁期间其他线程可能已经淘汰够了
+    while (memoryUsed() + incoming > options_.maxMemory && misses < kEvictionMaxMisses) {
+        const size_t before = memoryUsed();
+        if (!evictOne()) {
+            LOG_WARN << "KVStore: nothing left to evict, used=" << before
+                     << " maxMemory=" << options_.maxMemory;
+            return;
+        }
+        misses = memoryUsed() < before ? 0 : misses + 1;
+    }
+}
+
+bool KVStore::evictOne() {
+    // 轮流采样各个分片，跳过空的分片
+    const AccessTracker* tracker = accessTracker_.get();
+    const int64_t now = nowMs();
+    for (size_t tried = 0; tried < shards_.size(); tried++) {
+        const int index = static_cast<int>(evictionCursor_++ % shards_.size());
+        const Shard& shard = shards_[index];
+        if (shard.skiplist->size() == 0) {
+            continue;
+        }
+        shard.skiplist->sample(kEvictionSamples, [this, tracker, index, now](
+                                                     const std::string& key, const Value& value,
+                                                     uint16_t access) {
+            uint32_t score = value.expiredAt(now) ? kExpiredScore : tracker->score(access);
+            auto same = std::find_if(evictionPool_.begin(), evictionPool_.end(),
+                                     [&key](const EvictionCandidate& c) { return c.key == key; });
+            if (same != evictionPool_.end()) {
+                evictionPool_.erase(same);
+            }
+            if (evictionPool_.size() >= kEvictionPoolSize) {
+                if (score <= evictionPool_.front().score) {
+                    return;
+                }
+                evictionPool_.erase(evictionPool_.begin());
+            }
+            auto pos = std::upper_bound(
+                evictionPool_.begin(), evictionPool_.end(), score,
+                [](uint32_t s, const EvictionCandidate& c) { return s < c.score; });
+            evictionPool_.insert(pos, EvictionCandidate{score, index, key});
+        });
+        break;
+    }
+    if (evictionPool_.empty()) {
+        return false;
+    }
+    EvictionCandidate candidate = std::move(evictionPool_.back());
+    evictionPool_.pop_back();
+    if (evictKey(candidate)) {
+        evictedKeys_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool KVStore::evictKey(const EvictionCandidate& candidate) {
+    Shard& shard = shards_[candidate.shard];
+    bool live;
+    if (wal_) {
+        MutexLockGuard lock(*shard.logMutex);
+        live = shard.remove(candidate.key);
+        if (live) {
+            wal_->appendDel(candidate.key);
+        }
+    } else {
+        live = shard.remove(candidate.key);
+    }
+    LOG_DEBUG << "KVStore::evict key=" << candidate.key << " live=" << live;
+    return live;
+}
+
+MemtableFilter::Stats KVStore::filterStats() const {
+    MemtableFilter::Stats stats;
+    for (const Shard& shard : shards_) {
+        if (shard.filter) {
+            stats += shard.filter->stats();
+        }
+    }
+    return stats;
+}
+
+bool KVStore::syncLog() {
+    return !wal_ || wal_->sync();
+}
+
+// ==================== 分片所属线程 ====================
+
+bool KVStore::setShardOwners(const ShardExecutor& executor) {
+    if (tableSet_ || options_.maxMemory > 0) {
+        // 后台刷盘和淘汰会在其他线程中写分片
+        LOG_WARN << "KVStore: shard owners are not supported with the disk tier or maxmemory, "
+                    "writes stay locked";
+        return false;
+    }
+    shardExecutor_ = executor;
+    for (Shard& shard : shards_) {
+        if (shard.skiplist) {
+            shard.skiplist->setSingleWriter(true);
+        }
+    }
+    LOG_INFO << "KVStore: each shard is written by its owner thread only, writes skip the shard locks";
+    return true;
+}
+
+// ==================== 磁盘层 ====================
+
+bool KVStore::openTables(const std::string& dir, const TableOptions& options) {
+    if (options_.skipListType == SkipListType::kLockFree) {
+        LOG_ERROR << "KVStore: SSTables need the mutex skiplist (flushes pin versions)";
+        return false;
+    }
+    if (tableSet_) {
+        LOG_ERROR << "KVStore: tables are already open";
+        return false;
+    }
+    if (hasShardOwners()) {
+        LOG_ERROR << "KVStore: SSTables need locked shards (flushes write from a background thread)";
+        return false;
+    }
+    std::unique_ptr<TableSet> tableSet(new TableSet(dir, options));
+    if (!tableSet->open()) {
+        return false;
+    }
+    if (options_.maxMemory > 0) {
+        // 数据超过内存时刷到表里，不需要淘汰
+        LOG_WARN << "KVStore: maxmemory is ignored with SSTables";
+        options_.maxMemory = 0;
+    }
+    tableSet_ = std::move(tableSet);
+    tableWorker_.reset(new Thread([this] { tableWorkerLoop(); }, "TableWorker"));
+    tableWorker_->start();
+    recountMemtable();
+    if (tableSet_->needsCompaction()) {
+        MutexLockGuard lock(tableMutex_);
+        compactRequested_ = true;
+        tableCond_.notify();
+    }
+    return true;
+}
+
+bool KVStore::flush() {
+    if (!tableSet_) {
+        return false;
+    }
+    bool success = flushMemtable();
+    if (success && tableSet_->needsCompaction()) {
+        MutexLockGuard lock(tableMutex_);
+        compactRequested_ = true;
+        tableCond_.notify();
+    }
+    return success;
+}
+
+void KVStore::noteWrite(size_t bytes) {
+    if (!tableSet_) {
+        return;
+    }
+    size_t total = memtableBytes_.fetch_add(bytes + kMemtableEntryOverhead,
+                                            std::memory_order_relaxed) +
+                   bytes + kMemtableEntryOverhead;
+    // 只有第一个越过阈值的写操作通知后台线程，刷盘结束前不再重复通知
+    if (total >= tableSet_->options().memtableBytes &&
+        !flushPending_.exchange(true, std::memory_order_acq_rel)) {
+        MutexLockGuard lock(tableMutex_);
+        flushRequested_ = true;
+        tableCond_.notify();
+    }
+}
+
+void KVStore::recountMemtable() {
+    if (!tableSet_) {
+        return;
+    }
+    size_t bytes = 0;
+    size_t count = scanAt(nullptr, nullptr, true, "", "", 0,
+                          [&bytes](const std::string& key, const Value& value) {
+        bytes += key.size() + value.size();
+        return true;
+    });
+    memtableBytes_.store(0, std::memory_order_relaxed);
+    noteWrite(bytes + count * kMemtableEntryOverhead - kMemtableEntryOverhead);
+    recountLiveKeys();
+}
+
+void KVStore::recountLiveKeys() {
+    // 与刷盘互斥（刷盘会扣除写成墓碑的过期值）；持有所有分片的日志锁固定快照并读出计数，
+    // 两者对应同一时刻。遍历期间的写操作照常增减，最后只替换快照时刻的计数
+    beginSave();
+    lockAllShards();
+    bool rotated = false;
+    TableSet::TableListPtr tables;
+    SnapshotSequences sequences = pinSnapshot(PinPurpose::kScan, &rotated, &tables);
+    std::vector<int> before(shards_.size());
+    for (size_t i = 0; i < shards_.size(); i++) {
+        before[i] = shards_[i].liveKeys->load(std::memory_order_relaxed);
+    }
+    unlockAllShards();
+    // 与写操作的口径一致：最新版本不是墓碑就计入，过期未摘除的也算
+    std::vector<int> counts(shards_.size(), 0);
+    scanAt(&sequences, tables.get(), true, "", "", 0,
+           [this, &counts](const std::string& key, const Value& value) {
+        if (!value.isTombstone()) {
+            counts[shardIndex(key)]++;
+        }
+        return true;
+    });
+    unpinSnapshot();
+    endSave();
+    for (size_t i = 0; i < shards_.size(); i++) {
+        shards_[i].liveKeys->fetch_add(counts[i] - before[i], std::memory_order_relaxed);
+    }
+}
+
+bool KVStore::flushMemtable() {
+    beginSave();
+    // 先取 generation 再固定快照：两者之间发生的 clear 会让 addTable 丢弃这个表，
+    // 此时 memtable 中的数据原样保留，不会丢失
+    const uint64_t generation = tableSet_->generation();
+    bool rotated = false;
+    SnapshotSequences sequences = pinSnapshot(PinPurpose::kFlush, &rotated, nullptr);
+    const size_t bytes = memtableBytes_.load(std::memory_order_relaxed);
+    flushPending_.store(false, std::memory_order_release);
+
+    uint64_t number = 0;
+    const std::string path = tableSet_->newTablePath(&number);
+    TableBuilder builder(path, tableSet_->options().bloomBitsPerKey);
+    bool success = builder.open();
+    // 与 writeSnapshot 相同，分批遍历，墓碑也写进表中；已经过期的值写成墓碑，
+    // 它们仍要遮住更旧的表中的同一个 key
+    const int64_t now = nowMs();
+    std::vector<std::string> expired;  // 计数中还包含的过期值，写成墓碑后扣除（按 key 升序）
+    std::string last;
+    bool resumed = false;
+    while (success) {
+        size_t visited = scanAt(&sequences, nullptr, true, last, "", kSnapshotScanBatch + 1,
+                                [&](const std::string& key, const Value& value) {
+            if (resumed && key == last) {
+                return true;
+            }
+            if (!value.isTombstone() && value.expiredAt(now)) {
+                expired.push_back(key);
+            }
+            const bool dead = value.isTombstone() || value.expiredAt(now);
+            success = builder.add(key.data(), key.size(), value.data(), value.size(), dead,
+                                  value.expireAt());
+            last = key;
+            return success;
+        });
+        if (visited <= kSnapshotScanBatch) {
+            break;
+        }
+        resumed = true;
+    }
+    const uint64_t count = builder.count();
+    success = success && (count == 0 || builder.finish());
+    unpinSnapshot();
+
+    TableSet::TablePtr table;
+    if (success && count > 0) {
+        table = tableSet_->addTable(number, generation);
+        success = table != nullptr;
+    }
+    if (success && rotated) {
+        wal_->removeRotated();
+    }
+
+    // 表已经登记，读者在 memtable 中找不到时会查到它；快照之后又被写过的 key 留在 memtable。
+    // 摘除在日志锁下进行：写操作判断 key 是否已计数到写入之间，memtable 中的值不会被摘走。
+    // 摘掉的过期值在表中是墓碑，从计数中扣除；没摘掉的已被新的写操作重新计数
+    if (table) {
+        Table::Iterator it(table.get());
+        size_t nextExpired = 0;
+        for (it.seekToFirst(); it.valid(); it.next()) {
+            const std::string& key = it.key();
+            Shard& shard = shards_[shardIndex(key)];
+            MutexLockGuard lock(*shard.logMutex);
+            if (!shard.skiplist->removeIfUnchanged(key, sequences[shardIndex(key)])) {
+                continue;
+            }
+            if (shard.filter) {
+                shard.filter->noteRemove();
+            }
+            while (nextExpired < expired.size() && expired[nextExpired] < key) {
+                nextExpired++;
+            }
+            if (nextExpired < expired.size() && expired[nextExpired] == key) {
+                shard.liveKeys->fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+        // memtable 清空了大半，过滤器按剩下的 key 重建
+        for (Shard& shard : shards_) {
+            if (shard.filter && shard.filter->needsRebuild()) {
+                shard.rebuildFilter();
+            }
+        }
+        size_t current = memtableBytes_.load(std::memory_order_relaxed);
+        while (!memtableBytes_.compare_exchange_weak(current, current > bytes ? current - bytes : 0,
+                                                     std::memory_order_relaxed)) {
+        }
+        LOG_INFO << "KVStore flushed " << count << " keys to " << path;
+    } else if (!success) {
+        LOG_ERROR << "KVStore flush to " << path << " failed";
+    }
+    endSave();
+    return success;
+}
+
+void KVStore::tableWorkerLoop() {
+    while (true) {
+        bool flushNow = false;
+        bool compactNow = false;
+        {
+            MutexLockGuard lock(tableMutex_);
+            while (!tableStopping_ && !flushRequested_ && !compactRequested_) {
+                tableCond_.wait();
+            }
+            if (tableStopping_) {
+                return;
+            }
+            flushNow = flushRequested_;
+            compactNow = compactRequested_;
+            flushRequested_ = false;
+            compactRequested_ = false;
+        }
+        if (flushNow) {
+            flushMemtable();
+        }
+        // 合并丢掉了过期的值，这些 key 不再计入，按合并后的数据重新计数
+        if ((compactNow || tableSet_->needsCompaction()) && tableSet_->compact()) {
+            recountLiveKeys();
+        }
+    }
+}
+
+void KVStore::lockAllShards() const {
+    for (const Shard& shard : shards_) {
+        shard.logMutex->lock();
+    }
+}
+
+void KVStore::unlockAllShards() const {
+    for (auto it = shards_.rbegin(); it != shards_.rend(); ++it) {
+        it->logMutex->unlock();
+    }
+}
+
+void KVStore::applyLogRecord(const WalRecord& record) {
+    switch (record.type) {
+        case WalRecordType::kPut:
+            shardFor(record.key).insert(record.key, Value(record.value));
+            break;
+        case WalRecordType::kPutExpire:
+            // 已经过期的也照常写入，由读者隐藏：之后可能还有延长它的 EXPIRE
+            shardFor(record.key).insert(record.key, Value(record.value).withExpiry(record.expireAt));
+            break;
+        case WalRecordType::kExpire:
+            expireKey(shardFor(record.key), record.key, record.expireAt, 0);
+            break;
+        case WalRecordType::kDel:
+            eraseKey(shardFor(record.key), record.key);
+            break;
+        case WalRecordType::kClear:
+            clearData();
+            break;
+        case WalRecordType::kClearShard: {
+            if (record.shards == shards_.size()) {
+                clearShardData(static_cast<int>(record.shard));
+                break;
+            }
+            // 分片数变了：按写日志时的分片数找出属于该分片的 key
+            std::vector<std::string> keys;
+            scan("", "", 0, [&keys, &record](const std::string& key, const Value&) {
+                if (std::hash<std::string>()(key) % record.shards == record.shard) {
+                    keys.push_back(key);
+                }
+                return true;
+            });
+            for (const std::string& key : keys) {
+                eraseKey(shardFor(key), key);
+            }
+            break;
+        }
+    }
 }
 
 }  // namespace kvstore
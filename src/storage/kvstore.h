@@ -2,12 +2,49 @@
 #ifndef KVSTORE_STORAGE_KVSTORE_H
 #define KVSTORE_STORAGE_KVSTORE_H
 
+#include "base/mutex.h"
+#include "base/thread.h"
+#include "storage/bloom_filter.h"
+#include "storage/eviction.h"
 #include "storage/skiplist.h"
+#include "storage/lockfree_skiplist.h"
+#include "storage/snapshot.h"
+#include "storage/table_set.h"
+#include "storage/value.h"
+#include "storage/wal.h"
 
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace kvstore {
 
+/**
+ * @brief 底层跳表实现
+ */
+enum class SkipListType {
+    kMutex,     // 互斥锁保护的 SkipList（默认）
+    kLockFree,  // 基于 CAS 的 LockFreeSkipList
+};
+
+/**
+ * @brief KVStore 配置
+ */
+struct KVStoreOptions {
+    int maxLevel = 16;                                 // 跳表最大层数
+    SkipListType skipListType = SkipListType::kMutex;  // 底层跳表实现
+    int shards = 1;                                    // 分片数，每个分片一棵独立的跳表
+    bool hashIndex = false;                            // 为 GET/EXISTS/DEL 维护哈希索引（仅 kMutex）
+    bool prefixCompression = false;                    // 跳表节点压缩 key 前缀（仅 kMutex，与 hashIndex 互斥）
+    bool mmapValues = false;                           // 加载快照时长值直接引用文件映射（见 load）
+    int loadThreads = 0;                               // 加载快照的线程数，0 表示 CPU 核数（见 load）
+    int bloomBitsPerKey = 10;                          // 每个分片的布隆过滤器每 key 位数，0 表示关闭
+    size_t maxMemory = 0;                              // 数据占用内存的上限（字节），0 表示不限（仅 kMutex）
+    EvictionPolicy evictionPolicy = EvictionPolicy::kLru;  // 超过 maxMemory 时的淘汰策略
+};
+
 /**
  * @brief KV 存储引擎
  *
@@ -15,7 +52,57 @@ namespace kvstore {
  * 底层使用跳表作为内存索引结构，支持：
  * - O(log N) 的读写操作
  * - 数据持久化和加载
- * - 线程安全
+ * - 线程安全（可选互斥锁跳表或无锁跳表，见 SkipListType）
+ *
+ * 分片：数据按 key 的哈希分布到 options.shards 棵互相独立的跳表中，
+ * 不同分片的写操作互不竞争同一把锁。单 key 操作只访问一个分片；
+ * size/clear/save/load 依次作用于所有分片（不保证跨分片的原子性）。
+ * save 输出单个文件，格式与分片数无关，可以用不同的分片数加载。
+ *
+ * 值以 Value 存放：短值内联在跳表节点里，长值引用计数共享。
+ * get(key, Value&) 不分配内存，也不拷贝长值的内容。
+ *
+ * 预写日志（openLog）：开启后 put/del/clear 在写入内存的同时追加到 WAL，
+ * 同一分片的"写内存 + 追加日志"在分片的日志锁内完成，保证日志顺序与内存一致。
+ * save 作为检查点：先轮换日志，快照成功落盘后删除旧日志。
+ *
+ * 快照是时间点一致的：save/saveInBackground 短暂持有所有分片的写锁，固定每个分片的
+ * 写序号后立即释放，之后写操作照常进行，被覆盖、删除的旧版本保留在跳表中直到快照写完
+ * （见 SkipList::pinVersions）。无锁跳表没有多版本，它的快照是写入期间的遍历结果。
+ *
+ * 分片所属线程（setShardOwners，shard-per-core）：每个分片只由一个线程读写时，
+ * 写操作既不取跳表的写锁（SkipList::setSingleWriter）也不取分片的日志锁，只在所属线程中执行。
+ * 需要固定快照时由各所属线程分别固定自己的分片（不再是所有分片的同一时刻），
+ * 跨分片的遍历用 scanShard 在各所属线程中分别进行、由调用方归并。
+ * 开启 WAL 时日志文件仍是所有分片共用的，追加在 WAL 内部的锁下进行。
+ *
+ * 磁盘层（openTables，仅互斥锁跳表）：数据量超过内存时，跳表作为 memtable，
+ * 超过 TableOptions::memtableBytes 后由后台线程刷成一个 SSTable（见 TableSet）：
+ * 固定快照（与 save 相同，写操作不停顿），把快照写成表并登记，再把快照之后没有
+ * 再被写过的 key 从 memtable 中删除。读操作先查 memtable，再从新到旧查各个表；
+ * DEL 写入墓碑（Value::tombstone）遮住表中的旧值。表的个数达到阈值后在后台合并。
+ * 开启后各分片维护一个 key 数（最新版本不是墓碑的 key，与不开启时一样包括过期未摘除的），
+ * size/shardSize 不用遍历表：写操作在分片的日志锁下判断 key 是否已计数（memtable 中没有时
+ * 先问表的布隆过滤器，可能有才读表），刷盘扣除写成墓碑的过期值，合并丢弃过期值之后和批量
+ * 加载之后归并遍历一次重新计数。save 导出的是 memtable 与所有表合并后的结果。
+ *
+ * 过期时间（TTL）：保存在 Value 中（见 Value::withExpiry），是绝对时刻（Unix 毫秒）。
+ * 读操作按当前时间判断，已经过期的 key 对 get/exists/scan/del 都不存在（惰性过期）；
+ * 过期的 key 仍然占用内存，由调用方定期对每个分片调用 expireShard 分批扫描摘除（主动过期，
+ * 如服务端时间轮上的周期定时器）。主动过期只支持互斥锁跳表：判断和删除必须在同一把锁内，
+ * 否则会删掉并发写入的新值；无锁跳表只有惰性过期。开启磁盘层时过期的 key 在
+ * memtable 中换成墓碑，刷盘时写成墓碑，表中的过期值在合并时丢弃。
+ *
+ * 内存上限（options.maxMemory，仅互斥锁跳表、不开启磁盘层）：memoryUsed() 精确统计
+ * 各分片最新版本的节点和 key/value 的堆内存。put 之前估计新记录的大小，会超过上限时
+ * 先淘汰：从各分片轮流随机采样 kEvictionSamples 个 key，放进按淘汰优先级排序的候选池
+ * （跨轮次保留，采样越多越接近精确的 LRU/LFU），取出最该淘汰的删除，直到放得下为止。
+ * 已经过期的 key 最先淘汰。淘汰和 del 一样写 WAL，淘汰的 key 数见 evictedKeys()。
+ * 优先级来自节点的访问字（见 AccessTracker）：LRU 按最近访问时刻，LFU 按衰减的访问计数。
+ *
+ * 布隆过滤器：每个分片一个（MemtableFilter），随插入维护，加载之后重建。
+ * 不存在的 key 的 GET/EXISTS 通常在过滤器处就返回，不下降跳表；
+ * 开启磁盘层时每个表另有自己的过滤器（见 Table）。误判率见 filterStats()。
  *
  * 使用示例：
  *   KVStore store;
@@ -36,6 +123,12 @@ public:
      */
     explicit KVStore(int maxLevel = 16);
 
+    /**
+     * @brief 构造函数
+     * @param options 存储配置
+     */
+    explicit KVStore(const KVStoreOptions& options);
+
     /**
      * @brief 析构函数
      */
@@ -54,6 +147,9 @@ public:
      */
     bool put(const std::string& key, const std::string& value);
 
+    /// 写入键值对，value 已经是 Value 时不再重新构造；value 带过期时间时 key 到期后失效
+    bool put(const std::string& key, const Value& value);
+
     /**
      * @brief 读取键对应的值
      * @param key 键
@@ -62,6 +158,14 @@ public:
      */
     bool get(const std::string& key, std::string& value) const;
 
+    /**
+     * @brief 读取键对应的值，不拷贝值的内容
+     *
+     * 短值是一次 24 字节的拷贝，长值只增加引用计数；返回的 Value 与存储解耦，
+     * 之后的更新或删除不影响它。
+     */
+    bool get(const std::string& key, Value& value) const;
+
     /**
      * @brief 删除键值对
      * @param key 键
@@ -76,6 +180,102 @@ public:
      */
     bool exists(const std::string& key) const;
 
+    // ==================== 批量操作 ====================
+
+    /**
+     * @brief 批量读取
+     *
+     * keys 按分片分组、组内按 key 排序后，每个分片一次 finger search 遍历
+     * （见 SkipList::searchSorted），相邻的 key 不必每次从最高层下降。
+     * 不是跨 key 的原子快照。
+     *
+     * @param values 输出，与 keys 一一对应；不存在的 key 对应的 Value 为空
+     * @param found 输出，found[i] 表示 keys[i] 是否存在
+     * @return 存在的 key 数
+     */
+    size_t multiGet(const std::vector<std::string>& keys, std::vector<Value>* values,
+                    std::vector<bool>* found) const;
+
+    /**
+     * @brief 批量写入，keys[i] 的值为 values[i]，同一个 key 出现多次时后面的生效
+     *
+     * 每个分片只获取一次日志锁和跳表写锁，按 key 排序后一次遍历写完（见 SkipList::insertSorted）。
+     * 同一分片内的写入对读者逐条可见，不同分片之间没有原子性。
+     *
+     * @return 新增的 key 数
+     */
+    size_t multiPut(const std::vector<std::string>& keys, const std::vector<Value>& values);
+
+    /**
+     * @brief 批量删除，分片内的处理同 multiPut
+     * @return 删除的 key 数（不含已经过期的）
+     */
+    size_t multiDel(const std::vector<std::string>& keys);
+
+    // ==================== 过期时间 ====================
+
+    /// 当前时刻（Unix 毫秒），过期时间都以它为准
+    static int64_t nowMs();
+
+    /**
+     * @brief 设置 key 的过期时刻
+     *
+     * 不晚于当前时刻时等同于 del。
+     *
+     * @param expireAtMs 绝对时刻（Unix 毫秒），0 表示去掉过期时间
+     * @return true 成功，false 键不存在
+     */
+    bool expire(const std::string& key, int64_t expireAtMs);
+
+    /**
+     * @brief key 的过期时刻
+     * @return 过期时刻（Unix 毫秒）；0 表示没有过期时间；-1 表示键不存在
+     */
+    int64_t expireAt(const std::string& key) const;
+
+    /**
+     * @brief key 已经过期时把它从 memtable 中摘除（主动过期）
+     *
+     * 到期之后又被写过的 key 保留新值。无锁跳表不支持，总是返回 false。
+     *
+     * @return true 摘除了 key
+     */
+    bool expireIfDue(const std::string& key);
+
+    /// 是否支持主动过期（互斥锁跳表）
+    bool activeExpiry() const { return options_.skipListType == SkipListType::kMutex; }
+
+    /**
+     * @brief 主动过期的一步：从 *cursor 起检查分片 index 中最多 budget 个 key，摘除已经过期的
+     *
+     * 读的是节点中保存的过期时刻，不需要另外的索引。扫到分片末尾后 *cursor 置空，
+     * 下一次从头开始；只扫 memtable，表中的过期值在合并时丢弃。无锁跳表不支持，总是返回 0。
+     *
+     * @param cursor 下一个要检查的 key，空串表示从头开始；由调用方保存
+     * @return 摘除的 key 数
+     */
+    size_t expireShard(int index, std::string* cursor, size_t budget);
+
+    // ==================== 有序遍历 ====================
+
+    /// scan 的回调，返回 false 提前结束遍历
+    using ScanVisitor = std::function<bool(const std::string& key, const Value& value)>;
+
+    /**
+     * @brief 按 key 升序遍历 [start, end] 内的键值对
+     *
+     * 多个分片时对各分片的迭代器做多路归并。遍历不持锁，也不是快照：
+     * 与写操作并发时能否看到遍历期间的修改是不确定的。
+     *
+     * @param start 起始 key（包含），为空表示从最小的 key 开始
+     * @param end 结束 key（包含），为空表示不设上界
+     * @param limit 最多访问的条数，0 表示不限
+     * @param visitor 对每个键值对调用一次
+     * @return 实际访问的条数
+     */
+    size_t scan(const std::string& start, const std::string& end, size_t limit,
+                const ScanVisitor& visitor) const;
+
     // ==================== 管理操作 ====================
 
     /**
@@ -93,16 +293,51 @@ public:
 
     /**
      * @brief 将数据保存到文件
+     *
+     * 文件为二进制快照格式（见 snapshot.h），记录按 key 全局有序。
+     * 内容是调用时刻的数据，写文件期间不阻塞其他线程的读写。
+     * 有后台保存正在进行时先等待它完成。
+     *
      * @param filepath 文件路径
      * @return true 成功，false 失败
      */
     bool save(const std::string& filepath) const;
 
+    /**
+     * @brief 在后台线程中保存，立即返回
+     *
+     * 快照时刻在本函数返回前固定，文件内容与调用时刻的数据一致。
+     * 设置了分片所属线程时各分片的快照在后台线程开始后由所属线程固定。
+     *
+     * @return true 已开始保存，false 已有保存正在进行
+     */
+    bool saveInBackground(const std::string& filepath);
+
+    /// 是否有保存正在进行
+    bool isSaving() const;
+
+    /// 上一次保存的时刻之后是否有写操作（无锁跳表无法判断，总是返回 true）
+    bool hasUnsavedChanges() const;
+
     /**
      * @brief 从文件加载数据
      *
      * 注意：会清空当前数据后再加载
      *
+     * 快照文件通过 mmap 顺序读取，记录已按 key 排序，每个分片从表尾线性构建。
+     * 快照格式按块校验，损坏的块被跳过并记录错误日志，其余数据照常加载。
+     * 也能读取旧版本保存的 "key:value" 文本文件。
+     *
+     * 并行加载（options.loadThreads > 1）：快照的块可以独立解码，文件按块切成若干段，
+     * 多个线程同时解码并按分片归类；之后每个分片由一个线程按段的顺序追加构建，
+     * 同一分片的记录顺序与文件一致。构建的并行度不超过分片数，下一批段的解码与
+     * 上一批的构建同时进行。
+     *
+     * 开启 options.mmapValues 时，超过内联长度的值不拷贝到堆上，而是引用文件映射
+     * （Value::reference），映射保留到 KVStore 析构；这些页是文件页，内存紧张时内核可以
+     * 直接丢弃、用到时再从文件读回。此时从 get 得到的 Value 不能比 KVStore 活得久，
+     * 快照文件也不能被原地修改或截断（save 总是写临时文件再替换，不受影响）。
+     *
      * @param filepath 文件路径
      * @return true 成功，false 失败
      */
@@ -113,8 +348,353 @@ public:
      */
     void dump() const;
 
+    // ==================== 预写日志 ====================
+
+    /**
+     * @brief 重放 WAL 并开始记录之后的写操作
+     *
+     * 应在加载快照之后、开始处理请求之前调用。重放的记录直接应用到内存，不会再次写入日志。
+     *
+     * @param path 日志文件路径
+     * @param options 刷盘策略
+     * @return true 成功，false 日志文件无法打开
+     */
+    bool openLog(const std::string& path, const WalOptions& options);
+
+    /**
+     * @brief 等待到目前为止的写操作落盘
+     *
+     * 只有 WalSyncPolicy::kAlways 会阻塞；未开启日志时立即返回。
+     * 调用方在应答写请求前调用，一批请求只需调用一次。
+     * @return false 日志写入失败，这批写操作不会落盘，应答应改为错误
+     */
+    bool syncLog();
+
+    /// 是否开启了预写日志
+    bool hasLog() const { return wal_ != nullptr; }
+
+    // ==================== 分片所属线程 ====================
+
+    /// 在分片 shard 的所属线程中执行 task，调用线程就是所属线程时可以直接执行
+    using ShardExecutor = std::function<void(int shard, const std::function<void()>& task)>;
+
+    /**
+     * @brief 之后每个分片只在它的所属线程中读写，写操作不加锁
+     *
+     * 调用之后，单 key 操作、批量操作、clearShard、expireShard 只能在 key 所在分片的
+     * 所属线程中调用；clear 不能再使用（改为在各所属线程中 clearShard）。
+     * save/saveInBackground 通过 executor 让各所属线程固定和释放自己分片的快照：
+     * 轮换日志之后再固定，轮换与固定之间的写入在重放日志时再执行一遍，结果不变。
+     * save 会等待所属线程执行完，不能在所属线程中调用（只有一个所属线程、即调用线程时除外）。
+     *
+     * 磁盘层的后台刷盘和内存上限的淘汰要在其他线程中写分片，开启它们时不支持。
+     * 应在开始读写之前调用，之后不能取消。
+     *
+     * @return false 不支持，写操作保持加锁
+     */
+    bool setShardOwners(const ShardExecutor& executor);
+
+    /// 是否设置了分片所属线程
+    bool hasShardOwners() const { return static_cast<bool>(shardExecutor_); }
+
+    /**
+     * @brief 按 key 升序遍历分片 index 中 [start, end] 内的键值对，参数同 scan
+     *
+     * 只遍历 memtable，不与磁盘层的表归并。设置了分片所属线程时在所属线程中调用，
+     * 各分片的结果由调用方归并。
+     */
+    size_t scanShard(int index, const std::string& start, const std::string& end, size_t limit,
+                     const ScanVisitor& visitor) const;
+
+    /// 预写日志，未开启时为 nullptr
+    const WriteAheadLog* log() const { return wal_.get(); }
+
+    // ==================== 磁盘层 ====================
+
+    /**
+     * @brief 打开 dir 下的 SSTable，之后 memtable 超过阈值时刷盘
+     *
+     * 应在 openLog 之前调用（重放的删除需要写成墓碑）。开启后数据以表和 WAL 为准：
+     * 刷盘是检查点，轮换并删除已经写进表里的日志；load 会清空已有的表。
+     * 只支持互斥锁跳表（刷盘依赖多版本快照）。
+     *
+     * @return false 目录或表无法打开，或底层是无锁跳表
+     */
+    bool openTables(const std::string& dir, const TableOptions& options);
+
+    /// 是否开启了磁盘层
+    bool hasTables() const { return tableSet_ != nullptr; }
+
+    /// 磁盘层，未开启时为 nullptr
+    const TableSet* tables() const { return tableSet_.get(); }
+
+    /**
+     * @brief 把 memtable 刷成一个表，返回时已经落盘
+     * @return false 未开启磁盘层或写表失败
+     */
+    bool flush();
+
+    /// memtable 中数据的近似字节数（只在开启磁盘层时统计）
+    size_t memtableBytes() const { return memtableBytes_.load(std::memory_order_relaxed); }
+
+    // ==================== 内存上限 ====================
+
+    /// 各分片最新版本的数据占用的字节数（互斥锁跳表，见 SkipList::liveBytes；无锁跳表为 0）
+    size_t memoryUsed() const;
+
+    /// 内存上限，0 表示不限（配置不支持时也为 0）
+    size_t maxMemory() const { return options_.maxMemory; }
+
+    /// 淘汰策略
+    EvictionPolicy evictionPolicy() const { return options_.evictionPolicy; }
+
+    /// 因内存上限淘汰的 key 数（不含顺带摘除的过期 key）
+    uint64_t evictedKeys() const { return evictedKeys_.load(std::memory_order_relaxed); }
+
+    /// 所有分片的布隆过滤器统计之和（未开启过滤器时全为 0）
+    MemtableFilter::Stats filterStats() const;
+
+    /// 获取底层跳表实现类型
+    SkipListType skipListType() const { return options_.skipListType; }
+
+    /// 分片数
+    int shardCount() const { return static_cast<int>(shards_.size()); }
+
+    /// key 所属的分片下标，范围 [0, shardCount())
+    int shardIndex(const std::string& key) const;
+
+    /// 单个分片的键值对数量
+    int shardSize(int index) const;
+
+    /// 清空单个分片
+    void clearShard(int index);
+
 private:
-    SkipList<std::string, std::string> skiplist_;
+    using MutexSkipList = SkipList<std::string, Value>;
+    using ConcurrentSkipList = LockFreeSkipList<std::string, Value>;
+
+    /**
+     * @brief 一个分片：一棵独立的跳表
+     *
+     * 两个指针只有一个非空，由 options_.skipListType 决定。
+     */
+    struct Shard {
+        std::unique_ptr<MutexSkipList> skiplist;
+        std::unique_ptr<ConcurrentSkipList> lockFreeList;
+        std::unique_ptr<MutexLock> logMutex;  // 串行化本分片的写操作（与日志追加），见 writesLocked
+        std::unique_ptr<MemtableFilter> filter;  // 未命中的查询不下降跳表，bloomBitsPerKey 为 0 时为空
+        std::unique_ptr<std::atomic<int>> liveKeys;  // 开启磁盘层时本分片的 key 数
+
+        bool insert(const std::string& key, const Value& value);
+        bool search(const std::string& key, Value& value) const;
+
+        /// 删除 key，已经过期的 key 照常摘除但返回 false
+        bool remove(const std::string& key);
+
+        // 批量操作（仅互斥锁跳表）：order 为 keys 中属于本分片的下标，已按 key 升序排列
+
+        /// 对每个存在的 key 调用 visitor(下标, 值)
+        void searchBatch(const std::vector<std::string>& keys, const std::vector<size_t>& order,
+                         const std::function<void(size_t, const Value&)>& visitor) const;
+
+        /// 写入并对每条调用 visitor(下标, 是否新增)
+        void insertBatch(const std::vector<std::string>& keys, const std::vector<Value>& values,
+                         const std::vector<size_t>& order,
+                         const std::function<void(size_t, bool)>& visitor);
+
+        /// 删除并对每个删除了的未过期 key 调用 visitor(下标)
+        void removeBatch(const std::vector<std::string>& keys, const std::vector<size_t>& order,
+                         const std::function<void(size_t)>& visitor);
+
+        /// key 存在时用 fn 修改它的值（见 SkipList::modify）
+        bool modify(const std::string& key, const std::function<bool(Value&)>& fn);
+
+        /**
+         * @brief key 在 nowMs 时已经过期时摘除（仅互斥锁跳表）
+         * @param tombstone 换成墓碑而不是摘除（开启磁盘层时）
+         */
+        bool removeExpired(const std::string& key, int64_t nowMs, bool tombstone);
+
+        int size() const;
+        void clear();
+        void display() const;
+
+        /// 遍历跳表重建布隆过滤器（批量加载之后，或过滤器中失效的 key 太多时）
+        void rebuildFilter();
+    };
+
+    Shard& shardFor(const std::string& key) { return shards_[shardIndex(key)]; }
+    const Shard& shardFor(const std::string& key) const { return shards_[shardIndex(key)]; }
+
+    /// 批量操作是否逐分片批量执行（互斥锁跳表、未开启磁盘层），否则逐个 key 执行
+    bool batchable() const { return options_.skipListType == SkipListType::kMutex && !tableSet_; }
+
+    /// 开启 WAL 或磁盘层时，单 key 写操作在分片的日志锁下执行；分片只由所属线程写时不需要
+    bool writesLocked() const {
+        return (wal_ != nullptr || tableSet_ != nullptr) && !hasShardOwners();
+    }
+
+    /// 写分片时要持有的日志锁，不需要加锁时为 nullptr
+    MutexLock* writeLock(const Shard& shard) const {
+        return writesLocked() ? shard.logMutex.get() : nullptr;
+    }
+
+    /// 把 keys 的下标按分片分组，组内按 key 升序（相同的 key 保持原来的先后）
+    std::vector<std::vector<size_t>> groupByShard(const std::vector<std::string>& keys) const;
+
+    /// 按下标顺序获取 / 释放所有分片的日志锁
+    void lockAllShards() const;
+    void unlockAllShards() const;
+
+    /// 每个分片的快照序号，下标与 shards_ 一致
+    using SnapshotSequences = std::vector<uint64_t>;
+
+    /// 固定快照的用途，决定是否轮换 WAL、是否算作一次保存
+    enum class PinPurpose {
+        kSave,   // 保存快照文件：轮换日志（开启磁盘层时日志以表为准，不轮换）
+        kFlush,  // memtable 刷盘：轮换日志
+        kScan,   // 开启磁盘层时的 scan：只固定数据
+    };
+
+    /**
+     * @brief 在同一时刻固定所有分片的快照
+     * @param rotated 输出是否轮换了日志
+     * @param tables 非空时输出同一时刻的表列表（开启磁盘层时）
+     */
+    SnapshotSequences pinSnapshot(PinPurpose purpose, bool* rotated,
+                                  TableSet::TableListPtr* tables) const;
+
+    /// 设置了分片所属线程时的 pinSnapshot：rotate 为是否轮换日志
+    SnapshotSequences pinOwnedSnapshot(bool rotate, bool* rotated) const;
+
+    /// 释放 pinSnapshot 固定的快照
+    void unpinSnapshot() const;
+
+    /// 在每个分片的所属线程中执行 fn(分片下标)，全部执行完后返回
+    void runOnOwners(const std::function<void(int)>& fn) const;
+
+    /// 把快照写入 filepath（先写临时文件再替换），成功后删除轮换出的旧日志
+    bool writeSnapshot(const std::string& filepath, const SnapshotSequences& sequences,
+                       const TableSet::TableList* tables, bool rotated) const;
+
+    /// 等待正在进行的保存完成并标记开始保存 / 标记保存结束
+    void beginSave() const;
+    void endSave() const;
+
+    /// 所有互斥锁跳表分片的写序号之和
+    uint64_t writeSequence() const;
+
+    /**
+     * @brief scan 的实现
+     * @param sequences 非空时只读快照中的数据
+     * @param tables 非空时与这些表归并，同一个 key 以 memtable、较新的表为准
+     * @param tombstones 是否访问墓碑（刷盘时需要写进表中）
+     */
+    size_t scanAt(const SnapshotSequences* sequences, const TableSet::TableList* tables,
+                  bool tombstones, const std::string& start, const std::string& end,
+                  size_t limit, const ScanVisitor& visitor) const;
+
+    /// 依次查 memtable 和各个表，墓碑视为不存在
+    bool lookup(const Shard& shard, const std::string& key, Value& value) const;
+
+    /// 写入 key，返回是否新增；调用方持有分片的日志锁（开启 WAL 时）
+    bool insertKey(Shard& shard, const std::string& key, const Value& value);
+
+    /// 删除 key：开启磁盘层时写入墓碑，调用方持有分片的日志锁（开启 WAL 时）
+    bool eraseKey(Shard& shard, const std::string& key);
+
+    /**
+     * @brief 修改 key 的过期时刻，调用方持有分片的日志锁（开启 WAL 时）
+     * @param nowMs 在这个时刻已经过期的 key 视为不存在；重放日志时传 0
+     */
+    bool expireKey(Shard& shard, const std::string& key, int64_t expireAtMs, int64_t nowMs);
+
+    /// 清空一个分片的数据（开启磁盘层时为分片中的每个 key 写墓碑）
+    void clearShardData(int index);
+
+    /// 清空 memtable 和所有表
+    void clearData();
+
+    /// 记录 memtable 新增的一条记录，超过阈值时通知后台线程刷盘
+    void noteWrite(size_t bytes);
+
+    /// 批量写入（加载、重放）之后重新统计 memtable 的字节数和 key 数
+    void recountMemtable();
+
+    /// 开启磁盘层时归并遍历 memtable 和所有表，重新统计各分片的 key 数
+    void recountLiveKeys();
+
+    /// key 在 now 时已经过期时从分片中摘除（开启磁盘层时换成墓碑并扣除计数）
+    bool removeExpired(Shard& shard, const std::string& key, int64_t now);
+
+    /// 刷盘：固定快照写成表，登记后从 memtable 删除已写入的 key
+    bool flushMemtable();
+
+    /// 后台线程：刷盘和合并
+    void tableWorkerLoop();
+
+    /**
+     * @brief 用 threads 个线程并行加载快照的所有块（调用前已清空数据）
+     * @return true 所有块都完整且校验通过
+     */
+    bool loadBlocks(const SnapshotReader& reader, int threads);
+
+    /// 加载结束：记录日志，mmapValues 时保留映射
+    bool finishLoad(const std::string& filepath, std::unique_ptr<SnapshotReader> reader,
+                    bool complete);
+
+    /// 加载旧版 "key:value" 文本格式的数据文件
+    bool loadText(const std::string& filepath);
+
+    /// 将一条 WAL 记录应用到内存（重放时使用，不写日志）
+    void applyLogRecord(const WalRecord& record);
+
+    /// 淘汰的候选：采样时的优先级越大越先淘汰
+    struct EvictionCandidate {
+        uint32_t score;
+        int shard;
+        std::string key;
+    };
+
+    /// 写入约 incoming 字节之前，超过内存上限时淘汰 key 直到放得下（或没有可淘汰的）
+    void evictFor(size_t incoming);
+
+    /**
+     * @brief 采样一个分片补充候选池，再淘汰池中优先级最高的 key，调用方持有 evictionMutex_
+     * @return false 没有候选（所有分片都是空的）
+     */
+    bool evictOne();
+
+    /// 删除淘汰的 key 并写 WAL，返回是否删除了未过期的 key
+    bool evictKey(const EvictionCandidate& candidate);
+
+    KVStoreOptions options_;
+    std::unique_ptr<AccessTracker> accessTracker_;  // 开启内存上限时非空，须比分片活得久
+    std::vector<Shard> shards_;
+    std::unique_ptr<WriteAheadLog> wal_;
+    ShardExecutor shardExecutor_;        // 分片所属线程，为空表示任意线程都可以写
+    std::vector<std::unique_ptr<SnapshotReader>> mappedSnapshots_;  // mmapValues 时值引用的映射
+
+    mutable MutexLock saveMutex_;
+    mutable Condition saveDone_;         // 保存结束
+    mutable bool saving_;                // 是否有保存正在进行，saveMutex_ 保护
+    mutable std::atomic<uint64_t> savedSequence_;  // 上一次快照时刻的 writeSequence()
+    std::unique_ptr<Thread> saver_;      // 后台保存线程，saveMutex_ 保护
+
+    std::unique_ptr<TableSet> tableSet_;   // 磁盘层，openTables 之后非空
+    std::atomic<size_t> memtableBytes_;    // memtable 的近似字节数
+    std::atomic<bool> flushPending_;       // 已通知后台线程刷盘，尚未完成
+    MutexLock tableMutex_;
+    Condition tableCond_;                  // 唤醒后台线程
+    bool flushRequested_;                  // tableMutex_ 保护
+    bool compactRequested_;                // tableMutex_ 保护
+    bool tableStopping_;                   // tableMutex_ 保护
+    std::unique_ptr<Thread> tableWorker_;
+
+    MutexLock evictionMutex_;                      // 同一时刻只有一个线程在淘汰
+    std::vector<EvictionCandidate> evictionPool_;  // 按 score 升序，evictionMutex_ 保护
+    size_t evictionCursor_;                        // 下一个采样的分片，evictionMutex_ 保护
+    std::atomic<uint64_t> evictedKeys_;
 };
 
 }  // namespace kvstore
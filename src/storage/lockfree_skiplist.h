@@ -0,0 +1,729 @@
+// src/storage/lockfree_skiplist.h
+#ifndef KVSTORE_STORAGE_LOCKFREE_SKIPLIST_H
+#define KVSTORE_STORAGE_LOCKFREE_SKIPLIST_H
+
+#include "base/epoch.h"
+#include "base/noncopyable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace kvstore {
+
+/**
+ * @brief 无锁并发跳表
+ *
+ * 基于 CAS 的无锁跳表（Fraser / Herlihy-Shavit 算法）：
+ * - 每个节点的 next 指针是 std::atomic<uintptr_t>，最低位作为删除标记（marked pointer）
+ * - search 完全不加锁，也不修改任何共享状态
+ * - insert/remove 只在需要拼接的前驱节点上做 CAS，互不相关的写操作不会相互阻塞
+ *
+ * 删除分两步：
+ * 1. 逻辑删除：自顶向下给节点每一层的 next 打上标记，第 0 层标记成功者即为删除者
+ * 2. 物理删除：后续任何一次 find 遇到带标记的节点时，顺手把它从该层摘除
+ *
+ * 内存回收：
+ *   被删除的节点和被覆盖的旧值可能仍被并发的读者访问，不能立即释放。
+ *   退休时记下 EpochManager 的退休 epoch，挂到无锁的回收栈上；每退休 kReclaimBatch 个
+ *   尝试回收一次，释放所有线程都已离开读临界区的对象（与 SkipList 相同）。
+ *   所有操作都在 EpochGuard 内执行，EventLoop 线程中由静默状态保护。
+ *   节点在插入者链接完所有层、删除者完成摘除之后才退休（见 release）。
+ *
+ * 与 SkipList 的接口保持一致，可由 KVStore 按需选择。
+ *
+ * @tparam K 键类型，需要支持 < 和 == 运算符
+ * @tparam V 值类型
+ */
+template <typename K, typename V>
+class LockFreeSkipList : noncopyable {
+public:
+    /**
+     * @brief 构造函数
+     * @param maxLevel 跳表最大层数，默认 16
+     */
+    explicit LockFreeSkipList(int maxLevel = kDefaultMaxLevel);
+
+    /**
+     * @brief 析构函数
+     *
+     * 析构时不能有其他线程仍在访问跳表。
+     */
+    ~LockFreeSkipList();
+
+    /**
+     * @brief 插入键值对，key 已存在时更新 value
+     * @return true 插入成功（新键），false 更新已存在的键
+     */
+    bool insert(const K& key, const V& value);
+
+    /**
+     * @brief 查询键对应的值（无锁）
+     * @return true 查询成功，false 键不存在
+     */
+    bool search(const K& key, V& value) const;
+
+    /**
+     * @brief 删除键值对
+     * @return true 删除成功，false 键不存在
+     */
+    bool remove(const K& key);
+
+    /// 判断键是否存在
+    bool contains(const K& key) const;
+
+    /**
+     * @brief key 存在时用 fn 修改它的值
+     *
+     * fn(V& value) 的参数是当前值的副本，返回 false 表示不修改。新值用 CAS 换上，
+     * 期间值被其他线程替换时重新读取并再次调用 fn，不会覆盖并发的写入。
+     *
+     * @return true 已修改，false 键不存在或 fn 返回 false
+     */
+    template <typename Modifier>
+    bool modify(const K& key, Modifier fn);
+
+    /// 获取元素个数
+    int size() const { return elementCount_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 清空跳表
+     *
+     * 逐个逻辑删除当前所有节点，可以与其他操作并发执行。
+     */
+    void clear();
+
+    /// 将跳表数据持久化到文件（格式与 SkipList 相同："key:value\n"）
+    bool dumpFile(const std::string& filepath) const;
+
+    /// 按 key 升序将所有键值对写入输出流，格式同 dumpFile
+    bool dump(std::ostream& out) const;
+
+    /// 从文件加载数据到跳表
+    bool loadFile(const std::string& filepath);
+
+    /// 打印跳表结构（调试用）
+    void displayList() const;
+
+    /// 已退休、尚未释放的节点和旧值个数
+    size_t retiredCount() const { return retiredCount_.load(std::memory_order_relaxed); }
+
+    /// 有序迭代器（定义见类外）
+    class Iterator;
+
+private:
+    // ==================== 内部类型定义 ====================
+
+    /// 值的包装，被覆盖后挂到回收栈上
+    struct ValueBox {
+        V value;
+        ValueBox* retiredNext;
+        uint64_t retireEpoch;
+
+        explicit ValueBox(const V& v) : value(v), retiredNext(nullptr), retireEpoch(0) {}
+    };
+
+    /**
+     * @brief 跳表节点
+     *
+     * next 数组按节点层数变长分配：next[0..topLevel]。
+     */
+    struct Node {
+        K key;
+        std::atomic<ValueBox*> value;
+        int topLevel;
+        std::atomic<bool> released;  // 插入者或删除者之一已经放手
+        Node* retiredNext;
+        uint64_t retireEpoch;
+        std::atomic<uintptr_t> next[1];
+
+        Node(const K& k, ValueBox* v, int level)
+            : key(k), value(v), topLevel(level), released(false), retiredNext(nullptr),
+              retireEpoch(0) {}
+    };
+
+    // ==================== 标记指针 ====================
+
+    static constexpr uintptr_t kMarkBit = 1;
+
+    static Node* getPtr(uintptr_t p) { return reinterpret_cast<Node*>(p & ~kMarkBit); }
+    static bool isMarked(uintptr_t p) { return (p & kMarkBit) != 0; }
+    static uintptr_t toRaw(Node* node) { return reinterpret_cast<uintptr_t>(node); }
+
+    // ==================== 私有方法 ====================
+
+    int getRandomLevel() const;
+
+    Node* createNode(const K& key, ValueBox* value, int level);
+    static void destroyNode(Node* node);
+
+    /**
+     * @brief 定位 key 在每一层的前驱和后继
+     *
+     * 沿途把带删除标记的节点从对应层摘除；CAS 失败时从头重试。
+     *
+     * @return true 第 0 层后继的 key 与参数相等
+     */
+    bool find(const K& key, Node** preds, Node** succs) const;
+
+    /// 第一个 key >= 参数且未被逻辑删除的节点（只读，不摘除标记节点）
+    Node* findGreaterOrEqual(const K& key) const;
+
+    /// 逐层向上链接新节点，节点被并发删除时停止
+    void linkUpperLevels(Node* node, int topLevel, Node** preds, Node** succs);
+
+    /**
+     * @brief 插入者链接完所有层、删除者完成标记和摘除之后各调用一次，后调用的一方退休节点
+     *
+     * 插入者可能在删除者摘除之后又把节点链接到高层，后放手的一方再摘除一次，
+     * 退休的节点就不会再从跳表中可达。
+     */
+    void release(Node* node);
+
+    void retireNode(Node* node);
+    void retireValue(ValueBox* box);
+
+    /// 释放所有线程都已不可能访问的退休对象
+    void reclaim();
+
+    template <typename T>
+    void pushRetired(std::atomic<T*>* stack, T* first, T* last);
+
+    template <typename T>
+    void reclaimStack(std::atomic<T*>* stack, uint64_t safeEpoch);
+
+    static void destroyRetired(Node* node) {
+        delete node->value.load(std::memory_order_relaxed);
+        destroyNode(node);
+    }
+    static void destroyRetired(ValueBox* box) { delete box; }
+
+    bool parseString(const std::string& line, std::string& key, std::string& value) const;
+
+    // ==================== 成员变量 ====================
+
+    static constexpr int kDefaultMaxLevel = 16;
+    static constexpr int kMaxLevelLimit = 32;
+    static constexpr double kProbability = 0.25;
+    static constexpr char kDelimiter = ':';
+    static constexpr size_t kReclaimBatch = 64;  // 每退休多少个对象尝试回收一次
+
+    const int maxLevel_;
+    std::atomic<int> elementCount_;
+    Node* header_;
+
+    std::atomic<Node*> retiredNodes_;       // 已删除、等待宽限期的节点
+    std::atomic<ValueBox*> retiredValues_;  // 被覆盖、等待宽限期的旧值
+    std::atomic<size_t> retiredCount_;      // 两个回收栈中的对象数
+    std::atomic<size_t> retireTicks_;       // 累计退休次数，用于触发回收
+};
+
+/**
+ * @brief LockFreeSkipList 有序迭代器
+ *
+ * 沿第 0 层前进并跳过已逻辑删除的节点；与写操作并发时不是快照。
+ * 迭代器内含 EpochGuard，存活期间访问到的节点和值不会被回收；
+ * 必须在创建它的线程中使用和销毁，且不应长期持有（会推迟内存回收）。
+ */
+template <typename K, typename V>
+class LockFreeSkipList<K, V>::Iterator : noncopyable {
+public:
+    explicit Iterator(const LockFreeSkipList* list) : list_(list), node_(nullptr) {}
+
+    bool valid() const { return node_ != nullptr; }
+
+    const K& key() const { return node_->key; }
+    const V& value() const { return node_->value.load(std::memory_order_acquire)->value; }
+
+    void next() { node_ = skipMarked(node_->next[0].load(std::memory_order_acquire)); }
+
+    void seek(const K& target) { node_ = list_->findGreaterOrEqual(target); }
+
+    void seekToFirst() { node_ = skipMarked(list_->header_->next[0].load(std::memory_order_acquire)); }
+
+private:
+    /// 从 raw 指向的节点开始，跳过已逻辑删除的节点
+    static Node* skipMarked(uintptr_t raw) {
+        Node* node = getPtr(raw);
+        while (node != nullptr) {
+            uintptr_t succ = node->next[0].load(std::memory_order_acquire);
+            if (!isMarked(succ)) {
+                break;
+            }
+            node = getPtr(succ);
+        }
+        return node;
+    }
+
+    EpochGuard guard_;
+    const LockFreeSkipList* list_;
+    Node* node_;
+};
+
+// ==================== 模板类实现 ====================
+
+template <typename K, typename V>
+LockFreeSkipList<K, V>::LockFreeSkipList(int maxLevel)
+    : maxLevel_(maxLevel < 1 ? 1 : (maxLevel > kMaxLevelLimit ? kMaxLevelLimit : maxLevel)),
+      elementCount_(0),
+      header_(createNode(K(), nullptr, maxLevel_ - 1)),
+      retiredNodes_(nullptr),
+      retiredValues_(nullptr),
+      retiredCount_(0),
+      retireTicks_(0) {}
+
+template <typename K, typename V>
+LockFreeSkipList<K, V>::~LockFreeSkipList() {
+    // 此时已无并发访问：释放链表中的节点（含带标记但尚未摘除的）
+    Node* current = getPtr(header_->next[0].load(std::memory_order_acquire));
+    while (current != nullptr) {
+        Node* next = getPtr(current->next[0].load(std::memory_order_relaxed));
+        if (!isMarked(current->next[0].load(std::memory_order_relaxed))) {
+            delete current->value.load(std::memory_order_relaxed);
+            destroyNode(current);
+        }
+        current = next;
+    }
+    destroyNode(header_);
+
+    // 析构时不应再有并发读者，回收栈中的对象可以直接释放
+    reclaimStack(&retiredNodes_, std::numeric_limits<uint64_t>::max());
+    reclaimStack(&retiredValues_, std::numeric_limits<uint64_t>::max());
+}
+
+template <typename K, typename V>
+int LockFreeSkipList<K, V>::getRandomLevel() const {
+    thread_local std::random_device rd;
+    thread_local std::mt19937 gen(rd());
+    thread_local std::uniform_real_distribution<> dis(0.0, 1.0);
+
+    int level = 0;
+    while (dis(gen) < kProbability && level < maxLevel_ - 1) {
+        level++;
+    }
+    return level;
+}
+
+template <typename K, typename V>
+typename LockFreeSkipList<K, V>::Node* LockFreeSkipList<K, V>::createNode(const K& key,
+                                                                          ValueBox* value,
+                                                                          int level) {
+    // Node 自带 next[0]，额外再分配 level 个指针
+    size_t bytes = sizeof(Node) + level * sizeof(std::atomic<uintptr_t>);
+    void* mem = ::operator new(bytes);
+    Node* node = new (mem) Node(key, value, level);
+    for (int i = 0; i <= level; i++) {
+        new (&node->next[i]) std::atomic<uintptr_t>(0);
+    }
+    return node;
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::destroyNode(Node* node) {
+    node->~Node();
+    ::operator delete(node);
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::find(const K& key, Node** preds, Node** succs) const {
+retry:
+    Node* pred = header_;
+    for (int level = maxLevel_ - 1; level >= 0; level--) {
+        Node* curr = getPtr(pred->next[level].load(std::memory_order_acquire));
+        while (curr != nullptr) {
+            uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+            if (isMarked(succ)) {
+                // curr 已被逻辑删除，尝试从本层摘除；pred 被修改过则从头再来
+                uintptr_t expected = toRaw(curr);
+                if (!pred->next[level].compare_exchange_strong(expected, succ & ~kMarkBit,
+                                                               std::memory_order_acq_rel)) {
+                    goto retry;
+                }
+                curr = getPtr(succ);
+                continue;
+            }
+            if (curr->key < key) {
+                pred = curr;
+                curr = getPtr(succ);
+            } else {
+                break;
+            }
+        }
+        preds[level] = pred;
+        succs[level] = curr;
+    }
+    return succs[0] != nullptr && succs[0]->key == key;
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::insert(const K& key, const V& value) {
+    EpochGuard guard;
+    Node* preds[kMaxLevelLimit];
+    Node* succs[kMaxLevelLimit];
+    const int topLevel = getRandomLevel();
+    Node* newNode = nullptr;
+
+    while (true) {
+        if (find(key, preds, succs)) {
+            // key 已存在：原子替换 value，旧值延迟回收
+            ValueBox* box = new ValueBox(value);
+            ValueBox* old = succs[0]->value.exchange(box, std::memory_order_acq_rel);
+            retireValue(old);
+            if (newNode != nullptr) {
+                delete newNode->value.load(std::memory_order_relaxed);
+                destroyNode(newNode);
+            }
+            return false;
+        }
+
+        if (newNode == nullptr) {
+            newNode = createNode(key, new ValueBox(value), topLevel);
+        }
+        for (int i = 0; i <= topLevel; i++) {
+            newNode->next[i].store(toRaw(succs[i]), std::memory_order_relaxed);
+        }
+
+        // 第 0 层链接成功即代表插入生效（线性化点）
+        uintptr_t expected = toRaw(succs[0]);
+        if (preds[0]->next[0].compare_exchange_strong(expected, toRaw(newNode),
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    elementCount_.fetch_add(1, std::memory_order_relaxed);
+
+    linkUpperLevels(newNode, topLevel, preds, succs);
+    release(newNode);
+    return true;
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::linkUpperLevels(Node* node, int topLevel, Node** preds,
+                                              Node** succs) {
+    for (int level = 1; level <= topLevel; level++) {
+        while (true) {
+            uintptr_t nodeNext = node->next[level].load(std::memory_order_acquire);
+            if (isMarked(nodeNext)) {
+                return;
+            }
+            if (getPtr(nodeNext) != succs[level] &&
+                !node->next[level].compare_exchange_strong(nodeNext, toRaw(succs[level]),
+                                                            std::memory_order_acq_rel)) {
+                continue;
+            }
+            uintptr_t expected = toRaw(succs[level]);
+            if (preds[level]->next[level].compare_exchange_strong(expected, toRaw(node),
+                                                                  std::memory_order_release,
+                                                                  std::memory_order_relaxed)) {
+                break;
+            }
+            find(node->key, preds, succs);
+            if (succs[0] != node) {
+                return;
+            }
+        }
+    }
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::search(const K& key, V& value) const {
+    EpochGuard guard;
+    Node* curr = findGreaterOrEqual(key);
+    if (curr != nullptr && curr->key == key) {
+        value = curr->value.load(std::memory_order_acquire)->value;
+        return true;
+    }
+    return false;
+}
+
+template <typename K, typename V>
+typename LockFreeSkipList<K, V>::Node* LockFreeSkipList<K, V>::findGreaterOrEqual(
+    const K& key) const {
+    Node* pred = header_;
+    Node* curr = nullptr;
+
+    for (int level = maxLevel_ - 1; level >= 0; level--) {
+        curr = getPtr(pred->next[level].load(std::memory_order_acquire));
+        while (curr != nullptr) {
+            uintptr_t succ = curr->next[level].load(std::memory_order_acquire);
+            if (isMarked(succ)) {
+                // 跳过已逻辑删除的节点，读路径不做任何写操作
+                curr = getPtr(succ);
+                continue;
+            }
+            if (curr->key < key) {
+                pred = curr;
+                curr = getPtr(succ);
+            } else {
+                break;
+            }
+        }
+    }
+    return curr;
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::remove(const K& key) {
+    EpochGuard guard;
+    Node* preds[kMaxLevelLimit];
+    Node* succs[kMaxLevelLimit];
+
+    if (!find(key, preds, succs)) {
+        return false;
+    }
+    Node* victim = succs[0];
+
+    // 自顶向下标记第 1 层及以上
+    for (int level = victim->topLevel; level >= 1; level--) {
+        uintptr_t succ = victim->next[level].load(std::memory_order_acquire);
+        while (!isMarked(succ)) {
+            victim->next[level].compare_exchange_weak(succ, succ | kMarkBit,
+                                                      std::memory_order_acq_rel);
+        }
+    }
+
+    // 第 0 层标记成功者负责删除
+    uintptr_t succ = victim->next[0].load(std::memory_order_acquire);
+    while (true) {
+        if (isMarked(succ)) {
+            return false;  // 被其他线程抢先删除
+        }
+        if (victim->next[0].compare_exchange_weak(succ, succ | kMarkBit,
+                                                  std::memory_order_acq_rel)) {
+            break;
+        }
+    }
+
+    elementCount_.fetch_sub(1, std::memory_order_relaxed);
+    find(key, preds, succs);  // 物理摘除
+    release(victim);
+    return true;
+}
+
+template <typename K, typename V>
+template <typename Modifier>
+bool LockFreeSkipList<K, V>::modify(const K& key, Modifier fn) {
+    EpochGuard guard;
+    Node* curr = findGreaterOrEqual(key);
+    if (curr == nullptr || curr->key != key) {
+        return false;
+    }
+    ValueBox* old = curr->value.load(std::memory_order_acquire);
+    while (true) {
+        V value = old->value;
+        if (!fn(value)) {
+            return false;
+        }
+        ValueBox* box = new ValueBox(value);
+        if (curr->value.compare_exchange_strong(old, box, std::memory_order_acq_rel,
+                                                std::memory_order_acquire)) {
+            retireValue(old);
+            return true;
+        }
+        delete box;  // old 已更新为当前值
+    }
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::contains(const K& key) const {
+    V dummy;
+    return search(key, dummy);
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::clear() {
+    {
+        EpochGuard guard;
+        Node* current = getPtr(header_->next[0].load(std::memory_order_acquire));
+        while (current != nullptr) {
+            uintptr_t succ = current->next[0].load(std::memory_order_acquire);
+            if (!isMarked(succ)) {
+                remove(current->key);
+            }
+            current = getPtr(current->next[0].load(std::memory_order_acquire));
+        }
+    }
+    // 离开读临界区后再回收一次，没有其他读者时被删除的节点立即释放
+    reclaim();
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::release(Node* node) {
+    if (!node->released.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    Node* preds[kMaxLevelLimit];
+    Node* succs[kMaxLevelLimit];
+    find(node->key, preds, succs);
+    retireNode(node);
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::retireNode(Node* node) {
+    node->retireEpoch = EpochManager::instance().retireEpoch();
+    pushRetired(&retiredNodes_, node, node);
+    retiredCount_.fetch_add(1, std::memory_order_relaxed);
+    if ((retireTicks_.fetch_add(1, std::memory_order_relaxed) + 1) % kReclaimBatch == 0) {
+        reclaim();
+    }
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::retireValue(ValueBox* box) {
+    box->retireEpoch = EpochManager::instance().retireEpoch();
+    pushRetired(&retiredValues_, box, box);
+    retiredCount_.fetch_add(1, std::memory_order_relaxed);
+    if ((retireTicks_.fetch_add(1, std::memory_order_relaxed) + 1) % kReclaimBatch == 0) {
+        reclaim();
+    }
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::reclaim() {
+    uint64_t safeEpoch = EpochManager::instance().minActiveEpoch();
+    reclaimStack(&retiredNodes_, safeEpoch);
+    reclaimStack(&retiredValues_, safeEpoch);
+}
+
+template <typename K, typename V>
+template <typename T>
+void LockFreeSkipList<K, V>::pushRetired(std::atomic<T*>* stack, T* first, T* last) {
+    T* head = stack->load(std::memory_order_relaxed);
+    do {
+        last->retiredNext = head;
+    } while (!stack->compare_exchange_weak(head, first, std::memory_order_release,
+                                           std::memory_order_relaxed));
+}
+
+template <typename K, typename V>
+template <typename T>
+void LockFreeSkipList<K, V>::reclaimStack(std::atomic<T*>* stack, uint64_t safeEpoch) {
+    // 整个栈一次取走，多个线程同时回收时各自处理不相交的部分；还不能释放的放回去
+    T* item = stack->exchange(nullptr, std::memory_order_acquire);
+    T* keptFirst = nullptr;
+    T* keptLast = nullptr;
+    size_t freed = 0;
+    while (item != nullptr) {
+        T* next = item->retiredNext;
+        if (item->retireEpoch < safeEpoch) {
+            destroyRetired(item);
+            freed++;
+        } else {
+            item->retiredNext = keptFirst;
+            keptFirst = item;
+            if (keptLast == nullptr) {
+                keptLast = item;
+            }
+        }
+        item = next;
+    }
+    if (keptFirst != nullptr) {
+        pushRetired(stack, keptFirst, keptLast);
+    }
+    retiredCount_.fetch_sub(freed, std::memory_order_relaxed);
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::dumpFile(const std::string& filepath) const {
+    std::ofstream outFile(filepath);
+    if (!outFile.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filepath << std::endl;
+        return false;
+    }
+
+    bool success = dump(outFile);
+    outFile.close();
+    return success;
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::dump(std::ostream& out) const {
+    EpochGuard guard;
+    // 遍历第 0 层，跳过已逻辑删除的节点
+    Node* current = getPtr(header_->next[0].load(std::memory_order_acquire));
+    while (current != nullptr) {
+        uintptr_t succ = current->next[0].load(std::memory_order_acquire);
+        if (!isMarked(succ)) {
+            out << current->key << kDelimiter
+                << current->value.load(std::memory_order_acquire)->value << "\n";
+        }
+        current = getPtr(succ);
+    }
+
+    out.flush();
+    return static_cast<bool>(out);
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::loadFile(const std::string& filepath) {
+    std::ifstream inFile(filepath);
+    if (!inFile.is_open()) {
+        std::cerr << "Failed to open file for reading: " << filepath << std::endl;
+        return false;
+    }
+
+    std::string line;
+    std::string key;
+    std::string value;
+    while (std::getline(inFile, line)) {
+        if (parseString(line, key, value)) {
+            insert(static_cast<K>(key), static_cast<V>(value));
+        }
+    }
+    return true;
+}
+
+template <typename K, typename V>
+bool LockFreeSkipList<K, V>::parseString(const std::string& line, std::string& key,
+                                         std::string& value) const {
+    if (line.empty()) {
+        return false;
+    }
+
+    size_t pos = line.find(kDelimiter);
+    if (pos == std::string::npos) {
+        return false;
+    }
+
+    key = line.substr(0, pos);
+    value = line.substr(pos + 1);
+    return !key.empty();
+}
+
+template <typename K, typename V>
+void LockFreeSkipList<K, V>::displayList() const {
+    EpochGuard guard;
+    std::cout << "\n========== Lock-free Skip List ==========" << std::endl;
+    std::cout << "Element count: " << size() << std::endl;
+
+    for (int i = maxLevel_ - 1; i >= 0; i--) {
+        Node* current = getPtr(header_->next[i].load(std::memory_order_acquire));
+        if (current == nullptr) {
+            continue;
+        }
+        std::cout << "Level " << i << ": ";
+        while (current != nullptr) {
+            uintptr_t succ = current->next[i].load(std::memory_order_acquire);
+            if (!isMarked(succ)) {
+                std::cout << current->key << ":"
+                          << current->value.load(std::memory_order_acquire)->value << " -> ";
+            }
+            current = getPtr(succ);
+        }
+        std::cout << "NIL" << std::endl;
+    }
+    std::cout << "=========================================\n" << std::endl;
+}
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_LOCKFREE_SKIPLIST_H
@@ -2,21 +2,112 @@
 #ifndef KVSTORE_STORAGE_SKIPLIST_H
 #define KVSTORE_STORAGE_SKIPLIST_H
 
+#include "base/epoch.h"
 #include "base/mutex.h"
 #include "base/noncopyable.h"
+#include "storage/arena.h"
+#include "storage/eviction.h"
+#include "storage/hash_index.h"
+#include "storage/value.h"
 
+#include <atomic>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <deque>
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <new>
 #include <string>
 #include <vector>
 #include <random>
 
 namespace kvstore {
 
+namespace detail {
+
+// 前缀压缩用到的 key 操作。只有 std::string 真正压缩；
+// 其他 key 类型的共享前缀恒为 0，节点总是保存完整 key。
+
+/// 两个 key 的公共前缀长度
+template <typename K>
+size_t commonPrefix(const K& /*a*/, const K& /*b*/) {
+    return 0;
+}
+
+inline size_t commonPrefix(const std::string& a, const std::string& b) {
+    size_t n = a.size() < b.size() ? a.size() : b.size();
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+/// 三路比较：a < b 返回负数，相等返回 0，否则返回正数
+template <typename K>
+int compareKey(const K& a, const K& b) {
+    return a < b ? -1 : (a == b ? 0 : 1);
+}
+
+inline int compareKey(const std::string& a, const std::string& b) {
+    return a.compare(b);
+}
+
+/// 比较 suffix 与 key[offset..]，只看 offset 之后的字节
+template <typename K>
+int compareSuffix(const K& suffix, const K& key, size_t /*offset*/) {
+    return compareKey(suffix, key);
+}
+
+inline int compareSuffix(const std::string& suffix, const std::string& key, size_t offset) {
+    int r = key.compare(offset, std::string::npos, suffix);
+    return r < 0 ? 1 : (r > 0 ? -1 : 0);
+}
+
+/// 去掉前 shared 个字节
+template <typename K>
+K suffixOf(const K& key, size_t /*shared*/) {
+    return key;
+}
+
+inline std::string suffixOf(const std::string& key, size_t shared) {
+    return key.substr(shared);
+}
+
+/// base 的前 shared 个字节拼上 suffix，写入 out
+template <typename K>
+void joinKey(const K& /*base*/, size_t /*shared*/, const K& suffix, K* out) {
+    *out = suffix;
+}
+
+inline void joinKey(const std::string& base, size_t shared, const std::string& suffix,
+                    std::string* out) {
+    out->assign(base, 0, shared);
+    out->append(suffix);
+}
+
+// 节点之外在堆上占用的字节数，用于统计跳表的内存（SkipList::liveBytes）
+
+template <typename T>
+size_t heapBytes(const T& /*value*/) {
+    return 0;
+}
+
+/// 短字符串在对象内部（SSO），否则是一块 capacity + 1 字节的堆内存
+inline size_t heapBytes(const std::string& s) {
+    const char* self = reinterpret_cast<const char*>(&s);
+    bool local = s.data() >= self && s.data() < self + sizeof(s);
+    return local ? 0 : s.capacity() + 1;
+}
+
+inline size_t heapBytes(const Value& value) {
+    return value.heapBytes();
+}
+
+}  // namespace detail
+
 /**
  * @brief 跳表数据结构
  *
@@ -29,11 +120,32 @@ namespace kvstore {
  *   Level 1:  head → 5 → 10 → 15 → 20 → 25 → 30 → 40 → 50 → 60 → NIL
  *
  * 特点：
- * 1. 使用 MutexLock 保证线程安全
- * 2. 使用 shared_ptr 管理节点内存，避免内存泄漏
+ * 1. 读写分离（RCU 风格）：写操作由 MutexLock 串行化；search 不加锁，也没有原子 RMW，
+ *    沿 acquire 语义的 next 指针遍历。被删除/被替换的节点交给 EpochManager，
+ *    等所有 IO 线程都经过宽限期后才析构。更新已有 key 时整体替换节点，不原地修改 value。
+ *    只有一个线程写时可以开启单写者模式（setSingleWriter），写操作也不加锁
+ * 2. 节点（key、value 与各层 next 指针）是从 Arena 切出的一整块连续内存，
+ *    遍历只走裸指针，没有引用计数的原子操作；删除的节点按层数放入空闲链表复用
  * 3. 支持持久化到文件和从文件加载
+ * 4. 可选的哈希索引（HashIndex）：与跳表同步维护 key -> 节点的映射，
+ *    search/contains 一次探测即可命中，remove 不存在的 key 时无需下降跳表；
+ *    有序遍历仍然只走跳表
+ * 5. 可选的 key 前缀压缩（仅 std::string key 生效，与哈希索引互斥）：
+ *    层数 > 0 的节点作为"重启点"保存完整 key，只在第 0 层的节点保存相对于
+ *    前一个重启点的共享前缀长度和剩余后缀。形如 "tenant:1234:user:..." 的 key
+ *    后缀通常很短，能放进 std::string 的 SSO 缓冲，省掉一次堆分配。
+ *    第 0 层查找时只比较后缀：共享前缀长度与"目标和重启点的公共前缀"
+ *    不相等时，不读任何 key 字节就能判定大小
+ * 6. 多版本快照：每个节点带有写序号（每次写操作递增）。pinVersions() 之后，
+ *    被覆盖的节点不再回收，而是挂在新节点的 older 链上；被删除的 key 留下一个
+ *    墓碑节点。以快照序号构造的 Iterator 沿 older 链找到不晚于快照的版本，
+ *    看到的是固定时刻的数据，写操作照常进行。unpinVersions() 之后旧版本交给
+ *    延迟回收，墓碑从跳表中摘除
+ * 7. 淘汰支持：设置 AccessTracker 后，search 命中和写入时更新节点的 16 位访问字；
+ *    liveBytes() 精确统计最新版本占用的内存，sample() 不加锁地随机采样 key，
+ *    由上层（KVStore）按采样结果选择要淘汰的 key
  *
- * @tparam K 键类型，需要支持 < 运算符
+ * @tparam K 键类型，需要支持 < 运算符（启用哈希索引时还需要 std::hash<K>）
  * @tparam V 值类型
  */
 template <typename K, typename V>
@@ -42,8 +154,12 @@ public:
     /**
      * @brief 构造函数
      * @param maxLevel 跳表最大层数，默认 16
+     * @param hashIndex 是否同时维护哈希索引加速点查询
+     * @param prefixCompression 第 0 层节点只保存相对于重启点的 key 后缀；
+     *        哈希索引需要节点上的完整 key，两者同时开启时忽略本选项
      */
-    explicit SkipList(int maxLevel = kDefaultMaxLevel);
+    explicit SkipList(int maxLevel = kDefaultMaxLevel, bool hashIndex = false,
+                      bool prefixCompression = false);
 
     /**
      * @brief 析构函数
@@ -76,6 +192,38 @@ public:
      */
     bool remove(const K& key);
 
+    /**
+     * @brief key 在快照 snapshot 之后没有再被写过时删除它
+     *
+     * 用于把已经写到别处（如 SSTable）的快照数据从内存中移走，
+     * 快照之后又被覆盖的 key 保留新值。
+     *
+     * @return true 已删除，false 键不存在或快照之后被写过
+     */
+    bool removeIfUnchanged(const K& key, uint64_t snapshot);
+
+    /**
+     * @brief key 的当前值满足 pred 时删除它
+     *
+     * pred 在跳表的锁内调用，判断和删除之间不会插入其他写操作。
+     * 用于删除已经过期的 key：判断时值已经被新的写入覆盖则保留。
+     *
+     * @return true 已删除，false 键不存在或 pred 返回 false
+     */
+    template <typename Predicate>
+    bool removeIf(const K& key, Predicate pred);
+
+    /**
+     * @brief key 存在时用 fn 修改它的值
+     *
+     * fn(V& value) 在跳表的锁内调用，参数是当前值的副本，返回 false 表示不修改。
+     * 修改后的值与 insert 一样放进替换旧节点的新节点，读者不会看到改到一半的值。
+     *
+     * @return true 已修改，false 键不存在或 fn 返回 false
+     */
+    template <typename Modifier>
+    bool modify(const K& key, Modifier fn);
+
     /**
      * @brief 判断键是否存在
      * @param key 键
@@ -83,6 +231,39 @@ public:
      */
     bool contains(const K& key) const;
 
+    // ==================== 批量操作 ====================
+
+    /**
+     * @brief 按 key 升序批量查询
+     *
+     * keys 必须按升序排列（可以重复）。对每个 key 调用 visitor(i, value)，
+     * 不存在时 value 为 nullptr；value 只在回调期间有效。
+     *
+     * finger search：下一个 key 从上一个 key 在各层的前驱出发，从第 1 层向上找到
+     * 前驱不必移动的一层再向下搜索，相邻 key 的代价是 O(log d)（d 为两者之间的节点数），
+     * 而不是每个 key 都从最高层下降。整批在一个 EpochGuard 内完成；
+     * 不是原子快照，与并发写入的先后关系同逐个 search。
+     */
+    template <typename Visitor>
+    void searchSorted(const std::vector<const K*>& keys, Visitor visitor) const;
+
+    /**
+     * @brief 按 key 升序批量写入，整批只获取一次写锁
+     *
+     * entries 按 key 升序排列，相同的 key 后面的生效。查找方式同 searchSorted。
+     * 对每条调用 visitor(i, isNew)。
+     */
+    template <typename Visitor>
+    void insertSorted(const std::vector<std::pair<const K*, const V*>>& entries, Visitor visitor);
+
+    /**
+     * @brief 按 key 升序批量删除，整批只获取一次写锁
+     *
+     * 对每个删除了的 key 调用 visitor(i, value)，value 为删除前的值。
+     */
+    template <typename Visitor>
+    void removeSorted(const std::vector<const K*>& keys, Visitor visitor);
+
     /**
      * @brief 获取跳表中元素个数
      * @return 元素个数
@@ -101,6 +282,13 @@ public:
      */
     bool dumpFile(const std::string& filepath) const;
 
+    /**
+     * @brief 按 key 升序将所有键值对写入输出流，格式同 dumpFile
+     * @param out 输出流
+     * @return true 成功，false 写入失败
+     */
+    bool dump(std::ostream& out) const;
+
     /**
      * @brief 从文件加载数据到跳表
      * @param filepath 文件路径
@@ -113,28 +301,165 @@ public:
      */
     void displayList() const;
 
+    /**
+     * @brief 节点占用的内存（Arena 已申请的字节数，加上哈希索引的槽位数组）
+     *
+     * 不含 key/value 自身在堆上额外分配的内存（如长字符串）。
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief 最新版本的节点占用的字节数
+     *
+     * 每个节点按层数计算的大小，加上 key/value 在堆上的内存（共享的长值按完整长度计入）。
+     * 包括墓碑；不含快照保留的旧版本、等待回收的节点和哈希索引。
+     */
+    size_t liveBytes() const { return liveBytes_.load(std::memory_order_relaxed); }
+
+    /// 写入 key/value 之后 liveBytes() 预计增加的字节数（按层数为 0 的节点计算）
+    static size_t entryBytes(const K& key, const V& value) {
+        return nodeSize(0) + detail::heapBytes(key) + detail::heapBytes(value);
+    }
+
+    // ==================== 淘汰 ====================
+
+    /**
+     * @brief 设置访问记录，之后 search 命中和写入时更新节点的访问字
+     *
+     * nullptr（默认）表示不记录，search 不写节点。应在使用跳表之前设置，tracker 须比跳表活得久。
+     */
+    void setAccessTracker(const AccessTracker* tracker) { tracker_ = tracker; }
+
+    /**
+     * @brief 随机采样最多 count 个 key，对每个调用 visitor(key, value, access)
+     *
+     * 不加锁：从节点足够多的一层开始，每一层在上一层选中的节点与它的后继之间均匀地选一个节点，
+     * 再向下一层，直到第 0 层。各段长度相近时接近均匀采样，代价是 O(log N) 次指针跳转。
+     * 跳过墓碑；同一个 key 可能被采到多次。access 为节点的访问字（见 AccessTracker）。
+     * 参数只在回调期间有效。
+     */
+    template <typename Visitor>
+    void sample(size_t count, Visitor visitor) const;
+
+    /// 是否启用了哈希索引
+    bool hasHashIndex() const { return index_ != nullptr; }
+
+    /// 是否启用了 key 前缀压缩
+    bool hasPrefixCompression() const { return prefixCompression_; }
+
+    /**
+     * @brief 单写者模式：所有写操作（含 pinVersions/unpinVersions）都在同一个线程中调用时不加写锁
+     *
+     * 读者和迭代器本来就不加锁，仍然可以在任意线程中使用。开启后不能再用 lockWriters()
+     * 阻塞写操作，dump()/displayList() 也只能在写线程中调用。应在没有并发写操作时设置。
+     */
+    void setSingleWriter(bool on) { singleWriter_ = on; }
+
+    /// 是否处于单写者模式
+    bool singleWriter() const { return singleWriter_; }
+
+    // ==================== 快照 ====================
+
+    /// 不指定快照时迭代器看到的是最新数据
+    static constexpr uint64_t kLatest = (1ULL << 63) - 1;
+
+    /**
+     * @brief 阻塞本跳表的写操作，与 unlockWriters() 配对
+     *
+     * 多棵跳表需要在同一时刻固定快照时，先依次调用各自的 lockWriters()，
+     * 再分别 pinVersions()。持有期间本线程不能调用写接口。
+     */
+    void lockWriters() const { mutex_.lock(); }
+    void unlockWriters() const { mutex_.unlock(); }
+
+    /**
+     * @brief 固定快照，调用方需已 lockWriters()（单写者模式下在写线程中调用）
+     *
+     * 之后被覆盖或删除的数据作为旧版本保留，直到对应的 unpinVersions()。
+     * 可以同时存在多个快照。
+     *
+     * @return 快照序号，传给 Iterator 即可读到此刻的数据
+     */
+    uint64_t pinVersions();
+
+    /**
+     * @brief 释放 pinVersions() 固定的快照
+     *
+     * 最后一个快照释放时，保留的旧版本交给延迟回收，墓碑从跳表中摘除。
+     * 调用前必须先销毁使用该快照的迭代器。
+     */
+    void unpinVersions();
+
+    /// 最近一次写操作的序号，每次写入、删除、清空都会递增（可用于判断是否有新写入）
+    uint64_t sequence() const { return sequence_.load(std::memory_order_relaxed); }
+
+    /// 有序迭代器（定义见类外）
+    class Iterator;
+
+    /// 按 key 升序批量追加的构建器（定义见类外）
+    class Builder;
+
 private:
     // ==================== 内部类型定义 ====================
 
     /**
      * @brief 跳表节点
+     *
+     * 内存布局：[key | value | nodeLevel | access | shared | version | older | forward[0] ... forward[nodeLevel]]
+     * forward 数组按节点层数变长分配，与 key/value 位于同一块内存。
+     *
+     * version 的低 63 位是写序号，最高位为 1 表示墓碑（快照期间被删除的 key）。
+     * older 指向同一个 key 被本节点替换掉的上一个版本，只有替换发生在快照期间时才有意义；
+     * 快照全部释放后旧版本会被回收，older 不再解引用（此后的快照序号都不小于本节点的序号）。
+     *
+     * shared > 0 时 key 只保存后缀，完整 key 为重启点 key 的前 shared 个字节加上后缀。
+     * 重启点是第 0 层上位于本节点之前、最近的一个层数 > 0 的节点（或头节点）。
+     * 层数 > 0 的节点 shared 恒为 0。
+     *
+     * access 是淘汰用的访问字（见 AccessTracker），读者不加锁地更新，丢失个别更新无妨。
      */
     struct Node {
         K key;
         V value;
-        int nodeLevel;  // 节点层数
-
-        // forward[i] 指向第 i 层的下一个节点
-        std::vector<std::shared_ptr<Node>> forward;
-
-        Node(const K& k, const V& v, int level)
-            : key(k), value(v), nodeLevel(level), forward(level + 1, nullptr) {}
+        uint16_t nodeLevel;             // 节点层数
+        std::atomic<uint16_t> access;   // 访问字，与 nodeLevel 共用原来 int 的 4 字节
+        uint32_t shared;  // 与重启点共享的前缀长度（占用原本的对齐填充）
+        uint64_t version; // 写序号 | 墓碑标记
+        Node* older;      // 上一个版本，发布前写入，之后不变
+
+        // forward[i] 指向第 i 层的下一个节点，实际长度为 nodeLevel + 1
+        std::atomic<Node*> forward[1];
+
+        Node(const K& k, const V& v, int level, uint32_t sharedLen)
+            : key(k),
+              value(v),
+              nodeLevel(static_cast<uint16_t>(level)),
+              access(0),
+              shared(sharedLen),
+              version(0),
+              older(nullptr) {}
 
         // 空头节点构造
-        Node(int level) : key(), value(), nodeLevel(level), forward(level + 1, nullptr) {}
+        explicit Node(int level)
+            : key(),
+              value(),
+              nodeLevel(static_cast<uint16_t>(level)),
+              access(0),
+              shared(0),
+              version(0),
+              older(nullptr) {}
+
+        uint64_t sequence() const { return version & kLatest; }
+        bool isTombstone() const { return (version & kTombstoneBit) != 0; }
+
+        /// 读取第 i 层后继（acquire：保证看到后继节点完整初始化后的内容）
+        Node* next(int i) const { return forward[i].load(std::memory_order_acquire); }
+
+        /// 设置第 i 层后继（release：发布节点给无锁读者）
+        void setNext(int i, Node* x) { forward[i].store(x, std::memory_order_release); }
     };
 
-    using NodePtr = std::shared_ptr<Node>;
+    using NodePtr = Node*;
 
     // ==================== 私有方法 ====================
 
@@ -150,8 +475,153 @@ private:
 
     /**
      * @brief 创建新节点
+     *
+     * 优先复用同层数的空闲节点内存，否则从 Arena 分配。调用方需持有锁。
+     * shared > 0 时 key 为压缩后的后缀。
+     */
+    NodePtr createNode(const K& key, const V& value, int level, uint32_t shared = 0);
+
+    /// 创建空头节点
+    NodePtr createHeader();
+
+    /// 析构节点并将其内存放入空闲链表。调用方需持有锁。
+    void destroyNode(NodePtr node);
+
+    /// 层数为 level 的节点所需字节数
+    static size_t nodeSize(int level) {
+        return sizeof(Node) + level * sizeof(std::atomic<Node*>);
+    }
+
+    /// 节点计入 liveBytes_ 的字节数
+    static size_t entryBytes(NodePtr node) {
+        return nodeSize(node->nodeLevel) + detail::heapBytes(node->key) +
+               detail::heapBytes(node->value);
+    }
+
+    /// 节点离开最新版本（被摘除或被替换）。调用方需持有锁。
+    void dropLive(NodePtr node) {
+        liveBytes_.store(liveBytes_.load(std::memory_order_relaxed) - entryBytes(node),
+                         std::memory_order_relaxed);
+    }
+
+    /// 新写入的 key 的访问字
+    uint16_t createdAccess() const { return tracker_ ? tracker_->touch(0, true) : 0; }
+
+    /// 读命中或写入已有的 key 时更新访问字，没有变化时不写
+    void touch(NodePtr node) const {
+        uint16_t access = node->access.load(std::memory_order_relaxed);
+        uint16_t touched = tracker_->touch(access, false);
+        if (touched != access) {
+            node->access.store(touched, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 查找第一个 key >= 参数的节点
+     * @param update 非空时记录每一层的前驱节点（写者使用）
+     * @param exact 非空时输出返回节点的 key 是否等于参数（压缩节点不能直接比较 key）
+     * @param restart 非空时输出返回节点所在位置的重启点
+     * @param finger update 中已经是一个不大于 key 的 key 在各层（0 到 maxLevel_）的前驱
+     *        （批量操作的上一个 key，或全为头节点），从它们出发查找
+     */
+    NodePtr findGreaterOrEqual(const K& key, NodePtr* update, bool* exact = nullptr,
+                               NodePtr* restart = nullptr, bool finger = false) const;
+
+    /**
+     * @brief 第 0 层节点与目标 key 的三路比较
+     * @param lcp 目标 key 与当前重启点的公共前缀长度
+     */
+    int compareNode(NodePtr node, const K& key, size_t lcp) const;
+
+    /**
+     * @brief 节点的完整 key
+     *
+     * 未压缩的节点直接返回 node->key，否则拼接到 scratch 中并返回它。
+     * @param restart 节点所在位置的重启点
+     */
+    const K& fullKey(NodePtr node, NodePtr restart, K* scratch) const;
+
+    /**
+     * @brief 以 base 为新的重启点，重新编码 first 起的一段第 0 层节点
+     *
+     * 从 first 开始直到下一个重启点（或表尾）为止，为每个节点创建以 base
+     * 为基准重新压缩的副本并串成链，原节点保持不变供并发读者继续使用。
+     * 调用方把返回的链头发布到第 0 层后，对 replaced 中的原节点调用 retireNode。
+     *
+     * @param oldRestart first 原来所在位置的重启点
+     * @param baseKey 新重启点的完整 key
+     * @return 新链的头节点；first 为空或本身就是重启点时原样返回 first
+     */
+    NodePtr reencodeRun(NodePtr first, NodePtr oldRestart, const K& baseKey,
+                        std::vector<NodePtr>* replaced);
+
+    /**
+     * @brief insert 的实现，调用方需持有锁
+     * @param finger 非空时为批量写入的各层前驱（见 findGreaterOrEqual），写入后更新为本 key 的前驱
+     */
+    bool insertLocked(const K& key, const V& value, NodePtr* finger = nullptr);
+
+    /// 查找 key 对应的节点（有哈希索引时直接探测），不存在返回 nullptr
+    NodePtr findNode(const K& key) const;
+
+    /// 将已摘除的节点交给延迟回收，它不再计入 liveBytes_。调用方需持有锁。
+    void retireNode(NodePtr node);
+
+    /// 分配下一个写序号。调用方需持有锁（只有一个写者，不需要原子 RMW）。
+    uint64_t nextSequence() {
+        uint64_t sequence = sequence_.load(std::memory_order_relaxed) + 1;
+        sequence_.store(sequence, std::memory_order_relaxed);
+        return sequence;
+    }
+
+    /**
+     * @brief 创建与 current 层数、key 编码相同的新版本并替换它，调用方需持有锁
+     *
+     * 有快照时 current 成为新版本的 older，否则交给延迟回收。新版本沿用 current 的访问字。
+     * @param update 各层前驱
+     * @param tombstone 新版本是否为墓碑
+     * @return 新版本的节点
+     */
+    NodePtr replaceNode(const K& key, NodePtr current, const V& value, bool tombstone,
+                        NodePtr* update);
+
+    /**
+     * @brief 从所有层摘除 current，调用方需持有锁
+     * @param restart current 所在位置的重启点
      */
-    NodePtr createNode(const K& key, const V& value, int level);
+    void unlinkNode(NodePtr current, NodePtr* update, NodePtr restart);
+
+    /// removeIfUnchanged/removeIf 的实现：快照之后没有被写过、且当前值满足 pred 时删除
+    template <typename Predicate>
+    bool removeWhere(const K& key, uint64_t snapshot, Predicate pred);
+
+    /// removeWhere 的实现，调用方需持有锁；finger 同 insertLocked
+    template <typename Predicate>
+    bool removeLocked(const K& key, uint64_t snapshot, Predicate pred, NodePtr* finger);
+
+    /// 批量操作的 finger 初值：每一层的前驱都是头节点
+    void initFinger(NodePtr* finger) const {
+        for (int i = 0; i <= maxLevel_; i++) {
+            finger[i] = header_;
+        }
+    }
+
+    /// 快照期间清空：把每个节点替换为同一序号的墓碑。调用方需持有锁。
+    void tombstoneAll();
+
+    /// 最后一个快照释放后回收旧版本、摘除墓碑。调用方需持有锁。
+    void dropVersions();
+
+    /// node 在快照 snapshot 中可见的版本，不可见（尚未写入或已删除）返回 nullptr
+    static NodePtr visibleVersion(NodePtr node, uint64_t snapshot) {
+        while (node != nullptr && node->sequence() > snapshot) {
+            node = node->older;
+        }
+        return node != nullptr && !node->isTombstone() ? node : nullptr;
+    }
+
+    /// 析构所有已过宽限期的待回收节点。调用方需持有锁。
+    void reclaim();
 
     /**
      * @brief 解析一行数据
@@ -162,37 +632,218 @@ private:
      */
     bool parseString(const std::string& line, std::string& key, std::string& value) const;
 
+    /// 写操作的临界区：持有写锁，单写者模式下不加锁
+    class WriterGuard : noncopyable {
+    public:
+        explicit WriterGuard(const SkipList* list)
+            : mutex_(list->singleWriter_ ? nullptr : &list->mutex_) {
+            if (mutex_ != nullptr) {
+                mutex_->lock();
+            }
+        }
+
+        ~WriterGuard() {
+            if (mutex_ != nullptr) {
+                mutex_->unlock();
+            }
+        }
+
+    private:
+        MutexLock* mutex_;
+    };
+
     // ==================== 成员变量 ====================
 
     static constexpr int kDefaultMaxLevel = 16;     // 默认最大层数
+    static constexpr int kMaxLevelLimit = 32;       // 最大层数上限（决定栈上 update 数组大小）
     static constexpr double kProbability = 0.25;    // 层数扩展概率
     static constexpr char kDelimiter = ':';         // 持久化分隔符
+    static constexpr size_t kReclaimBatch = 64;     // 累积多少个待回收节点后尝试回收
+    static constexpr uint64_t kTombstoneBit = 1ULL << 63;  // version 中的墓碑标记
+    static constexpr size_t kSampleSpanLimit = 256;  // 采样时每层最多向前数的节点数
+    static constexpr size_t kSampleStartSpan = 32;   // 采样从至少有这么多节点的层开始下降
+
+    int maxLevel_;                      // 最大层数
+    bool prefixCompression_;            // 第 0 层节点是否压缩 key
+    std::atomic<int> currentLevel_;     // 当前最高层数
+    std::atomic<int> elementCount_;     // 元素个数
+    Arena arena_;                       // 节点内存池
+    void* freeList_[kMaxLevelLimit];  // 按层数组织的空闲节点内存，首个指针大小的字段串成链表
+    NodePtr header_;                    // 头节点
+    std::unique_ptr<HashIndex<K, Node>> index_;  // 可选的哈希索引，写锁保护写入
+    std::deque<std::pair<uint64_t, NodePtr>> retired_;  // (退休 epoch, 节点)，按 epoch 递增
+    std::atomic<uint64_t> sequence_;    // 最近一次写操作的序号，只在写锁内修改
+    int pins_;                          // 未释放的快照数，写锁保护
+    std::vector<NodePtr> superseded_;   // 快照期间被替换的旧版本，释放快照时回收
+    std::vector<K> tombstoneKeys_;      // 快照期间留下墓碑的 key，释放快照时摘除
+    std::atomic<size_t> liveBytes_;     // 最新版本占用的字节数，只在写锁内修改
+    const AccessTracker* tracker_;      // 访问记录，nullptr 表示不记录
+    bool singleWriter_;                 // 单写者模式，写操作不加写锁
+
+    mutable MutexLock mutex_;  // 写锁（读者不加锁）
+};
 
-    int maxLevel_;          // 最大层数
-    int currentLevel_;      // 当前最高层数
-    int elementCount_;      // 元素个数
-    NodePtr header_;        // 头节点
+/**
+ * @brief SkipList 有序迭代器
+ *
+ * 无锁沿第 0 层前进，不持有写锁。默认读最新数据，不是快照：与写操作并发时，
+ * 可能看到迭代开始之后的插入，或已被替换 key 的旧值，但 key 严格递增、不会重复。
+ * 传入 pinVersions() 返回的序号时只读该时刻的数据，在对应的 unpinVersions() 之前销毁。
+ * 迭代器内含 EpochGuard，存活期间访问到的节点不会被回收；
+ * 必须在创建它的线程中使用和销毁，且不应长期持有（会推迟内存回收）。
+ *
+ * 使用示例：
+ *   SkipList<std::string, std::string>::Iterator it(&list);
+ *   for (it.seek("a"); it.valid() && it.key() <= "b"; it.next()) {
+ *       use(it.key(), it.value());
+ *   }
+ */
+template <typename K, typename V>
+class SkipList<K, V>::Iterator : noncopyable {
+public:
+    explicit Iterator(const SkipList* list, uint64_t snapshot = kLatest)
+        : list_(list),
+          snapshot_(snapshot),
+          node_(nullptr),
+          visible_(nullptr),
+          restart_(nullptr),
+          key_(nullptr) {}
+
+    /// 是否指向有效节点
+    bool valid() const { return node_ != nullptr; }
+
+    /// 完整 key（压缩节点的 key 在定位时还原，引用在下次移动前有效）
+    const K& key() const { return *key_; }
+    const V& value() const { return visible_->value; }
+
+    /// 前进到下一个节点，要求 valid()
+    void next() {
+        if (node_->nodeLevel > 0) {
+            restart_ = node_;
+        }
+        node_ = node_->next(0);
+        settle();
+    }
+
+    /// 定位到第一个 key >= target 的节点
+    void seek(const K& target) {
+        node_ = list_->findGreaterOrEqual(target, nullptr, nullptr, &restart_);
+        settle();
+    }
+
+    /// 定位到第一个节点
+    void seekToFirst() {
+        restart_ = list_->header_;
+        node_ = restart_->next(0);
+        settle();
+    }
+
+private:
+    /// 跳过在快照中不可见的节点（快照之后插入的、已删除的），还原 key
+    void settle() {
+        while (node_ != nullptr && (visible_ = visibleVersion(node_, snapshot_)) == nullptr) {
+            if (node_->nodeLevel > 0) {
+                restart_ = node_;
+            }
+            node_ = node_->next(0);
+        }
+        key_ = node_ != nullptr ? &list_->fullKey(node_, restart_, &scratch_) : nullptr;
+    }
+
+    EpochGuard guard_;
+    const SkipList* list_;
+    const uint64_t snapshot_;
+    NodePtr node_;
+    NodePtr visible_;  // node_ 在快照中可见的版本，value 从这里读
+    NodePtr restart_;  // node_ 所在位置的重启点
+    const K* key_;     // 指向 node_->key 或 scratch_
+    K scratch_;        // 压缩节点还原出的完整 key
+};
+
+/**
+ * @brief SkipList 批量构建器
+ *
+ * 从按 key 升序的输入构建跳表（如加载快照）：记住每一层的最后一个节点，
+ * 新节点直接链到各层末尾，每条记录 O(1)，不需要一次 O(log N) 的查找。
+ * 前缀压缩和哈希索引照常维护。
+ *
+ * 构建器存活期间持有跳表的写锁（单写者模式下不加锁），并发读者可以正常读取已追加的节点。
+ * 遇到不大于当前最后一个 key 的输入时退化为普通插入，结果仍然正确。
+ *
+ * 使用示例：
+ *   SkipList<std::string, Value>::Builder builder(&list);
+ *   for (const auto& kv : sorted) {
+ *       builder.add(kv.first, kv.second);
+ *   }
+ */
+template <typename K, typename V>
+class SkipList<K, V>::Builder : noncopyable {
+public:
+    explicit Builder(SkipList* list) : list_(list), lock_(list) { locateTails(); }
+
+    /**
+     * @brief 追加键值对
+     * @return true 新增，false 更新已存在的键
+     */
+    bool add(const K& key, const V& value);
+
+private:
+    /// 找到每一层的最后一个节点
+    void locateTails();
 
-    mutable MutexLock mutex_;  // 线程安全锁
+    SkipList* list_;
+    WriterGuard lock_;
+    NodePtr tails_[kMaxLevelLimit + 1];  // tails_[i] 为第 i 层的最后一个节点（或头节点）
 };
 
 // ==================== 模板类实现 ====================
 
+// C++14 中 ODR 使用的 static constexpr 成员仍需类外定义
 template <typename K, typename V>
-SkipList<K, V>::SkipList(int maxLevel)
-    : maxLevel_(maxLevel),
+constexpr uint64_t SkipList<K, V>::kLatest;
+
+template <typename K, typename V>
+SkipList<K, V>::SkipList(int maxLevel, bool hashIndex, bool prefixCompression)
+    : maxLevel_(maxLevel < 1 ? 1 : (maxLevel > kMaxLevelLimit ? kMaxLevelLimit : maxLevel)),
+      prefixCompression_(prefixCompression && !hashIndex),
       currentLevel_(0),
       elementCount_(0),
-      header_(std::make_shared<Node>(maxLevel)),
+      arena_(),
+      freeList_(),
+      header_(nullptr),
+      index_(hashIndex ? new HashIndex<K, Node>() : nullptr),
+      sequence_(0),
+      pins_(0),
+      liveBytes_(0),
+      tracker_(nullptr),
+      singleWriter_(false),
       mutex_() {
     // 随机数生成器已改为 thread_local，无需初始化种子
+    header_ = createHeader();
 }
 
 template <typename K, typename V>
 SkipList<K, V>::~SkipList() {
-    // shared_ptr 自动管理内存，无需手动释放
-    // 但为了安全，我们显式清空
+    // 节点内存由 Arena 统一释放，这里只需调用 key/value 的析构函数
+    // 析构时不应再有并发读者，待回收节点可以直接析构
+    {
+        MutexLockGuard lock(mutex_);
+        pins_ = 0;
+        for (NodePtr node : superseded_) {
+            destroyNode(node);
+        }
+        superseded_.clear();
+        tombstoneKeys_.clear();
+    }
     clear();
+    {
+        MutexLockGuard lock(mutex_);
+        for (const auto& retired : retired_) {
+            destroyNode(retired.second);
+        }
+        retired_.clear();
+    }
+    header_->~Node();
 }
 
 template <typename K, typename V>
@@ -212,169 +863,776 @@ int SkipList<K, V>::getRandomLevel() const {
 
 template <typename K, typename V>
 typename SkipList<K, V>::NodePtr SkipList<K, V>::createNode(const K& key, const V& value,
-                                                             int level) {
-    return std::make_shared<Node>(key, value, level);
+                                                             int level, uint32_t shared) {
+    void* mem = freeList_[level];
+    if (mem != nullptr) {
+        freeList_[level] = *static_cast<void**>(mem);
+    } else {
+        mem = arena_.allocateAligned(nodeSize(level));
+    }
+    NodePtr node = new (mem) Node(key, value, level, shared);
+    for (int i = 0; i <= level; i++) {
+        new (&node->forward[i]) std::atomic<Node*>(nullptr);
+    }
+    liveBytes_.store(liveBytes_.load(std::memory_order_relaxed) + entryBytes(node),
+                     std::memory_order_relaxed);
+    return node;
 }
 
 template <typename K, typename V>
-bool SkipList<K, V>::insert(const K& key, const V& value) {
-    MutexLockGuard lock(mutex_);
+typename SkipList<K, V>::NodePtr SkipList<K, V>::createHeader() {
+    void* mem = arena_.allocateAligned(nodeSize(maxLevel_));
+    NodePtr header = new (mem) Node(maxLevel_);
+    for (int i = 0; i <= maxLevel_; i++) {
+        new (&header->forward[i]) std::atomic<Node*>(nullptr);
+    }
+    return header;
+}
 
-    // update[i] 记录第 i 层需要更新 forward 指针的节点
-    std::vector<NodePtr> update(maxLevel_ + 1, nullptr);
+template <typename K, typename V>
+void SkipList<K, V>::destroyNode(NodePtr node) {
+    int level = node->nodeLevel;
+    node->~Node();
+    // 节点内存已不再使用，借用开头的指针大小空间串入空闲链表
+    void* mem = node;
+    *static_cast<void**>(mem) = freeList_[level];
+    freeList_[level] = mem;
+}
+
+template <typename K, typename V>
+void SkipList<K, V>::retireNode(NodePtr node) {
+    dropLive(node);
+    // 节点已从所有层摘除，但可能仍有读者持有它，等宽限期过后再析构
+    retired_.emplace_back(EpochManager::instance().retireEpoch(), node);
+    if (retired_.size() >= kReclaimBatch) {
+        reclaim();
+    }
+}
+
+template <typename K, typename V>
+void SkipList<K, V>::reclaim() {
+    uint64_t safeEpoch = EpochManager::instance().minActiveEpoch();
+    while (!retired_.empty() && retired_.front().first < safeEpoch) {
+        destroyNode(retired_.front().second);
+        retired_.pop_front();
+    }
+}
+
+template <typename K, typename V>
+typename SkipList<K, V>::NodePtr SkipList<K, V>::findGreaterOrEqual(const K& key,
+                                                                    NodePtr* update,
+                                                                    bool* exact,
+                                                                    NodePtr* restart,
+                                                                    bool finger) const {
     NodePtr current = header_;
+    NodePtr next = nullptr;
+    int top = currentLevel_.load(std::memory_order_acquire);
+
+    if (finger && top > 0) {
+        // update[h] 之后第 h 层的下一个节点不小于 key 时，更高层的前驱也都不用移动
+        // （它们在第 h 层上都排在那个节点之后）：从前驱需要移动的最高一层开始下降
+        int h = 1;
+        while (h < top) {
+            next = update[h]->next(h);
+            if (next == nullptr || !(next->key < key)) {
+                break;
+            }
+            h++;
+        }
+        current = update[h];
+        top = h;
+    }
 
-    // 从最高层向下搜索插入位置
-    for (int i = currentLevel_; i >= 0; i--) {
-        while (current->forward[i] != nullptr && current->forward[i]->key < key) {
-            current = current->forward[i];
+    // 从最高层向下搜索（层数 > 0 的节点都保存完整 key）
+    for (int i = top; i > 0; i--) {
+        next = current->next(i);
+        while (next != nullptr && next->key < key) {
+            current = next;
+            next = current->next(i);
+        }
+        if (update != nullptr) {
+            update[i] = current;
+        }
+    }
+
+    // 第 0 层：current 是头节点或层数 > 0 的节点，即第一个重启点
+    NodePtr base = current;
+    size_t lcp = prefixCompression_ ? detail::commonPrefix(base->key, key) : 0;
+    int cmp = 1;
+    next = current->next(0);
+    while (next != nullptr && (cmp = compareNode(next, key, lcp)) < 0) {
+        current = next;
+        // 并发插入可能在第 0 层链入新的重启点
+        if (prefixCompression_ && current->nodeLevel > 0) {
+            base = current;
+            lcp = detail::commonPrefix(base->key, key);
+        }
+        next = current->next(0);
+    }
+    if (update != nullptr) {
+        update[0] = current;
+    }
+    if (exact != nullptr) {
+        *exact = (next != nullptr && cmp == 0);
+    }
+    if (restart != nullptr) {
+        *restart = base;
+    }
+
+    // 直接返回第 0 层比较过的后继，不能重新读取 current->next(0)：
+    // 并发插入可能已在 current 与目标节点之间链入了更小的 key
+    return next;
+}
+
+template <typename K, typename V>
+int SkipList<K, V>::compareNode(NodePtr node, const K& key, size_t lcp) const {
+    if (node->shared == 0) {
+        return detail::compareKey(node->key, key);
+    }
+    // 重启点 < key，且二者恰好共享 lcp 个字节：
+    // - 节点与重启点共享更少，说明它在更靠前的位置就已经大于重启点，也就大于 key
+    // - 节点与重启点共享更多，说明它在第 lcp 个字节上和重启点一样小于 key
+    // 只有 shared == lcp 时才需要比较后缀
+    if (node->shared < lcp) {
+        return 1;
+    }
+    if (node->shared > lcp) {
+        return -1;
+    }
+    return detail::compareSuffix(node->key, key, lcp);
+}
+
+template <typename K, typename V>
+const K& SkipList<K, V>::fullKey(NodePtr node, NodePtr restart, K* scratch) const {
+    if (node->shared == 0) {
+        return node->key;
+    }
+    detail::joinKey(restart->key, node->shared, node->key, scratch);
+    return *scratch;
+}
+
+template <typename K, typename V>
+typename SkipList<K, V>::NodePtr SkipList<K, V>::reencodeRun(NodePtr first,
+                                                             NodePtr oldRestart,
+                                                             const K& baseKey,
+                                                             std::vector<NodePtr>* replaced) {
+    NodePtr head = nullptr;
+    NodePtr tail = nullptr;
+    NodePtr current = first;
+    K scratch;
+    while (current != nullptr && current->nodeLevel == 0) {
+        const K& key = fullKey(current, oldRestart, &scratch);
+        size_t shared = detail::commonPrefix(baseKey, key);
+        NodePtr copy = shared > 0
+            ? createNode(detail::suffixOf(key, shared), current->value, 0,
+                         static_cast<uint32_t>(shared))
+            : createNode(key, current->value, 0);
+        copy->version = current->version;
+        copy->older = current->older;
+        copy->access.store(current->access.load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+        if (tail == nullptr) {
+            head = copy;
+        } else {
+            tail->setNext(0, copy);
         }
-        update[i] = current;
+        tail = copy;
+        replaced->push_back(current);
+        current = current->next(0);
     }
+    if (tail == nullptr) {
+        return first;
+    }
+    tail->setNext(0, current);
+    return head;
+}
 
-    // current 现在指向第 0 层中 key 的前驱节点
-    current = current->forward[0];
+template <typename K, typename V>
+bool SkipList<K, V>::insert(const K& key, const V& value) {
+    WriterGuard lock(this);
+    return insertLocked(key, value);
+}
+
+template <typename K, typename V>
+bool SkipList<K, V>::insertLocked(const K& key, const V& value, NodePtr* finger) {
+    // update[i] 记录第 i 层需要更新 forward 指针的节点
+    NodePtr local[kMaxLevelLimit + 1];
+    NodePtr* update = finger != nullptr ? finger : local;
+    NodePtr restart = nullptr;
+    bool exists = false;
+    NodePtr current = findGreaterOrEqual(key, update, &exists, &restart, finger != nullptr);
 
     // 检查 key 是否已存在
-    if (current != nullptr && current->key == key) {
-        // key 已存在，更新 value
-        current->value = value;
-        return false;  // 返回 false 表示是更新而非新插入
+    if (exists) {
+        // key 已存在：读者可能正在读取旧节点的 value，不能原地修改，
+        // 而是用一个层数相同的新节点整体替换旧节点（key 编码原样保留）
+        bool revived = current->isTombstone();
+        NodePtr node = replaceNode(key, current, value, false, update);
+        if (tracker_) {
+            if (revived) {
+                node->access.store(createdAccess(), std::memory_order_relaxed);
+            } else {
+                touch(node);
+            }
+        }
+        if (revived) {
+            elementCount_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return revived;  // 返回 false 表示是更新而非新插入
     }
 
     // 生成新节点的随机层数
     int randomLevel = getRandomLevel();
+    int level = currentLevel_.load(std::memory_order_relaxed);
 
     // 如果新节点层数超过当前最高层，初始化新层的 update
-    if (randomLevel > currentLevel_) {
-        for (int i = currentLevel_ + 1; i <= randomLevel; i++) {
+    if (randomLevel > level) {
+        for (int i = level + 1; i <= randomLevel; i++) {
             update[i] = header_;
         }
-        currentLevel_ = randomLevel;
+        // 读者看到更高的层数时，新层上只有 header（next 为空），可以安全地跳过
+        currentLevel_.store(randomLevel, std::memory_order_release);
     }
 
-    // 创建新节点
-    NodePtr newNode = createNode(key, value, randomLevel);
+    // 创建新节点：第 0 层节点相对重启点压缩，更高层的节点本身成为新的重启点
+    size_t shared = 0;
+    if (prefixCompression_ && randomLevel == 0) {
+        shared = detail::commonPrefix(restart->key, key);
+    }
+    NodePtr newNode = shared > 0
+        ? createNode(detail::suffixOf(key, shared), value, 0, static_cast<uint32_t>(shared))
+        : createNode(key, value, randomLevel);
+    newNode->version = nextSequence();
+    newNode->access.store(createdAccess(), std::memory_order_relaxed);
+
+    // 新的重启点之后、下一个重启点之前的节点改为相对新节点编码
+    std::vector<NodePtr> replaced;
+    NodePtr successor = update[0]->next(0);
+    if (prefixCompression_ && randomLevel > 0) {
+        successor = reencodeRun(successor, restart, key, &replaced);
+    }
 
-    // 插入节点：更新每一层的 forward 指针
+    // 插入节点：先填好新节点的 next，再自底向上发布
+    newNode->setNext(0, successor);
+    for (int i = 1; i <= randomLevel; i++) {
+        newNode->setNext(i, update[i]->next(i));
+    }
     for (int i = 0; i <= randomLevel; i++) {
-        newNode->forward[i] = update[i]->forward[i];
-        update[i]->forward[i] = newNode;
+        update[i]->setNext(i, newNode);
+    }
+    if (index_) {
+        index_->insert(key, newNode);
+    }
+    for (NodePtr node : replaced) {
+        retireNode(node);
     }
 
-    elementCount_++;
+    elementCount_.fetch_add(1, std::memory_order_relaxed);
     return true;
 }
 
 template <typename K, typename V>
-bool SkipList<K, V>::search(const K& key, V& value) const {
-    MutexLockGuard lock(mutex_);
-
-    NodePtr current = header_;
+void SkipList<K, V>::Builder::locateTails() {
+    NodePtr current = list_->header_;
+    for (int i = list_->maxLevel_; i >= 0; i--) {
+        NodePtr next = current->next(i);
+        while (next != nullptr) {
+            current = next;
+            next = current->next(i);
+        }
+        tails_[i] = current;
+    }
+}
 
-    // 从最高层向下搜索
-    for (int i = currentLevel_; i >= 0; i--) {
-        while (current->forward[i] != nullptr && current->forward[i]->key < key) {
-            current = current->forward[i];
+template <typename K, typename V>
+bool SkipList<K, V>::Builder::add(const K& key, const V& value) {
+    SkipList* list = list_;
+    NodePtr last = tails_[0];
+    // 表尾所在位置的重启点：最后一个层数 > 0 的节点，没有时为头节点
+    NodePtr restart = tails_[1];
+    size_t lcp = 0;
+    if (last != list->header_) {
+        bool ascending = restart == list->header_ || restart->key < key;
+        if (ascending) {
+            lcp = list->prefixCompression_ ? detail::commonPrefix(restart->key, key) : 0;
+            ascending = list->compareNode(last, key, lcp) < 0;
+        }
+        if (!ascending) {
+            bool isNew = list->insertLocked(key, value);
+            locateTails();
+            return isNew;
         }
     }
 
-    // 移动到第 0 层的下一个节点
-    current = current->forward[0];
+    int level = list->getRandomLevel();
+    if (level > list->currentLevel_.load(std::memory_order_relaxed)) {
+        list->currentLevel_.store(level, std::memory_order_release);
+    }
 
-    // 检查是否找到
-    if (current != nullptr && current->key == key) {
+    // 追加在表尾，后面没有需要重新编码的节点
+    NodePtr node = list->prefixCompression_ && level == 0 && lcp > 0
+        ? list->createNode(detail::suffixOf(key, lcp), value, 0, static_cast<uint32_t>(lcp))
+        : list->createNode(key, value, level);
+    node->version = list->nextSequence();
+    node->access.store(list->createdAccess(), std::memory_order_relaxed);
+    for (int i = 0; i <= level; i++) {
+        tails_[i]->setNext(i, node);
+        tails_[i] = node;
+    }
+    if (list->index_) {
+        list->index_->insert(key, node);
+    }
+    list->elementCount_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename K, typename V>
+bool SkipList<K, V>::search(const K& key, V& value) const {
+    // 读路径不加锁：EventLoop 线程中为空操作，其他线程发布 epoch
+    EpochGuard guard;
+
+    NodePtr current = findNode(key);
+    if (current != nullptr) {
         value = current->value;
+        if (tracker_) {
+            touch(current);
+        }
         return true;
     }
 
     return false;
 }
 
+template <typename K, typename V>
+typename SkipList<K, V>::NodePtr SkipList<K, V>::findNode(const K& key) const {
+    NodePtr current = nullptr;
+    if (index_) {
+        current = index_->find(key);
+    } else {
+        bool exact = false;
+        current = findGreaterOrEqual(key, nullptr, &exact);
+        current = exact ? current : nullptr;
+    }
+    return current != nullptr && !current->isTombstone() ? current : nullptr;
+}
+
 template <typename K, typename V>
 bool SkipList<K, V>::remove(const K& key) {
-    MutexLockGuard lock(mutex_);
+    return removeIfUnchanged(key, kLatest);
+}
 
-    std::vector<NodePtr> update(maxLevel_ + 1, nullptr);
-    NodePtr current = header_;
+template <typename K, typename V>
+bool SkipList<K, V>::removeIfUnchanged(const K& key, uint64_t snapshot) {
+    return removeWhere(key, snapshot, [](const V&) { return true; });
+}
 
-    // 从最高层向下搜索
-    for (int i = currentLevel_; i >= 0; i--) {
-        while (current->forward[i] != nullptr && current->forward[i]->key < key) {
-            current = current->forward[i];
-        }
-        update[i] = current;
+template <typename K, typename V>
+template <typename Predicate>
+bool SkipList<K, V>::removeIf(const K& key, Predicate pred) {
+    return removeWhere(key, kLatest, pred);
+}
+
+template <typename K, typename V>
+template <typename Modifier>
+bool SkipList<K, V>::modify(const K& key, Modifier fn) {
+    WriterGuard lock(this);
+    if (index_ && index_->find(key) == nullptr) {
+        return false;
     }
 
-    current = current->forward[0];
+    NodePtr update[kMaxLevelLimit + 1];
+    NodePtr restart = nullptr;
+    bool exists = false;
+    NodePtr current = findGreaterOrEqual(key, update, &exists, &restart);
+    if (!exists || current->isTombstone()) {
+        return false;
+    }
+    V value = current->value;
+    if (!fn(value)) {
+        return false;
+    }
+    replaceNode(key, current, value, false, update);
+    return true;
+}
+
+template <typename K, typename V>
+template <typename Predicate>
+bool SkipList<K, V>::removeWhere(const K& key, uint64_t snapshot, Predicate pred) {
+    WriterGuard lock(this);
+    return removeLocked(key, snapshot, pred, nullptr);
+}
+
+template <typename K, typename V>
+template <typename Predicate>
+bool SkipList<K, V>::removeLocked(const K& key, uint64_t snapshot, Predicate pred,
+                                  NodePtr* finger) {
+    // 有哈希索引时，不存在的 key 不用下降跳表
+    if (index_ && index_->find(key) == nullptr) {
+        return false;
+    }
+
+    NodePtr local[kMaxLevelLimit + 1];
+    NodePtr* update = finger != nullptr ? finger : local;
+    NodePtr restart = nullptr;
+    bool exists = false;
+    NodePtr current = findGreaterOrEqual(key, update, &exists, &restart, finger != nullptr);
 
     // 检查 key 是否存在
-    if (current == nullptr || current->key != key) {
+    if (!exists || current->isTombstone() || current->sequence() > snapshot ||
+        !pred(static_cast<const V&>(current->value))) {
         return false;
     }
+    elementCount_.fetch_sub(1, std::memory_order_relaxed);
+
+    // 有快照时不能摘除节点：换成墓碑，旧节点留给快照读取
+    if (pins_ > 0) {
+        replaceNode(key, current, V(), true, update);
+        tombstoneKeys_.push_back(key);
+        return true;
+    }
+    nextSequence();
+    // 先从索引摘除：unlinkNode 退休的节点在没有读者时可能立即被回收
+    if (index_) {
+        index_->erase(key);
+    }
+    unlinkNode(current, update, restart);
+    return true;
+}
+
+template <typename K, typename V>
+void SkipList<K, V>::unlinkNode(NodePtr current, NodePtr* update, NodePtr restart) {
+    // 删除的是重启点时，它后面的压缩节点改为相对前一个重启点编码
+    std::vector<NodePtr> replaced;
+    NodePtr successor = current->next(0);
+    if (prefixCompression_ && current->nodeLevel > 0) {
+        successor = reencodeRun(successor, current, restart->key, &replaced);
+    }
+
+    // 从每一层中删除节点（自顶向下，被摘除节点自身的 next 保持不变，读者可以继续前进）
+    for (int i = current->nodeLevel; i > 0; i--) {
+        update[i]->setNext(i, current->next(i));
+    }
+    update[0]->setNext(0, successor);
+    for (NodePtr node : replaced) {
+        retireNode(node);
+    }
+
+    // 更新当前最高层数（如果删除后某些层变空）
+    int level = currentLevel_.load(std::memory_order_relaxed);
+    while (level > 0 && header_->next(level) == nullptr) {
+        level--;
+    }
+    currentLevel_.store(level, std::memory_order_release);
+
+    retireNode(current);
+}
+
+template <typename K, typename V>
+typename SkipList<K, V>::NodePtr SkipList<K, V>::replaceNode(const K& key, NodePtr current,
+                                                              const V& value, bool tombstone,
+                                                              NodePtr* update) {
+    NodePtr newNode = createNode(current->key, value, current->nodeLevel, current->shared);
+    newNode->version = nextSequence() | (tombstone ? kTombstoneBit : 0);
+    newNode->older = pins_ > 0 ? current : nullptr;
+    newNode->access.store(current->access.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+    for (int i = 0; i <= current->nodeLevel; i++) {
+        newNode->setNext(i, current->next(i));
+    }
+    for (int i = 0; i <= current->nodeLevel; i++) {
+        update[i]->setNext(i, newNode);
+    }
+    if (index_) {
+        index_->insert(key, newNode);
+    }
+    if (pins_ > 0) {
+        dropLive(current);
+        superseded_.push_back(current);
+    } else {
+        retireNode(current);
+    }
+    return newNode;
+}
+
+template <typename K, typename V>
+uint64_t SkipList<K, V>::pinVersions() {
+    if (!singleWriter_) {
+        mutex_.assertLocked();
+    }
+    pins_++;
+    return sequence_.load(std::memory_order_relaxed);
+}
+
+template <typename K, typename V>
+void SkipList<K, V>::unpinVersions() {
+    WriterGuard lock(this);
+    if (--pins_ == 0) {
+        dropVersions();
+    }
+}
+
+template <typename K, typename V>
+void SkipList<K, V>::dropVersions() {
+    // 最新版本的 older 仍指向这些节点，但之后的快照序号不小于任何现存节点的序号，
+    // 不会再沿 older 访问它们；正在读最新数据的读者由 epoch 保护。
+    // 它们被替换时已经不计入 liveBytes_，直接放入待回收队列
+    uint64_t epoch = EpochManager::instance().retireEpoch();
+    for (NodePtr node : superseded_) {
+        retired_.emplace_back(epoch, node);
+    }
+    superseded_.clear();
+    reclaim();
+
+    NodePtr update[kMaxLevelLimit + 1];
+    for (const K& key : tombstoneKeys_) {
+        NodePtr restart = nullptr;
+        bool exists = false;
+        NodePtr current = findGreaterOrEqual(key, update, &exists, &restart);
+        // 同一个 key 可能被删除多次，也可能已重新写入
+        if (exists && current->isTombstone()) {
+            if (index_) {
+                index_->erase(key);
+            }
+            unlinkNode(current, update, restart);
+        }
+    }
+    tombstoneKeys_.clear();
+    tombstoneKeys_.shrink_to_fit();
+}
 
-    // 从每一层中删除节点
-    for (int i = 0; i <= currentLevel_; i++) {
-        if (update[i]->forward[i] != current) {
+template <typename K, typename V>
+template <typename Visitor>
+void SkipList<K, V>::sample(size_t count, Visitor visitor) const {
+    thread_local std::mt19937 gen(std::random_device{}());
+    EpochGuard guard;
+    K scratch;
+    // 最高的几层节点很少，各段长度相差悬殊，从那里下降会严重偏向短的段：
+    // 从第一个至少有 kSampleStartSpan 个节点的层开始
+    int start = 0;
+    for (int i = currentLevel_.load(std::memory_order_acquire); i > 0; i--) {
+        size_t n = 0;
+        for (NodePtr x = header_->next(i); x != nullptr && n < kSampleStartSpan; x = x->next(i)) {
+            n++;
+        }
+        if (n >= kSampleStartSpan) {
+            start = i;
             break;
         }
-        update[i]->forward[i] = current->forward[i];
     }
+    // 下降可能停在头节点（表为空或只选中了表头之前）或墓碑上，尝试次数有上限
+    size_t found = 0;
+    for (size_t attempt = 0; found < count && attempt < count * 4; attempt++) {
+        NodePtr current = header_;
+        NodePtr restart = header_;
+        NodePtr bound = nullptr;  // 上一层中 current 的后继，本层只在 [current, bound) 内选
+        for (int i = start; i >= 0; i--) {
+            size_t span = 0;
+            for (NodePtr x = current->next(i); x != bound && x != nullptr && span < kSampleSpanLimit;
+                 x = x->next(i)) {
+                span++;
+            }
+            // 第 0 层停在头节点等于没有选中，至少前进一步
+            size_t low = (i == 0 && current == header_) ? 1 : 0;
+            if (span < low) {
+                break;
+            }
+            size_t steps = std::uniform_int_distribution<size_t>(low, span)(gen);
+            for (size_t s = 0; s < steps; s++) {
+                // 并发删除可能让这一段变短
+                NodePtr next = current->next(i);
+                if (next == nullptr) {
+                    break;
+                }
+                current = next;
+                if (current->nodeLevel > 0) {
+                    restart = current;
+                }
+            }
+            bound = current->next(i);
+        }
+        if (current == header_ || current->isTombstone()) {
+            continue;
+        }
+        found++;
+        visitor(static_cast<const K&>(fullKey(current, restart, &scratch)),
+                static_cast<const V&>(current->value),
+                current->access.load(std::memory_order_relaxed));
+    }
+}
 
-    // 更新当前最高层数（如果删除后某些层变空）
-    while (currentLevel_ > 0 && header_->forward[currentLevel_] == nullptr) {
-        currentLevel_--;
+template <typename K, typename V>
+template <typename Visitor>
+void SkipList<K, V>::searchSorted(const std::vector<const K*>& keys, Visitor visitor) const {
+    EpochGuard guard;
+    NodePtr finger[kMaxLevelLimit + 1];
+    initFinger(finger);
+    for (size_t i = 0; i < keys.size(); i++) {
+        NodePtr current = nullptr;
+        if (index_) {
+            // 哈希索引一次探测即可，不需要 finger
+            current = index_->find(*keys[i]);
+        } else {
+            bool exact = false;
+            current = findGreaterOrEqual(*keys[i], finger, &exact, nullptr, true);
+            current = exact ? current : nullptr;
+        }
+        if (current != nullptr && !current->isTombstone()) {
+            if (tracker_) {
+                touch(current);
+            }
+            visitor(i, static_cast<const V*>(&current->value));
+        } else {
+            visitor(i, static_cast<const V*>(nullptr));
+        }
     }
+}
 
-    elementCount_--;
-    return true;
+template <typename K, typename V>
+template <typename Visitor>
+void SkipList<K, V>::insertSorted(const std::vector<std::pair<const K*, const V*>>& entries,
+                                  Visitor visitor) {
+    WriterGuard lock(this);
+    NodePtr finger[kMaxLevelLimit + 1];
+    initFinger(finger);
+    for (size_t i = 0; i < entries.size(); i++) {
+        visitor(i, insertLocked(*entries[i].first, *entries[i].second, finger));
+    }
+}
+
+template <typename K, typename V>
+template <typename Visitor>
+void SkipList<K, V>::removeSorted(const std::vector<const K*>& keys, Visitor visitor) {
+    WriterGuard lock(this);
+    NodePtr finger[kMaxLevelLimit + 1];
+    initFinger(finger);
+    for (size_t i = 0; i < keys.size(); i++) {
+        removeLocked(*keys[i], kLatest, [&visitor, i](const V& value) {
+            visitor(i, value);
+            return true;
+        }, finger);
+    }
 }
 
 template <typename K, typename V>
 bool SkipList<K, V>::contains(const K& key) const {
-    V dummy;
-    return search(key, dummy);
+    EpochGuard guard;
+    return findNode(key) != nullptr;
 }
 
 template <typename K, typename V>
 int SkipList<K, V>::size() const {
-    MutexLockGuard lock(mutex_);
-    return elementCount_;
+    return elementCount_.load(std::memory_order_relaxed);
 }
 
 template <typename K, typename V>
 void SkipList<K, V>::clear() {
-    MutexLockGuard lock(mutex_);
+    WriterGuard lock(this);
+
+    if (pins_ > 0) {
+        tombstoneAll();
+        return;
+    }
+    nextSequence();
 
-    // 清空所有 forward 指针
-    for (int i = 0; i <= currentLevel_; i++) {
-        header_->forward[i] = nullptr;
+    NodePtr current = header_->next(0);
+
+    // 清空所有 forward 指针，之后的读者看到的是空表
+    for (int i = 0; i <= maxLevel_; i++) {
+        header_->setNext(i, nullptr);
+    }
+    currentLevel_.store(0, std::memory_order_release);
+    if (index_) {
+        index_->clear();
     }
+    elementCount_.store(0, std::memory_order_relaxed);
+    liveBytes_.store(0, std::memory_order_relaxed);
 
-    currentLevel_ = 0;
-    elementCount_ = 0;
+    // 旧节点可能仍被读者访问，统一延迟回收
+    uint64_t epoch = EpochManager::instance().retireEpoch();
+    while (current != nullptr) {
+        NodePtr next = current->next(0);
+        retired_.emplace_back(epoch, current);
+        current = next;
+    }
+    reclaim();
 }
 
 template <typename K, typename V>
-bool SkipList<K, V>::dumpFile(const std::string& filepath) const {
-    MutexLockGuard lock(mutex_);
+void SkipList<K, V>::tombstoneAll() {
+    // 沿第 0 层依次替换，prev[i] 为第 i 层上已处理的最后一个节点，即下一个节点的前驱
+    NodePtr prev[kMaxLevelLimit + 1];
+    for (int i = 0; i <= maxLevel_; i++) {
+        prev[i] = header_;
+    }
+    uint64_t version = nextSequence() | kTombstoneBit;
+    NodePtr restart = header_;
+    K scratch;
+    NodePtr current = header_->next(0);
+    while (current != nullptr) {
+        NodePtr next = current->next(0);
+        NodePtr replacement = current;
+        if (!current->isTombstone()) {
+            const K& key = fullKey(current, restart, &scratch);
+            replacement = createNode(current->key, V(), current->nodeLevel, current->shared);
+            replacement->version = version;
+            replacement->older = current;
+            for (int i = 0; i <= current->nodeLevel; i++) {
+                replacement->setNext(i, current->next(i));
+            }
+            for (int i = 0; i <= current->nodeLevel; i++) {
+                prev[i]->setNext(i, replacement);
+            }
+            if (index_) {
+                index_->insert(key, replacement);
+            }
+            tombstoneKeys_.push_back(key);
+            dropLive(current);
+            superseded_.push_back(current);
+        }
+        for (int i = 0; i <= replacement->nodeLevel; i++) {
+            prev[i] = replacement;
+        }
+        if (replacement->nodeLevel > 0) {
+            restart = replacement;
+        }
+        current = next;
+    }
+    elementCount_.store(0, std::memory_order_relaxed);
+}
 
+template <typename K, typename V>
+bool SkipList<K, V>::dumpFile(const std::string& filepath) const {
     std::ofstream outFile(filepath);
     if (!outFile.is_open()) {
         std::cerr << "Failed to open file for writing: " << filepath << std::endl;
         return false;
     }
 
+    bool success = dump(outFile);
+    outFile.close();
+    return success;
+}
+
+template <typename K, typename V>
+bool SkipList<K, V>::dump(std::ostream& out) const {
+    MutexLockGuard lock(mutex_);
+
     // 遍历第 0 层，写入所有键值对
-    NodePtr current = header_->forward[0];
+    NodePtr restart = header_;
+    K scratch;
+    NodePtr current = header_->next(0);
     while (current != nullptr) {
-        outFile << current->key << kDelimiter << current->value << "\n";
-        current = current->forward[0];
+        if (!current->isTombstone()) {
+            out << fullKey(current, restart, &scratch) << kDelimiter << current->value << "\n";
+        }
+        if (current->nodeLevel > 0) {
+            restart = current;
+        }
+        current = current->next(0);
     }
 
-    outFile.flush();
-    outFile.close();
-    return true;
+    out.flush();
+    return static_cast<bool>(out);
 }
 
 template <typename K, typename V>
@@ -430,6 +1688,11 @@ bool SkipList<K, V>::parseString(const std::string& line, std::string& key,
     return true;
 }
 
+template <typename K, typename V>
+size_t SkipList<K, V>::memoryUsage() const {
+    return arena_.memoryUsage() + (index_ ? index_->memoryUsage() : 0);
+}
+
 template <typename K, typename V>
 void SkipList<K, V>::displayList() const {
     MutexLockGuard lock(mutex_);
@@ -440,10 +1703,15 @@ void SkipList<K, V>::displayList() const {
 
     for (int i = currentLevel_; i >= 0; i--) {
         std::cout << "Level " << i << ": ";
-        NodePtr current = header_->forward[i];
+        NodePtr restart = header_;
+        K scratch;
+        NodePtr current = header_->next(i);
         while (current != nullptr) {
-            std::cout << current->key << ":" << current->value << " -> ";
-            current = current->forward[i];
+            std::cout << fullKey(current, restart, &scratch) << ":" << current->value << " -> ";
+            if (current->nodeLevel > 0) {
+                restart = current;
+            }
+            current = current->next(i);
         }
         std::cout << "NIL" << std::endl;
     }
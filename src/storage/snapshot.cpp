@@ -0,0 +1,410 @@
+// src/storage/snapshot.cpp
+#include "storage/snapshot.h"
+
+#include "base/coding.h"
+#include "base/crc32c.h"
+#include "base/logger.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace kvstore {
+
+namespace {
+
+bool writeAll(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t written = ::write(fd, p, n);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        n -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool preadExact(int fd, char* dst, size_t n, uint64_t offset) {
+    while (n > 0) {
+        ssize_t got = ::pread(fd, dst, n, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+        dst += got;
+        n -= static_cast<size_t>(got);
+        offset += static_cast<uint64_t>(got);
+    }
+    return true;
+}
+
+}  // namespace
+
+// ==================== SnapshotWriter ====================
+
+SnapshotWriter::SnapshotWriter(const std::string& path)
+    : path_(path),
+      fd_(-1),
+      fileOffset_(0),
+      blockStart_(0),
+      blockRecords_(0),
+      count_(0),
+      blocks_(0),
+      minKeyOffset_(0),
+      maxKeyOffset_(0),
+      minKeyLen_(0),
+      maxKeyLen_(0),
+      finished_(false) {}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        if (!finished_) {
+            ::unlink(path_.c_str());
+        }
+    }
+}
+
+bool SnapshotWriter::open() {
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR << "Snapshot open " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    buffer_.reserve(kWriteBufferSize + kBlockSize);
+    // 文件头先占位，finish() 时回填
+    buffer_.assign(snapshot::kHeaderSize, '\0');
+    blockStart_ = buffer_.size();
+    buffer_.append(snapshot::kBlockHeaderSize, '\0');
+    return true;
+}
+
+bool SnapshotWriter::add(const char* key, size_t keyLen, const char* value, size_t valueLen,
+                         int64_t expireAt) {
+    putVarint32(&buffer_, static_cast<uint32_t>(keyLen));
+    putVarint32(&buffer_, static_cast<uint32_t>(valueLen << 1) | (expireAt != 0 ? 1 : 0));
+    if (expireAt != 0) {
+        putFixed64(&buffer_, static_cast<uint64_t>(expireAt));
+    }
+    uint64_t keyOffset = fileOffset_ + buffer_.size();
+    buffer_.append(key, keyLen);
+    buffer_.append(value, valueLen);
+
+    if (count_ == 0) {
+        minKeyOffset_ = keyOffset;
+        minKeyLen_ = static_cast<uint32_t>(keyLen);
+    }
+    maxKeyOffset_ = keyOffset;
+    maxKeyLen_ = static_cast<uint32_t>(keyLen);
+    count_++;
+    blockRecords_++;
+
+    if (buffer_.size() - blockStart_ >= kBlockSize) {
+        finishBlock();
+        if (buffer_.size() >= kWriteBufferSize && !flush()) {
+            return false;
+        }
+        blockStart_ = buffer_.size();
+        buffer_.append(snapshot::kBlockHeaderSize, '\0');
+    }
+    return true;
+}
+
+void SnapshotWriter::finishBlock() {
+    char* header = &buffer_[blockStart_];
+    const char* payload = header + snapshot::kBlockHeaderSize;
+    size_t payloadLen = buffer_.size() - blockStart_ - snapshot::kBlockHeaderSize;
+    encodeFixed32(header, static_cast<uint32_t>(payloadLen));
+    encodeFixed32(header + 4, blockRecords_);
+    uint32_t crc = crc32c::value(header + 4, 4);
+    encodeFixed32(header + 8, crc32c::extend(crc, payload, payloadLen));
+    blockOffsets_.push_back(fileOffset_ + blockStart_);
+    blocks_++;
+    blockRecords_ = 0;
+}
+
+bool SnapshotWriter::flush() {
+    if (!writeAll(fd_, buffer_.data(), buffer_.size())) {
+        LOG_ERROR << "Snapshot write " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    fileOffset_ += buffer_.size();
+    buffer_.clear();
+    return true;
+}
+
+bool SnapshotWriter::finish() {
+    if (blockRecords_ > 0) {
+        finishBlock();
+    } else {
+        buffer_.resize(blockStart_);  // 去掉空块的占位块头
+    }
+    appendIndex();
+    if (!flush()) {
+        return false;
+    }
+
+    char header[snapshot::kHeaderSize] = {};
+    memcpy(header, snapshot::kMagic, sizeof(snapshot::kMagic));
+    encodeFixed32(header + 8, snapshot::kVersion);
+    encodeFixed32(header + 12, 0);
+    encodeFixed64(header + 16, count_);
+    encodeFixed64(header + 24, blocks_);
+    encodeFixed64(header + 32, minKeyOffset_);
+    encodeFixed64(header + 40, maxKeyOffset_);
+    encodeFixed32(header + 48, minKeyLen_);
+    encodeFixed32(header + 52, maxKeyLen_);
+    encodeFixed32(header + 56, crc32c::value(header, 56));
+
+    // 数据先落盘再写文件头，文件头存在即说明数据完整
+    bool ok = ::fdatasync(fd_) == 0 &&
+              ::pwrite(fd_, header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+              ::fsync(fd_) == 0;
+    if (!ok) {
+        LOG_ERROR << "Snapshot finish " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    finished_ = true;
+    return true;
+}
+
+void SnapshotWriter::appendIndex() {
+    size_t indexStart = buffer_.size();
+    for (uint64_t offset : blockOffsets_) {
+        putFixed64(&buffer_, offset);
+    }
+    putFixed32(&buffer_, crc32c::value(buffer_.data() + indexStart, buffer_.size() - indexStart));
+}
+
+// ==================== SnapshotReader ====================
+
+SnapshotReader::SnapshotReader(const std::string& path)
+    : path_(path), data_(nullptr), size_(0) {}
+
+SnapshotReader::~SnapshotReader() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+bool SnapshotReader::probe(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    char magic[sizeof(snapshot::kMagic)];
+    bool match = preadExact(fd, magic, sizeof(magic), 0) &&
+                 memcmp(magic, snapshot::kMagic, sizeof(magic)) == 0;
+    ::close(fd);
+    return match;
+}
+
+bool SnapshotReader::open() {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < snapshot::kHeaderSize) {
+        ::close(fd);
+        LOG_ERROR << "Snapshot " << path_ << ": not a snapshot file";
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // 映射建立后不再需要文件描述符
+    if (addr == MAP_FAILED) {
+        LOG_ERROR << "Snapshot mmap " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    data_ = static_cast<const char*>(addr);
+    ::madvise(addr, size_, MADV_SEQUENTIAL);
+
+    const char* header = data_;
+    if (memcmp(header, snapshot::kMagic, sizeof(snapshot::kMagic)) != 0) {
+        LOG_ERROR << "Snapshot " << path_ << ": not a snapshot file";
+        return false;
+    }
+    if (crc32c::value(header, 56) != decodeFixed32(header + 56)) {
+        LOG_ERROR << "Snapshot " << path_ << ": header checksum mismatch";
+        return false;
+    }
+    info_.version = decodeFixed32(header + 8);
+    if (info_.version < snapshot::kMinVersion || info_.version > snapshot::kVersion) {
+        LOG_ERROR << "Snapshot " << path_ << ": unsupported version " << info_.version;
+        return false;
+    }
+    info_.count = decodeFixed64(header + 16);
+    info_.blocks = decodeFixed64(header + 24);
+
+    uint64_t minKeyOffset = decodeFixed64(header + 32);
+    uint64_t maxKeyOffset = decodeFixed64(header + 40);
+    uint32_t minKeyLen = decodeFixed32(header + 48);
+    uint32_t maxKeyLen = decodeFixed32(header + 52);
+    // 文件被截断时 key 范围可能落在文件之外，留空，仍然读取剩下的块
+    if (minKeyOffset <= size_ && minKeyLen <= size_ - minKeyOffset &&
+        maxKeyOffset <= size_ && maxKeyLen <= size_ - maxKeyOffset) {
+        info_.minKey.assign(data_ + minKeyOffset, minKeyLen);
+        info_.maxKey.assign(data_ + maxKeyOffset, maxKeyLen);
+    } else {
+        LOG_WARN << "Snapshot " << path_ << ": key range out of file";
+    }
+    locateBlocks();
+    return true;
+}
+
+void SnapshotReader::locateBlocks() {
+    blockOffsets_.clear();
+    const size_t dataSize = size_ - snapshot::kHeaderSize;
+    if (info_.version >= 2 && dataSize >= 4 && info_.blocks <= (dataSize - 4) / 8) {
+        size_t indexLen = static_cast<size_t>(info_.blocks) * 8;
+        const char* index = data_ + size_ - 4 - indexLen;
+        if (crc32c::value(index, indexLen) == decodeFixed32(index + indexLen)) {
+            uint64_t limit = static_cast<uint64_t>(index - data_);
+            uint64_t next = snapshot::kHeaderSize;
+            bool valid = true;
+            for (size_t i = 0; i < info_.blocks && valid; i++) {
+                uint64_t offset = decodeFixed64(index + i * 8);
+                valid = offset >= next && offset + snapshot::kBlockHeaderSize <= limit;
+                next = offset + snapshot::kBlockHeaderSize;
+                blockOffsets_.push_back(offset);
+            }
+            if (valid) {
+                return;
+            }
+        }
+        LOG_WARN << "Snapshot " << path_ << ": block index is damaged, scanning block headers";
+        blockOffsets_.clear();
+    }
+
+    // 顺序查找：每个块头记录了 payload 长度，跳过 payload 就是下一个块
+    size_t offset = snapshot::kHeaderSize;
+    while (blockOffsets_.size() < info_.blocks && size_ - offset >= snapshot::kBlockHeaderSize) {
+        uint32_t payloadLen = decodeFixed32(data_ + offset);
+        if (size_ - offset - snapshot::kBlockHeaderSize < payloadLen) {
+            break;
+        }
+        blockOffsets_.push_back(offset);
+        offset += snapshot::kBlockHeaderSize + payloadLen;
+    }
+}
+
+bool SnapshotReader::read(const RecordVisitor& visitor, bool releasePages) {
+    if (data_ == nullptr) {
+        return false;
+    }
+    uint64_t records = 0;
+    uint64_t badBlocks = 0;
+    size_t released = 0;  // 之前的块占用的页已释放
+    for (size_t i = 0; i < blockOffsets_.size(); i++) {
+        uint32_t count = 0;
+        if (readBlock(i, visitor, &count)) {
+            records += count;
+        } else {
+            badBlocks++;
+        }
+
+        // 回调已经拷贝走解码出的数据，已读的页不再需要
+        size_t next = i + 1 < blockOffsets_.size() ? blockOffsets_[i + 1] : size_;
+        if (releasePages && next - blockOffsets_[released] >= kReleaseChunk) {
+            releaseBlocks(released, i + 1);
+            released = i + 1;
+        }
+    }
+    if (!releasePages) {
+        adviseRandomAccess();
+    }
+    return checkComplete(records, badBlocks);
+}
+
+bool SnapshotReader::readBlock(size_t index, const RecordVisitor& visitor,
+                               uint32_t* records) const {
+    uint64_t offset = blockOffsets_[index];
+    const char* header = data_ + offset;
+    uint32_t payloadLen = decodeFixed32(header);
+    *records = decodeFixed32(header + 4);
+    const char* payload = header + snapshot::kBlockHeaderSize;
+    bool ok = size_ - offset - snapshot::kBlockHeaderSize >= payloadLen &&
+              crc32c::extend(crc32c::value(header + 4, 4), payload, payloadLen) ==
+                  decodeFixed32(header + 8) &&
+              decodeBlock(payload, payloadLen, *records, info_.version >= 3, visitor);
+    if (!ok) {
+        LOG_ERROR << "Snapshot " << path_ << ": block " << index << " is corrupt, skipping "
+                  << *records << " records";
+    }
+    return ok;
+}
+
+void SnapshotReader::releaseBlocks(size_t begin, size_t end) const {
+    if (begin >= end || begin >= blockOffsets_.size()) {
+        return;
+    }
+    const size_t pageMask = static_cast<size_t>(::sysconf(_SC_PAGESIZE)) - 1;
+    size_t from = blockOffsets_[begin] & ~pageMask;
+    size_t to = (end < blockOffsets_.size() ? blockOffsets_[end] : size_) & ~pageMask;
+    if (from < to) {
+        ::madvise(const_cast<char*>(data_) + from, to - from, MADV_DONTNEED);
+    }
+}
+
+void SnapshotReader::adviseRandomAccess() const {
+    if (data_ != nullptr) {
+        ::madvise(const_cast<char*>(data_), size_, MADV_RANDOM);
+    }
+}
+
+bool SnapshotReader::checkComplete(uint64_t records, uint64_t badBlocks) const {
+    if (blockOffsets_.size() < info_.blocks) {
+        LOG_ERROR << "Snapshot " << path_ << ": truncated at block " << blockOffsets_.size()
+                  << " of " << info_.blocks;
+        return false;
+    }
+    if (badBlocks > 0 || records != info_.count) {
+        LOG_ERROR << "Snapshot " << path_ << ": loaded " << records << " of " << info_.count
+                  << " records";
+        return false;
+    }
+    return true;
+}
+
+bool SnapshotReader::decodeBlock(const char* p, size_t n, uint32_t records, bool expiry,
+                                 const RecordVisitor& visitor) {
+    const char* limit = p + n;
+    for (uint32_t i = 0; i < records; i++) {
+        uint32_t keyLen = 0;
+        uint32_t valueLen = 0;
+        int64_t expireAt = 0;
+        p = getVarint32(p, limit, &keyLen);
+        p = p != nullptr ? getVarint32(p, limit, &valueLen) : nullptr;
+        if (p != nullptr && expiry) {
+            const bool hasExpiry = (valueLen & 1) != 0;
+            valueLen >>= 1;
+            if (hasExpiry) {
+                if (limit - p < 8) {
+                    return false;
+                }
+                expireAt = static_cast<int64_t>(decodeFixed64(p));
+                p += 8;
+            }
+        }
+        if (p == nullptr || static_cast<size_t>(limit - p) < static_cast<size_t>(keyLen) + valueLen) {
+            return false;
+        }
+        visitor(p, keyLen, p + keyLen, valueLen, expireAt);
+        p += keyLen + valueLen;
+    }
+    return p == limit;
+}
+
+}  // namespace kvstore
@@ -0,0 +1,218 @@
+// src/storage/snapshot.h
+#ifndef KVSTORE_STORAGE_SNAPSHOT_H
+#define KVSTORE_STORAGE_SNAPSHOT_H
+
+#include "base/noncopyable.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace kvstore {
+
+/**
+ * @brief 快照文件头中的元信息
+ */
+struct SnapshotInfo {
+    uint32_t version = 0;
+    uint64_t count = 0;   // 记录总数
+    uint64_t blocks = 0;  // 数据块数
+    std::string minKey;   // 第一条记录的 key（count 为 0 或文件被截断时为空）
+    std::string maxKey;   // 最后一条记录的 key（同上）
+};
+
+/**
+ * @brief 快照文件格式
+ *
+ * 二进制、按块组织、带校验，取代逐行 "key:value" 的文本格式
+ * （文本格式无法保存含 ':' 或换行的值）。整数均为小端。
+ *
+ *   [文件头 64 字节]
+ *     magic[8] = "RKVSNAP\0"
+ *     version u32 | flags u32
+ *     count u64 | blocks u64
+ *     minKeyOffset u64 | maxKeyOffset u64   (key 在文件中的偏移)
+ *     minKeyLen u32 | maxKeyLen u32
+ *     headerCrc u32                         (覆盖前 56 字节)
+ *     reserved u32
+ *   [数据块] * blocks
+ *     payloadLen u32 | recordCount u32 | crc u32 (覆盖 recordCount 和 payload)
+ *     payload = [keyLen varint32][valueTag varint32][expireAt u64][key][value] * recordCount
+ *       valueTag = valueLen << 1 | hasExpiry，没有过期时间时不写 expireAt（version >= 3）；
+ *       version 1、2 中 valueTag 就是 valueLen
+ *   [块索引]（version >= 2）
+ *     blockOffset u64 * blocks                (每个块的块头在文件中的偏移)
+ *     indexCrc u32                            (覆盖 blockOffset 数组)
+ *
+ * 每个块都能独立校验和解码，块索引让读取方不用顺序走一遍块头就能把文件切成
+ * 若干段并行解码。没有索引（version 1）或索引损坏时退化为顺序查找块头。
+ *
+ * 记录按 key 严格升序排列，加载时可以直接从尾部追加构建跳表，不用逐条查找插入位置。
+ * 文件头最后写入：写到一半崩溃的文件没有合法的 magic，不会被当成快照加载。
+ * key 范围以偏移的形式引用数据块中的 key，文件头因此是定长的，可以在写完数据后回填。
+ */
+namespace snapshot {
+
+const char kMagic[8] = {'R', 'K', 'V', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t kVersion = 3;
+const uint32_t kMinVersion = 1;  // 仍能读取的最旧版本
+const size_t kHeaderSize = 64;
+const size_t kBlockHeaderSize = 12;  // payloadLen + recordCount + crc
+
+}  // namespace snapshot
+
+/**
+ * @brief 快照写入器
+ *
+ * 记录先编码进内存缓冲，每凑满 kBlockSize 封一个块，每凑满 kWriteBufferSize
+ * 调用一次 write，整个文件只有 O(文件大小 / 1MB) 次系统调用。
+ *
+ * 使用示例：
+ *   SnapshotWriter writer(path);
+ *   bool ok = writer.open();
+ *   for (...) ok = ok && writer.add(key, keyLen, value, valueLen, expireAt);  // key 升序
+ *   ok = ok && writer.finish();  // 回填文件头并 fsync
+ */
+class SnapshotWriter : noncopyable {
+public:
+    static const size_t kBlockSize = 64 * 1024;
+    static const size_t kWriteBufferSize = 1024 * 1024;
+
+    explicit SnapshotWriter(const std::string& path);
+
+    /// 未 finish 的文件会被关闭并删除
+    ~SnapshotWriter();
+
+    /// 创建（截断）文件
+    bool open();
+
+    /**
+     * @brief 追加一条记录，调用方保证 key 严格升序
+     * @param expireAt 绝对过期时刻（Unix 毫秒），0 表示不过期
+     * @return false 写文件失败
+     */
+    bool add(const char* key, size_t keyLen, const char* value, size_t valueLen,
+             int64_t expireAt = 0);
+
+    /**
+     * @brief 封闭最后一个块，写入文件头，fsync 并关闭
+     * @return true 文件已完整落盘
+     */
+    bool finish();
+
+    /// 已追加的记录数
+    uint64_t count() const { return count_; }
+
+private:
+    /// 封闭当前块：回填块头
+    void finishBlock();
+
+    /// 把缓冲写入文件
+    bool flush();
+
+    /// 追加块索引
+    void appendIndex();
+
+    const std::string path_;
+    int fd_;
+    std::string buffer_;    // 尚未写入文件的字节
+    uint64_t fileOffset_;   // buffer_ 开头在文件中的偏移
+    size_t blockStart_;     // 当前块的块头在 buffer_ 中的位置
+    uint32_t blockRecords_;
+    uint64_t count_;
+    uint64_t blocks_;
+    std::vector<uint64_t> blockOffsets_;  // 已封闭的块的偏移
+    uint64_t minKeyOffset_;
+    uint64_t maxKeyOffset_;
+    uint32_t minKeyLen_;
+    uint32_t maxKeyLen_;
+    bool finished_;
+};
+
+/**
+ * @brief 快照读取器
+ *
+ * 整个文件只读 mmap，按块校验后直接在映射上解码，回调拿到的 key/value 指针
+ * 指向映射内部，读取过程中没有 read 系统调用，也不把数据拷贝到中间缓冲。
+ * 映射按顺序访问（MADV_SEQUENTIAL），已经读完的页及时释放（MADV_DONTNEED），
+ * 加载大文件时进程常驻内存不会随文件大小增长。
+ *
+ * 校验失败的块整体跳过（块头完整时仍能定位到下一个块），
+ * 块头本身损坏或文件被截断时停止。
+ */
+class SnapshotReader : noncopyable {
+public:
+    /// 每条记录调用一次，指针指向文件映射，在读取器析构前有效；expireAt 为 0 表示不过期
+    using RecordVisitor = std::function<void(const char* key, size_t keyLen,
+                                             const char* value, size_t valueLen,
+                                             int64_t expireAt)>;
+
+    explicit SnapshotReader(const std::string& path);
+    ~SnapshotReader();
+
+    /// 文件是否以快照的 magic 开头（用于区分旧的文本格式）
+    static bool probe(const std::string& path);
+
+    /**
+     * @brief 打开并映射文件，校验文件头
+     * @return false 文件不存在、不是快照或文件头损坏
+     */
+    bool open();
+
+    /// 文件头中的元信息，open() 成功后有效
+    const SnapshotInfo& info() const { return info_; }
+
+    /**
+     * @brief 按文件中的顺序读取全部记录
+     * @param releasePages 是否释放已读的页；回调保留了指向映射的指针时传 false
+     * @return true 所有块都完整且校验通过，记录数与文件头一致
+     */
+    bool read(const RecordVisitor& visitor, bool releasePages = true);
+
+    // ==================== 按块读取（可多线程并行） ====================
+
+    /// 能定位到的块数（文件被截断时小于 info().blocks）
+    size_t blockCount() const { return blockOffsets_.size(); }
+
+    /**
+     * @brief 校验并解码第 index 个块，可以在多个线程中同时调用
+     * @param records 输出块中的记录数
+     * @return false 块损坏（已记录错误日志，回调可能已收到部分记录）
+     */
+    bool readBlock(size_t index, const RecordVisitor& visitor, uint32_t* records) const;
+
+    /// 释放 [begin, end) 块占用的页，之后不应再读取这些块
+    void releaseBlocks(size_t begin, size_t end) const;
+
+    /// 映射之后按 key 随机访问（引用了映射中的值），关闭顺序预读
+    void adviseRandomAccess() const;
+
+    /**
+     * @brief 检查按块读取的结果是否完整，不完整时记录错误日志
+     * @return true 所有块都能定位且校验通过，记录数与文件头一致
+     */
+    bool checkComplete(uint64_t records, uint64_t badBlocks) const;
+
+private:
+    /// 定位所有块：优先使用块索引，没有或损坏时顺序查找块头
+    void locateBlocks();
+
+    /// 每读完这么多字节释放一次已读的页
+    static const size_t kReleaseChunk = 64 * 1024 * 1024;
+
+    /// 解码一个块的 payload，格式错误返回 false；expiry 表示记录带过期时间标志（version >= 3）
+    static bool decodeBlock(const char* p, size_t n, uint32_t records, bool expiry,
+                            const RecordVisitor& visitor);
+
+    const std::string path_;
+    const char* data_;  // 文件映射，open() 成功后有效
+    size_t size_;       // 文件大小
+    SnapshotInfo info_;
+    std::vector<uint64_t> blockOffsets_;  // 各块块头的偏移
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_SNAPSHOT_H
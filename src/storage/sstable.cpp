@@ -0,0 +1,409 @@
+// src/storage/sstable.cpp
+#include "storage/sstable.h"
+
+#include "base/coding.h"
+#include "base/crc32c.h"
+#include "base/logger.h"
+#include "storage/bloom_filter.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace kvstore {
+
+namespace {
+
+bool writeAll(int fd, const char* p, size_t n) {
+    while (n > 0) {
+        ssize_t written = ::write(fd, p, n);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        n -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+/// 解码出的一条记录，指针指向映射
+struct Entry {
+    const char* key;
+    uint32_t keyLen;
+    const char* value;
+    uint32_t valueLen;
+    int64_t expireAt;
+    bool tombstone;
+};
+
+/**
+ * @brief 解码 [p, limit) 开头的一条记录
+ * @param format 文件的 entry 编码版本
+ * @return 下一条记录的位置；格式错误返回 nullptr
+ */
+const char* decodeEntry(const char* p, const char* limit, uint32_t format, Entry* entry) {
+    uint32_t tag = 0;
+    p = getVarint32(p, limit, &entry->keyLen);
+    p = p != nullptr ? getVarint32(p, limit, &tag) : nullptr;
+    if (p == nullptr) {
+        return nullptr;
+    }
+    entry->tombstone = (tag & 1) != 0;
+    entry->expireAt = 0;
+    if (format < 2) {
+        entry->valueLen = tag >> 1;
+    } else {
+        entry->valueLen = tag >> 2;
+        if ((tag & 2) != 0) {
+            if (limit - p < 8) {
+                return nullptr;
+            }
+            entry->expireAt = static_cast<int64_t>(decodeFixed64(p));
+            p += 8;
+        }
+    }
+    if (static_cast<size_t>(limit - p) < static_cast<size_t>(entry->keyLen) + entry->valueLen) {
+        return nullptr;
+    }
+    entry->key = p;
+    entry->value = p + entry->keyLen;
+    return entry->value + entry->valueLen;
+}
+
+}  // namespace
+
+// ==================== TableBuilder ====================
+
+TableBuilder::TableBuilder(const std::string& path, int bitsPerKey)
+    : path_(path),
+      bitsPerKey_(bitsPerKey),
+      fd_(-1),
+      fileOffset_(0),
+      blockStart_(0),
+      count_(0),
+      finished_(false) {}
+
+TableBuilder::~TableBuilder() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        if (!finished_) {
+            ::unlink(path_.c_str());
+        }
+    }
+}
+
+bool TableBuilder::open() {
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR << "Table open " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    buffer_.reserve(kWriteBufferSize + kBlockSize);
+    return true;
+}
+
+bool TableBuilder::add(const char* key, size_t keyLen, const char* value, size_t valueLen,
+                       bool tombstone, int64_t expireAt) {
+    if (tombstone) {
+        valueLen = 0;
+        expireAt = 0;
+    }
+    putVarint32(&buffer_, static_cast<uint32_t>(keyLen));
+    putVarint32(&buffer_, static_cast<uint32_t>(valueLen << 2) | (expireAt != 0 ? 2 : 0) |
+                              (tombstone ? 1 : 0));
+    if (expireAt != 0) {
+        putFixed64(&buffer_, static_cast<uint64_t>(expireAt));
+    }
+    buffer_.append(key, keyLen);
+    buffer_.append(value, valueLen);
+    lastKey_.assign(key, keyLen);
+    hashes_.push_back(BloomFilter::hash(key, keyLen));
+    count_++;
+
+    if (buffer_.size() - blockStart_ >= kBlockSize) {
+        finishBlock();
+        if (buffer_.size() >= kWriteBufferSize && !flush()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TableBuilder::finishBlock() {
+    size_t size = buffer_.size() - blockStart_;
+    putFixed32(&buffer_, crc32c::value(buffer_.data() + blockStart_, size));
+    putVarint32(&index_, static_cast<uint32_t>(lastKey_.size()));
+    index_.append(lastKey_);
+    putFixed64(&index_, fileOffset_ + blockStart_);
+    putFixed32(&index_, static_cast<uint32_t>(size));
+    blockStart_ = buffer_.size();
+}
+
+bool TableBuilder::flush() {
+    if (!writeAll(fd_, buffer_.data(), buffer_.size())) {
+        LOG_ERROR << "Table write " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    fileOffset_ += buffer_.size();
+    buffer_.clear();
+    blockStart_ = 0;
+    return true;
+}
+
+bool TableBuilder::finish() {
+    if (buffer_.size() > blockStart_) {
+        finishBlock();
+    }
+
+    uint64_t filterOffset = fileOffset_ + buffer_.size();
+    BloomFilter::build(hashes_, bitsPerKey_, &buffer_);
+    uint64_t indexOffset = fileOffset_ + buffer_.size();
+    uint32_t filterSize = static_cast<uint32_t>(indexOffset - filterOffset);
+    buffer_.append(index_);
+    putFixed32(&buffer_, crc32c::value(index_.data(), index_.size()));
+
+    char footer[table::kFooterSize] = {};
+    encodeFixed64(footer, indexOffset);
+    encodeFixed64(footer + 8, filterOffset);
+    encodeFixed64(footer + 16, count_);
+    encodeFixed32(footer + 24, static_cast<uint32_t>(index_.size()));
+    encodeFixed32(footer + 28, filterSize);
+    encodeFixed32(footer + 32, crc32c::value(footer, 32));
+    encodeFixed32(footer + 36, table::kFormat);
+    memcpy(footer + 40, table::kMagic, sizeof(table::kMagic));
+    buffer_.append(footer, sizeof(footer));
+
+    if (!flush() || ::fsync(fd_) != 0) {
+        LOG_ERROR << "Table finish " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    ::close(fd_);
+    fd_ = -1;
+    finished_ = true;
+    return true;
+}
+
+// ==================== Table ====================
+
+Table::Table(const std::string& path)
+    : path_(path),
+      data_(nullptr),
+      size_(0),
+      count_(0),
+      filter_(nullptr),
+      filterSize_(0),
+      format_(table::kFormat) {}
+
+Table::~Table() {
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+bool Table::open() {
+    int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR << "Table open " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < table::kFooterSize) {
+        ::close(fd);
+        LOG_ERROR << "Table " << path_ << ": not a table file";
+        return false;
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    void* addr = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        LOG_ERROR << "Table mmap " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    data_ = static_cast<const char*>(addr);
+    // 点查找按 key 随机访问，预读只会读进用不到的页
+    ::madvise(addr, size_, MADV_RANDOM);
+
+    const char* footer = data_ + size_ - table::kFooterSize;
+    if (memcmp(footer + 40, table::kMagic, sizeof(table::kMagic)) != 0 ||
+        crc32c::value(footer, 32) != decodeFixed32(footer + 32)) {
+        LOG_ERROR << "Table " << path_ << ": bad footer";
+        return false;
+    }
+    uint64_t indexOffset = decodeFixed64(footer);
+    uint64_t filterOffset = decodeFixed64(footer + 8);
+    count_ = decodeFixed64(footer + 16);
+    uint32_t indexSize = decodeFixed32(footer + 24);
+    filterSize_ = decodeFixed32(footer + 28);
+    format_ = std::max<uint32_t>(decodeFixed32(footer + 36), 1);
+    if (format_ > table::kFormat) {
+        LOG_ERROR << "Table " << path_ << ": unsupported format " << format_;
+        return false;
+    }
+    const uint64_t limit = size_ - table::kFooterSize;
+    if (filterOffset + filterSize_ > indexOffset || indexOffset + indexSize + 4 > limit) {
+        LOG_ERROR << "Table " << path_ << ": footer out of file";
+        return false;
+    }
+    filter_ = data_ + filterOffset;
+
+    const char* p = data_ + indexOffset;
+    const char* end = p + indexSize;
+    if (crc32c::value(p, indexSize) != decodeFixed32(end)) {
+        LOG_ERROR << "Table " << path_ << ": index checksum mismatch";
+        return false;
+    }
+    index_.clear();
+    while (p < end) {
+        uint32_t keyLen = 0;
+        p = getVarint32(p, end, &keyLen);
+        if (p == nullptr || static_cast<size_t>(end - p) < static_cast<size_t>(keyLen) + 12) {
+            LOG_ERROR << "Table " << path_ << ": bad index entry";
+            return false;
+        }
+        IndexEntry entry;
+        entry.lastKey.assign(p, keyLen);
+        entry.offset = decodeFixed64(p + keyLen);
+        entry.size = decodeFixed32(p + keyLen + 8);
+        p += keyLen + 12;
+        if (entry.offset + entry.size + table::kBlockTrailerSize > filterOffset) {
+            LOG_ERROR << "Table " << path_ << ": block out of file";
+            return false;
+        }
+        index_.push_back(std::move(entry));
+    }
+    return true;
+}
+
+bool Table::mayContain(const std::string& key) const {
+    return BloomFilter::mayContain(filter_, filterSize_, BloomFilter::hash(key.data(), key.size()));
+}
+
+size_t Table::findBlock(const std::string& key) const {
+    size_t lo = 0;
+    size_t hi = index_.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (index_[mid].lastKey < key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool Table::blockContents(size_t index, const char** begin, const char** end) const {
+    const IndexEntry& entry = index_[index];
+    const char* block = data_ + entry.offset;
+    if (crc32c::value(block, entry.size) != decodeFixed32(block + entry.size)) {
+        LOG_ERROR << "Table " << path_ << ": block " << index << " is corrupt";
+        return false;
+    }
+    *begin = block;
+    *end = block + entry.size;
+    return true;
+}
+
+Table::Lookup Table::get(const std::string& key, Value* value) const {
+    if (!mayContain(key)) {
+        return Lookup::kNotFound;
+    }
+    size_t index = findBlock(key);
+    const char* p = nullptr;
+    const char* end = nullptr;
+    if (index == index_.size() || !blockContents(index, &p, &end)) {
+        return Lookup::kNotFound;
+    }
+    while (p != nullptr && p < end) {
+        Entry entry;
+        p = decodeEntry(p, end, format_, &entry);
+        if (p == nullptr) {
+            break;
+        }
+        int cmp = key.compare(0, std::string::npos, entry.key, entry.keyLen);
+        if (cmp == 0) {
+            if (entry.tombstone) {
+                return Lookup::kDeleted;
+            }
+            *value = Value(entry.value, entry.valueLen);
+            if (entry.expireAt != 0) {
+                *value = value->withExpiry(entry.expireAt);
+            }
+            return Lookup::kFound;
+        }
+        if (cmp < 0) {
+            break;
+        }
+    }
+    return Lookup::kNotFound;
+}
+
+// ==================== Table::Iterator ====================
+
+Table::Iterator::Iterator(const Table* table)
+    : table_(table),
+      block_(0),
+      p_(nullptr),
+      limit_(nullptr),
+      value_(nullptr),
+      valueLen_(0),
+      expireAt_(0),
+      tombstone_(false),
+      valid_(false) {}
+
+void Table::Iterator::seekToFirst() {
+    enterBlock(0);
+}
+
+void Table::Iterator::seek(const std::string& target) {
+    enterBlock(table_->findBlock(target));
+    while (valid_ && key_ < target) {
+        next();
+    }
+}
+
+void Table::Iterator::next() {
+    if (p_ < limit_) {
+        parseEntry();
+    } else {
+        enterBlock(block_ + 1);
+    }
+}
+
+void Table::Iterator::enterBlock(size_t index) {
+    // 损坏的块整体跳过（已记录错误日志）
+    for (block_ = index; block_ < table_->index_.size(); block_++) {
+        if (table_->blockContents(block_, &p_, &limit_) && p_ < limit_) {
+            parseEntry();
+            return;
+        }
+    }
+    valid_ = false;
+}
+
+void Table::Iterator::parseEntry() {
+    Entry entry;
+    const char* next = decodeEntry(p_, limit_, table_->format_, &entry);
+    if (next == nullptr) {
+        LOG_ERROR << "Table " << table_->path_ << ": bad entry in block " << block_;
+        enterBlock(block_ + 1);
+        return;
+    }
+    p_ = next;
+    valid_ = true;
+    key_.assign(entry.key, entry.keyLen);
+    value_ = entry.value;
+    valueLen_ = entry.valueLen;
+    expireAt_ = entry.expireAt;
+    tombstone_ = entry.tombstone;
+}
+
+}  // namespace kvstore
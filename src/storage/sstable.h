@@ -0,0 +1,230 @@
+// src/storage/sstable.h
+#ifndef KVSTORE_STORAGE_SSTABLE_H
+#define KVSTORE_STORAGE_SSTABLE_H
+
+#include "base/noncopyable.h"
+#include "storage/value.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace kvstore {
+
+/**
+ * @brief SSTable 文件格式
+ *
+ * 不可变的有序表，保存一次 memtable 刷盘或一次合并的结果。整数均为小端。
+ *
+ *   [数据块] * N
+ *     entry = [keyLen varint32][valueTag varint32][expireAt u64][key][value]
+ *       valueTag = valueLen << 2 | hasExpiry << 1 | tombstone，墓碑没有 value，
+ *       没有过期时间时不写 expireAt（format 1 中 valueTag = valueLen << 1 | tombstone）
+ *     crc u32                                  (覆盖本块全部 entry)
+ *   [过滤块]   布隆过滤器（见 BloomFilter），覆盖所有 key
+ *   [索引块]
+ *     [lastKeyLen varint32][lastKey][offset u64][size u32] * N   (每个数据块一项)
+ *     crc u32
+ *   [文件尾 48 字节]
+ *     indexOffset u64 | filterOffset u64 | count u64
+ *     indexSize u32 | filterSize u32
+ *     footerCrc u32                            (覆盖前 32 字节)
+ *     format u32                               (entry 的编码版本，旧文件为 0，按 1 处理)
+ *     magic[8] = "RKVTABL\0"
+ *
+ * 数据块约 4KB，点查找只需在内存中的索引上二分、校验并解码一个块。
+ * 与快照（snapshot.h）不同，表中可以有墓碑：删除必须遮住更旧的表中的同一个 key。
+ */
+namespace table {
+
+const char kMagic[8] = {'R', 'K', 'V', 'T', 'A', 'B', 'L', '\0'};
+const size_t kFooterSize = 48;
+const size_t kBlockTrailerSize = 4;  // crc
+const uint32_t kFormat = 2;          // entry 带过期时间标志
+
+}  // namespace table
+
+/**
+ * @brief SSTable 写入器
+ *
+ * 使用示例：
+ *   TableBuilder builder(path, 10);
+ *   bool ok = builder.open();
+ *   for (...) ok = ok && builder.add(key, keyLen, value, valueLen, tombstone, expireAt);  // key 升序
+ *   ok = ok && builder.finish();  // 写入过滤块、索引块和文件尾，fsync 并关闭
+ */
+class TableBuilder : noncopyable {
+public:
+    static const size_t kBlockSize = 4 * 1024;
+    static const size_t kWriteBufferSize = 1024 * 1024;
+
+    /// bitsPerKey 为布隆过滤器每个 key 占用的位数
+    TableBuilder(const std::string& path, int bitsPerKey);
+
+    /// 未 finish 的文件会被关闭并删除
+    ~TableBuilder();
+
+    /// 创建（截断）文件
+    bool open();
+
+    /**
+     * @brief 追加一条记录，调用方保证 key 严格升序
+     * @param tombstone 是否为删除标记（value 被忽略）
+     * @param expireAt 绝对过期时刻（Unix 毫秒），0 表示不过期
+     * @return false 写文件失败
+     */
+    bool add(const char* key, size_t keyLen, const char* value, size_t valueLen, bool tombstone,
+             int64_t expireAt = 0);
+
+    /**
+     * @brief 封闭最后一个数据块，写入过滤块、索引块和文件尾
+     * @return true 文件已完整落盘
+     */
+    bool finish();
+
+    /// 已追加的记录数
+    uint64_t count() const { return count_; }
+
+    /// 文件大小，finish() 成功后有效
+    uint64_t fileSize() const { return fileOffset_; }
+
+private:
+    /// 封闭当前数据块：追加 crc，记录索引项
+    void finishBlock();
+
+    /// 把缓冲写入文件
+    bool flush();
+
+    const std::string path_;
+    const int bitsPerKey_;
+    int fd_;
+    std::string buffer_;    // 尚未写入文件的字节
+    uint64_t fileOffset_;   // buffer_ 开头在文件中的偏移
+    size_t blockStart_;     // 当前数据块在 buffer_ 中的位置
+    std::string lastKey_;   // 最近追加的 key
+    std::string index_;     // 已编码的索引项
+    std::vector<uint32_t> hashes_;  // 所有 key 的哈希，finish() 时构建过滤器
+    uint64_t count_;
+    bool finished_;
+};
+
+/**
+ * @brief 只读的 SSTable
+ *
+ * 整个文件只读 mmap，索引块解码到内存，过滤块直接引用映射。
+ * get 和迭代器都是只读的，可以在多个线程中同时使用。
+ * 取出的值拷贝到 Value 中，不引用映射：表在合并后会被删除。
+ */
+class Table : noncopyable {
+public:
+    /// 点查找的结果
+    enum class Lookup {
+        kNotFound,  // 表中没有这个 key，需要继续查更旧的表
+        kFound,     // 找到值
+        kDeleted,   // 表中是墓碑：key 已被删除，不用再查更旧的表
+    };
+
+    explicit Table(const std::string& path);
+    ~Table();
+
+    /**
+     * @brief 映射文件，校验文件尾并加载索引
+     * @return false 文件不存在或格式错误
+     */
+    bool open();
+
+    /// 查找 key，kFound 时 value 为它的值（带过期时间，过期与否由调用方判断）
+    Lookup get(const std::string& key, Value* value) const;
+
+    /// 布隆过滤器判断 key 是否可能在表中
+    bool mayContain(const std::string& key) const;
+
+    const std::string& path() const { return path_; }
+
+    /// 记录数（含墓碑）
+    uint64_t count() const { return count_; }
+
+    /// 文件大小
+    uint64_t fileSize() const { return size_; }
+
+    /// 有序迭代器（定义见类外）
+    class Iterator;
+
+private:
+    /// 一个数据块的索引项
+    struct IndexEntry {
+        std::string lastKey;  // 块中最后一个 key
+        uint64_t offset;
+        uint32_t size;        // 不含 crc
+    };
+
+    /// 第一个 lastKey >= key 的块，没有时返回块数
+    size_t findBlock(const std::string& key) const;
+
+    /// 校验第 index 个块，通过时返回它的 entry 范围
+    bool blockContents(size_t index, const char** begin, const char** end) const;
+
+    const std::string path_;
+    const char* data_;  // 文件映射，open() 成功后有效
+    size_t size_;
+    uint64_t count_;
+    const char* filter_;  // 过滤块，指向映射
+    size_t filterSize_;
+    uint32_t format_;     // entry 的编码版本
+    std::vector<IndexEntry> index_;
+};
+
+/**
+ * @brief Table 的有序迭代器，包含墓碑
+ *
+ * 使用示例：
+ *   Table::Iterator it(&table);
+ *   for (it.seekToFirst(); it.valid(); it.next()) {
+ *       if (!it.isTombstone()) use(it.key(), it.valueData(), it.valueSize());
+ *   }
+ */
+class Table::Iterator {
+public:
+    explicit Iterator(const Table* table);
+
+    bool valid() const { return valid_; }
+
+    /// 定位到第一条记录
+    void seekToFirst();
+
+    /// 定位到第一个 >= target 的 key
+    void seek(const std::string& target);
+
+    void next();
+
+    const std::string& key() const { return key_; }
+    const char* valueData() const { return value_; }
+    size_t valueSize() const { return valueLen_; }
+    bool isTombstone() const { return tombstone_; }
+
+    /// 过期时刻（Unix 毫秒），0 表示不过期
+    int64_t expireAt() const { return expireAt_; }
+
+private:
+    /// 从第 index 个块开始，定位到第一个能解码的块的第一条记录
+    void enterBlock(size_t index);
+
+    /// 解码 p_ 处的记录，块读完时进入下一个块
+    void parseEntry();
+
+    const Table* table_;
+    size_t block_;      // 当前块下标
+    const char* p_;     // 下一条记录的位置
+    const char* limit_; // 当前块的结尾
+    std::string key_;
+    const char* value_;
+    uint32_t valueLen_;
+    int64_t expireAt_;
+    bool tombstone_;
+    bool valid_;
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_SSTABLE_H
@@ -0,0 +1,352 @@
+// src/storage/table_set.cpp
+#include "storage/table_set.h"
+
+#include "base/logger.h"
+#include "base/timestamp.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <set>
+
+namespace kvstore {
+
+namespace {
+
+const char* kManifestName = "MANIFEST";
+const char* kManifestHeader = "RKVMANIFEST 1";
+const char* kTableSuffix = ".sst";
+
+/// 文件名为 "<编号>.sst" 时解析出编号
+bool parseTableName(const std::string& name, uint64_t* number) {
+    const size_t suffixLen = strlen(kTableSuffix);
+    if (name.size() <= suffixLen ||
+        name.compare(name.size() - suffixLen, suffixLen, kTableSuffix) != 0) {
+        return false;
+    }
+    uint64_t n = 0;
+    for (size_t i = 0; i < name.size() - suffixLen; i++) {
+        if (name[i] < '0' || name[i] > '9') {
+            return false;
+        }
+        n = n * 10 + static_cast<uint64_t>(name[i] - '0');
+    }
+    *number = n;
+    return true;
+}
+
+/// 目录项的创建、改名在 fsync 目录之后才持久
+void syncDir(const std::string& dir) {
+    int fd = ::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+}  // namespace
+
+TableSet::TableSet(const std::string& dir, const TableOptions& options)
+    : dir_(dir),
+      options_(options),
+      nextNumber_(1),
+      generation_(0),
+      compactions_(0),
+      tables_(std::make_shared<TableList>()) {}
+
+std::string TableSet::tablePath(uint64_t number) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%06llu%s", static_cast<unsigned long long>(number), kTableSuffix);
+    return dir_ + "/" + name;
+}
+
+bool TableSet::open() {
+    if (::mkdir(dir_.c_str(), 0755) < 0 && errno != EEXIST) {
+        LOG_ERROR << "TableSet mkdir " << dir_ << " failed: " << strerror(errno);
+        return false;
+    }
+
+    MutexLockGuard lock(manifestMutex_);
+    std::vector<uint64_t> numbers;
+    std::ifstream manifest(dir_ + "/" + kManifestName);
+    if (manifest.is_open()) {
+        std::string header;
+        std::string key;
+        std::getline(manifest, header);
+        if (header != kManifestHeader || !(manifest >> key >> nextNumber_) || key != "next") {
+            LOG_ERROR << "TableSet " << dir_ << ": bad MANIFEST";
+            return false;
+        }
+        uint64_t number;
+        while (manifest >> number) {
+            numbers.push_back(number);
+        }
+    }
+
+    std::shared_ptr<TableList> tables = std::make_shared<TableList>();
+    for (uint64_t number : numbers) {
+        std::shared_ptr<Table> table = std::make_shared<Table>(tablePath(number));
+        if (!table->open()) {
+            LOG_ERROR << "TableSet " << dir_ << ": table " << number << " listed in MANIFEST "
+                      << "cannot be opened";
+            return false;
+        }
+        tables->push_back(table);
+        nextNumber_ = std::max(nextNumber_, number + 1);
+    }
+
+    // 刷盘或合并写到一半崩溃留下的文件
+    std::set<uint64_t> live(numbers.begin(), numbers.end());
+    if (DIR* d = ::opendir(dir_.c_str())) {
+        while (struct dirent* entry = ::readdir(d)) {
+            uint64_t number;
+            if (parseTableName(entry->d_name, &number) && live.count(number) == 0) {
+                LOG_WARN << "TableSet " << dir_ << ": removing unlisted table " << entry->d_name;
+                ::unlink((dir_ + "/" + entry->d_name).c_str());
+                nextNumber_ = std::max(nextNumber_, number + 1);
+            }
+        }
+        ::closedir(d);
+    }
+
+    install(tables, numbers);
+    LOG_INFO << "TableSet opened " << dir_ << " with " << numbers.size() << " tables";
+    return true;
+}
+
+TableSet::TableListPtr TableSet::current() const {
+    MutexLockGuard lock(mutex_);
+    return tables_;
+}
+
+Table::Lookup TableSet::get(const std::string& key, Value* value) const {
+    TableListPtr tables = current();
+    for (const TablePtr& table : *tables) {
+        Table::Lookup result = table->get(key, value);
+        if (result != Table::Lookup::kNotFound) {
+            return result;
+        }
+    }
+    return Table::Lookup::kNotFound;
+}
+
+bool TableSet::mayContain(const std::string& key) const {
+    TableListPtr tables = current();
+    for (const TablePtr& table : *tables) {
+        if (table->mayContain(key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string TableSet::newTablePath(uint64_t* number) {
+    MutexLockGuard lock(manifestMutex_);
+    *number = nextNumber_++;
+    return tablePath(*number);
+}
+
+TableSet::TablePtr TableSet::addTable(uint64_t number, uint64_t generation) {
+    std::shared_ptr<Table> table = std::make_shared<Table>(tablePath(number));
+    if (!table->open()) {
+        ::unlink(tablePath(number).c_str());
+        return nullptr;
+    }
+
+    MutexLockGuard lock(manifestMutex_);
+    if (generation != generation_.load(std::memory_order_relaxed)) {
+        LOG_INFO << "TableSet " << dir_ << ": cleared while writing table " << number
+                 << ", discarded";
+        ::unlink(tablePath(number).c_str());
+        return nullptr;
+    }
+    std::vector<uint64_t> numbers;
+    numbers.reserve(numbers_.size() + 1);
+    numbers.push_back(number);
+    numbers.insert(numbers.end(), numbers_.begin(), numbers_.end());
+    if (!writeManifest(numbers)) {
+        ::unlink(tablePath(number).c_str());
+        return nullptr;
+    }
+
+    std::shared_ptr<TableList> tables = std::make_shared<TableList>();
+    tables->push_back(table);
+    TableListPtr old = current();
+    tables->insert(tables->end(), old->begin(), old->end());
+    install(tables, numbers);
+    return table;
+}
+
+bool TableSet::needsCompaction() const {
+    return options_.compactionTrigger > 0 &&
+           tableCount() >= static_cast<size_t>(options_.compactionTrigger);
+}
+
+bool TableSet::compact() {
+    TableListPtr inputs = current();
+    const uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (inputs->size() < 2) {
+        return true;
+    }
+
+    uint64_t number;
+    std::string path = newTablePath(&number);
+    TableBuilder builder(path, options_.bloomBitsPerKey);
+    bool ok = builder.open();
+
+    // 多路归并：堆顶是最小的 key，key 相同时下标小（更新）的表在前
+    std::vector<std::unique_ptr<Table::Iterator>> iters;
+    for (const TablePtr& table : *inputs) {
+        iters.emplace_back(new Table::Iterator(table.get()));
+        iters.back()->seekToFirst();
+    }
+    auto greater = [&iters](size_t a, size_t b) {
+        int cmp = iters[a]->key().compare(iters[b]->key());
+        return cmp != 0 ? cmp > 0 : a > b;
+    };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heap(greater);
+    for (size_t i = 0; i < iters.size(); i++) {
+        if (iters[i]->valid()) {
+            heap.push(i);
+        }
+    }
+    const int64_t nowMs = Timestamp::now().microSecondsSinceEpoch() / 1000;
+    std::string key;
+    while (ok && !heap.empty()) {
+        size_t top = heap.top();
+        heap.pop();
+        Table::Iterator* it = iters[top].get();
+        key = it->key();
+        // 合并的是全部的表，墓碑和已经过期的值之下没有更旧的数据，不用再保留
+        const int64_t expireAt = it->expireAt();
+        if (!it->isTombstone() && (expireAt == 0 || expireAt > nowMs)) {
+            ok = builder.add(key.data(), key.size(), it->valueData(), it->valueSize(), false,
+                             expireAt);
+        }
+        it->next();
+        if (it->valid()) {
+            heap.push(top);
+        }
+        // 更旧的表中同一个 key 的记录被遮住
+        while (!heap.empty() && iters[heap.top()]->key() == key) {
+            size_t older = heap.top();
+            heap.pop();
+            iters[older]->next();
+            if (iters[older]->valid()) {
+                heap.push(older);
+            }
+        }
+    }
+    const bool empty = builder.count() == 0;
+    ok = ok && builder.finish();
+    iters.clear();
+    if (!ok) {
+        LOG_ERROR << "TableSet " << dir_ << ": compaction failed";
+        return false;
+    }
+
+    std::shared_ptr<Table> merged;
+    if (!empty) {
+        merged = std::make_shared<Table>(path);
+        if (!merged->open()) {
+            ::unlink(path.c_str());
+            return false;
+        }
+    } else {
+        ::unlink(path.c_str());  // 所有记录都被删除了
+    }
+
+    std::vector<std::string> obsolete;
+    {
+        MutexLockGuard lock(manifestMutex_);
+        if (generation != generation_.load(std::memory_order_relaxed)) {
+            ::unlink(path.c_str());
+            return true;
+        }
+        // 合并期间新登记的表排在前面，输入的表是列表末尾的 inputs->size() 个
+        TableListPtr old = current();
+        const size_t newer = old->size() - inputs->size();
+        std::shared_ptr<TableList> tables =
+            std::make_shared<TableList>(old->begin(), old->begin() + newer);
+        std::vector<uint64_t> numbers(numbers_.begin(), numbers_.begin() + newer);
+        for (size_t i = newer; i < numbers_.size(); i++) {
+            obsolete.push_back(tablePath(numbers_[i]));
+        }
+        if (merged) {
+            tables->push_back(merged);
+            numbers.push_back(number);
+        }
+        if (!writeManifest(numbers)) {
+            ::unlink(path.c_str());
+            return false;
+        }
+        // 先计数再替换：看到表数减少的线程也能看到这次合并
+        compactions_.fetch_add(1, std::memory_order_relaxed);
+        install(tables, numbers);
+    }
+
+    // 已经从 MANIFEST 中移除，仍在使用这些表的读者持有映射，删除文件不影响它们
+    for (const std::string& file : obsolete) {
+        ::unlink(file.c_str());
+    }
+    LOG_INFO << "TableSet " << dir_ << ": compacted " << inputs->size() << " tables into "
+             << (merged ? builder.count() : 0) << " keys";
+    return true;
+}
+
+void TableSet::clear() {
+    std::vector<std::string> obsolete;
+    {
+        MutexLockGuard lock(manifestMutex_);
+        generation_.fetch_add(1, std::memory_order_acq_rel);
+        for (uint64_t number : numbers_) {
+            obsolete.push_back(tablePath(number));
+        }
+        writeManifest(std::vector<uint64_t>());
+        install(std::make_shared<TableList>(), std::vector<uint64_t>());
+    }
+    for (const std::string& file : obsolete) {
+        ::unlink(file.c_str());
+    }
+}
+
+bool TableSet::writeManifest(const std::vector<uint64_t>& numbers) {
+    const std::string path = dir_ + "/" + kManifestName;
+    const std::string tmpPath = path + ".tmp";
+    std::string content = std::string(kManifestHeader) + "\nnext " + std::to_string(nextNumber_) + "\n";
+    for (uint64_t number : numbers) {
+        content += std::to_string(number) + "\n";
+    }
+
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool ok = fd >= 0 &&
+              ::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()) &&
+              ::fsync(fd) == 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    ok = ok && ::rename(tmpPath.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        LOG_ERROR << "TableSet write " << path << " failed: " << strerror(errno);
+        ::unlink(tmpPath.c_str());
+        return false;
+    }
+    syncDir(dir_);
+    return true;
+}
+
+void TableSet::install(TableListPtr tables, std::vector<uint64_t> numbers) {
+    numbers_ = std::move(numbers);
+    MutexLockGuard lock(mutex_);
+    tables_ = std::move(tables);
+}
+
+}  // namespace kvstore
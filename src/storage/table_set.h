@@ -0,0 +1,133 @@
+// src/storage/table_set.h
+#ifndef KVSTORE_STORAGE_TABLE_SET_H
+#define KVSTORE_STORAGE_TABLE_SET_H
+
+#include "base/mutex.h"
+#include "storage/sstable.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace kvstore {
+
+/**
+ * @brief 磁盘层配置
+ */
+struct TableOptions {
+    size_t memtableBytes = 64 * 1024 * 1024;  // memtable 超过这个大小（近似）后刷成一个表
+    int compactionTrigger = 4;                // 表的个数达到后在后台合并
+    int bloomBitsPerKey = 10;                 // 布隆过滤器每个 key 的位数
+};
+
+/**
+ * @brief 一个目录下的全部 SSTable
+ *
+ * 表按新旧排列，查找从最新的表开始，第一个包含该 key 的表（值或墓碑）决定结果。
+ * 表的集合保存在目录下的 MANIFEST 中，每次变化都写临时文件再原子替换：
+ * 刷盘或合并写到一半崩溃时，没有登记的 .sst 文件在下次 open() 时删除。
+ *
+ * MANIFEST 格式（文本）：
+ *   RKVMANIFEST 1
+ *   next <下一个文件编号>
+ *   <文件编号>       (每行一个，从新到旧)
+ *
+ * 合并（compact）把当前所有的表归并成一个：同一个 key 只保留最新的版本，
+ * 墓碑和已经过期的值之下已经没有更旧的数据，直接丢弃。合并期间新刷出的表排在结果前面。
+ *
+ * 线程安全：current()/get() 可以在任意线程调用，只在复制表列表的指针时短暂加锁；
+ * 修改表集合的操作（addTable/compact/clear）由内部的锁串行化，写 MANIFEST 时不阻塞读者。
+ */
+class TableSet : noncopyable {
+public:
+    using TablePtr = std::shared_ptr<const Table>;
+    using TableList = std::vector<TablePtr>;  // 从新到旧
+    using TableListPtr = std::shared_ptr<const TableList>;
+
+    TableSet(const std::string& dir, const TableOptions& options);
+
+    /**
+     * @brief 创建目录（不存在时），按 MANIFEST 打开所有表，删除没有登记的表文件
+     * @return false 目录无法创建，或 MANIFEST 登记的表无法打开
+     */
+    bool open();
+
+    const std::string& dir() const { return dir_; }
+    const TableOptions& options() const { return options_; }
+
+    /// 当前的表列表（从新到旧），持有期间表不会被关闭
+    TableListPtr current() const;
+
+    /// 表的个数
+    size_t tableCount() const { return current()->size(); }
+
+    /**
+     * @brief 从最新的表开始查找 key
+     * @return kFound 找到值；kDeleted 最新的记录是墓碑；kNotFound 所有表中都没有
+     */
+    Table::Lookup get(const std::string& key, Value* value) const;
+
+    /// 是否有表的布隆过滤器认为 key 可能在其中（只查过滤器，不读数据块）
+    bool mayContain(const std::string& key) const;
+
+    /**
+     * @brief 分配一个新的表文件
+     * @param number 输出文件编号，写完后传给 addTable
+     * @return 文件路径
+     */
+    std::string newTablePath(uint64_t* number);
+
+    /// clear() 的次数，addTable 用它判断写表期间数据是否被清空
+    uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief 把写好的表登记为最新的表
+     *
+     * 写表期间发生过 clear()（generation 变了）时表中是被清空之前的数据，
+     * 丢弃文件并返回 nullptr。
+     */
+    TablePtr addTable(uint64_t number, uint64_t generation);
+
+    /// 表的个数是否达到了合并的阈值
+    bool needsCompaction() const;
+
+    /**
+     * @brief 把当前所有的表合并成一个
+     * @return false 写文件失败（原有的表保持不变）
+     */
+    bool compact();
+
+    /// 删除所有的表
+    void clear();
+
+    /// 合并的次数（统计用）
+    uint64_t compactions() const { return compactions_.load(std::memory_order_relaxed); }
+
+private:
+    std::string tablePath(uint64_t number) const;
+
+    /// 用 numbers（从新到旧）替换 MANIFEST，调用方持有 manifestMutex_
+    bool writeManifest(const std::vector<uint64_t>& numbers);
+
+    /// 替换表列表，调用方持有 manifestMutex_
+    void install(TableListPtr tables, std::vector<uint64_t> numbers);
+
+    const std::string dir_;
+    const TableOptions options_;
+
+    MutexLock manifestMutex_;          // 串行化对表集合的修改
+    uint64_t nextNumber_;              // manifestMutex_ 保护
+    std::vector<uint64_t> numbers_;    // 与表列表一一对应，manifestMutex_ 保护
+    std::atomic<uint64_t> generation_;
+    std::atomic<uint64_t> compactions_;
+
+    mutable MutexLock mutex_;  // 只保护 tables_ 指针本身
+    TableListPtr tables_;
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_TABLE_SET_H
@@ -0,0 +1,111 @@
+// src/storage/value.cpp
+#include "storage/value.h"
+
+#include <new>
+
+namespace kvstore {
+
+constexpr size_t Value::kInlineCapacity;
+
+Value::Value(const char* data, size_t len) {
+    if (len <= kInlineCapacity) {
+        memcpy(rep_, data, len);
+        setTag(static_cast<uint8_t>(len));
+        return;
+    }
+    initBlob(data, len);
+}
+
+void Value::initBlob(const char* data, size_t len) {
+    void* mem = ::operator new(offsetof(Blob, data) + len);
+    Blob* b = static_cast<Blob*>(mem);
+    new (&b->refs) std::atomic<uint32_t>(1);
+    memcpy(b->data, data, len);
+    setPointer(b->data, len, kBlobTag);
+}
+
+Value Value::reference(const char* data, size_t len) {
+    if (len <= kInlineCapacity) {
+        return Value(data, len);
+    }
+    Value value;
+    value.setPointer(data, len, kExternalTag);
+    return value;
+}
+
+Value Value::tombstone() {
+    Value value;
+    value.setPointer("", 0, kTombstoneTag);
+    return value;
+}
+
+Value Value::withExpiry(int64_t expireAtMs) const {
+    if (expireAtMs == 0) {
+        // 去掉过期时间：短值回到内联表示
+        if (isInline() || (hasBlob() && size() <= kInlineCapacity)) {
+            return Value(data(), size());
+        }
+        Value value(*this);
+        memset(value.rep_ + kExpiryOffset, 0, kExpiryBytes);
+        return value;
+    }
+    Value value;
+    if (isInline()) {
+        value.initBlob(data(), size());
+    } else {
+        value = *this;
+    }
+    uint64_t ms = static_cast<uint64_t>(expireAtMs);
+    memcpy(value.rep_ + kExpiryOffset, &ms, kExpiryBytes);
+    return value;
+}
+
+Value::Value(const Value& other) noexcept {
+    memcpy(rep_, other.rep_, sizeof(rep_));
+    if (hasBlob()) {
+        blob()->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Value::Value(Value&& other) noexcept {
+    memcpy(rep_, other.rep_, sizeof(rep_));
+    other.setTag(0);
+}
+
+Value& Value::operator=(const Value& other) noexcept {
+    if (this != &other) {
+        // 先加后减：other 与 *this 共享同一个 Blob 时也不会提前释放
+        if (other.hasBlob()) {
+            other.blob()->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        memcpy(rep_, other.rep_, sizeof(rep_));
+    }
+    return *this;
+}
+
+Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        release();
+        memcpy(rep_, other.rep_, sizeof(rep_));
+        other.setTag(0);
+    }
+    return *this;
+}
+
+size_t Value::heapBytes() const {
+    return hasBlob() ? offsetof(Blob, data) + length() : 0;
+}
+
+void Value::release() noexcept {
+    if (!hasBlob()) {
+        return;
+    }
+    Blob* b = blob();
+    // acq_rel：最后一个持有者释放前，其他持有者对 Blob 的读取都已完成
+    if (b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        ::operator delete(b);
+    }
+}
+
+}  // namespace kvstore
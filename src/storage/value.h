@@ -0,0 +1,177 @@
+// src/storage/value.h
+#ifndef KVSTORE_STORAGE_VALUE_H
+#define KVSTORE_STORAGE_VALUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace kvstore {
+
+/**
+ * @brief 紧凑的值表示：小值内联，大值引用计数共享
+ *
+ * 固定占用 24 字节（std::string 为 32 字节）：
+ * - 长度 <= kInlineCapacity（23 字节）的值直接存放在对象内部，构造和拷贝都不分配内存
+ * - 更长的值放在堆上的 Blob 中，对象内只保存指针；拷贝只增加引用计数，
+ *   最后一个持有者析构时释放
+ * - reference() 构造的长值直接引用外部内存（如快照文件的映射），不分配、不计数，
+ *   由调用方保证外部内存比所有副本活得久
+ *
+ * Blob 创建后内容不可变，多个线程可以同时持有同一个 Blob 的 Value，
+ * 引用计数是原子的。单个 Value 对象本身不是线程安全的。
+ *
+ * 跳表节点存放 Value，GET 把节点上的 Value 拷贝给调用方：小值是一次 24 字节的
+ * 内存拷贝，大值是一次原子加，都不分配内存；调用方通过 data()/size() 直接读取内容，
+ * 不需要再拷贝出一个 std::string。
+ *
+ * 过期时间（TTL）：非内联表示的 rep_[16..22] 原本空闲，用来保存 56 位的绝对过期时刻
+ * （Unix 毫秒），节点不因 TTL 多占一个字节。设置了过期时间的短值改用 Blob 存放，
+ * 过期与否由读者按当前时间判断（见 expiredAt()）。
+ *
+ * 内存布局：rep_[0..22] 为内联数据，rep_[23] 为标签（内联长度、kBlobTag、kExternalTag 或 kTombstoneTag）；
+ * 非内联时 rep_[0..7] 保存数据指针，rep_[8..15] 保存长度，rep_[16..22] 保存过期时刻（0 表示不过期），
+ * 读取 data()/size() 不需要访问 Blob 本身；Blob 的地址由数据指针倒推。
+ */
+class Value {
+public:
+    static constexpr size_t kInlineCapacity = 23;
+
+    /// 空值
+    Value() noexcept { setTag(0); }
+
+    Value(const char* data, size_t len);
+
+    explicit Value(const std::string& str) : Value(str.data(), str.size()) {}
+
+    /**
+     * @brief 引用 [data, data + len) 而不拷贝（短值仍然内联拷贝）
+     *
+     * 拷贝得到的 Value 同样引用这段内存；调用方保证它在所有副本析构之前有效且不被修改。
+     */
+    static Value reference(const char* data, size_t len);
+
+    /**
+     * @brief 删除标记（空内容）
+     *
+     * 开启磁盘层时 DEL 不能直接摘除 memtable 中的 key：更旧的 SSTable 里可能还有它，
+     * 写入墓碑把它们遮住，刷盘时墓碑也写进表中。
+     */
+    static Value tombstone();
+
+    /**
+     * @brief 带过期时刻的副本，内容与本值相同
+     * @param expireAtMs 绝对过期时刻（Unix 毫秒），0 表示去掉过期时间
+     */
+    Value withExpiry(int64_t expireAtMs) const;
+
+    /// 过期时刻（Unix 毫秒），没有设置时为 0
+    int64_t expireAt() const {
+        if (isInline()) {
+            return 0;
+        }
+        uint64_t ms = 0;
+        memcpy(&ms, rep_ + kExpiryOffset, kExpiryBytes);  // 小端
+        return static_cast<int64_t>(ms);
+    }
+
+    /// 在 nowMs 时刻是否已经过期
+    bool expiredAt(int64_t nowMs) const {
+        int64_t at = expireAt();
+        return at != 0 && at <= nowMs;
+    }
+
+    Value(const Value& other) noexcept;
+    Value(Value&& other) noexcept;
+    Value& operator=(const Value& other) noexcept;
+    Value& operator=(Value&& other) noexcept;
+
+    ~Value() { release(); }
+
+    const char* data() const { return isInline() ? rep_ : pointer(); }
+    size_t size() const { return isInline() ? tag() : length(); }
+    bool empty() const { return size() == 0; }
+
+    /// 是否内联存储（没有堆上的 Blob，也不引用外部内存）
+    bool isInline() const { return tag() <= kInlineCapacity; }
+
+    /// 是否引用外部内存（见 reference()）
+    bool isExternal() const { return tag() == kExternalTag; }
+
+    /// 是否为删除标记（见 tombstone()）
+    bool isTombstone() const { return tag() == kTombstoneTag; }
+
+    /// 拷贝出 std::string
+    std::string toString() const { return std::string(data(), size()); }
+
+    /// 堆上额外占用的字节数（内联值为 0）
+    size_t heapBytes() const;
+
+    bool operator==(const Value& other) const {
+        return size() == other.size() && memcmp(data(), other.data(), size()) == 0;
+    }
+    bool operator!=(const Value& other) const { return !(*this == other); }
+
+private:
+    /// 大值的共享存储，按实际长度变长分配（长度保存在 Value 里）
+    struct Blob {
+        std::atomic<uint32_t> refs;
+        char data[1];
+    };
+
+    static constexpr size_t kTagOffset = kInlineCapacity;
+    static constexpr size_t kExpiryOffset = 16;
+    static constexpr size_t kExpiryBytes = kTagOffset - kExpiryOffset;  // 7 字节，约 228 万年
+    static constexpr uint8_t kBlobTag = 0xFF;
+    static constexpr uint8_t kExternalTag = 0xFE;
+    static constexpr uint8_t kTombstoneTag = 0xFD;
+
+    uint8_t tag() const { return static_cast<uint8_t>(rep_[kTagOffset]); }
+    void setTag(uint8_t tag) { rep_[kTagOffset] = static_cast<char>(tag); }
+
+    /// 是否持有 Blob 的引用
+    bool hasBlob() const { return tag() == kBlobTag; }
+
+    /// 非内联值的数据指针和长度
+    const char* pointer() const {
+        const char* p;
+        memcpy(&p, rep_, sizeof(p));
+        return p;
+    }
+    size_t length() const {
+        size_t n;
+        memcpy(&n, rep_ + sizeof(const char*), sizeof(n));
+        return n;
+    }
+    void setPointer(const char* p, size_t n, uint8_t tag) {
+        memcpy(rep_, &p, sizeof(p));
+        memcpy(rep_ + sizeof(p), &n, sizeof(n));
+        memset(rep_ + kExpiryOffset, 0, kExpiryBytes);
+        setTag(tag);
+    }
+
+    /// 把 [data, data + len) 拷贝到新的 Blob 中并引用它
+    void initBlob(const char* data, size_t len);
+
+    Blob* blob() const {
+        return reinterpret_cast<Blob*>(const_cast<char*>(pointer()) - offsetof(Blob, data));
+    }
+
+    /// 释放持有的 Blob 引用，之后对象处于未定义内容，需要重新赋值
+    void release() noexcept;
+
+    alignas(8) char rep_[kInlineCapacity + 1];
+};
+
+static_assert(sizeof(Value) == 24, "Value should stay three words wide");
+
+inline std::ostream& operator<<(std::ostream& out, const Value& value) {
+    return out.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_VALUE_H
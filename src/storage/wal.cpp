@@ -0,0 +1,416 @@
+// src/storage/wal.cpp
+#include "storage/wal.h"
+
+#include "base/coding.h"
+#include "base/crc32c.h"
+#include "base/logger.h"
+#include "base/timestamp.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <iterator>
+
+namespace kvstore {
+
+namespace {
+
+/// 解码 payload，格式不合法返回 false
+bool decodeRecord(WalRecordType type, const char* p, size_t n, WalRecord* record) {
+    record->type = type;
+    record->expireAt = 0;
+    switch (type) {
+        case WalRecordType::kPut: {
+            if (n < 4) {
+                return false;
+            }
+            uint32_t keyLen = decodeFixed32(p);
+            if (keyLen > n - 4) {
+                return false;
+            }
+            record->key.assign(p + 4, keyLen);
+            record->value.assign(p + 4 + keyLen, n - 4 - keyLen);
+            return true;
+        }
+        case WalRecordType::kDel:
+            record->key.assign(p, n);
+            return true;
+        case WalRecordType::kClear:
+            return n == 0;
+        case WalRecordType::kClearShard:
+            if (n != 8) {
+                return false;
+            }
+            record->shard = decodeFixed32(p);
+            record->shards = decodeFixed32(p + 4);
+            return record->shards > 0;
+        case WalRecordType::kPutExpire:
+            if (n < 8 || !decodeRecord(WalRecordType::kPut, p + 8, n - 8, record)) {
+                return false;
+            }
+            record->type = WalRecordType::kPutExpire;
+            record->expireAt = static_cast<int64_t>(decodeFixed64(p));
+            return true;
+        case WalRecordType::kExpire:
+            if (n < 8) {
+                return false;
+            }
+            record->expireAt = static_cast<int64_t>(decodeFixed64(p));
+            record->key.assign(p + 8, n - 8);
+            return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string& path, const WalOptions& options)
+    : path_(path),
+      rotatedPath_(path + ".old"),
+      options_(options),
+      fd_(-1),
+      fileSize_(0),
+      mutex_(),
+      flushCond_(mutex_),
+      doneCond_(mutex_),
+      appendedLsn_(0),
+      durableLsn_(0),
+      syncCount_(0),
+      failed_(false),
+      running_(false),
+      rotateRequested_(false),
+      rotateOk_(false) {}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+size_t WriteAheadLog::replay(const ReplayCallback& callback) {
+    size_t count = replayFile(rotatedPath_, false, callback);
+    count += replayFile(path_, true, callback);
+    return count;
+}
+
+size_t WriteAheadLog::replayFile(const std::string& file, bool truncateTail,
+                                 const ReplayCallback& callback) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open()) {
+        return 0;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    size_t count = 0;
+    size_t offset = 0;
+    WalRecord record;
+    while (data.size() - offset >= kHeaderSize) {
+        const char* p = data.data() + offset;
+        uint32_t crc = decodeFixed32(p);
+        uint32_t length = decodeFixed32(p + 4);
+        if (length == 0 || length > data.size() - offset - 8) {
+            break;
+        }
+        if (crc32c::value(p + 8, length) != crc ||
+            !decodeRecord(static_cast<WalRecordType>(p[8]), p + kHeaderSize, length - 1,
+                          &record)) {
+            break;
+        }
+        callback(record);
+        count++;
+        offset += 8 + length;
+    }
+
+    if (offset < data.size()) {
+        LOG_WARN << "WAL " << file << ": dropping " << data.size() - offset
+                 << " bytes of incomplete or corrupt records at offset " << offset;
+        if (truncateTail && ::truncate(file.c_str(), static_cast<off_t>(offset)) != 0) {
+            LOG_ERROR << "WAL truncate " << file << " failed: " << strerror(errno);
+        }
+    }
+    LOG_INFO << "WAL replayed " << count << " records from " << file;
+    return count;
+}
+
+bool WriteAheadLog::open() {
+    fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOG_ERROR << "WAL open " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) {
+        LOG_ERROR << "WAL stat " << path_ << " failed: " << strerror(errno);
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    fileSize_ = static_cast<uint64_t>(st.st_size);
+
+    running_ = true;
+    thread_.reset(new Thread(std::bind(&WriteAheadLog::flushLoop, this), "WalFlusher"));
+    thread_->start();
+    return true;
+}
+
+void WriteAheadLog::close() {
+    if (!thread_) {
+        return;
+    }
+    {
+        MutexLockGuard lock(mutex_);
+        running_ = false;
+        flushCond_.notify();
+    }
+    thread_->join();
+    thread_.reset();
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+uint64_t WriteAheadLog::appendPut(const std::string& key, const char* value, size_t valueLen,
+                                  int64_t expireAt) {
+    std::string keyPart;
+    keyPart.reserve(12 + key.size());
+    if (expireAt != 0) {
+        putFixed64(&keyPart, static_cast<uint64_t>(expireAt));
+    }
+    putFixed32(&keyPart, static_cast<uint32_t>(key.size()));
+    keyPart.append(key);
+    return append(expireAt != 0 ? WalRecordType::kPutExpire : WalRecordType::kPut,
+                  keyPart.data(), keyPart.size(), value, valueLen);
+}
+
+uint64_t WriteAheadLog::appendExpire(const std::string& key, int64_t expireAt) {
+    std::string payload;
+    payload.reserve(8 + key.size());
+    putFixed64(&payload, static_cast<uint64_t>(expireAt));
+    payload.append(key);
+    return append(WalRecordType::kExpire, payload.data(), payload.size(), nullptr, 0);
+}
+
+uint64_t WriteAheadLog::appendDel(const std::string& key) {
+    return append(WalRecordType::kDel, key.data(), key.size(), nullptr, 0);
+}
+
+uint64_t WriteAheadLog::appendClear() {
+    return append(WalRecordType::kClear, nullptr, 0, nullptr, 0);
+}
+
+uint64_t WriteAheadLog::appendClearShard(uint32_t shard, uint32_t shards) {
+    std::string payload;
+    putFixed32(&payload, shard);
+    putFixed32(&payload, shards);
+    return append(WalRecordType::kClearShard, payload.data(), payload.size(), nullptr, 0);
+}
+
+uint64_t WriteAheadLog::append(WalRecordType type, const char* payload1, size_t len1,
+                               const char* payload2, size_t len2) {
+    // 校验和在锁外计算
+    const char typeByte = static_cast<char>(type);
+    uint32_t crc = crc32c::value(&typeByte, 1);
+    crc = crc32c::extend(crc, payload1, len1);
+    crc = crc32c::extend(crc, payload2, len2);
+
+    MutexLockGuard lock(mutex_);
+    putFixed32(&buffer_, crc);
+    putFixed32(&buffer_, static_cast<uint32_t>(1 + len1 + len2));
+    buffer_.push_back(typeByte);
+    buffer_.append(payload1, len1);
+    buffer_.append(payload2, len2);
+    if (buffer_.size() >= kMaxBufferBytes) {
+        flushCond_.notify();
+    }
+    return ++appendedLsn_;
+}
+
+bool WriteAheadLog::sync() {
+    MutexLockGuard lock(mutex_);
+    if (options_.syncPolicy == WalSyncPolicy::kAlways) {
+        uint64_t target = appendedLsn_;
+        while (durableLsn_ < target && running_ && !failed_) {
+            flushCond_.notify();
+            doneCond_.wait();
+        }
+    }
+    return !failed_;
+}
+
+bool WriteAheadLog::rotate() {
+    MutexLockGuard lock(mutex_);
+    if (!running_) {
+        return false;
+    }
+    rotateRequested_ = true;
+    flushCond_.notify();
+    while (rotateRequested_) {
+        doneCond_.wait();
+    }
+    return rotateOk_;
+}
+
+void WriteAheadLog::removeRotated() {
+    if (::unlink(rotatedPath_.c_str()) != 0 && errno != ENOENT) {
+        LOG_ERROR << "WAL unlink " << rotatedPath_ << " failed: " << strerror(errno);
+    }
+}
+
+uint64_t WriteAheadLog::appendedLsn() const {
+    MutexLockGuard lock(mutex_);
+    return appendedLsn_;
+}
+
+uint64_t WriteAheadLog::syncCount() const {
+    MutexLockGuard lock(mutex_);
+    return syncCount_;
+}
+
+bool WriteAheadLog::failed() const {
+    MutexLockGuard lock(mutex_);
+    return failed_;
+}
+
+void WriteAheadLog::flushLoop() {
+    const bool always = options_.syncPolicy == WalSyncPolicy::kAlways;
+    const double interval = (options_.syncIntervalMs > 0 ? options_.syncIntervalMs : 1) / 1000.0;
+    std::string pending;
+    Timestamp lastSync = Timestamp::now();
+
+    while (true) {
+        uint64_t lsn;
+        bool rotate;
+        bool stop;
+        bool ok;
+        {
+            MutexLockGuard lock(mutex_);
+            if (always) {
+                // 等有人调用 sync()（或缓冲过大）再刷，一次刷掉期间所有线程追加的记录
+                while (running_ && !rotateRequested_ && buffer_.empty()) {
+                    flushCond_.wait();
+                }
+            } else if (running_ && !rotateRequested_ && buffer_.size() < kMaxBufferBytes) {
+                flushCond_.waitForSeconds(interval);
+            }
+            pending.swap(buffer_);
+            lsn = appendedLsn_;
+            rotate = rotateRequested_;
+            stop = !running_;
+            ok = !failed_;
+        }
+
+        // 失败之后的记录不再写入：它们之前可能缺了记录，重放出来的状态不一致
+        ok = ok && (pending.empty() || writeAll(pending));
+        pending.clear();
+
+        Timestamp now = Timestamp::now();
+        bool needSync = always || stop || rotate ||
+                        (options_.syncPolicy == WalSyncPolicy::kInterval &&
+                         timeDifference(now, lastSync) >= interval);
+        if (ok && needSync && options_.syncPolicy != WalSyncPolicy::kNever) {
+            ok = syncFile();
+            lastSync = now;
+        }
+        bool rotated = rotate && ok && rotateFile();
+
+        {
+            MutexLockGuard lock(mutex_);
+            if (ok) {
+                durableLsn_ = lsn;
+            } else {
+                // 不推进 durableLsn_：等待中的 sync() 看到失败状态后返回 false
+                failed_ = true;
+            }
+            if (rotate) {
+                rotateOk_ = rotated;
+                rotateRequested_ = false;
+            }
+            doneCond_.notifyAll();
+        }
+        if (stop) {
+            break;
+        }
+    }
+}
+
+bool WriteAheadLog::rotateFile() {
+    // 文件已经 fdatasync，换下的旧文件内容完整
+    if (::access(rotatedPath_.c_str(), F_OK) == 0) {
+        // 上次快照失败留下的旧文件还在：把当前文件接到它后面，再清空当前文件
+        std::ifstream in(path_, std::ios::binary);
+        std::ofstream out(rotatedPath_, std::ios::binary | std::ios::app);
+        out << in.rdbuf();
+        out.flush();
+        if (!out) {
+            LOG_ERROR << "WAL append " << path_ << " to " << rotatedPath_ << " failed";
+            return false;
+        }
+        out.close();
+        int oldFd = ::open(rotatedPath_.c_str(), O_WRONLY | O_CLOEXEC);
+        if (oldFd >= 0) {
+            ::fdatasync(oldFd);
+            ::close(oldFd);
+        }
+        if (::ftruncate(fd_, 0) != 0) {
+            LOG_ERROR << "WAL truncate " << path_ << " failed: " << strerror(errno);
+            return false;
+        }
+        fileSize_ = 0;
+        return true;
+    }
+
+    if (::rename(path_.c_str(), rotatedPath_.c_str()) != 0) {
+        LOG_ERROR << "WAL rename " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    int fd = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR << "WAL reopen " << path_ << " failed: " << strerror(errno);
+        return false;
+    }
+    ::close(fd_);
+    fd_ = fd;
+    fileSize_ = 0;
+    return true;
+}
+
+bool WriteAheadLog::writeAll(const std::string& data) {
+    const char* p = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        ssize_t n = ::write(fd_, p, remaining);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR << "WAL write " << path_ << " failed: " << strerror(errno);
+            // 截掉已经写出的部分，文件仍以完整记录结尾
+            if (::ftruncate(fd_, static_cast<off_t>(fileSize_)) != 0) {
+                LOG_ERROR << "WAL truncate " << path_ << " failed: " << strerror(errno);
+            }
+            return false;
+        }
+        p += n;
+        remaining -= static_cast<size_t>(n);
+    }
+    fileSize_ += data.size();
+    return true;
+}
+
+bool WriteAheadLog::syncFile() {
+    // fdatasync 失败后内核可能已经丢弃了这些脏页，重试成功也不能说明数据已落盘
+    bool ok = ::fdatasync(fd_) == 0;
+    if (!ok) {
+        LOG_ERROR << "WAL fdatasync " << path_ << " failed: " << strerror(errno);
+    }
+    MutexLockGuard lock(mutex_);
+    syncCount_++;
+    return ok;
+}
+
+}  // namespace kvstore
@@ -0,0 +1,204 @@
+// src/storage/wal.h
+#ifndef KVSTORE_STORAGE_WAL_H
+#define KVSTORE_STORAGE_WAL_H
+
+#include "base/mutex.h"
+#include "base/noncopyable.h"
+#include "base/thread.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace kvstore {
+
+/**
+ * @brief WAL 刷盘策略
+ */
+enum class WalSyncPolicy {
+    kAlways,    // 每次写操作应答前都已 fdatasync（多个写操作共享一次刷盘）
+    kInterval,  // 每 syncIntervalMs 毫秒 fdatasync 一次，崩溃最多丢失这段时间的写入
+    kNever,     // 只 write 到内核，由操作系统决定何时落盘
+};
+
+/**
+ * @brief WAL 配置
+ */
+struct WalOptions {
+    WalSyncPolicy syncPolicy = WalSyncPolicy::kInterval;
+    int syncIntervalMs = 1000;  // kInterval 的刷盘间隔；kNever 时也按此间隔把缓冲写入内核
+};
+
+/**
+ * @brief WAL 记录类型
+ */
+enum class WalRecordType : uint8_t {
+    kPut = 1,         // key, value
+    kDel = 2,         // key
+    kClear = 3,       // 无
+    kClearShard = 4,  // shard, shards：清空 std::hash(key) % shards == shard 的 key
+    kPutExpire = 5,   // expireAt, key, value：带过期时间的 PUT
+    kExpire = 6,      // expireAt, key：修改已有 key 的过期时间（0 表示去掉）
+};
+
+/**
+ * @brief 一条解码后的 WAL 记录
+ */
+struct WalRecord {
+    WalRecordType type = WalRecordType::kPut;
+    std::string key;
+    std::string value;
+    uint32_t shard = 0;
+    uint32_t shards = 0;
+    int64_t expireAt = 0;  // 绝对过期时刻（Unix 毫秒），kPutExpire/kExpire
+};
+
+/**
+ * @brief 预写日志（Write-Ahead Log）
+ *
+ * 只追加的日志文件，记录快照之后的每一次 PUT/DEL/CLEAR，启动时先加载快照再重放日志。
+ *
+ * 记录格式（小端）：
+ *   [crc32c u32][length u32][type u8][payload]
+ *   crc 覆盖 type 和 payload，length = 1 + payload 长度
+ *   PUT:         [key 长度 u32][key][value]
+ *   DEL:         [key]
+ *   CLEAR:       空
+ *   CLEAR_SHARD: [shard u32][shards u32]
+ *   PUT_EXPIRE:  [expireAt u64][key 长度 u32][key][value]
+ *   EXPIRE:      [expireAt u64][key]
+ * 过期时间是绝对时刻，重放时已经过期的 key 照常写入内存，由读者按当前时间隐藏。
+ * 重放遇到不完整或校验失败的记录即停止，并把文件截断到最后一条完整记录（崩溃时写了一半）。
+ *
+ * 组提交：
+ * - append* 只把编码后的记录追加到内存缓冲并分配 LSN，不做系统调用
+ * - 后台刷盘线程一次取走整个缓冲，一次 write，按策略 fdatasync
+ * - kAlways 下写者在应答前调用 sync()，等待到目前为止追加的记录落盘；
+ *   刷盘线程忙于上一次 fdatasync 时，所有 IO 线程新追加的记录会合并到下一次刷盘中
+ *
+ * 检查点：日志只记录快照之后的变化。rotate() 把当前文件改名为 path.old 并重新开始，
+ * 快照写完后 removeRotated() 删除旧文件；快照失败时旧文件保留，下次 rotate 时
+ * 当前文件会追加到 path.old 末尾。重放依次读取 path.old 和 path。
+ * 所有记录都是覆盖写，在已包含它们的快照上重放一遍结果不变，因此快照与
+ * 删除旧文件之间崩溃也是安全的。
+ *
+ * 写入失败：write 出错时把文件截断回上一次成功写入的末尾，不留下残缺记录；
+ * write 或 fdatasync 出错后日志进入失败状态，之后的记录不再写入文件，
+ * sync() 返回 false，由调用方把写请求应答为错误。失败状态不会自动恢复。
+ *
+ * 线程安全：append*、sync 可以在任意线程并发调用。
+ * 调用方需保证同一个 key 的追加顺序与应用到内存的顺序一致。
+ */
+class WriteAheadLog : noncopyable {
+public:
+    using ReplayCallback = std::function<void(const WalRecord& record)>;
+
+    WriteAheadLog(const std::string& path, const WalOptions& options);
+
+    /// 析构时刷盘并关闭
+    ~WriteAheadLog();
+
+    /**
+     * @brief 重放已有的日志（必须在 open() 之前调用）
+     * @param callback 按写入顺序对每条记录调用一次
+     * @return 重放的记录数
+     */
+    size_t replay(const ReplayCallback& callback);
+
+    /**
+     * @brief 打开日志文件用于追加，并启动刷盘线程
+     * @return true 成功，false 打开失败
+     */
+    bool open();
+
+    /// 刷出缓冲中的全部记录并关闭文件（按策略刷盘），之后不能再追加
+    void close();
+
+    // ==================== 追加（返回 LSN） ====================
+
+    /// expireAt 非 0 时写成 PUT_EXPIRE
+    uint64_t appendPut(const std::string& key, const char* value, size_t valueLen,
+                       int64_t expireAt = 0);
+    uint64_t appendDel(const std::string& key);
+    uint64_t appendExpire(const std::string& key, int64_t expireAt);
+    uint64_t appendClear();
+    uint64_t appendClearShard(uint32_t shard, uint32_t shards);
+
+    /**
+     * @brief 等待到目前为止追加的所有记录落盘
+     *
+     * 只有 kAlways 策略会阻塞，其他策略立即返回。
+     * @return false 日志已经写入失败，这些记录不会落盘
+     */
+    bool sync();
+
+    /**
+     * @brief 开始一次检查点：刷出缓冲并把当前文件换成新文件
+     *
+     * 调用方需保证此时所有已追加的记录都已应用到内存，之后开始的快照包含它们。
+     * @return true 成功
+     */
+    bool rotate();
+
+    /// 快照已经成功落盘，删除 rotate() 换下的旧文件
+    void removeRotated();
+
+    const std::string& path() const { return path_; }
+    const WalOptions& options() const { return options_; }
+
+    /// 已追加的记录数（LSN 从 1 开始）
+    uint64_t appendedLsn() const;
+
+    /// fdatasync 的次数（统计用，体现组提交效果）
+    uint64_t syncCount() const;
+
+    /// 是否已经因为 write / fdatasync 出错进入失败状态
+    bool failed() const;
+
+private:
+    static const size_t kHeaderSize = 9;  // crc(4) + length(4) + type(1)
+    static const size_t kMaxBufferBytes = 4 * 1024 * 1024;  // 超过后提前唤醒刷盘线程
+
+    /// 编码一条记录并追加到缓冲，返回 LSN
+    uint64_t append(WalRecordType type, const char* payload1, size_t len1,
+                    const char* payload2, size_t len2);
+
+    /// 重放单个文件，truncateTail 为 true 时截掉文件末尾的残缺记录
+    size_t replayFile(const std::string& file, bool truncateTail,
+                      const ReplayCallback& callback);
+
+    /// 刷盘线程主循环
+    void flushLoop();
+
+    /// 在刷盘线程中执行 rotate
+    bool rotateFile();
+
+    /// 写入一批记录；失败时截断到 fileSize_，不留下残缺记录
+    bool writeAll(const std::string& data);
+    bool syncFile();
+
+    const std::string path_;
+    const std::string rotatedPath_;
+    const WalOptions options_;
+    int fd_;
+    uint64_t fileSize_;  // 已完整写入的文件长度，只在刷盘线程中访问
+
+    mutable MutexLock mutex_;
+    Condition flushCond_;  // 唤醒刷盘线程
+    Condition doneCond_;   // 刷盘线程完成一轮
+    std::string buffer_;   // 待写入的记录
+    uint64_t appendedLsn_;
+    uint64_t durableLsn_;  // 已 write（kAlways 下为已 fdatasync）的最大 LSN
+    uint64_t syncCount_;
+    bool failed_;  // write / fdatasync 出错，之后的记录不再写入
+    bool running_;
+    bool rotateRequested_;
+    bool rotateOk_;
+    std::unique_ptr<Thread> thread_;
+};
+
+}  // namespace kvstore
+
+#endif  // KVSTORE_STORAGE_WAL_H
@@ -0,0 +1,32 @@
+// tests/base/crc32c_test.cpp
+#include "base/crc32c.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+using namespace kvstore;
+
+TEST(Crc32cTest, StandardResults) {
+    // RFC 3720 附录 B.4 中的测试向量
+    std::string zeros(32, '\0');
+    EXPECT_EQ(crc32c::value(zeros.data(), zeros.size()), 0x8A9136AAu);
+    std::string ones(32, '\xFF');
+    EXPECT_EQ(crc32c::value(ones.data(), ones.size()), 0x62A8AB43u);
+    EXPECT_EQ(crc32c::value("123456789", 9), 0xE3069283u);
+    EXPECT_EQ(crc32c::value("", 0), 0u);
+}
+
+TEST(Crc32cTest, ExtendMatchesWholeBuffer) {
+    std::string data;
+    for (int i = 0; i < 1000; i++) {
+        data.push_back(static_cast<char>(i * 31 + 7));
+    }
+    uint32_t whole = crc32c::value(data.data(), data.size());
+    // 各种切分位置（含不足 8 字节的尾部）结果都与整体计算一致
+    for (size_t split : {0, 1, 7, 8, 9, 500, 999, 1000}) {
+        uint32_t crc = crc32c::value(data.data(), split);
+        crc = crc32c::extend(crc, data.data() + split, data.size() - split);
+        EXPECT_EQ(crc, whole) << "split=" << split;
+    }
+}
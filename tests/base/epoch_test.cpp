@@ -0,0 +1,107 @@
+// tests/base/epoch_test.cpp
+#include "base/epoch.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <limits>
+#include <thread>
+
+using namespace kvstore;
+
+namespace {
+const uint64_t kNoActive = std::numeric_limits<uint64_t>::max();
+}
+
+TEST(EpochTest, RetireEpochAdvances) {
+    EpochManager& manager = EpochManager::instance();
+    uint64_t e1 = manager.retireEpoch();
+    uint64_t e2 = manager.retireEpoch();
+    EXPECT_LT(e1, e2);
+    EXPECT_GT(manager.currentEpoch(), e2);
+}
+
+TEST(EpochTest, GuardBlocksReclamation) {
+    EpochManager& manager = EpochManager::instance();
+    EXPECT_EQ(manager.minActiveEpoch(), kNoActive);
+
+    {
+        EpochGuard guard;
+        uint64_t retired = manager.retireEpoch();
+        // 读者在退休之前进入临界区，退休的对象不能被回收
+        EXPECT_LE(manager.minActiveEpoch(), retired);
+
+        {
+            EpochGuard nested;  // 嵌套不改变已发布的 epoch
+            EXPECT_LE(manager.minActiveEpoch(), retired);
+        }
+        EXPECT_LE(manager.minActiveEpoch(), retired);
+    }
+
+    EXPECT_EQ(manager.minActiveEpoch(), kNoActive);
+}
+
+TEST(EpochTest, QuiescentThreadOnlineOffline) {
+    EpochManager& manager = EpochManager::instance();
+
+    std::atomic<int> step(0);
+    uint64_t retired = 0;
+
+    std::thread reader([&]() {
+        manager.registerThread();
+        EXPECT_TRUE(manager.isRegisteredThread());
+        step = 1;
+        while (step != 2) {
+            std::this_thread::yield();
+        }
+        // 静默点：之后观察到的 epoch 晚于之前退休的对象
+        manager.online();
+        step = 3;
+        while (step != 4) {
+            std::this_thread::yield();
+        }
+        manager.offline();
+        step = 5;
+        while (step != 6) {
+            std::this_thread::yield();
+        }
+        manager.unregisterThread();
+        EXPECT_FALSE(manager.isRegisteredThread());
+    });
+
+    while (step != 1) {
+        std::this_thread::yield();
+    }
+    retired = manager.retireEpoch();
+    EXPECT_LE(manager.minActiveEpoch(), retired);  // 读者还在上一轮迭代中
+
+    step = 2;
+    while (step != 3) {
+        std::this_thread::yield();
+    }
+    EXPECT_GT(manager.minActiveEpoch(), retired);
+    EXPECT_NE(manager.minActiveEpoch(), kNoActive);
+
+    step = 4;
+    while (step != 5) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(manager.minActiveEpoch(), kNoActive);  // offline 不阻碍回收
+
+    step = 6;
+    reader.join();
+}
+
+TEST(EpochTest, GuardIsNoopInQuiescentThread) {
+    EpochManager& manager = EpochManager::instance();
+    std::thread t([&manager]() {
+        manager.registerThread();
+        manager.offline();
+        {
+            EpochGuard guard;
+            EXPECT_EQ(manager.minActiveEpoch(), kNoActive);
+        }
+        manager.unregisterThread();
+    });
+    t.join();
+}
@@ -0,0 +1,94 @@
+// tests/net/timer_queue_test.cpp
+#include "net/eventloop.h"
+#include "net/eventloop_thread.h"
+#include "base/mutex.h"
+#include "base/timestamp.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+/// 等待 pred 成立，最长 seconds 秒
+template <typename Pred>
+bool waitFor(Pred pred, double seconds = 2.0) {
+    Timestamp deadline = addTime(Timestamp::now(), seconds);
+    while (!pred()) {
+        if (deadline < Timestamp::now()) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+}  // namespace
+
+TEST(TimerQueueTest, RunAfterFromLoopThread) {
+    EventLoop loop;
+    Timestamp start = Timestamp::now();
+    std::vector<int> order;
+    loop.runAfter(0.03, [&]() {
+        order.push_back(30);
+        loop.quit();
+    });
+    loop.runAfter(0.01, [&]() { order.push_back(10); });
+    loop.runAfter(0.02, [&]() { order.push_back(20); });
+    loop.loop();
+
+    EXPECT_EQ(order, (std::vector<int>{10, 20, 30}));
+    EXPECT_GE(timeDifference(Timestamp::now(), start), 0.03);
+}
+
+TEST(TimerQueueTest, RunEveryAndCancelFromOtherThread) {
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    std::atomic<int> ticks(0);
+    TimerId id = loop->runEvery(0.005, [&ticks]() { ticks++; });
+    ASSERT_TRUE(waitFor([&ticks]() { return ticks.load() >= 3; }));
+
+    loop->cancel(id);
+    // cancel 经任务队列执行，等它之后的一个任务完成
+    std::atomic<bool> flushed(false);
+    loop->runInLoop([&flushed]() { flushed = true; });
+    ASSERT_TRUE(waitFor([&flushed]() { return flushed.load(); }));
+    int stopped = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(ticks.load(), stopped);
+}
+
+TEST(TimerQueueTest, ManyTimersFromManyThreads) {
+    EventLoopThread thread;
+    EventLoop* loop = thread.startLoop();
+    const int kThreads = 4;
+    const int kTimers = 2000;
+    std::atomic<int> fired(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([loop, &fired, t]() {
+            for (int i = 0; i < kTimers; i++) {
+                // 奇数线程取消自己添加的一半；到期之前取消才有效，这些定时器延后 200 毫秒，
+                // 添加线程在 runAfter 和 cancel 之间被调度出去也来得及
+                bool cancelled = t % 2 == 1 && i % 2 == 0;
+                double delay = 0.001 * (i % 50) + (cancelled ? 0.2 : 0);
+                TimerId id = loop->runAfter(delay, [&fired]() { fired++; });
+                if (cancelled) {
+                    loop->cancel(id);
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    const int expected = kThreads * kTimers - (kThreads / 2) * (kTimers / 2);
+    ASSERT_TRUE(waitFor([&]() { return fired.load() >= expected; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    EXPECT_EQ(fired.load(), expected);
+}
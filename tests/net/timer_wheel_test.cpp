@@ -0,0 +1,114 @@
+// tests/net/timer_wheel_test.cpp
+#include "net/timer_wheel.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+const int64_t kStart = 1700000000000000;  // 任意的起点（微秒）
+
+int64_t ms(int64_t n) { return kStart + n * 1000; }
+
+}  // namespace
+
+TEST(TimerWheelTest, FiresInOrderAndNotEarly) {
+    TimerWheel wheel(kStart);
+    std::vector<int> fired;
+    wheel.add(ms(30), [&fired]() { fired.push_back(30); });
+    wheel.add(ms(10), [&fired]() { fired.push_back(10); });
+    wheel.add(ms(20), [&fired]() { fired.push_back(20); });
+    wheel.add(ms(20), [&fired]() { fired.push_back(21); });
+    EXPECT_EQ(wheel.size(), 4u);
+
+    EXPECT_EQ(wheel.advance(ms(9)), 0u);
+    EXPECT_EQ(wheel.advance(ms(10)), 1u);
+    EXPECT_EQ(wheel.advance(ms(25)), 2u);
+    EXPECT_EQ(wheel.advance(ms(100)), 1u);
+    ASSERT_EQ(fired.size(), 4u);
+    EXPECT_EQ(fired[0], 10);
+    EXPECT_EQ(fired[3], 30);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheelTest, PastTimersFireOnNextTick) {
+    TimerWheel wheel(kStart);
+    int fired = 0;
+    wheel.add(kStart - 5000, [&fired]() { fired++; });
+    EXPECT_EQ(wheel.advance(kStart), 0u);
+    EXPECT_EQ(wheel.advance(ms(1)), 1u);
+    EXPECT_EQ(fired, 1);
+}
+
+TEST(TimerWheelTest, Cancel) {
+    TimerWheel wheel(kStart);
+    int fired = 0;
+    TimerId a = wheel.add(ms(5), [&fired]() { fired++; });
+    TimerId b = wheel.add(ms(5000), [&fired]() { fired++; });
+    EXPECT_TRUE(wheel.cancel(a));
+    EXPECT_FALSE(wheel.cancel(a));
+    EXPECT_TRUE(wheel.cancel(b));
+    wheel.advance(ms(10000));
+    EXPECT_EQ(fired, 0);
+    EXPECT_EQ(wheel.size(), 0u);
+
+    // 回调中取消同一个 tick 的另一个定时器：先执行的那个取消另一个
+    TimerId first = 0;
+    TimerId second = 0;
+    first = wheel.add(ms(10001), [&]() { fired++; wheel.cancel(second); });
+    second = wheel.add(ms(10001), [&]() { fired++; wheel.cancel(first); });
+    wheel.advance(ms(10002));
+    EXPECT_EQ(fired, 1);
+}
+
+TEST(TimerWheelTest, PeriodicTimerUntilCancelled) {
+    TimerWheel wheel(kStart);
+    int fired = 0;
+    TimerId id = 0;
+    id = wheel.add(ms(10), [&]() {
+        if (++fired == 3) {
+            wheel.cancel(id);
+        }
+    }, 10000);
+    EXPECT_EQ(wheel.advance(ms(25)), 2u);
+    EXPECT_EQ(wheel.advance(ms(1000)), 1u);
+    EXPECT_EQ(fired, 3);
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimerWheelTest, CascadesFromUpperLevels) {
+    TimerWheel wheel(kStart);
+    // 分布在各层：第 0 层之内、第 1 层、第 2 层、第 3 层
+    const int64_t delays[] = {100, 300, 256 * 64 + 7, 1 << 21, 5000000};
+    std::vector<int64_t> firedAt;
+    int64_t now = 0;
+    for (int64_t delay : delays) {
+        wheel.add(ms(delay), [&firedAt, &now]() { firedAt.push_back(now); });
+    }
+    // 按 nextTimeout 逐次推进，每个定时器恰好在到期的 tick 触发
+    while (wheel.size() > 0) {
+        int64_t timeout = wheel.nextTimeout(ms(now));
+        ASSERT_GT(timeout, 0);
+        now += timeout / 1000;
+        wheel.advance(ms(now));
+    }
+    ASSERT_EQ(firedAt.size(), 5u);
+    for (size_t i = 0; i < firedAt.size(); i++) {
+        EXPECT_EQ(firedAt[i], delays[i]);
+    }
+}
+
+TEST(TimerWheelTest, NextTimeout) {
+    TimerWheel wheel(kStart);
+    EXPECT_EQ(wheel.nextTimeout(kStart), -1);
+    wheel.add(ms(40), []() {});
+    EXPECT_EQ(wheel.nextTimeout(kStart), 40000);
+    EXPECT_EQ(wheel.nextTimeout(kStart + 500), 39500);
+    TimerId id = wheel.add(ms(7), []() {});
+    EXPECT_EQ(wheel.nextTimeout(kStart), 7000);
+    wheel.cancel(id);
+    EXPECT_EQ(wheel.nextTimeout(kStart), 40000);
+}
@@ -0,0 +1,123 @@
+// tests/protocol/binary_codec_test.cpp
+#include "protocol/binary_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <endian.h>
+
+#include <cstring>
+#include <string>
+
+using namespace kvstore;
+
+namespace {
+
+/// 按协议格式手工拼一帧请求
+std::string makeFrame(CommandType command, const std::string& key, const std::string& value,
+                      uint32_t requestId, uint32_t extra = 0) {
+    std::string frame(16, '\0');
+    frame[0] = static_cast<char>(0x80);
+    frame[1] = static_cast<char>(command);
+    uint16_t keyLength = htobe16(static_cast<uint16_t>(key.size()));
+    uint32_t valueLength = htobe32(static_cast<uint32_t>(value.size()));
+    uint32_t id = htobe32(requestId);
+    uint32_t be32 = htobe32(extra);
+    memcpy(&frame[2], &keyLength, 2);
+    memcpy(&frame[4], &valueLength, 4);
+    memcpy(&frame[8], &id, 4);
+    memcpy(&frame[12], &be32, 4);
+    return frame + key + value;
+}
+
+}  // namespace
+
+TEST(BinaryCodecTest, PeekFrameViewsIntoBuffer) {
+    const std::string value("line one\r\n\0 with spaces", 23);
+    std::string frame = makeFrame(CommandType::kPut, "key", value, 42, 60);
+    Buffer buf;
+    buf.append(frame);
+
+    BinaryFrame parsed;
+    ASSERT_EQ(BinaryCodec::peekFrame(buf, &parsed), BinaryCodec::ParseResult::kComplete);
+    EXPECT_EQ(parsed.opcode, static_cast<uint8_t>(CommandType::kPut));
+    EXPECT_EQ(parsed.requestId, 42u);
+    EXPECT_EQ(parsed.extra, 60u);
+    EXPECT_EQ(std::string(parsed.key, parsed.keyLength), "key");
+    EXPECT_EQ(std::string(parsed.value, parsed.valueLength), value);
+    EXPECT_EQ(parsed.key, buf.peek() + 16);
+    EXPECT_EQ(parsed.size(), frame.size());
+    EXPECT_EQ(buf.readableBytes(), frame.size());  // 不取走数据
+}
+
+TEST(BinaryCodecTest, IncompleteUntilWholeFrameArrives) {
+    std::string frame = makeFrame(CommandType::kGet, "hello", "", 7);
+    Buffer buf;
+    BinaryFrame parsed;
+    for (size_t i = 0; i < frame.size(); i++) {
+        EXPECT_EQ(BinaryCodec::peekFrame(buf, &parsed), BinaryCodec::ParseResult::kIncomplete);
+        buf.append(&frame[i], 1);
+    }
+    EXPECT_EQ(BinaryCodec::peekFrame(buf, &parsed), BinaryCodec::ParseResult::kComplete);
+}
+
+TEST(BinaryCodecTest, RejectsBadMagicAndOversizedValues) {
+    Buffer buf;
+    buf.append(std::string("GET key\r\n        "));
+    BinaryFrame parsed;
+    EXPECT_EQ(BinaryCodec::peekFrame(buf, &parsed), BinaryCodec::ParseResult::kInvalid);
+
+    std::string frame = makeFrame(CommandType::kPut, "k", "", 1);
+    uint32_t huge = htobe32(BinaryCodec::kMaxValueLength + 1);
+    memcpy(&frame[4], &huge, 4);
+    Buffer oversized;
+    oversized.append(frame);
+    EXPECT_EQ(BinaryCodec::peekFrame(oversized, &parsed), BinaryCodec::ParseResult::kInvalid);
+}
+
+TEST(BinaryCodecTest, ParseRequestConsumesPipelinedFrames) {
+    Buffer buf;
+    buf.append(makeFrame(CommandType::kPut, "a", "1", 1, 10));
+    buf.append(makeFrame(CommandType::kRange, "a", "z", 2));
+    buf.append(makeFrame(CommandType::kExpire, "a", "", 3, 5));
+
+    Request request;
+    uint32_t id = 0;
+    ASSERT_EQ(BinaryCodec::parseRequest(&buf, &request, &id), BinaryCodec::ParseResult::kComplete);
+    EXPECT_EQ(request.command, CommandType::kPut);
+    EXPECT_EQ(request.key, "a");
+    EXPECT_EQ(request.value, "1");
+    EXPECT_EQ(request.limit, 10u);
+    EXPECT_EQ(id, 1u);
+
+    // 不支持的命令：帧被取走，command 为 kUnknown
+    Request unsupported;
+    ASSERT_EQ(BinaryCodec::parseRequest(&buf, &unsupported, &id), BinaryCodec::ParseResult::kComplete);
+    EXPECT_EQ(unsupported.command, CommandType::kUnknown);
+    EXPECT_EQ(id, 2u);
+
+    Request expire;
+    ASSERT_EQ(BinaryCodec::parseRequest(&buf, &expire, &id), BinaryCodec::ParseResult::kComplete);
+    EXPECT_EQ(expire.command, CommandType::kExpire);
+    EXPECT_EQ(expire.limit, 5u);
+    EXPECT_EQ(buf.readableBytes(), 0u);
+}
+
+TEST(BinaryCodecTest, EncodeResponse) {
+    Buffer out;
+    BinaryCodec::encodeResponse(9, Response::notFound(), &out);
+    const std::string value("\0\x01\x02", 3);
+    BinaryCodec::encodeValue(10, StatusCode::kOk, value.data(), value.size(), &out);
+    ASSERT_EQ(out.readableBytes(), 16u + 16u + value.size());
+
+    const char* p = out.peek();
+    EXPECT_EQ(static_cast<uint8_t>(p[0]), 0x81);
+    EXPECT_EQ(p[1], static_cast<char>(StatusCode::kNotFound));
+    EXPECT_EQ(be32toh(*reinterpret_cast<const uint32_t*>(p + 4)), 0u);
+    EXPECT_EQ(be32toh(*reinterpret_cast<const uint32_t*>(p + 8)), 9u);
+
+    p += 16;
+    EXPECT_EQ(p[1], static_cast<char>(StatusCode::kOk));
+    EXPECT_EQ(be32toh(*reinterpret_cast<const uint32_t*>(p + 4)), value.size());
+    EXPECT_EQ(be32toh(*reinterpret_cast<const uint32_t*>(p + 8)), 10u);
+    EXPECT_EQ(std::string(p + 16, value.size()), value);
+}
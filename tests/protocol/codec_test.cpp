@@ -0,0 +1,107 @@
+// tests/protocol/codec_test.cpp
+#include "protocol/codec.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+/// 解析一行，返回拷贝出来的 Request
+Request parse(const std::string& line) {
+    Buffer buf;
+    buf.append(line + "\r\n");
+    Request request;
+    EXPECT_TRUE(Codec::parseRequest(&buf, &request));
+    EXPECT_EQ(buf.readableBytes(), 0u);
+    return request;
+}
+
+}  // namespace
+
+TEST(CodecTest, PeekRequestViewsIntoBuffer) {
+    Buffer buf;
+    buf.append("put key  a value with spaces\r\nGET key\n");
+
+    RequestView view;
+    ASSERT_TRUE(Codec::peekRequest(buf, &view));
+    EXPECT_EQ(view.command, CommandType::kPut);
+    EXPECT_EQ(view.key, "key");
+    EXPECT_EQ(view.value, "a value with spaces");
+    EXPECT_EQ(view.key.data(), buf.peek() + 4);
+    EXPECT_EQ(view.length, 30u);
+    EXPECT_EQ(buf.readableBytes(), 38u);  // 不取走数据
+
+    buf.retrieve(view.length);
+    ASSERT_TRUE(Codec::peekRequest(buf, &view));
+    EXPECT_EQ(view.command, CommandType::kGet);
+    EXPECT_EQ(view.key, "key");
+    EXPECT_TRUE(view.value.empty());
+    EXPECT_EQ(view.length, 8u);
+
+    buf.retrieve(view.length);
+    buf.append("GET partial");
+    EXPECT_FALSE(Codec::peekRequest(buf, &view));
+}
+
+TEST(CodecTest, CommandNamesAreCaseInsensitive) {
+    EXPECT_EQ(parse("Get k").command, CommandType::kGet);
+    EXPECT_EQ(parse("dElEtE k").command, CommandType::kDel);
+    EXPECT_EQ(parse("flushdb").command, CommandType::kClear);
+    EXPECT_EQ(parse("dbsize").command, CommandType::kSize);
+    EXPECT_EQ(parse("info").command, CommandType::kStats);
+    EXPECT_EQ(parse("exit").command, CommandType::kQuit);
+    EXPECT_EQ(parse("GETX k").command, CommandType::kUnknown);
+    EXPECT_EQ(parse("GET").command, CommandType::kUnknown);
+    EXPECT_EQ(parse("   ").command, CommandType::kUnknown);
+}
+
+TEST(CodecTest, PutWithExpiry) {
+    Request request = parse("PUT k hello world ex 30");
+    EXPECT_EQ(request.command, CommandType::kPut);
+    EXPECT_EQ(request.value, "hello world");
+    EXPECT_EQ(request.limit, 30u);
+
+    // EX 后面不是正整数时属于 value
+    request = parse("PUT k v EX soon");
+    EXPECT_EQ(request.value, "v EX soon");
+    EXPECT_EQ(request.limit, 0u);
+
+    // key 也出现在命令名里时 value 仍从 key 之后开始
+    request = parse("PUT P value");
+    EXPECT_EQ(request.key, "P");
+    EXPECT_EQ(request.value, "value");
+}
+
+TEST(CodecTest, MultiKeyAndRangeCommands) {
+    Request request = parse("MSET a 1 b 2");
+    EXPECT_EQ(request.command, CommandType::kMPut);
+    EXPECT_EQ(request.keys, (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(request.values, (std::vector<std::string>{"1", "2"}));
+    EXPECT_EQ(parse("MPUT a 1 b").command, CommandType::kUnknown);
+
+    request = parse("MGET x y z");
+    EXPECT_EQ(request.command, CommandType::kMGet);
+    EXPECT_EQ(request.keys.size(), 3u);
+
+    request = parse("RANGE a z LIMIT 5");
+    EXPECT_EQ(request.command, CommandType::kRange);
+    EXPECT_EQ(request.key, "a");
+    EXPECT_EQ(request.value, "z");
+    EXPECT_EQ(request.limit, 5u);
+
+    request = parse("SCAN @next COUNT 3");
+    EXPECT_EQ(request.command, CommandType::kScan);
+    EXPECT_EQ(request.key, "next");
+    EXPECT_EQ(request.limit, 3u);
+    request = parse("SCAN 0");
+    EXPECT_EQ(request.command, CommandType::kScan);
+    EXPECT_TRUE(request.key.empty());
+    EXPECT_EQ(request.limit, static_cast<size_t>(Codec::kDefaultScanCount));
+
+    EXPECT_EQ(parse("EXPIRE k 0").command, CommandType::kExpire);
+    EXPECT_EQ(parse("EXPIRE k -1").command, CommandType::kUnknown);
+}
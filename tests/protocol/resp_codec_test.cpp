@@ -0,0 +1,149 @@
+// tests/protocol/resp_codec_test.cpp
+#include "protocol/resp_codec.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace kvstore;
+
+TEST(RespCodecTest, ParseArrayOfBulkStrings) {
+    const std::string value("a b\r\nc", 6);
+    Buffer buf;
+    buf.append("*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$6\r\n" + value + "\r\n*1\r\n$4\r\nPING\r\n");
+
+    std::vector<std::string> args;
+    ASSERT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kComplete);
+    ASSERT_EQ(args.size(), 3u);
+    EXPECT_EQ(args[0], "SET");
+    EXPECT_EQ(args[1], "key");
+    EXPECT_EQ(args[2], value);
+
+    ASSERT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kComplete);
+    ASSERT_EQ(args.size(), 1u);
+    EXPECT_EQ(args[0], "PING");
+    EXPECT_EQ(buf.readableBytes(), 0u);
+}
+
+TEST(RespCodecTest, IncompleteUntilWholeCommandArrives) {
+    const std::string command = "*2\r\n$3\r\nGET\r\n$5\r\nhello\r\n";
+    Buffer buf;
+    std::vector<std::string> args;
+    for (size_t i = 0; i < command.size(); i++) {
+        EXPECT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kIncomplete);
+        EXPECT_EQ(buf.readableBytes(), i);  // 不取走数据
+        buf.append(&command[i], 1);
+    }
+    ASSERT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kComplete);
+    EXPECT_EQ(args, (std::vector<std::string>{"GET", "hello"}));
+}
+
+TEST(RespCodecTest, InlineCommandsAndEmptyLines) {
+    Buffer buf;
+    buf.append("\r\n  set  k   v\r\nPING\n");
+    std::vector<std::string> args;
+    ASSERT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kComplete);
+    EXPECT_EQ(args, (std::vector<std::string>{"set", "k", "v"}));
+    ASSERT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kComplete);
+    EXPECT_EQ(args, (std::vector<std::string>{"PING"}));
+    EXPECT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kIncomplete);
+}
+
+TEST(RespCodecTest, InvalidRequests) {
+    std::vector<std::string> args;
+    for (const char* bad : {"*1\r\n+PING\r\n", "*x\r\n", "*1\r\n$-5\r\n", "*1\r\n$2\r\nabc\r\n"}) {
+        Buffer buf;
+        buf.append(bad);
+        EXPECT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kInvalid) << bad;
+    }
+    Buffer buf;
+    buf.append(std::string(RespCodec::kMaxInlineLength + 1, 'a'));
+    EXPECT_EQ(RespCodec::parseCommand(&buf, &args), RespCodec::ParseResult::kInvalid);
+}
+
+TEST(RespCodecTest, MapCommandsToRequests) {
+    bool resp3 = false;
+    Request request;
+    RespCommand command;
+    Buffer reply;
+
+    ASSERT_TRUE(RespCodec::toRequest({"set", "k", "v", "EX", "10"}, &resp3, &request, &command,
+                                     &reply));
+    EXPECT_EQ(command, RespCommand::kSet);
+    EXPECT_EQ(request.command, CommandType::kPut);
+    EXPECT_EQ(request.key, "k");
+    EXPECT_EQ(request.value, "v");
+    EXPECT_EQ(request.limit, 10u);
+
+    request = Request();
+    ASSERT_TRUE(RespCodec::toRequest({"DEL", "a", "b"}, &resp3, &request, &command, &reply));
+    EXPECT_EQ(command, RespCommand::kDel);
+    EXPECT_EQ(request.command, CommandType::kMDel);
+    EXPECT_EQ(request.keys, (std::vector<std::string>{"a", "b"}));
+
+    request = Request();
+    ASSERT_TRUE(RespCodec::toRequest({"DBSIZE"}, &resp3, &request, &command, &reply));
+    EXPECT_EQ(request.command, CommandType::kSize);
+    EXPECT_EQ(reply.readableBytes(), 0u);
+
+    // 参数错误和握手命令直接应答
+    EXPECT_FALSE(RespCodec::toRequest({"GET"}, &resp3, &request, &command, &reply));
+    EXPECT_EQ(reply.retrieveAllAsString(), "-ERR wrong number of arguments for 'GET' command\r\n");
+    EXPECT_FALSE(RespCodec::toRequest({"NOPE"}, &resp3, &request, &command, &reply));
+    EXPECT_EQ(reply.retrieveAllAsString(), "-ERR unknown command 'NOPE'\r\n");
+    EXPECT_FALSE(RespCodec::toRequest({"ECHO", "hi"}, &resp3, &request, &command, &reply));
+    EXPECT_EQ(reply.retrieveAllAsString(), "$2\r\nhi\r\n");
+
+    EXPECT_FALSE(RespCodec::toRequest({"HELLO", "3"}, &resp3, &request, &command, &reply));
+    EXPECT_TRUE(resp3);
+    EXPECT_EQ(reply.retrieveAllAsString().substr(0, 4), "%3\r\n");
+    EXPECT_FALSE(RespCodec::toRequest({"HELLO", "4"}, &resp3, &request, &command, &reply));
+    EXPECT_TRUE(resp3);
+    EXPECT_EQ(reply.retrieveAllAsString().substr(0, 8), "-NOPROTO");
+}
+
+TEST(RespCodecTest, RejectOverflowingExpireTimes) {
+    bool resp3 = false;
+    Request request;
+    RespCommand command;
+    Buffer reply;
+
+    // 当前毫秒加上 seconds * 1000 会超过 INT64_MAX
+    const std::string huge = "999999999999999999";
+    EXPECT_FALSE(RespCodec::toRequest({"SET", "k", "v", "EX", huge}, &resp3, &request, &command,
+                                      &reply));
+    EXPECT_EQ(reply.retrieveAllAsString(), "-ERR invalid expire time in 'set' command\r\n");
+    EXPECT_FALSE(RespCodec::toRequest({"EXPIRE", "k", huge}, &resp3, &request, &command, &reply));
+    EXPECT_EQ(reply.retrieveAllAsString(), "-ERR invalid expire time in 'expire' command\r\n");
+
+    // 上限以内照常接受
+    request = Request();
+    ASSERT_TRUE(RespCodec::toRequest({"EXPIRE", "k", "9000000000000000"}, &resp3, &request,
+                                     &command, &reply));
+    EXPECT_EQ(request.limit, 9000000000000000u);
+    EXPECT_EQ(reply.readableBytes(), 0u);
+}
+
+TEST(RespCodecTest, EncodeResponses) {
+    Buffer out;
+    RespCodec::encodeResponse(RespCommand::kGet, false, Response::ok("v"), &out);
+    RespCodec::encodeResponse(RespCommand::kGet, false, Response::notFound(), &out);
+    RespCodec::encodeResponse(RespCommand::kGet, true, Response::notFound(), &out);
+    RespCodec::encodeResponse(RespCommand::kSet, false, Response::ok("CREATED"), &out);
+    RespCodec::encodeResponse(RespCommand::kDel, false, Response::ok("DELETED"), &out);
+    RespCodec::encodeResponse(RespCommand::kExists, false, Response::ok("0"), &out);
+    RespCodec::encodeResponse(RespCommand::kTtl, false, Response::notFound(), &out);
+    RespCodec::encodeResponse(RespCommand::kPing, false, Response::pong(), &out);
+    RespCodec::encodeResponse(RespCommand::kSet, false, Response::error("Key cannot be empty"),
+                              &out);
+    EXPECT_EQ(out.retrieveAllAsString(),
+              "$1\r\nv\r\n$-1\r\n_\r\n+OK\r\n:1\r\n:0\r\n:-2\r\n+PONG\r\n"
+              "-ERR Key cannot be empty\r\n");
+
+    std::vector<std::string> values = {"x", ""};
+    std::vector<bool> found = {true, false};
+    RespCodec::encodeBatch(RespCommand::kMGet, false, values, found, 1, &out);
+    RespCodec::encodeBatch(RespCommand::kExists, false, values, found, 1, &out);
+    EXPECT_EQ(out.retrieveAllAsString(), "*2\r\n$1\r\nx\r\n$-1\r\n:1\r\n");
+}
@@ -0,0 +1,51 @@
+// tests/storage/arena_test.cpp
+#include "storage/arena.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace kvstore;
+
+TEST(ArenaTest, Empty) {
+    Arena arena;
+    EXPECT_EQ(arena.memoryUsage(), 0u);
+}
+
+TEST(ArenaTest, AllocatedMemoryIsIndependent) {
+    Arena arena;
+    std::vector<std::pair<size_t, char*>> allocated;
+    std::mt19937 gen(301);
+    std::uniform_int_distribution<> sizeDis(1, 6000);
+
+    size_t bytes = 0;
+    for (int i = 0; i < 2000; i++) {
+        size_t s = (i % 100 == 0) ? sizeDis(gen) : (sizeDis(gen) % 64) + 1;
+        char* r = (i % 2 == 0) ? arena.allocateAligned(s) : arena.allocate(s);
+        // 用序号填充，稍后检查没有被其他分配覆盖
+        memset(r, i % 256, s);
+        allocated.emplace_back(s, r);
+        bytes += s;
+        EXPECT_GE(arena.memoryUsage(), bytes);
+    }
+
+    for (size_t i = 0; i < allocated.size(); i++) {
+        for (size_t b = 0; b < allocated[i].first; b++) {
+            ASSERT_EQ(static_cast<int>(allocated[i].second[b]) & 0xff, static_cast<int>(i % 256));
+        }
+    }
+}
+
+TEST(ArenaTest, AlignedAllocation) {
+    Arena arena;
+    arena.allocate(3);  // 打乱对齐
+    for (int i = 0; i < 100; i++) {
+        char* p = arena.allocateAligned(i + 1);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % sizeof(void*), 0u);
+        arena.allocate(1);
+    }
+}
@@ -0,0 +1,135 @@
+// tests/storage/bloom_filter_test.cpp
+#include "storage/bloom_filter.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+uint32_t hashOf(int i) {
+    char key[32];
+    int n = snprintf(key, sizeof(key), "key%08d", i);
+    return BloomFilter::hash(key, static_cast<size_t>(n));
+}
+
+}  // namespace
+
+TEST(BloomFilterTest, NoFalseNegativesAndFewFalsePositives) {
+    std::vector<uint32_t> hashes;
+    for (int i = 0; i < 10000; i++) {
+        hashes.push_back(hashOf(i));
+    }
+    std::string filter;
+    BloomFilter::build(hashes, 10, &filter);
+    // 整数个 64 字节的块，末尾一个字节保存 k
+    EXPECT_EQ((filter.size() - 1) % BloomFilter::kBlockBytes, 0u);
+
+    for (uint32_t h : hashes) {
+        ASSERT_TRUE(BloomFilter::mayContain(filter.data(), filter.size(), h));
+    }
+    int falsePositives = 0;
+    for (int i = 10000; i < 20000; i++) {
+        if (BloomFilter::mayContain(filter.data(), filter.size(), hashOf(i))) {
+            falsePositives++;
+        }
+    }
+    // 10 位每 key 的分块过滤器理论误判率约 1.2%
+    EXPECT_LT(falsePositives, 300);
+}
+
+TEST(BloomFilterTest, UnknownFormatDoesNotFilter) {
+    const char filter[3] = {0, 0, 7};
+    EXPECT_TRUE(BloomFilter::mayContain(filter, sizeof(filter), hashOf(1)));
+    EXPECT_TRUE(BloomFilter::mayContain(nullptr, 0, hashOf(1)));
+}
+
+TEST(MemtableFilterTest, TracksInsertsAndFalsePositiveRate) {
+    MemtableFilter filter(10);
+    for (int i = 0; i < 500; i++) {
+        uint32_t h = hashOf(i);
+        uint64_t generation = filter.add(h);
+        filter.inserted(h, true, generation);
+    }
+    for (int i = 0; i < 500; i++) {
+        ASSERT_TRUE(filter.mayContain(hashOf(i)));
+    }
+    for (int i = 500; i < 10500; i++) {
+        if (filter.mayContain(hashOf(i))) {
+            filter.noteFalsePositive();
+        }
+    }
+    MemtableFilter::Stats stats = filter.stats();
+    EXPECT_EQ(stats.negatives + stats.falsePositives, 10000u);
+    // 按 1024 个 key 分配的位数组只用了一半，误判率远低于 1%
+    EXPECT_LT(stats.falsePositiveRate(), 0.01);
+    EXPECT_GT(stats.bytes, 0u);
+}
+
+TEST(MemtableFilterTest, RebuildAfterGrowthAndRemoval) {
+    MemtableFilter filter(10);
+    std::vector<uint32_t> keys;
+    for (int i = 0; !filter.needsRebuild(); i++) {
+        keys.push_back(hashOf(i));
+        uint64_t generation = filter.add(keys.back());
+        filter.inserted(keys.back(), true, generation);
+    }
+    size_t before = filter.stats().bytes;
+
+    ASSERT_TRUE(filter.beginRebuild(keys.size()));
+    EXPECT_FALSE(filter.beginRebuild(keys.size()));  // 同一时刻只有一个重建
+    for (uint32_t h : keys) {
+        filter.addRebuilt(h);
+    }
+    filter.endRebuild();
+    EXPECT_FALSE(filter.needsRebuild());
+    EXPECT_GT(filter.stats().bytes, before);
+    EXPECT_EQ(filter.stats().rebuilds, 1u);
+    for (uint32_t h : keys) {
+        ASSERT_TRUE(filter.mayContain(h));
+    }
+
+    // 删除一半以上之后需要重建，按剩下的 key 缩小
+    for (size_t i = 0; !filter.needsRebuild(); i++) {
+        filter.noteRemove();
+    }
+    ASSERT_TRUE(filter.beginRebuild(0));
+    filter.endRebuild();
+    EXPECT_FALSE(filter.mayContain(keys.front()) && filter.mayContain(keys.back()) &&
+                 filter.mayContain(keys[keys.size() / 2]));
+}
+
+TEST(MemtableFilterTest, InsertsDuringRebuildAreKept) {
+    MemtableFilter filter(10);
+    const int kKeys = 20000;
+    std::atomic<int> inserted(0);
+
+    // 写线程按 add -> 插入 -> inserted 的顺序写；重建线程只看得到已经"插入"的 key
+    std::thread writer([&] {
+        for (int i = 0; i < kKeys; i++) {
+            uint32_t h = hashOf(i);
+            uint64_t generation = filter.add(h);
+            inserted.store(i + 1, std::memory_order_seq_cst);
+            filter.inserted(h, true, generation);
+        }
+    });
+    for (int round = 0; round < 20; round++) {
+        if (filter.beginRebuild(static_cast<size_t>(kKeys))) {
+            int visible = inserted.load(std::memory_order_seq_cst);
+            for (int i = 0; i < visible; i++) {
+                filter.addRebuilt(hashOf(i));
+            }
+            filter.endRebuild();
+        }
+    }
+    writer.join();
+    for (int i = 0; i < kKeys; i++) {
+        ASSERT_TRUE(filter.mayContain(hashOf(i))) << i;
+    }
+}
@@ -0,0 +1,75 @@
+// tests/storage/hash_index_test.cpp
+#include "storage/hash_index.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+struct Item {
+    std::string key;
+    int value;
+};
+
+}  // namespace
+
+TEST(HashIndexTest, InsertFindErase) {
+    HashIndex<std::string, Item> index;
+    Item a{"a", 1};
+    Item b{"b", 2};
+
+    index.insert(a.key, &a);
+    index.insert(b.key, &b);
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_EQ(index.find("a"), &a);
+    EXPECT_EQ(index.find("b"), &b);
+    EXPECT_EQ(index.find("c"), nullptr);
+
+    // 替换同一个 key 的指针
+    Item a2{"a", 3};
+    index.insert(a2.key, &a2);
+    EXPECT_EQ(index.size(), 2u);
+    EXPECT_EQ(index.find("a"), &a2);
+
+    EXPECT_TRUE(index.erase("a"));
+    EXPECT_FALSE(index.erase("a"));
+    EXPECT_EQ(index.find("a"), nullptr);
+    EXPECT_EQ(index.find("b"), &b);
+    EXPECT_EQ(index.size(), 1u);
+
+    index.clear();
+    EXPECT_EQ(index.size(), 0u);
+    EXPECT_EQ(index.find("b"), nullptr);
+}
+
+TEST(HashIndexTest, GrowsAndReusesTombstones) {
+    HashIndex<std::string, Item> index;
+    const int count = 10000;
+    std::vector<Item> items(count);
+    for (int i = 0; i < count; i++) {
+        items[i].key = "key" + std::to_string(i);
+        items[i].value = i;
+        index.insert(items[i].key, &items[i]);
+    }
+    EXPECT_EQ(index.size(), static_cast<size_t>(count));
+    size_t grownMemory = index.memoryUsage();
+
+    // 反复删除再插入，墓碑不应让表无限增长
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < count; i += 2) {
+            ASSERT_TRUE(index.erase(items[i].key));
+        }
+        for (int i = 0; i < count; i += 2) {
+            index.insert(items[i].key, &items[i]);
+        }
+    }
+    EXPECT_EQ(index.memoryUsage(), grownMemory);
+
+    for (int i = 0; i < count; i++) {
+        ASSERT_EQ(index.find(items[i].key), &items[i]);
+    }
+}
@@ -1,10 +1,16 @@
 // tests/storage/kvstore_test.cpp
 #include "storage/kvstore.h"
+#include "base/count_down_latch.h"
+#include "base/threadpool.h"
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <string>
+#include <thread>
+#include <vector>
 
 using namespace kvstore;
 
@@ -216,3 +222,662 @@ TEST_F(KVStoreTest, LargeDataSet) {
 
     std::remove(filepath.c_str());
 }
+
+// ==================== 无锁跳表引擎 ====================
+
+TEST(KVStoreEngineTest, LockFreeEngine) {
+    KVStoreOptions options;
+    options.skipListType = SkipListType::kLockFree;
+    KVStore store(options);
+    EXPECT_EQ(store.skipListType(), SkipListType::kLockFree);
+
+    EXPECT_TRUE(store.put("name", "Alice"));
+    EXPECT_FALSE(store.put("name", "Bob"));
+    EXPECT_TRUE(store.put("city", "Beijing"));
+
+    std::string value;
+    EXPECT_TRUE(store.get("name", value));
+    EXPECT_EQ(value, "Bob");
+    EXPECT_TRUE(store.del("city"));
+    EXPECT_FALSE(store.exists("city"));
+    EXPECT_EQ(store.size(), 1);
+
+    std::string filepath = "/tmp/kvstore_lockfree_test.db";
+    EXPECT_TRUE(store.save(filepath));
+
+    KVStore newStore(options);
+    EXPECT_TRUE(newStore.load(filepath));
+    EXPECT_EQ(newStore.size(), 1);
+    EXPECT_TRUE(newStore.get("name", value));
+    EXPECT_EQ(value, "Bob");
+
+    std::remove(filepath.c_str());
+}
+
+// ==================== 分片 ====================
+
+TEST(KVStoreShardTest, RoutesAndFansOut) {
+    KVStoreOptions options;
+    options.shards = 4;
+    KVStore store(options);
+    EXPECT_EQ(store.shardCount(), 4);
+
+    const int count = 1000;
+    std::vector<int> perShard(store.shardCount(), 0);
+    for (int i = 0; i < count; i++) {
+        std::string key = "key" + std::to_string(i);
+        EXPECT_TRUE(store.put(key, "value" + std::to_string(i)));
+        perShard[store.shardIndex(key)]++;
+    }
+    EXPECT_EQ(store.size(), count);
+    for (int n : perShard) {
+        EXPECT_GT(n, 0);  // 每个分片都分到了数据
+    }
+
+    std::string value;
+    EXPECT_TRUE(store.get("key42", value));
+    EXPECT_EQ(value, "value42");
+    EXPECT_TRUE(store.del("key42"));
+    EXPECT_FALSE(store.exists("key42"));
+
+    // 保存后用不同的分片数加载
+    std::string filepath = "/tmp/kvstore_shard_test.db";
+    EXPECT_TRUE(store.save(filepath));
+
+    KVStore single;
+    EXPECT_TRUE(single.load(filepath));
+    EXPECT_EQ(single.size(), count - 1);
+    EXPECT_TRUE(single.get("key999", value));
+    EXPECT_EQ(value, "value999");
+
+    store.clear();
+    EXPECT_EQ(store.size(), 0);
+    EXPECT_TRUE(store.load(filepath));
+    EXPECT_EQ(store.size(), count - 1);
+
+    std::remove(filepath.c_str());
+}
+
+TEST(KVStoreShardTest, ConcurrentWriters) {
+    KVStoreOptions options;
+    options.shards = 8;
+    KVStore store(options);
+
+    const int numThreads = 4;
+    const int numPerThread = 2000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([&store, t, numPerThread]() {
+            for (int i = 0; i < numPerThread; i++) {
+                store.put("t" + std::to_string(t) + "_" + std::to_string(i), "value");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(store.size(), numThreads * numPerThread);
+}
+
+TEST(KVStoreShardTest, OwnerThreadsWriteWithoutLocks) {
+    const std::string filepath = "/tmp/kvstore_owner_test.db";
+    const std::string walPath = "/tmp/kvstore_owner_test.wal";
+    std::remove(filepath.c_str());
+    std::remove(walPath.c_str());
+
+    // 两个所属线程，分片 i 归 owners[i % 2]
+    ThreadPool owners[2];
+    owners[0].start(1);
+    owners[1].start(1);
+    KVStoreOptions options;
+    options.shards = 4;
+    KVStore store(options);
+    WalOptions walOptions;
+    walOptions.syncPolicy = WalSyncPolicy::kAlways;  // syncLog 之后日志已经写进文件
+    ASSERT_TRUE(store.openLog(walPath, walOptions));
+    ASSERT_TRUE(store.setShardOwners([&owners](int shard, const std::function<void()>& task) {
+        owners[shard % 2].run(task);
+    }));
+    EXPECT_TRUE(store.hasShardOwners());
+
+    // 在 key 所在分片的所属线程中执行 fn，等它执行完
+    auto onOwner = [&store, &owners](const std::string& key, const std::function<void()>& fn) {
+        CountDownLatch latch(1);
+        owners[store.shardIndex(key) % 2].run([&fn, &latch]() {
+            fn();
+            latch.countDown();
+        });
+        latch.wait();
+    };
+    const int count = 500;
+    for (int i = 0; i < count; i++) {
+        std::string key = "key" + std::to_string(i);
+        onOwner(key, [&store, key]() { store.put(key, "v1"); });
+    }
+
+    // 后台保存期间接着写：快照由所属线程固定，之后的写入在新日志里
+    ASSERT_TRUE(store.saveInBackground(filepath));
+    for (int i = 0; i < count; i += 2) {
+        std::string key = "key" + std::to_string(i);
+        onOwner(key, [&store, key]() { store.put(key, "v2"); });
+    }
+    onOwner("key1", [&store]() { store.del("key1"); });
+    while (store.isSaving()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // 每个分片在所属线程中遍历
+    int scanned = 0;
+    for (int shard = 0; shard < store.shardCount(); shard++) {
+        CountDownLatch latch(1);
+        owners[shard % 2].run([&store, &scanned, &latch, shard]() {
+            scanned += static_cast<int>(store.scanShard(shard, "", "", 0,
+                                                        [](const std::string&, const Value&) {
+                                                            return true;
+                                                        }));
+            latch.countDown();
+        });
+        latch.wait();
+    }
+    EXPECT_EQ(scanned, count - 1);
+    store.syncLog();
+
+    // 快照加上重放日志得到最新的数据
+    KVStore recovered(options);
+    ASSERT_TRUE(recovered.load(filepath));
+    ASSERT_TRUE(recovered.openLog(walPath, WalOptions()));
+    EXPECT_EQ(recovered.size(), count - 1);
+    std::string value;
+    EXPECT_FALSE(recovered.exists("key1"));
+    EXPECT_TRUE(recovered.get("key2", value));
+    EXPECT_EQ(value, "v2");
+    EXPECT_TRUE(recovered.get("key3", value));
+    EXPECT_EQ(value, "v1");
+
+    owners[0].stop();
+    owners[1].stop();
+    std::remove(filepath.c_str());
+    std::remove(walPath.c_str());
+}
+
+TEST(KVStoreShardTest, OwnerThreadsNeedLocalWrites) {
+    // 淘汰要在其他线程中写分片
+    KVStoreOptions options;
+    options.maxMemory = 1 << 20;
+    KVStore store(options);
+    EXPECT_FALSE(store.setShardOwners([](int, const std::function<void()>& task) { task(); }));
+    EXPECT_FALSE(store.hasShardOwners());
+}
+
+// ==================== 有序遍历 ====================
+
+TEST(KVStoreScanTest, MergesShardsInKeyOrder) {
+    KVStoreOptions options;
+    options.shards = 4;
+    KVStore store(options);
+    for (int i = 0; i < 200; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%03d", i);
+        store.put(key, std::to_string(i));
+    }
+
+    std::vector<std::string> keys;
+    auto collect = [&keys](const std::string& key, const Value&) {
+        keys.push_back(key);
+        return true;
+    };
+
+    // [key010, key019]
+    EXPECT_EQ(store.scan("key010", "key019", 0, collect), 10u);
+    ASSERT_EQ(keys.size(), 10u);
+    EXPECT_EQ(keys.front(), "key010");
+    EXPECT_EQ(keys.back(), "key019");
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+    // 全表 + LIMIT
+    keys.clear();
+    EXPECT_EQ(store.scan("", "", 25, collect), 25u);
+    EXPECT_EQ(keys.front(), "key000");
+    EXPECT_EQ(keys.back(), "key024");
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+    // 回调返回 false 提前结束
+    int visited = 0;
+    store.scan("", "", 0, [&visited](const std::string&, const Value&) {
+        return ++visited < 3;
+    });
+    EXPECT_EQ(visited, 3);
+
+    keys.clear();
+    EXPECT_EQ(store.scan("zzz", "", 0, collect), 0u);
+    EXPECT_TRUE(keys.empty());
+}
+
+TEST(KVStoreValueTest, GetReturnsValueWithoutCopy) {
+    KVStore store;
+    store.put("small", "tiny");
+    std::string large(1000, 'x');
+    store.put("large", large);
+
+    Value value;
+    ASSERT_TRUE(store.get("small", value));
+    EXPECT_TRUE(value.isInline());
+    EXPECT_EQ(value.toString(), "tiny");
+
+    ASSERT_TRUE(store.get("large", value));
+    EXPECT_FALSE(value.isInline());
+    Value again;
+    ASSERT_TRUE(store.get("large", again));
+    EXPECT_EQ(again.data(), value.data());  // 共享存储中的同一块 Blob
+
+    // 读出的值不受之后的更新和删除影响
+    store.put("large", "replaced");
+    store.del("small");
+    EXPECT_EQ(value.toString(), large);
+    EXPECT_FALSE(store.get("small", again));
+}
+
+// ==================== 布隆过滤器 ====================
+
+TEST(KVStoreFilterTest, MissesAreFilteredBeforeTheSkipList) {
+    KVStoreOptions options;
+    options.shards = 4;
+    KVStore store(options);
+    for (int i = 0; i < 5000; i++) {
+        store.put("key" + std::to_string(i), "v");
+    }
+    for (int i = 0; i < 5000; i++) {
+        ASSERT_TRUE(store.exists("key" + std::to_string(i)));
+    }
+    std::string value;
+    for (int i = 0; i < 10000; i++) {
+        EXPECT_FALSE(store.get("missing" + std::to_string(i), value));
+    }
+
+    MemtableFilter::Stats stats = store.filterStats();
+    EXPECT_EQ(stats.negatives + stats.falsePositives, 10000u);
+    EXPECT_LT(stats.falsePositiveRate(), 0.05);
+    EXPECT_GT(stats.rebuilds, 0u);  // 超出初始容量后重建过
+
+    // 删除后的 key 不再命中，统计里计为误判
+    store.del("key1");
+    EXPECT_FALSE(store.exists("key1"));
+    EXPECT_EQ(store.filterStats().falsePositives, stats.falsePositives + 1);
+}
+
+TEST(KVStoreFilterTest, RebuiltAfterLoad) {
+    const std::string filepath = "/tmp/kvstore_filter_test.db";
+    {
+        KVStore store;
+        for (int i = 0; i < 3000; i++) {
+            store.put("key" + std::to_string(i), std::to_string(i));
+        }
+        ASSERT_TRUE(store.save(filepath));
+    }
+    for (int threads : {1, 2}) {
+        KVStoreOptions options;
+        options.shards = 3;
+        options.loadThreads = threads;
+        KVStore store(options);
+        ASSERT_TRUE(store.load(filepath));
+        std::string value;
+        for (int i = 0; i < 3000; i++) {
+            ASSERT_TRUE(store.get("key" + std::to_string(i), value)) << i;
+            EXPECT_EQ(value, std::to_string(i));
+        }
+        EXPECT_FALSE(store.exists("key3000"));
+    }
+    std::remove(filepath.c_str());
+}
+
+TEST(KVStoreFilterTest, CanBeDisabled) {
+    KVStoreOptions options;
+    options.bloomBitsPerKey = 0;
+    KVStore store(options);
+    store.put("a", "1");
+    EXPECT_TRUE(store.exists("a"));
+    EXPECT_FALSE(store.exists("b"));
+    MemtableFilter::Stats stats = store.filterStats();
+    EXPECT_EQ(stats.negatives, 0u);
+    EXPECT_EQ(stats.bytes, 0u);
+}
+
+// ==================== 批量命令 ====================
+
+namespace {
+
+std::vector<KVStoreOptions> batchConfigurations() {
+    std::vector<KVStoreOptions> configs(4);
+    configs[1].shards = 4;
+    configs[2].shards = 4;
+    configs[2].hashIndex = true;
+    configs[3].prefixCompression = true;
+    return configs;
+}
+
+}  // namespace
+
+TEST(KVStoreBatchTest, MatchesSingleKeyOperations) {
+    for (const KVStoreOptions& options : batchConfigurations()) {
+        KVStore store(options);
+        std::vector<std::string> keys;
+        std::vector<Value> values;
+        for (int i = 0; i < 200; i++) {
+            keys.push_back("user:" + std::to_string(i * 7 % 200));
+            values.emplace_back("v" + std::to_string(i));
+        }
+        ASSERT_TRUE(store.put("user:3", "old"));
+        EXPECT_EQ(store.multiPut(keys, values), 199u);  // user:3 已经存在
+        EXPECT_EQ(store.size(), 200);
+
+        std::vector<std::string> lookups = {"user:14", "missing", "user:3", "user:14", "user:0"};
+        std::vector<Value> found;
+        std::vector<bool> present;
+        EXPECT_EQ(store.multiGet(lookups, &found, &present), 4u);
+        ASSERT_EQ(found.size(), lookups.size());
+        ASSERT_EQ(present.size(), lookups.size());
+        for (size_t i = 0; i < lookups.size(); i++) {
+            std::string value;
+            EXPECT_EQ(present[i], store.get(lookups[i], value)) << lookups[i];
+            if (present[i]) {
+                EXPECT_EQ(found[i].toString(), value);
+            }
+        }
+
+        std::vector<std::string> removals = {"user:5", "missing", "user:5", "user:199"};
+        EXPECT_EQ(store.multiDel(removals), 2u);
+        EXPECT_FALSE(store.exists("user:5"));
+        EXPECT_FALSE(store.exists("user:199"));
+        EXPECT_EQ(store.size(), 198);
+    }
+}
+
+TEST(KVStoreBatchTest, LaterDuplicateWins) {
+    KVStoreOptions options;
+    options.shards = 2;
+    KVStore store(options);
+    std::vector<std::string> keys = {"k", "a", "k"};
+    std::vector<Value> values = {Value("first"), Value("x"), Value("second")};
+    EXPECT_EQ(store.multiPut(keys, values), 2u);
+    std::string value;
+    EXPECT_TRUE(store.get("k", value));
+    EXPECT_EQ(value, "second");
+
+    // 有空 key 时整批拒绝
+    keys = {"b", ""};
+    values = {Value("1"), Value("2")};
+    EXPECT_EQ(store.multiPut(keys, values), 0u);
+    EXPECT_FALSE(store.exists("b"));
+}
+
+TEST(KVStoreBatchTest, SkipsExpiredKeys) {
+    KVStore store;
+    const int64_t now = KVStore::nowMs();
+    store.put("live", "1");
+    store.put("gone", Value("2").withExpiry(now - 1));
+    std::vector<std::string> keys = {"gone", "live"};
+    std::vector<Value> values;
+    std::vector<bool> found;
+    EXPECT_EQ(store.multiGet(keys, &values, &found), 1u);
+    EXPECT_FALSE(found[0]);
+    EXPECT_TRUE(found[1]);
+    EXPECT_EQ(store.multiDel(keys), 1u);
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST(KVStoreBatchTest, LockFreeEngineFallsBackToSingleKeys) {
+    KVStoreOptions options;
+    options.skipListType = SkipListType::kLockFree;
+    options.shards = 2;
+    KVStore store(options);
+    std::vector<std::string> keys = {"b", "a", "c"};
+    std::vector<Value> values = {Value("2"), Value("1"), Value("3")};
+    EXPECT_EQ(store.multiPut(keys, values), 3u);
+    std::vector<Value> found;
+    std::vector<bool> present;
+    EXPECT_EQ(store.multiGet(keys, &found, &present), 3u);
+    EXPECT_EQ(found[0].toString(), "2");
+    EXPECT_EQ(store.multiDel(keys), 3u);
+    EXPECT_EQ(store.size(), 0);
+}
+
+// ==================== 过期时间 ====================
+
+TEST(KVStoreExpiryTest, ExpiredKeysAreInvisible) {
+    KVStore store;
+    const int64_t now = KVStore::nowMs();
+    store.put("live", Value("v").withExpiry(now + 60000));
+    store.put("dead", Value("v").withExpiry(now - 1));
+    store.put("plain", "v");
+
+    std::string value;
+    EXPECT_TRUE(store.get("live", value));
+    EXPECT_FALSE(store.get("dead", value));
+    EXPECT_FALSE(store.exists("dead"));
+    EXPECT_FALSE(store.del("dead"));
+    EXPECT_EQ(store.expireAt("live"), now + 60000);
+    EXPECT_EQ(store.expireAt("plain"), 0);
+    EXPECT_EQ(store.expireAt("dead"), -1);
+
+    std::vector<std::string> keys;
+    store.scan("", "", 0, [&keys](const std::string& key, const Value&) {
+        keys.push_back(key);
+        return true;
+    });
+    EXPECT_EQ(keys, (std::vector<std::string>{"live", "plain"}));
+}
+
+TEST(KVStoreExpiryTest, ExpireSetsClearsAndDeletes) {
+    KVStore store;
+    const int64_t now = KVStore::nowMs();
+    store.put("a", "1");
+    EXPECT_FALSE(store.expire("missing", now + 1000));
+
+    EXPECT_TRUE(store.expire("a", now + 1000));
+    EXPECT_EQ(store.expireAt("a"), now + 1000);
+    std::string value;
+    ASSERT_TRUE(store.get("a", value));
+    EXPECT_EQ(value, "1");
+
+    EXPECT_TRUE(store.expire("a", 0));  // 去掉过期时间
+    EXPECT_EQ(store.expireAt("a"), 0);
+
+    EXPECT_TRUE(store.expire("a", now - 1));  // 过去的时刻等同于删除
+    EXPECT_FALSE(store.exists("a"));
+    EXPECT_EQ(store.size(), 0);
+
+    // 重新写入会去掉过期时间
+    store.put("b", Value("2").withExpiry(now + 1000));
+    store.put("b", "3");
+    EXPECT_EQ(store.expireAt("b"), 0);
+}
+
+TEST(KVStoreExpiryTest, ExpireIfDueKeepsRewrittenKeys) {
+    KVStore store;
+    ASSERT_TRUE(store.activeExpiry());
+    const int64_t now = KVStore::nowMs();
+    store.put("due", Value("v").withExpiry(now - 1));
+    store.put("later", Value("v").withExpiry(now + 60000));
+    store.put("plain", "v");
+
+    EXPECT_TRUE(store.expireIfDue("due"));
+    EXPECT_FALSE(store.expireIfDue("later"));
+    EXPECT_FALSE(store.expireIfDue("plain"));
+    EXPECT_EQ(store.size(), 2);
+}
+
+TEST(KVStoreExpiryTest, ExpireShardSweepsInBatches) {
+    KVStoreOptions options;
+    options.shards = 2;
+    KVStore store(options);
+    const int64_t now = KVStore::nowMs();
+    for (int i = 0; i < 100; i++) {
+        const std::string key = "k" + std::to_string(i);
+        if (i % 2 == 0) {
+            store.put(key, Value("v").withExpiry(now - 1));
+        } else {
+            store.put(key, Value("v").withExpiry(now + 60000));
+        }
+    }
+    EXPECT_EQ(store.size(), 100);
+
+    // 每次最多检查 10 个 key，cursor 回到空串时扫完一个分片
+    size_t removed = 0;
+    for (int shard = 0; shard < store.shardCount(); shard++) {
+        std::string cursor;
+        int steps = 0;
+        do {
+            removed += store.expireShard(shard, &cursor, 10);
+            steps++;
+        } while (!cursor.empty());
+        EXPECT_GT(steps, 1);
+    }
+    EXPECT_EQ(removed, 50u);
+    EXPECT_EQ(store.size(), 50);
+    EXPECT_TRUE(store.exists("k1"));
+    EXPECT_FALSE(store.exists("k0"));
+}
+
+TEST(KVStoreExpiryTest, SaveAndLoadKeepExpiry) {
+    const std::string filepath = "/tmp/kvstore_expiry_test.db";
+    const int64_t now = KVStore::nowMs();
+    {
+        KVStore store;
+        store.put("live", Value("v").withExpiry(now + 60000));
+        store.put("plain", "v");
+        store.put("dead", Value("v").withExpiry(now - 1));
+        ASSERT_TRUE(store.save(filepath));
+    }
+    KVStore store;
+    ASSERT_TRUE(store.load(filepath));
+    EXPECT_EQ(store.size(), 2);  // 已经过期的记录不加载
+    EXPECT_EQ(store.expireAt("live"), now + 60000);
+    EXPECT_EQ(store.expireAt("plain"), 0);
+    std::remove(filepath.c_str());
+}
+
+TEST(KVStoreExpiryTest, LockFreeEngineExpiresLazily) {
+    KVStoreOptions options;
+    options.skipListType = SkipListType::kLockFree;
+    KVStore store(options);
+    EXPECT_FALSE(store.activeExpiry());
+    const int64_t now = KVStore::nowMs();
+    store.put("a", "1");
+    EXPECT_TRUE(store.expire("a", now + 60000));
+    EXPECT_EQ(store.expireAt("a"), now + 60000);
+    EXPECT_TRUE(store.expire("a", now - 1));
+    EXPECT_FALSE(store.exists("a"));
+    EXPECT_FALSE(store.expireIfDue("a"));
+}
+
+// ==================== 内存上限测试 ====================
+
+TEST(KVStoreEvictionTest, StaysWithinMaxMemory) {
+    KVStoreOptions options;
+    options.shards = 4;
+    options.maxMemory = 256 * 1024;
+    KVStore store(options);
+    const std::string value(200, 'v');
+    for (int i = 0; i < 5000; i++) {
+        store.put("key" + std::to_string(i), value);
+        // 新记录按层数为 0 估计，超出的部分不超过一个节点的各层指针
+        ASSERT_LE(store.memoryUsed(), options.maxMemory + 16 * sizeof(void*));
+    }
+    EXPECT_GT(store.evictedKeys(), 0u);
+    EXPECT_EQ(static_cast<uint64_t>(store.size()) + store.evictedKeys(), 5000u);
+    // 最近写入的 key 还在
+    EXPECT_TRUE(store.exists("key4999"));
+
+    store.clear();
+    EXPECT_EQ(store.memoryUsed(), 0u);
+}
+
+TEST(KVStoreEvictionTest, LruKeepsRecentlyReadKeys) {
+    KVStoreOptions options;
+    options.maxMemory = 512 * 1024;
+    KVStore store(options);
+    const std::string value(100, 'v');
+    for (int i = 0; i < 100; i++) {
+        store.put("hot" + std::to_string(i), value);
+    }
+    int cold = 0;
+    while (store.memoryUsed() < options.maxMemory * 9 / 10) {
+        store.put("cold" + std::to_string(cold++), value);
+    }
+    // 访问字的精度是秒：一秒之后只读热 key，再写入新 key 触发淘汰
+    std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+    std::string out;
+    for (int j = 0; j < 100; j++) {
+        store.get("hot" + std::to_string(j), out);
+    }
+    for (int i = 0; i < cold / 2; i++) {
+        store.put("new" + std::to_string(i), value);
+    }
+    EXPECT_GT(store.evictedKeys(), 0u);
+    int hot = 0;
+    for (int j = 0; j < 100; j++) {
+        hot += store.exists("hot" + std::to_string(j)) ? 1 : 0;
+    }
+    // 写入新 key 期间跨过秒边界时热 key 与冷 key 的空闲时间可能相同，允许少量误淘汰
+    EXPECT_GE(hot, 95);
+}
+
+TEST(KVStoreEvictionTest, LfuKeepsFrequentlyReadKeys) {
+    KVStoreOptions options;
+    options.maxMemory = 512 * 1024;
+    options.evictionPolicy = EvictionPolicy::kLfu;
+    KVStore store(options);
+    const std::string value(100, 'v');
+    std::string out;
+    for (int i = 0; i < 100; i++) {
+        store.put("hot" + std::to_string(i), value);
+        for (int n = 0; n < 200; n++) {
+            store.get("hot" + std::to_string(i), out);
+        }
+    }
+    for (int i = 0; i < 20000; i++) {
+        store.put("cold" + std::to_string(i), value);
+    }
+    EXPECT_GT(store.evictedKeys(), 10000u);
+    int hot = 0;
+    for (int j = 0; j < 100; j++) {
+        hot += store.exists("hot" + std::to_string(j)) ? 1 : 0;
+    }
+    EXPECT_GE(hot, 95);
+}
+
+TEST(KVStoreEvictionTest, ExpiredKeysGoFirstAndAreNotCounted) {
+    KVStoreOptions options;
+    options.maxMemory = 64 * 1024;
+    KVStore store(options);
+    const std::string value(100, 'v');
+    const int64_t past = KVStore::nowMs() - 1;
+    int expiring = 0;
+    while (store.memoryUsed() < options.maxMemory / 2) {
+        store.put("exp" + std::to_string(expiring++), Value(value).withExpiry(past));
+    }
+    for (int i = 0; i < 200; i++) {
+        store.put("live" + std::to_string(i), value);
+    }
+    // 采样是近似的：一轮 5 个样本可能都没有过期的 key，偶尔会淘汰一个未过期的 key
+    EXPECT_LE(store.evictedKeys(), 2u);
+    int missing = 0;
+    for (int i = 0; i < 200; i++) {
+        missing += store.exists("live" + std::to_string(i)) ? 0 : 1;
+    }
+    // 只有未过期的 key 计入 evicted_keys
+    EXPECT_EQ(static_cast<size_t>(missing), store.evictedKeys());
+}
+
+TEST(KVStoreEvictionTest, UnsupportedConfigurationsIgnoreTheLimit) {
+    KVStoreOptions options;
+    options.skipListType = SkipListType::kLockFree;
+    options.maxMemory = 1024;
+    KVStore store(options);
+    EXPECT_EQ(store.maxMemory(), 0u);
+    for (int i = 0; i < 1000; i++) {
+        store.put("key" + std::to_string(i), std::string(100, 'v'));
+    }
+    EXPECT_EQ(store.size(), 1000);
+    EXPECT_EQ(store.evictedKeys(), 0u);
+}
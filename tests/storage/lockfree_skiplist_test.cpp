@@ -0,0 +1,276 @@
+// tests/storage/lockfree_skiplist_test.cpp
+#include "storage/lockfree_skiplist.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kvstore;
+
+class LockFreeSkipListTest : public ::testing::Test {
+protected:
+    LockFreeSkipList<std::string, std::string> skiplist_;
+};
+
+// ==================== 基本功能测试 ====================
+
+TEST_F(LockFreeSkipListTest, InsertSearchRemove) {
+    EXPECT_TRUE(skiplist_.insert("key1", "value1"));
+    EXPECT_TRUE(skiplist_.insert("key2", "value2"));
+    EXPECT_FALSE(skiplist_.insert("key1", "new_value1"));  // 更新
+    EXPECT_EQ(skiplist_.size(), 2);
+
+    std::string value;
+    EXPECT_TRUE(skiplist_.search("key1", value));
+    EXPECT_EQ(value, "new_value1");
+
+    EXPECT_TRUE(skiplist_.remove("key1"));
+    EXPECT_FALSE(skiplist_.remove("key1"));
+    EXPECT_FALSE(skiplist_.search("key1", value));
+    EXPECT_TRUE(skiplist_.contains("key2"));
+    EXPECT_EQ(skiplist_.size(), 1);
+}
+
+TEST_F(LockFreeSkipListTest, ReinsertAfterRemove) {
+    for (int round = 0; round < 3; round++) {
+        EXPECT_TRUE(skiplist_.insert("key", "v" + std::to_string(round)));
+        std::string value;
+        EXPECT_TRUE(skiplist_.search("key", value));
+        EXPECT_EQ(value, "v" + std::to_string(round));
+        EXPECT_TRUE(skiplist_.remove("key"));
+    }
+    EXPECT_EQ(skiplist_.size(), 0);
+}
+
+TEST_F(LockFreeSkipListTest, Clear) {
+    for (int i = 0; i < 100; i++) {
+        skiplist_.insert("key" + std::to_string(i), "value");
+    }
+    skiplist_.clear();
+    EXPECT_EQ(skiplist_.size(), 0);
+    EXPECT_FALSE(skiplist_.contains("key1"));
+
+    EXPECT_TRUE(skiplist_.insert("key1", "again"));
+    EXPECT_EQ(skiplist_.size(), 1);
+}
+
+TEST_F(LockFreeSkipListTest, DumpAndLoad) {
+    skiplist_.insert("name", "Alice");
+    skiplist_.insert("city", "Beijing");
+    skiplist_.remove("city");
+
+    std::string filepath = "/tmp/lockfree_skiplist_test.db";
+    EXPECT_TRUE(skiplist_.dumpFile(filepath));
+
+    LockFreeSkipList<std::string, std::string> loaded;
+    EXPECT_TRUE(loaded.loadFile(filepath));
+    EXPECT_EQ(loaded.size(), 1);
+
+    std::string value;
+    EXPECT_TRUE(loaded.search("name", value));
+    EXPECT_EQ(value, "Alice");
+
+    std::remove(filepath.c_str());
+}
+
+// ==================== 多线程测试 ====================
+
+TEST_F(LockFreeSkipListTest, ConcurrentInsert) {
+    const int numThreads = 8;
+    const int numPerThread = 2000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([this, t, numPerThread]() {
+            for (int i = 0; i < numPerThread; i++) {
+                skiplist_.insert("t" + std::to_string(t) + "_key" + std::to_string(i), "value");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(skiplist_.size(), numThreads * numPerThread);
+    for (int t = 0; t < numThreads; t++) {
+        for (int i = 0; i < numPerThread; i++) {
+            ASSERT_TRUE(skiplist_.contains("t" + std::to_string(t) + "_key" + std::to_string(i)));
+        }
+    }
+}
+
+TEST_F(LockFreeSkipListTest, ConcurrentInsertRemoveSameKeys) {
+    // 多个线程对同一批 key 反复插入/删除，最后每个 key 的存在性与计数保持一致
+    const int numThreads = 4;
+    const int numKeys = 200;
+    const int rounds = 200;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; t++) {
+        threads.emplace_back([this, t]() {
+            for (int r = 0; r < rounds; r++) {
+                for (int i = t; i < numKeys; i += 2) {
+                    std::string key = "key" + std::to_string(i);
+                    if ((r + t) % 2 == 0) {
+                        skiplist_.insert(key, "value" + std::to_string(r));
+                    } else {
+                        skiplist_.remove(key);
+                    }
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    int present = 0;
+    for (int i = 0; i < numKeys; i++) {
+        if (skiplist_.contains("key" + std::to_string(i))) {
+            present++;
+        }
+    }
+    EXPECT_EQ(skiplist_.size(), present);
+}
+
+TEST_F(LockFreeSkipListTest, ConcurrentReadWrite) {
+    for (int i = 0; i < 1000; i++) {
+        skiplist_.insert("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([this, &stop, &mismatches]() {
+            std::string value;
+            while (!stop) {
+                for (int i = 0; i < 1000; i += 7) {
+                    std::string key = "key" + std::to_string(i);
+                    // 偶数 key 从不被删除
+                    if (i % 2 == 0 && !skiplist_.search(key, value)) {
+                        mismatches++;
+                    }
+                }
+            }
+        });
+    }
+
+    std::thread writer([this]() {
+        for (int r = 0; r < 50; r++) {
+            for (int i = 1; i < 1000; i += 2) {
+                skiplist_.remove("key" + std::to_string(i));
+            }
+            for (int i = 0; i < 1000; i++) {
+                skiplist_.insert("key" + std::to_string(i), "round" + std::to_string(r));
+            }
+        }
+    });
+
+    writer.join();
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0);
+    EXPECT_EQ(skiplist_.size(), 1000);
+}
+
+TEST_F(LockFreeSkipListTest, IteratorSkipsRemovedKeys) {
+    for (int i = 0; i < 10; i++) {
+        skiplist_.insert("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    skiplist_.remove("key0");
+    skiplist_.remove("key5");
+
+    LockFreeSkipList<std::string, std::string>::Iterator it(&skiplist_);
+    std::vector<std::string> keys;
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        keys.push_back(it.key());
+    }
+    EXPECT_EQ(keys, (std::vector<std::string>{"key1", "key2", "key3", "key4", "key6", "key7",
+                                              "key8", "key9"}));
+
+    it.seek("key5");
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), "key6");
+    EXPECT_EQ(it.value(), "value6");
+}
+
+// ==================== 内存回收测试 ====================
+
+TEST_F(LockFreeSkipListTest, OverwritesDoNotAccumulateRetiredValues) {
+    for (int i = 0; i < 100000; i++) {
+        skiplist_.insert("key", "value" + std::to_string(i));
+    }
+    // 没有并发读者时，被覆盖的旧值每攒够一批就释放
+    EXPECT_LT(skiplist_.retiredCount(), 128u);
+
+    std::string value;
+    EXPECT_TRUE(skiplist_.search("key", value));
+    EXPECT_EQ(value, "value99999");
+}
+
+TEST_F(LockFreeSkipListTest, RemovedNodesAreReclaimed) {
+    for (int round = 0; round < 1000; round++) {
+        for (int i = 0; i < 10; i++) {
+            skiplist_.insert("key" + std::to_string(i), "value");
+        }
+        for (int i = 0; i < 10; i++) {
+            EXPECT_TRUE(skiplist_.remove("key" + std::to_string(i)));
+        }
+    }
+    EXPECT_LT(skiplist_.retiredCount(), 128u);
+
+    for (int i = 0; i < 1000; i++) {
+        skiplist_.insert("key" + std::to_string(i), "value");
+    }
+    skiplist_.clear();
+    EXPECT_EQ(skiplist_.size(), 0);
+    EXPECT_EQ(skiplist_.retiredCount(), 0u);
+}
+
+TEST_F(LockFreeSkipListTest, ReclaimWithConcurrentReaders) {
+    std::atomic<bool> stop(false);
+    std::atomic<int> mismatches(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([this, &stop, &mismatches]() {
+            std::string value;
+            while (!stop.load()) {
+                if (skiplist_.search("hot", value) && value.compare(0, 5, "value") != 0) {
+                    mismatches++;
+                }
+                LockFreeSkipList<std::string, std::string>::Iterator it(&skiplist_);
+                for (it.seekToFirst(); it.valid(); it.next()) {
+                    if (it.value().compare(0, 5, "value") != 0) {
+                        mismatches++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int i = 0; i < 20000; i++) {
+        skiplist_.insert("hot", "value" + std::to_string(i));
+        skiplist_.insert("tmp" + std::to_string(i % 50), "value");
+        skiplist_.remove("tmp" + std::to_string((i + 25) % 50));
+    }
+    stop = true;
+    for (auto& t : readers) {
+        t.join();
+    }
+
+    EXPECT_EQ(mismatches.load(), 0);
+    // 读者退出后再做一次会触发回收的写入，积压的对象被释放
+    for (int i = 0; i < 200; i++) {
+        skiplist_.insert("hot", "value");
+    }
+    EXPECT_LT(skiplist_.retiredCount(), 128u);
+}
@@ -4,7 +4,11 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <atomic>
+#include <map>
 #include <random>
+#include <set>
+#include <sstream>
 #include <string>
 #include <thread>
 #include <vector>
@@ -315,3 +319,649 @@ TEST(IntSkipListTest, IntegerKeys) {
     EXPECT_TRUE(intSkiplist.remove(2));
     EXPECT_FALSE(intSkiplist.search(2, value));
 }
+
+// ==================== 内存复用测试 ====================
+
+TEST(SkipListMemoryTest, RemovedNodesAreReused) {
+    SkipList<std::string, std::string> skiplist;
+    for (int i = 0; i < 1000; i++) {
+        skiplist.insert("key" + std::to_string(i), "value");
+    }
+    size_t usage = skiplist.memoryUsage();
+    EXPECT_GT(usage, 0u);
+
+    // 反复删除再插入同样数量的 key，节点内存从空闲链表复用，Arena 不应明显增长
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < 1000; i++) {
+            skiplist.remove("key" + std::to_string(i));
+        }
+        for (int i = 0; i < 1000; i++) {
+            skiplist.insert("key" + std::to_string(i), "value" + std::to_string(round));
+        }
+    }
+    EXPECT_EQ(skiplist.size(), 1000);
+    EXPECT_LT(skiplist.memoryUsage(), usage * 2);
+
+    std::string value;
+    EXPECT_TRUE(skiplist.search("key999", value));
+    EXPECT_EQ(value, "value4");
+}
+
+// ==================== 无锁读测试 ====================
+
+TEST(SkipListRcuTest, ReadersDuringUpdateAndRemove) {
+    SkipList<std::string, std::string> skiplist;
+    const int count = 500;
+    for (int i = 0; i < count; i++) {
+        skiplist.insert("key" + std::to_string(i), "value");
+    }
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&]() {
+            std::string value;
+            while (!stop) {
+                for (int i = 0; i < count; i += 3) {
+                    std::string key = "key" + std::to_string(i);
+                    bool found = skiplist.search(key, value);
+                    // 偶数 key 只会被更新，不会被删除；读到的值必须是完整写入过的某个版本
+                    if (i % 2 == 0 && (!found || value.compare(0, 5, "value") != 0)) {
+                        errors++;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 100; round++) {
+        for (int i = 0; i < count; i++) {
+            std::string key = "key" + std::to_string(i);
+            if (i % 2 == 0) {
+                skiplist.insert(key, "value" + std::to_string(round));
+            } else if (round % 2 == 0) {
+                skiplist.remove(key);
+            } else {
+                skiplist.insert(key, "value");
+            }
+        }
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(skiplist.size(), count);
+    std::string value;
+    EXPECT_TRUE(skiplist.search("key0", value));
+    EXPECT_EQ(value, "value99");
+}
+
+// ==================== 哈希索引 ====================
+
+TEST(SkipListHashIndexTest, PointOpsStayInSyncWithList) {
+    SkipList<std::string, std::string> skiplist(16, true);
+    EXPECT_TRUE(skiplist.hasHashIndex());
+
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_TRUE(skiplist.insert("key" + std::to_string(i), "value" + std::to_string(i)));
+    }
+    EXPECT_FALSE(skiplist.insert("key5", "updated"));
+    for (int i = 0; i < 1000; i += 2) {
+        EXPECT_TRUE(skiplist.remove("key" + std::to_string(i)));
+    }
+    EXPECT_FALSE(skiplist.remove("key0"));
+    EXPECT_FALSE(skiplist.remove("missing"));
+    EXPECT_EQ(skiplist.size(), 500);
+
+    std::string value;
+    EXPECT_TRUE(skiplist.search("key5", value));
+    EXPECT_EQ(value, "updated");
+    EXPECT_FALSE(skiplist.contains("key4"));
+    EXPECT_TRUE(skiplist.contains("key999"));
+
+    skiplist.clear();
+    EXPECT_FALSE(skiplist.contains("key999"));
+    EXPECT_TRUE(skiplist.insert("key999", "again"));
+    EXPECT_TRUE(skiplist.search("key999", value));
+    EXPECT_EQ(value, "again");
+}
+
+// ==================== 迭代器 ====================
+
+TEST(SkipListIteratorTest, SeekAndNextInOrder) {
+    SkipList<std::string, std::string> skiplist;
+    for (int i = 0; i < 100; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%03d", i);
+        skiplist.insert(key, "value" + std::to_string(i));
+    }
+
+    SkipList<std::string, std::string>::Iterator it(&skiplist);
+    it.seekToFirst();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), "key000");
+
+    int count = 0;
+    std::string prev;
+    for (; it.valid(); it.next()) {
+        EXPECT_LT(prev, it.key());
+        prev = it.key();
+        count++;
+    }
+    EXPECT_EQ(count, 100);
+
+    it.seek("key0505");  // 不存在，定位到下一个 key
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), "key051");
+    EXPECT_EQ(it.value(), "value51");
+
+    it.seek("key999");
+    EXPECT_FALSE(it.valid());
+}
+
+// ==================== 前缀压缩 ====================
+
+TEST(SkipListPrefixCompressionTest, MatchesReferenceMap) {
+    SkipList<std::string, std::string> skiplist(16, false, true);
+    EXPECT_TRUE(skiplist.hasPrefixCompression());
+    std::map<std::string, std::string> expected;
+
+    // 共享长前缀、长度不一、互为前缀的 key，随机插入 / 更新 / 删除
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<> keyDis(0, 2999);
+    std::uniform_int_distribution<> opDis(0, 9);
+    for (int i = 0; i < 20000; i++) {
+        int n = keyDis(gen);
+        std::string key = "tenant:" + std::to_string(n % 7) + ":user:" + std::to_string(n);
+        if (n % 11 == 0) {
+            key = key.substr(0, key.size() - 1);
+        }
+        if (opDis(gen) < 3) {
+            EXPECT_EQ(skiplist.remove(key), expected.erase(key) == 1);
+        } else {
+            std::string value = "v" + std::to_string(i);
+            EXPECT_EQ(skiplist.insert(key, value), expected.count(key) == 0);
+            expected[key] = value;
+        }
+    }
+    ASSERT_EQ(skiplist.size(), static_cast<int>(expected.size()));
+
+    std::string value;
+    for (int n = 0; n < 3000; n++) {
+        std::string key = "tenant:" + std::to_string(n % 7) + ":user:" + std::to_string(n);
+        auto it = expected.find(key);
+        EXPECT_EQ(skiplist.search(key, value), it != expected.end()) << key;
+        if (it != expected.end()) {
+            EXPECT_EQ(value, it->second);
+        }
+    }
+    EXPECT_FALSE(skiplist.contains("tenant:"));
+    EXPECT_FALSE(skiplist.contains("tenant:9"));
+
+    // 迭代器还原出完整 key，顺序与参照一致
+    SkipList<std::string, std::string>::Iterator it(&skiplist);
+    auto ref = expected.begin();
+    for (it.seekToFirst(); it.valid(); it.next(), ++ref) {
+        ASSERT_NE(ref, expected.end());
+        EXPECT_EQ(it.key(), ref->first);
+        EXPECT_EQ(it.value(), ref->second);
+    }
+    EXPECT_EQ(ref, expected.end());
+
+    it.seek("tenant:3:user:1");
+    ref = expected.lower_bound("tenant:3:user:1");
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), ref->first);
+
+    // dump 输出完整 key
+    std::ostringstream out;
+    EXPECT_TRUE(skiplist.dump(out));
+    std::ostringstream refOut;
+    for (const auto& kv : expected) {
+        refOut << kv.first << ":" << kv.second << "\n";
+    }
+    EXPECT_EQ(out.str(), refOut.str());
+}
+
+TEST(SkipListPrefixCompressionTest, DisabledWithHashIndex) {
+    SkipList<std::string, std::string> skiplist(16, true, true);
+    EXPECT_TRUE(skiplist.hasHashIndex());
+    EXPECT_FALSE(skiplist.hasPrefixCompression());
+
+    // 非字符串 key 不压缩，但选项本身可用
+    SkipList<int, std::string> intSkiplist(16, false, true);
+    for (int i = 0; i < 100; i++) {
+        intSkiplist.insert(i, std::to_string(i));
+    }
+    std::string value;
+    EXPECT_TRUE(intSkiplist.search(42, value));
+    EXPECT_EQ(value, "42");
+}
+
+TEST(SkipListPrefixCompressionTest, ReadersDuringRestartChanges) {
+    SkipList<std::string, std::string> skiplist(16, false, true);
+    const int count = 400;
+    for (int i = 0; i < count; i += 2) {
+        skiplist.insert("tenant:1:user:" + std::to_string(i), "value");
+    }
+
+    // 偶数 key 一直存在；奇数 key 反复插入删除，不断产生和删除重启点
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; t++) {
+        readers.emplace_back([&]() {
+            std::string value;
+            while (!stop) {
+                for (int i = 0; i < count; i += 2) {
+                    if (!skiplist.search("tenant:1:user:" + std::to_string(i), value)) {
+                        errors++;
+                    }
+                }
+                SkipList<std::string, std::string>::Iterator it(&skiplist);
+                std::string prev;
+                for (it.seekToFirst(); it.valid(); it.next()) {
+                    if (it.key() <= prev || it.key().compare(0, 14, "tenant:1:user:") != 0) {
+                        errors++;
+                    }
+                    prev = it.key();
+                }
+            }
+        });
+    }
+
+    for (int round = 0; round < 50; round++) {
+        for (int i = 1; i < count; i += 2) {
+            std::string key = "tenant:1:user:" + std::to_string(i);
+            if (round % 2 == 0) {
+                skiplist.insert(key, "value");
+            } else {
+                skiplist.remove(key);
+            }
+        }
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(skiplist.size(), count / 2);
+}
+
+// ==================== 批量构建 ====================
+
+TEST(SkipListBuilderTest, MatchesInsertForSortedAndUnsortedInput) {
+    for (int mode = 0; mode < 3; mode++) {
+        bool hashIndex = mode == 1;
+        bool prefixCompression = mode == 2;
+        SkipList<std::string, std::string> skiplist(16, hashIndex, prefixCompression);
+        std::map<std::string, std::string> expected;
+        {
+            SkipList<std::string, std::string>::Builder builder(&skiplist);
+            for (int i = 0; i < 2000; i++) {
+                char key[32];
+                snprintf(key, sizeof(key), "tenant:%d:user:%05d", i / 500, i);
+                EXPECT_TRUE(builder.add(key, std::to_string(i)));
+                expected[key] = std::to_string(i);
+            }
+            // 乱序和重复的输入退化为普通插入
+            EXPECT_TRUE(builder.add("tenant:0:user:00010x", "late"));
+            expected["tenant:0:user:00010x"] = "late";
+            EXPECT_FALSE(builder.add("tenant:1:user:00600", "updated"));
+            expected["tenant:1:user:00600"] = "updated";
+            EXPECT_TRUE(builder.add("zzz", "tail"));
+            expected["zzz"] = "tail";
+        }
+        EXPECT_EQ(skiplist.size(), static_cast<int>(expected.size()));
+
+        // 构建完成后与逐条插入的跳表行为一致
+        EXPECT_TRUE(skiplist.insert("tenant:0:user:00010y", "after"));
+        expected["tenant:0:user:00010y"] = "after";
+        for (const auto& kv : expected) {
+            std::string value;
+            ASSERT_TRUE(skiplist.search(kv.first, value)) << kv.first;
+            EXPECT_EQ(value, kv.second);
+        }
+        SkipList<std::string, std::string>::Iterator it(&skiplist);
+        auto ref = expected.begin();
+        for (it.seekToFirst(); it.valid(); it.next(), ++ref) {
+            ASSERT_NE(ref, expected.end());
+            EXPECT_EQ(it.key(), ref->first);
+        }
+        EXPECT_EQ(ref, expected.end());
+    }
+}
+
+// ==================== 多版本快照 ====================
+
+namespace {
+
+using StringMap = std::map<std::string, std::string>;
+
+StringMap collect(const SkipList<std::string, std::string>& skiplist, uint64_t snapshot) {
+    StringMap result;
+    SkipList<std::string, std::string>::Iterator it(&skiplist, snapshot);
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        result[it.key()] = it.value();
+    }
+    return result;
+}
+
+uint64_t pin(SkipList<std::string, std::string>* skiplist) {
+    skiplist->lockWriters();
+    uint64_t snapshot = skiplist->pinVersions();
+    skiplist->unlockWriters();
+    return snapshot;
+}
+
+}  // namespace
+
+TEST(SkipListSnapshotTest, IteratorSeesPointInTimeData) {
+    for (int mode = 0; mode < 3; mode++) {
+        SkipList<std::string, std::string> skiplist(16, mode == 1, mode == 2);
+        StringMap before;
+        for (int i = 0; i < 1000; i++) {
+            std::string key = "tenant:1:user:" + std::to_string(i);
+            skiplist.insert(key, "v" + std::to_string(i));
+            before[key] = "v" + std::to_string(i);
+        }
+
+        uint64_t snapshot = pin(&skiplist);
+
+        // 快照之后：更新、删除、插入新 key、删除后重新写入
+        StringMap after = before;
+        for (int i = 0; i < 1000; i += 3) {
+            std::string key = "tenant:1:user:" + std::to_string(i);
+            EXPECT_FALSE(skiplist.insert(key, "updated"));
+            after[key] = "updated";
+        }
+        for (int i = 1; i < 1000; i += 3) {
+            std::string key = "tenant:1:user:" + std::to_string(i);
+            EXPECT_TRUE(skiplist.remove(key));
+            EXPECT_FALSE(skiplist.remove(key));
+            after.erase(key);
+        }
+        for (int i = 1000; i < 1300; i++) {
+            std::string key = "tenant:1:user:" + std::to_string(i);
+            EXPECT_TRUE(skiplist.insert(key, "new"));
+            after[key] = "new";
+        }
+        EXPECT_TRUE(skiplist.insert("tenant:1:user:1", "revived"));
+        after["tenant:1:user:1"] = "revived";
+
+        // 最新数据和快照互不影响
+        EXPECT_EQ(skiplist.size(), static_cast<int>(after.size()));
+        EXPECT_EQ(collect(skiplist, SkipList<std::string, std::string>::kLatest), after);
+        EXPECT_EQ(collect(skiplist, snapshot), before);
+        std::string value;
+        EXPECT_FALSE(skiplist.search("tenant:1:user:4", value));
+        EXPECT_FALSE(skiplist.contains("tenant:1:user:4"));
+        EXPECT_TRUE(skiplist.search("tenant:1:user:1", value));
+        EXPECT_EQ(value, "revived");
+
+        // 快照期间清空
+        skiplist.clear();
+        EXPECT_EQ(skiplist.size(), 0);
+        EXPECT_FALSE(skiplist.contains("tenant:1:user:0"));
+        EXPECT_TRUE(collect(skiplist, SkipList<std::string, std::string>::kLatest).empty());
+        EXPECT_EQ(collect(skiplist, snapshot), before);
+        EXPECT_TRUE(skiplist.insert("tenant:1:user:2", "again"));
+
+        // 释放快照后墓碑被摘除，跳表与普通写入的结果一致
+        skiplist.unpinVersions();
+        EXPECT_EQ(skiplist.size(), 1);
+        StringMap expected = {{"tenant:1:user:2", "again"}};
+        EXPECT_EQ(collect(skiplist, SkipList<std::string, std::string>::kLatest), expected);
+        EXPECT_TRUE(skiplist.remove("tenant:1:user:2"));
+        EXPECT_EQ(skiplist.size(), 0);
+        std::ostringstream out;
+        EXPECT_TRUE(skiplist.dump(out));
+        EXPECT_TRUE(out.str().empty());
+    }
+}
+
+TEST(SkipListSnapshotTest, UnpinRemovesTombstones) {
+    SkipList<std::string, std::string> skiplist(16, false, true);
+    for (int i = 0; i < 500; i++) {
+        skiplist.insert("key" + std::to_string(i), "v");
+    }
+    uint64_t first = pin(&skiplist);
+    for (int i = 0; i < 500; i += 2) {
+        skiplist.remove("key" + std::to_string(i));
+    }
+    // 嵌套快照：看到第一批删除，看不到之后的删除
+    uint64_t second = pin(&skiplist);
+    for (int i = 1; i < 500; i += 4) {
+        skiplist.remove("key" + std::to_string(i));
+    }
+    EXPECT_EQ(collect(skiplist, first).size(), 500u);
+    EXPECT_EQ(collect(skiplist, second).size(), 250u);
+    skiplist.unpinVersions();
+    EXPECT_EQ(collect(skiplist, first).size(), 500u);
+    skiplist.unpinVersions();
+
+    // 此时表中只剩存活节点：逐个删除后为空
+    StringMap live = collect(skiplist, SkipList<std::string, std::string>::kLatest);
+    EXPECT_EQ(live.size(), 125u);
+    EXPECT_EQ(skiplist.size(), 125);
+    for (const auto& kv : live) {
+        EXPECT_TRUE(skiplist.remove(kv.first)) << kv.first;
+    }
+    EXPECT_EQ(skiplist.size(), 0);
+    EXPECT_TRUE(collect(skiplist, SkipList<std::string, std::string>::kLatest).empty());
+}
+
+TEST(SkipListSnapshotTest, RemoveIfUnchangedKeepsNewerWrites) {
+    SkipList<std::string, std::string> skiplist(16, true);
+    for (int i = 0; i < 100; i++) {
+        skiplist.insert("key" + std::to_string(i), "v");
+    }
+    uint64_t snapshot = pin(&skiplist);
+    skiplist.unpinVersions();
+    skiplist.insert("key1", "newer");
+    skiplist.insert("key100", "new");
+
+    // 快照之后写过的 key 保留，其余的删除
+    for (int i = 0; i <= 100; i++) {
+        EXPECT_EQ(skiplist.removeIfUnchanged("key" + std::to_string(i), snapshot),
+                  i != 1 && i != 100) << i;
+    }
+    StringMap expected = {{"key1", "newer"}, {"key100", "new"}};
+    EXPECT_EQ(collect(skiplist, SkipList<std::string, std::string>::kLatest), expected);
+    EXPECT_EQ(skiplist.size(), 2);
+    EXPECT_FALSE(skiplist.removeIfUnchanged("key2", SkipList<std::string, std::string>::kLatest));
+    EXPECT_TRUE(skiplist.removeIfUnchanged("key1", SkipList<std::string, std::string>::kLatest));
+}
+
+TEST(SkipListSnapshotTest, SnapshotReadersDuringWrites) {
+    SkipList<std::string, std::string> skiplist;
+    const int count = 2000;
+    for (int i = 0; i < count; i++) {
+        skiplist.insert("key" + std::to_string(i), "old");
+    }
+    uint64_t snapshot = pin(&skiplist);
+
+    std::atomic<bool> stop(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; t++) {
+        readers.emplace_back([&]() {
+            while (!stop) {
+                SkipList<std::string, std::string>::Iterator it(&skiplist, snapshot);
+                int seen = 0;
+                for (it.seekToFirst(); it.valid(); it.next()) {
+                    if (it.value() != "old") {
+                        errors++;
+                    }
+                    seen++;
+                }
+                if (seen != count) {
+                    errors++;
+                }
+            }
+        });
+    }
+
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<> dis(0, count * 2);
+    for (int i = 0; i < 20000; i++) {
+        std::string key = "key" + std::to_string(dis(gen));
+        if (i % 3 == 0) {
+            skiplist.remove(key);
+        } else {
+            skiplist.insert(key, "new");
+        }
+    }
+    stop = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    skiplist.unpinVersions();
+    EXPECT_EQ(errors.load(), 0);
+}
+
+// ==================== 淘汰支持测试 ====================
+
+TEST(SkipListBatchTest, SortedOperationsMatchSingleOperations) {
+    for (int variant = 0; variant < 3; variant++) {
+        SkipList<std::string, std::string> skiplist(16, variant == 1, variant == 2);
+        std::map<std::string, std::string> expected;
+        std::mt19937 rng(7);
+        for (int i = 0; i < 500; i++) {
+            std::string key = "key:" + std::to_string(rng() % 2000);
+            skiplist.insert(key, "v" + std::to_string(i));
+            expected[key] = "v" + std::to_string(i);
+        }
+
+        // 有序的批量写入：已有、新增、重复的 key 混在一起
+        std::vector<std::string> keys;
+        std::vector<std::string> values;
+        for (int i = 0; i < 300; i++) {
+            keys.push_back("key:" + std::to_string(rng() % 2000));
+        }
+        std::sort(keys.begin(), keys.end());
+        std::vector<std::pair<const std::string*, const std::string*>> entries;
+        for (size_t i = 0; i < keys.size(); i++) {
+            values.push_back("batch" + std::to_string(i));
+        }
+        for (size_t i = 0; i < keys.size(); i++) {
+            entries.emplace_back(&keys[i], &values[i]);
+        }
+        std::map<std::string, std::string> before = expected;
+        size_t created = 0;
+        skiplist.insertSorted(entries, [&](size_t i, bool isNew) {
+            EXPECT_EQ(isNew, expected.find(keys[i]) == expected.end()) << keys[i];
+            created += isNew ? 1 : 0;
+            expected[keys[i]] = values[i];
+        });
+        EXPECT_EQ(skiplist.size(), static_cast<int>(expected.size()));
+        EXPECT_EQ(expected.size(), before.size() + created);
+
+        // 有序的批量查询与逐个 search 一致
+        std::vector<std::string> lookups;
+        for (int i = 0; i < 2000; i += 3) {
+            lookups.push_back("key:" + std::to_string(i));
+        }
+        std::sort(lookups.begin(), lookups.end());
+        std::vector<const std::string*> pointers;
+        for (const std::string& key : lookups) {
+            pointers.push_back(&key);
+        }
+        size_t visited = 0;
+        skiplist.searchSorted(pointers, [&](size_t i, const std::string* value) {
+            EXPECT_EQ(i, visited++);
+            auto it = expected.find(lookups[i]);
+            if (it == expected.end()) {
+                EXPECT_EQ(value, nullptr) << lookups[i];
+            } else {
+                ASSERT_NE(value, nullptr) << lookups[i];
+                EXPECT_EQ(*value, it->second);
+            }
+        });
+        EXPECT_EQ(visited, lookups.size());
+
+        // 有序的批量删除：visitor 只看到删除了的 key
+        skiplist.removeSorted(pointers, [&](size_t i, const std::string& value) {
+            auto it = expected.find(lookups[i]);
+            ASSERT_NE(it, expected.end()) << lookups[i];
+            EXPECT_EQ(value, it->second);
+            expected.erase(it);
+        });
+        EXPECT_EQ(skiplist.size(), static_cast<int>(expected.size()));
+        for (const auto& kv : expected) {
+            std::string value;
+            EXPECT_TRUE(skiplist.search(kv.first, value)) << kv.first;
+            EXPECT_EQ(value, kv.second);
+        }
+    }
+}
+
+TEST(SkipListEvictionTest, LiveBytesTracksLatestVersions) {
+    SkipList<std::string, Value> skiplist(16, false, true);
+    EXPECT_EQ(skiplist.liveBytes(), 0u);
+    const std::string large(100, 'x');
+    for (int i = 0; i < 1000; i++) {
+        skiplist.insert("tenant:42:key" + std::to_string(i), Value(large));
+    }
+    const size_t full = skiplist.liveBytes();
+    EXPECT_GT(full, 1000u * large.size());
+
+    // 覆盖为短值：长值的堆内存不再计入
+    for (int i = 0; i < 1000; i++) {
+        skiplist.insert("tenant:42:key" + std::to_string(i), Value("v"));
+    }
+    EXPECT_LT(skiplist.liveBytes(), full - 1000u * large.size());
+
+    // 快照期间被替换的旧版本不计入，释放之后也不会重复扣除
+    skiplist.lockWriters();
+    skiplist.pinVersions();
+    skiplist.unlockWriters();
+    for (int i = 0; i < 1000; i += 2) {
+        skiplist.remove("tenant:42:key" + std::to_string(i));
+    }
+    skiplist.unpinVersions();
+    for (int i = 1; i < 1000; i += 2) {
+        EXPECT_TRUE(skiplist.remove("tenant:42:key" + std::to_string(i)));
+    }
+    EXPECT_EQ(skiplist.size(), 0);
+    EXPECT_EQ(skiplist.liveBytes(), 0u);
+
+    skiplist.insert("a", Value(large));
+    EXPECT_GT(skiplist.liveBytes(), 0u);
+    skiplist.clear();
+    EXPECT_EQ(skiplist.liveBytes(), 0u);
+}
+
+TEST(SkipListEvictionTest, SampleVisitsLiveKeysWithAccess) {
+    AccessTracker tracker(EvictionPolicy::kLfu);
+    SkipList<std::string, std::string> skiplist(16, false, true);
+    skiplist.setAccessTracker(&tracker);
+    std::map<std::string, std::string> expected;
+    for (int i = 0; i < 2000; i++) {
+        std::string key = "user:" + std::to_string(i % 7) + ":" + std::to_string(i);
+        skiplist.insert(key, "v" + std::to_string(i));
+        expected[key] = "v" + std::to_string(i);
+    }
+
+    std::set<std::string> seen;
+    for (int round = 0; round < 200; round++) {
+        skiplist.sample(5, [&](const std::string& key, const std::string& value, uint16_t access) {
+            auto it = expected.find(key);
+            ASSERT_NE(it, expected.end()) << key;
+            EXPECT_EQ(value, it->second);
+            EXPECT_EQ(access >> 8, AccessTracker::kLfuInitial);
+            seen.insert(key);
+        });
+    }
+    // 1000 次采样应覆盖相当一部分 key
+    EXPECT_GT(seen.size(), 300u);
+
+    SkipList<std::string, std::string> empty;
+    int visits = 0;
+    empty.sample(5, [&visits](const std::string&, const std::string&, uint16_t) { visits++; });
+    EXPECT_EQ(visits, 0);
+}
@@ -0,0 +1,404 @@
+// tests/storage/snapshot_test.cpp
+#include "storage/snapshot.h"
+#include "storage/kvstore.h"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+const char* kSnapshotPath = "/tmp/snapshot_test.db";
+
+using Records = std::vector<std::pair<std::string, std::string>>;
+
+Records makeRecords(int count) {
+    Records records;
+    for (int i = 0; i < count; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "key%08d", i);
+        records.emplace_back(key, std::string(i % 100, 'v') + std::to_string(i));
+    }
+    return records;
+}
+
+bool writeRecords(const Records& records) {
+    SnapshotWriter writer(kSnapshotPath);
+    if (!writer.open()) {
+        return false;
+    }
+    for (const auto& kv : records) {
+        if (!writer.add(kv.first.data(), kv.first.size(), kv.second.data(), kv.second.size())) {
+            return false;
+        }
+    }
+    return writer.finish();
+}
+
+Records readRecords(bool* complete) {
+    Records records;
+    SnapshotReader reader(kSnapshotPath);
+    if (!reader.open()) {
+        *complete = false;
+        return records;
+    }
+    *complete = reader.read([&records](const char* key, size_t keyLen, const char* value,
+                                       size_t valueLen, int64_t) {
+        records.emplace_back(std::string(key, keyLen), std::string(value, valueLen));
+    });
+    return records;
+}
+
+}  // namespace
+
+TEST(SnapshotTest, RoundTripAcrossBlocks) {
+    Records records = makeRecords(20000);  // 约 1.2MB，跨多个块和多次 write
+    ASSERT_TRUE(writeRecords(records));
+
+    SnapshotReader reader(kSnapshotPath);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(reader.info().version, snapshot::kVersion);
+    EXPECT_EQ(reader.info().count, records.size());
+    EXPECT_GT(reader.info().blocks, 1u);
+    EXPECT_EQ(reader.info().minKey, records.front().first);
+    EXPECT_EQ(reader.info().maxKey, records.back().first);
+
+    bool complete = false;
+    EXPECT_EQ(readRecords(&complete), records);
+    EXPECT_TRUE(complete);
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, EmptySnapshot) {
+    ASSERT_TRUE(writeRecords(Records()));
+    SnapshotReader reader(kSnapshotPath);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(reader.info().count, 0u);
+    EXPECT_EQ(reader.info().blocks, 0u);
+    EXPECT_TRUE(reader.info().minKey.empty());
+
+    bool complete = false;
+    EXPECT_TRUE(readRecords(&complete).empty());
+    EXPECT_TRUE(complete);
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, CorruptBlockIsSkipped) {
+    Records records = makeRecords(20000);
+    ASSERT_TRUE(writeRecords(records));
+
+    // 翻转第一个块 payload 中的一个字节
+    int fd = ::open(kSnapshotPath, O_RDWR);
+    ASSERT_GE(fd, 0);
+    off_t offset = static_cast<off_t>(snapshot::kHeaderSize + snapshot::kBlockHeaderSize + 100);
+    char byte;
+    ASSERT_EQ(::pread(fd, &byte, 1, offset), 1);
+    byte ^= 0x01;
+    ASSERT_EQ(::pwrite(fd, &byte, 1, offset), 1);
+    ::close(fd);
+
+    bool complete = true;
+    Records loaded = readRecords(&complete);
+    EXPECT_FALSE(complete);
+    ASSERT_FALSE(loaded.empty());
+    EXPECT_LT(loaded.size(), records.size());
+    EXPECT_EQ(loaded.back(), records.back());  // 后面的块照常读取
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, ExpiryRoundTrip) {
+    {
+        SnapshotWriter writer(kSnapshotPath);
+        ASSERT_TRUE(writer.open());
+        ASSERT_TRUE(writer.add("a", 1, "plain", 5));
+        ASSERT_TRUE(writer.add("b", 1, "ttl", 3, 1700000000123LL));
+        ASSERT_TRUE(writer.add("c", 1, "", 0, 42));
+        ASSERT_TRUE(writer.finish());
+    }
+    SnapshotReader reader(kSnapshotPath);
+    ASSERT_TRUE(reader.open());
+    std::vector<std::pair<std::string, int64_t>> records;
+    EXPECT_TRUE(reader.read([&records](const char* key, size_t keyLen, const char* value,
+                                       size_t valueLen, int64_t expireAt) {
+        records.emplace_back(std::string(key, keyLen) + "=" + std::string(value, valueLen),
+                             expireAt);
+    }));
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[0], std::make_pair(std::string("a=plain"), int64_t(0)));
+    EXPECT_EQ(records[1], std::make_pair(std::string("b=ttl"), int64_t(1700000000123LL)));
+    EXPECT_EQ(records[2], std::make_pair(std::string("c="), int64_t(42)));
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, UnfinishedFileIsNotASnapshot) {
+    {
+        SnapshotWriter writer(kSnapshotPath);
+        ASSERT_TRUE(writer.open());
+        ASSERT_TRUE(writer.add("k", 1, "v", 1));
+        // 未 finish：析构时删除文件
+    }
+    EXPECT_FALSE(SnapshotReader::probe(kSnapshotPath));
+    SnapshotReader reader(kSnapshotPath);
+    EXPECT_FALSE(reader.open());
+}
+
+TEST(SnapshotTest, KVStoreKeepsBinaryValues) {
+    KVStoreOptions options;
+    options.shards = 4;
+    KVStore store(options);
+    std::string tricky("a:b\nc\0d", 7);
+    store.put("colon:key", "x:y");
+    store.put("newline", tricky);
+    for (int i = 0; i < 1000; i++) {
+        store.put("key" + std::to_string(i), std::to_string(i));
+    }
+    ASSERT_TRUE(store.save(kSnapshotPath));
+    EXPECT_TRUE(SnapshotReader::probe(kSnapshotPath));
+
+    // 不同的分片数、开启前缀压缩加载
+    KVStoreOptions loadOptions;
+    loadOptions.shards = 3;
+    loadOptions.prefixCompression = true;
+    KVStore loaded(loadOptions);
+    ASSERT_TRUE(loaded.load(kSnapshotPath));
+    EXPECT_EQ(loaded.size(), store.size());
+
+    std::string value;
+    EXPECT_TRUE(loaded.get("colon:key", value));
+    EXPECT_EQ(value, "x:y");
+    EXPECT_TRUE(loaded.get("newline", value));
+    EXPECT_EQ(value, tricky);
+    EXPECT_TRUE(loaded.get("key999", value));
+    EXPECT_EQ(value, "999");
+
+    std::vector<std::string> keys;
+    loaded.scan("", "", 0, [&keys](const std::string& key, const Value&) {
+        keys.push_back(key);
+        return true;
+    });
+    EXPECT_EQ(keys.size(), static_cast<size_t>(store.size()));
+    EXPECT_TRUE(std::is_sorted(keys.begin(), keys.end()));
+
+    // 加载后仍可正常写入
+    EXPECT_TRUE(loaded.put("key0000", "new"));
+    EXPECT_TRUE(loaded.get("key0000", value));
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, KVStoreLoadsLegacyTextFile) {
+    {
+        std::ofstream out(kSnapshotPath);
+        out << "name:Alice\ncity:Beijing\n";
+    }
+    KVStore store;
+    ASSERT_TRUE(store.load(kSnapshotPath));
+    EXPECT_EQ(store.size(), 2);
+    std::string value;
+    EXPECT_TRUE(store.get("city", value));
+    EXPECT_EQ(value, "Beijing");
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, BackgroundSaveIsPointInTime) {
+    KVStoreOptions options;
+    options.shards = 4;
+    KVStore store(options);
+    for (int i = 0; i < 20000; i++) {
+        store.put("key" + std::to_string(i), "before");
+    }
+    EXPECT_TRUE(store.hasUnsavedChanges());
+
+    ASSERT_TRUE(store.saveInBackground(kSnapshotPath));
+    EXPECT_FALSE(store.hasUnsavedChanges());
+    // 后台保存期间照常写入，这些修改不进入快照
+    for (int i = 0; i < 20000; i += 2) {
+        store.put("key" + std::to_string(i), "after");
+        store.del("key" + std::to_string(i + 1));
+    }
+    store.put("extra", "after");
+    EXPECT_TRUE(store.hasUnsavedChanges());
+
+    // 等待后台保存完成；空路径直接拒绝
+    while (store.isSaving()) {
+        usleep(1000);
+    }
+    EXPECT_FALSE(store.saveInBackground(""));
+
+    KVStore loaded(options);
+    ASSERT_TRUE(loaded.load(kSnapshotPath));
+    EXPECT_EQ(loaded.size(), 20000);
+    std::string value;
+    EXPECT_TRUE(loaded.get("key1", value));
+    EXPECT_EQ(value, "before");
+    EXPECT_TRUE(loaded.get("key0", value));
+    EXPECT_EQ(value, "before");
+    EXPECT_FALSE(loaded.exists("extra"));
+
+    // 保存结束后旧版本已释放，最新数据不受影响
+    EXPECT_EQ(store.size(), 10001);
+    EXPECT_TRUE(store.get("key0", value));
+    EXPECT_EQ(value, "after");
+    EXPECT_FALSE(store.exists("key1"));
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, TruncatedFileKeepsWholeBlocks) {
+    Records records = makeRecords(20000);
+    ASSERT_TRUE(writeRecords(records));
+
+    // 截断掉块索引和最后一个块的一部分：文件头完好，前面的块照常读取
+    std::ifstream in(kSnapshotPath, std::ios::binary | std::ios::ate);
+    off_t size = static_cast<off_t>(in.tellg());
+    in.close();
+    ASSERT_EQ(::truncate(kSnapshotPath, size - 1000), 0);
+
+    bool complete = true;
+    Records loaded = readRecords(&complete);
+    EXPECT_FALSE(complete);
+    ASSERT_FALSE(loaded.empty());
+    EXPECT_LT(loaded.size(), records.size());
+    EXPECT_TRUE(std::equal(loaded.begin(), loaded.end(), records.begin()));
+
+    // 只剩文件头的一部分
+    ASSERT_EQ(::truncate(kSnapshotPath, 10), 0);
+    SnapshotReader reader(kSnapshotPath);
+    EXPECT_FALSE(reader.open());
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, KVStoreMapsLongValues) {
+    KVStoreOptions options;
+    options.shards = 2;
+    KVStore store(options);
+    for (int i = 0; i < 1000; i++) {
+        store.put("key" + std::to_string(i), std::string(i % 60, 'v'));
+    }
+    ASSERT_TRUE(store.save(kSnapshotPath));
+
+    options.mmapValues = true;
+    KVStore loaded(options);
+    ASSERT_TRUE(loaded.load(kSnapshotPath));
+    // 映射建立后文件被替换或删除都不影响已加载的值
+    std::remove(kSnapshotPath);
+    EXPECT_EQ(loaded.size(), 1000);
+    Value value;
+    ASSERT_TRUE(loaded.get("key59", value));
+    EXPECT_TRUE(value.isExternal());
+    EXPECT_EQ(value.toString(), std::string(59, 'v'));
+    ASSERT_TRUE(loaded.get("key3", value));
+    EXPECT_TRUE(value.isInline());
+
+    // 覆盖写入得到普通的值，映射中的旧值不受影响
+    EXPECT_FALSE(loaded.put("key59", std::string(40, 'n')));
+    ASSERT_TRUE(loaded.get("key59", value));
+    EXPECT_FALSE(value.isExternal());
+    ASSERT_TRUE(loaded.get("key119", value));
+    EXPECT_EQ(value.toString(), std::string(59, 'v'));
+
+    // 从映射加载的数据可以再保存
+    ASSERT_TRUE(loaded.save(kSnapshotPath));
+    KVStore reloaded(options);
+    ASSERT_TRUE(reloaded.load(kSnapshotPath));
+    std::string str;
+    EXPECT_TRUE(reloaded.get("key119", str));
+    EXPECT_EQ(str, std::string(59, 'v'));
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, DamagedIndexFallsBackToScanning) {
+    Records records = makeRecords(20000);
+    ASSERT_TRUE(writeRecords(records));
+
+    // 破坏块索引末尾的校验和
+    int fd = ::open(kSnapshotPath, O_RDWR);
+    ASSERT_GE(fd, 0);
+    off_t offset = ::lseek(fd, -1, SEEK_END);
+    char byte;
+    ASSERT_EQ(::pread(fd, &byte, 1, offset), 1);
+    byte ^= 0x01;
+    ASSERT_EQ(::pwrite(fd, &byte, 1, offset), 1);
+    ::close(fd);
+
+    SnapshotReader reader(kSnapshotPath);
+    ASSERT_TRUE(reader.open());
+    EXPECT_EQ(reader.blockCount(), reader.info().blocks);
+    bool complete = false;
+    EXPECT_EQ(readRecords(&complete), records);
+    EXPECT_TRUE(complete);
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, BlocksDecodeIndependently) {
+    Records records = makeRecords(20000);
+    ASSERT_TRUE(writeRecords(records));
+    SnapshotReader reader(kSnapshotPath);
+    ASSERT_TRUE(reader.open());
+    ASSERT_GT(reader.blockCount(), 2u);
+
+    // 倒序读取各块，拼起来与顺序读取一致
+    std::vector<Records> blocks(reader.blockCount());
+    uint64_t total = 0;
+    for (size_t i = blocks.size(); i-- > 0;) {
+        uint32_t count = 0;
+        Records* block = &blocks[i];
+        ASSERT_TRUE(reader.readBlock(i, [block](const char* key, size_t keyLen,
+                                                const char* value, size_t valueLen, int64_t) {
+            block->emplace_back(std::string(key, keyLen), std::string(value, valueLen));
+        }, &count));
+        EXPECT_EQ(count, block->size());
+        total += count;
+    }
+    EXPECT_TRUE(reader.checkComplete(total, 0));
+    Records joined;
+    for (const Records& block : blocks) {
+        joined.insert(joined.end(), block.begin(), block.end());
+    }
+    EXPECT_EQ(joined, records);
+    std::remove(kSnapshotPath);
+}
+
+TEST(SnapshotTest, KVStoreLoadsInParallel) {
+    Records records = makeRecords(100000);
+    ASSERT_TRUE(writeRecords(records));
+
+    // 分片数少于、多于线程数，两种跳表，映射与拷贝值
+    struct Case {
+        int shards;
+        SkipListType type;
+        bool mmapValues;
+    };
+    const Case cases[] = {
+        {1, SkipListType::kMutex, false},
+        {8, SkipListType::kMutex, false},
+        {3, SkipListType::kMutex, true},
+        {2, SkipListType::kLockFree, false},
+    };
+    for (const Case& c : cases) {
+        KVStoreOptions options;
+        options.shards = c.shards;
+        options.skipListType = c.type;
+        options.mmapValues = c.mmapValues;
+        options.loadThreads = 4;
+        KVStore store(options);
+        ASSERT_TRUE(store.load(kSnapshotPath));
+        ASSERT_EQ(store.size(), static_cast<int>(records.size()));
+
+        Records loaded;
+        store.scan("", "", 0, [&loaded](const std::string& key, const Value& value) {
+            loaded.emplace_back(key, value.toString());
+            return true;
+        });
+        EXPECT_TRUE(loaded == records) << "shards=" << c.shards;
+    }
+    std::remove(kSnapshotPath);
+}
@@ -0,0 +1,109 @@
+// tests/storage/sstable_test.cpp
+#include "storage/sstable.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+using namespace kvstore;
+
+namespace {
+
+const char* kTablePath = "/tmp/sstable_test.sst";
+
+std::string keyOf(int i) {
+    char key[32];
+    snprintf(key, sizeof(key), "key%08d", i);
+    return key;
+}
+
+/// 偶数 key 为值，每 7 个 key 中有一个墓碑
+bool buildTable(int count) {
+    TableBuilder builder(kTablePath, 10);
+    bool ok = builder.open();
+    for (int i = 0; ok && i < count; i++) {
+        std::string key = keyOf(i * 2);
+        std::string value = std::string(i % 50, 'v') + std::to_string(i);
+        ok = builder.add(key.data(), key.size(), value.data(), value.size(), i % 7 == 0);
+    }
+    return ok && builder.finish();
+}
+
+class SSTableTest : public ::testing::Test {
+protected:
+    void SetUp() override { std::remove(kTablePath); }
+    void TearDown() override { std::remove(kTablePath); }
+};
+
+}  // namespace
+
+TEST_F(SSTableTest, GetFindsValuesAndTombstones) {
+    const int kCount = 5000;  // 跨越多个数据块
+    ASSERT_TRUE(buildTable(kCount));
+    Table table(kTablePath);
+    ASSERT_TRUE(table.open());
+    EXPECT_EQ(table.count(), static_cast<uint64_t>(kCount));
+
+    for (int i = 0; i < kCount; i++) {
+        Value value;
+        Table::Lookup result = table.get(keyOf(i * 2), &value);
+        if (i % 7 == 0) {
+            EXPECT_EQ(result, Table::Lookup::kDeleted) << i;
+        } else {
+            ASSERT_EQ(result, Table::Lookup::kFound) << i;
+            EXPECT_EQ(value.toString(), std::string(i % 50, 'v') + std::to_string(i));
+        }
+        EXPECT_EQ(table.get(keyOf(i * 2 + 1), &value), Table::Lookup::kNotFound);
+    }
+    Value value;
+    EXPECT_EQ(table.get("zzz", &value), Table::Lookup::kNotFound);
+    EXPECT_EQ(table.get("", &value), Table::Lookup::kNotFound);
+}
+
+TEST_F(SSTableTest, IteratorVisitsAllEntriesInOrder) {
+    const int kCount = 3000;
+    ASSERT_TRUE(buildTable(kCount));
+    Table table(kTablePath);
+    ASSERT_TRUE(table.open());
+
+    Table::Iterator it(&table);
+    int i = 0;
+    for (it.seekToFirst(); it.valid(); it.next(), i++) {
+        ASSERT_EQ(it.key(), keyOf(i * 2));
+        EXPECT_EQ(it.isTombstone(), i % 7 == 0);
+        if (!it.isTombstone()) {
+            EXPECT_EQ(std::string(it.valueData(), it.valueSize()),
+                      std::string(i % 50, 'v') + std::to_string(i));
+        }
+    }
+    EXPECT_EQ(i, kCount);
+
+    it.seek(keyOf(1001));  // 不存在，定位到下一个
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), keyOf(1002));
+    it.seek("zzz");
+    EXPECT_FALSE(it.valid());
+}
+
+TEST_F(SSTableTest, UnfinishedTableIsRemoved) {
+    {
+        TableBuilder builder(kTablePath, 10);
+        ASSERT_TRUE(builder.open());
+        ASSERT_TRUE(builder.add("a", 1, "1", 1, false));
+    }
+    std::ifstream in(kTablePath);
+    EXPECT_FALSE(in.is_open());
+}
+
+TEST_F(SSTableTest, CorruptFooterIsRejected) {
+    ASSERT_TRUE(buildTable(100));
+    {
+        std::fstream file(kTablePath, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-20, std::ios::end);
+        file.put('\xff');
+    }
+    Table table(kTablePath);
+    EXPECT_FALSE(table.open());
+}
@@ -0,0 +1,296 @@
+// tests/storage/table_set_test.cpp
+#include "storage/table_set.h"
+#include "storage/kvstore.h"
+
+#include <gtest/gtest.h>
+
+#include <dirent.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+
+using namespace kvstore;
+
+namespace {
+
+const char* kTableDir = "/tmp/table_set_test";
+const char* kWalPath = "/tmp/table_set_test.wal";
+
+void removeFiles() {
+    if (DIR* d = ::opendir(kTableDir)) {
+        while (struct dirent* entry = ::readdir(d)) {
+            std::string name = entry->d_name;
+            if (name != "." && name != "..") {
+                ::unlink((std::string(kTableDir) + "/" + name).c_str());
+            }
+        }
+        ::closedir(d);
+        ::rmdir(kTableDir);
+    }
+    std::remove(kWalPath);
+    std::remove((std::string(kWalPath) + ".old").c_str());
+}
+
+std::string keyOf(int i) {
+    char key[32];
+    snprintf(key, sizeof(key), "key%06d", i);
+    return key;
+}
+
+/// 不会自动刷盘和合并，由测试显式调用
+TableOptions manualOptions() {
+    TableOptions options;
+    options.memtableBytes = 1ull << 40;
+    options.compactionTrigger = 0;
+    return options;
+}
+
+std::map<std::string, std::string> scanAll(const KVStore& store) {
+    std::map<std::string, std::string> result;
+    store.scan("", "", 0, [&result](const std::string& key, const Value& value) {
+        result[key] = value.toString();
+        return true;
+    });
+    return result;
+}
+
+class TableSetTest : public ::testing::Test {
+protected:
+    void SetUp() override { removeFiles(); }
+    void TearDown() override { removeFiles(); }
+};
+
+}  // namespace
+
+TEST_F(TableSetTest, FlushMovesMemtableToTable) {
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+    for (int i = 0; i < 1000; i++) {
+        store.put(keyOf(i), "v" + std::to_string(i));
+    }
+    EXPECT_GT(store.memtableBytes(), 0u);
+    ASSERT_TRUE(store.flush());
+    EXPECT_EQ(store.tables()->tableCount(), 1u);
+    EXPECT_EQ(store.memtableBytes(), 0u);
+    EXPECT_EQ(store.size(), 1000);
+
+    std::string value;
+    ASSERT_TRUE(store.get(keyOf(123), value));
+    EXPECT_EQ(value, "v123");
+    EXPECT_TRUE(store.exists(keyOf(999)));
+    EXPECT_FALSE(store.exists(keyOf(1000)));
+}
+
+TEST_F(TableSetTest, NewerWritesShadowTables) {
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+    store.put("a", "1");
+    store.put("b", "1");
+    store.put("c", "1");
+    ASSERT_TRUE(store.flush());
+
+    store.put("a", "2");    // 更新：memtable 中的值更新
+    store.del("b");         // 删除：墓碑遮住表中的旧值
+    ASSERT_TRUE(store.flush());
+    store.put("c", "3");    // 还在 memtable 中
+
+    std::string value;
+    ASSERT_TRUE(store.get("a", value));
+    EXPECT_EQ(value, "2");
+    EXPECT_FALSE(store.get("b", value));
+    EXPECT_FALSE(store.exists("b"));
+    ASSERT_TRUE(store.get("c", value));
+    EXPECT_EQ(value, "3");
+
+    std::map<std::string, std::string> expected = {{"a", "2"}, {"c", "3"}};
+    EXPECT_EQ(scanAll(store), expected);
+    EXPECT_EQ(store.size(), 2);
+}
+
+TEST_F(TableSetTest, ExpiredValuesShadowTables) {
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+    const int64_t now = KVStore::nowMs();
+    store.put("a", "old");
+    store.put("b", Value("1").withExpiry(now + 60000));
+    ASSERT_TRUE(store.flush());
+
+    // 表中的值带着过期时间，EXPIRE 读出表中的值写回 memtable
+    EXPECT_EQ(store.expireAt("b"), now + 60000);
+    EXPECT_TRUE(store.expire("a", now + 30000));
+    EXPECT_EQ(store.expireAt("a"), now + 30000);
+
+    // 过期的值遮住表中的旧值，刷盘后仍然如此
+    store.put("a", Value("new").withExpiry(now - 1));
+    EXPECT_FALSE(store.exists("a"));
+    EXPECT_TRUE(store.expireIfDue("a"));
+    ASSERT_TRUE(store.flush());
+    EXPECT_FALSE(store.exists("a"));
+    EXPECT_EQ(store.expireAt("b"), now + 60000);
+
+    ASSERT_TRUE(const_cast<TableSet*>(store.tables())->compact());
+    std::map<std::string, std::string> expected = {{"b", "1"}};
+    EXPECT_EQ(scanAll(store), expected);
+    EXPECT_EQ(store.expireAt("b"), now + 60000);
+}
+
+TEST_F(TableSetTest, CompactionMergesTablesAndDropsTombstones) {
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+    std::map<std::string, std::string> expected;
+    for (int round = 0; round < 4; round++) {
+        for (int i = round; i < 500; i += 2) {
+            store.put(keyOf(i), std::to_string(round));
+            expected[keyOf(i)] = std::to_string(round);
+        }
+        for (int i = round * 100; i < round * 100 + 20; i++) {
+            store.del(keyOf(i));
+            expected.erase(keyOf(i));
+        }
+        ASSERT_TRUE(store.flush());
+    }
+    ASSERT_EQ(store.tables()->tableCount(), 4u);
+    EXPECT_EQ(scanAll(store), expected);
+
+    TableSet* tables = const_cast<TableSet*>(store.tables());
+    ASSERT_TRUE(tables->compact());
+    EXPECT_EQ(tables->tableCount(), 1u);
+    EXPECT_EQ(tables->compactions(), 1u);
+    EXPECT_EQ(tables->current()->front()->count(), expected.size());
+    EXPECT_EQ(scanAll(store), expected);
+}
+
+TEST_F(TableSetTest, BackgroundFlushAndCompaction) {
+    TableOptions options;
+    options.memtableBytes = 16 * 1024;
+    options.compactionTrigger = 3;
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, options));
+    for (int i = 0; i < 5000; i++) {
+        store.put(keyOf(i), std::string(40, 'x'));
+    }
+    ASSERT_TRUE(store.flush());
+    // 后台线程可能还在合并，等它结束；负载高时后台刷盘攒得多、表少，
+    // 不够合并阈值时再刷两个小表
+    for (int round = 0; round < 2 && !store.tables()->needsCompaction() &&
+                        store.tables()->compactions() == 0;
+         round++) {
+        store.put(keyOf(round), std::string(40, 'x'));
+        ASSERT_TRUE(store.flush());
+    }
+    for (int i = 0; i < 500 && store.tables()->compactions() == 0; i++) {
+        usleep(10 * 1000);
+    }
+    EXPECT_GT(store.tables()->compactions(), 0u);
+    EXPECT_EQ(store.size(), 5000);
+    std::string value;
+    ASSERT_TRUE(store.get(keyOf(4321), value));
+    EXPECT_EQ(value, std::string(40, 'x'));
+}
+
+TEST_F(TableSetTest, SizeIsTrackedWithoutScanningTables) {
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+    for (int i = 0; i < 100; i++) {
+        store.put(keyOf(i), "v");
+    }
+    ASSERT_TRUE(store.flush());
+    EXPECT_EQ(store.size(), 100);
+
+    // 表中已有的 key 读表确认，算作更新
+    for (int i = 0; i < 100; i++) {
+        EXPECT_FALSE(store.put(keyOf(i), "w"));
+    }
+    EXPECT_EQ(store.size(), 100);
+
+    // 删除查到了值才计数；memtable 中是墓碑时再写入算作新增
+    EXPECT_TRUE(store.del(keyOf(0)));
+    EXPECT_FALSE(store.del(keyOf(0)));
+    EXPECT_EQ(store.size(), 99);
+    EXPECT_TRUE(store.put(keyOf(0), "x"));
+    EXPECT_EQ(store.size(), 100);
+
+    // 刷盘时已经过期的值写成墓碑，从计数中扣除
+    store.put("expired", Value("1").withExpiry(KVStore::nowMs() - 1));
+    EXPECT_EQ(store.size(), 101);
+    ASSERT_TRUE(store.flush());
+    EXPECT_EQ(store.size(), 100);
+
+    // 表中是墓碑的 key 过滤器会放行，读表之后仍然算作新增
+    EXPECT_TRUE(store.put("expired", "2"));
+    EXPECT_TRUE(store.del(keyOf(1)));
+    ASSERT_TRUE(store.flush());
+    EXPECT_EQ(store.size(), 100);
+    EXPECT_TRUE(store.put(keyOf(1), "y"));
+    EXPECT_EQ(store.size(), 101);
+
+    // 表中没有的 key 即使被过滤器误判也算作新增
+    for (int i = 1000; i < 3000; i++) {
+        EXPECT_TRUE(store.put(keyOf(i), "z"));
+    }
+    EXPECT_EQ(store.size(), 2101);
+}
+
+TEST_F(TableSetTest, ReopenRecoversTablesAndLog) {
+    {
+        KVStore store;
+        ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+        ASSERT_TRUE(store.openLog(kWalPath, WalOptions()));
+        store.put("a", "1");
+        store.put("b", "1");
+        ASSERT_TRUE(store.flush());
+        store.put("b", "2");   // 只在日志中
+        store.del("a");
+        store.put("c", "3");
+        store.syncLog();
+    }
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+    ASSERT_TRUE(store.openLog(kWalPath, WalOptions()));
+    EXPECT_EQ(store.tables()->tableCount(), 1u);
+    std::map<std::string, std::string> expected = {{"b", "2"}, {"c", "3"}};
+    EXPECT_EQ(scanAll(store), expected);
+}
+
+TEST_F(TableSetTest, ClearRemovesTables) {
+    KVStore store;
+    ASSERT_TRUE(store.openTables(kTableDir, manualOptions()));
+    store.put("a", "1");
+    ASSERT_TRUE(store.flush());
+    store.put("b", "2");
+    store.clear();
+    EXPECT_EQ(store.tables()->tableCount(), 0u);
+    EXPECT_EQ(store.size(), 0);
+    EXPECT_FALSE(store.exists("a"));
+
+    KVStore reopened;
+    ASSERT_TRUE(reopened.openTables(kTableDir, manualOptions()));
+    EXPECT_EQ(reopened.size(), 0);
+}
+
+TEST_F(TableSetTest, UnlistedTablesAreRemovedOnOpen) {
+    {
+        TableSet tables(kTableDir, manualOptions());
+        ASSERT_TRUE(tables.open());
+        uint64_t number;
+        std::string path = tables.newTablePath(&number);
+        TableBuilder builder(path, 10);
+        ASSERT_TRUE(builder.open());
+        ASSERT_TRUE(builder.add("a", 1, "1", 1, false));
+        ASSERT_TRUE(builder.finish());  // 写完但没有 addTable：模拟登记前崩溃
+    }
+    TableSet tables(kTableDir, manualOptions());
+    ASSERT_TRUE(tables.open());
+    EXPECT_EQ(tables.tableCount(), 0u);
+    Value value;
+    EXPECT_EQ(tables.get("a", &value), Table::Lookup::kNotFound);
+}
+
+TEST_F(TableSetTest, LockFreeEngineIsRejected) {
+    KVStoreOptions options;
+    options.skipListType = SkipListType::kLockFree;
+    KVStore store(options);
+    EXPECT_FALSE(store.openTables(kTableDir, manualOptions()));
+}
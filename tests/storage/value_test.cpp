@@ -0,0 +1,159 @@
+// tests/storage/value_test.cpp
+#include "storage/value.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kvstore;
+
+TEST(ValueTest, SmallValuesAreInline) {
+    Value empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_TRUE(empty.isInline());
+    EXPECT_EQ(empty.toString(), "");
+
+    std::string max(Value::kInlineCapacity, 'x');
+    Value small(max);
+    EXPECT_TRUE(small.isInline());
+    EXPECT_EQ(small.size(), Value::kInlineCapacity);
+    EXPECT_EQ(small.toString(), max);
+    EXPECT_EQ(small.heapBytes(), 0u);
+
+    Value copy(small);
+    EXPECT_EQ(copy, small);
+    EXPECT_NE(copy.data(), small.data());
+}
+
+TEST(ValueTest, LargeValuesShareOneBlob) {
+    std::string payload(Value::kInlineCapacity + 1, 'y');
+    Value large(payload);
+    EXPECT_FALSE(large.isInline());
+    EXPECT_EQ(large.toString(), payload);
+    EXPECT_GT(large.heapBytes(), payload.size());
+
+    // 拷贝共享同一块内存
+    Value copy(large);
+    EXPECT_EQ(copy.data(), large.data());
+
+    Value assigned;
+    assigned = copy;
+    EXPECT_EQ(assigned.data(), large.data());
+    assigned = assigned;
+    EXPECT_EQ(assigned.toString(), payload);
+
+    // 被覆盖 / 移走后，其他持有者不受影响
+    large = Value("short", 5);
+    EXPECT_TRUE(large.isInline());
+    Value moved(std::move(copy));
+    EXPECT_TRUE(copy.empty());
+    EXPECT_EQ(moved.toString(), payload);
+    EXPECT_EQ(assigned.toString(), payload);
+
+    std::ostringstream out;
+    out << large << ":" << moved;
+    EXPECT_EQ(out.str(), "short:" + payload);
+}
+
+TEST(ValueTest, ConcurrentCopiesOfSharedBlob) {
+    const std::string payload(1024, 'z');
+    Value shared(payload);
+    std::atomic<int> errors(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < 10000; i++) {
+                Value copy(shared);
+                if (copy.size() != payload.size() || copy.data()[i % payload.size()] != 'z') {
+                    errors++;
+                }
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    EXPECT_EQ(errors.load(), 0);
+    EXPECT_EQ(shared.toString(), payload);
+}
+
+TEST(ValueTest, ReferenceDoesNotCopyLongValues) {
+    const std::string payload(100, 'r');
+    Value ref = Value::reference(payload.data(), payload.size());
+    EXPECT_TRUE(ref.isExternal());
+    EXPECT_FALSE(ref.isInline());
+    EXPECT_EQ(ref.data(), payload.data());
+    EXPECT_EQ(ref.size(), payload.size());
+    EXPECT_EQ(ref.heapBytes(), 0u);
+
+    // 拷贝仍然引用同一段内存，也可以被普通值覆盖
+    Value copy(ref);
+    EXPECT_EQ(copy.data(), payload.data());
+    Value assigned(std::string(50, 'b'));
+    assigned = ref;
+    EXPECT_EQ(assigned.data(), payload.data());
+    copy = Value(payload);
+    EXPECT_FALSE(copy.isExternal());
+    EXPECT_NE(copy.data(), payload.data());
+    EXPECT_EQ(copy, ref);
+
+    // 短值照常内联
+    Value small = Value::reference(payload.data(), 5);
+    EXPECT_TRUE(small.isInline());
+    EXPECT_NE(small.data(), payload.data());
+}
+
+TEST(ValueTest, TombstoneIsDistinctFromEmpty) {
+    Value tombstone = Value::tombstone();
+    EXPECT_TRUE(tombstone.isTombstone());
+    EXPECT_TRUE(tombstone.empty());
+    EXPECT_EQ(tombstone.heapBytes(), 0u);
+
+    Value copy(tombstone);
+    EXPECT_TRUE(copy.isTombstone());
+    EXPECT_FALSE(Value().isTombstone());
+    EXPECT_FALSE(Value(std::string(40, 'x')).isTombstone());
+    copy = Value("v", 1);
+    EXPECT_FALSE(copy.isTombstone());
+}
+
+TEST(ValueTest, ExpiryLivesInSpareBytes) {
+    const int64_t at = 1700000000123LL;
+
+    // 短值带上过期时间后改用 Blob，内容不变
+    Value small("abc", 3);
+    EXPECT_EQ(small.expireAt(), 0);
+    Value expiring = small.withExpiry(at);
+    EXPECT_FALSE(expiring.isInline());
+    EXPECT_EQ(expiring.toString(), "abc");
+    EXPECT_EQ(expiring.expireAt(), at);
+    EXPECT_FALSE(expiring.expiredAt(at - 1));
+    EXPECT_TRUE(expiring.expiredAt(at));
+
+    // 拷贝保留过期时间，长值共享同一个 Blob
+    Value large(std::string(100, 'x'));
+    Value largeExpiring = large.withExpiry(at);
+    EXPECT_EQ(largeExpiring.data(), large.data());
+    Value copy(largeExpiring);
+    EXPECT_EQ(copy.expireAt(), at);
+    EXPECT_EQ(large.expireAt(), 0);
+
+    // 去掉过期时间后短值回到内联表示
+    Value persisted = expiring.withExpiry(0);
+    EXPECT_TRUE(persisted.isInline());
+    EXPECT_EQ(persisted.expireAt(), 0);
+    EXPECT_EQ(persisted, small);
+    EXPECT_EQ(largeExpiring.withExpiry(0).expireAt(), 0);
+
+    // 外部内存的引用也能带过期时间
+    std::string payload(64, 'p');
+    Value ref = Value::reference(payload.data(), payload.size()).withExpiry(at);
+    EXPECT_TRUE(ref.isExternal());
+    EXPECT_EQ(ref.data(), payload.data());
+    EXPECT_EQ(ref.expireAt(), at);
+}
@@ -0,0 +1,289 @@
+// tests/storage/wal_test.cpp
+#include "storage/wal.h"
+#include "storage/kvstore.h"
+
+#include <gtest/gtest.h>
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kvstore;
+
+namespace {
+
+const char* kWalPath = "/tmp/wal_test.wal";
+const char* kSnapshotPath = "/tmp/wal_test.db";
+
+off_t fileSize(const char* path) {
+    struct stat st;
+    return ::stat(path, &st) == 0 ? st.st_size : -1;
+}
+
+void removeFiles() {
+    std::remove(kWalPath);
+    std::remove((std::string(kWalPath) + ".old").c_str());
+    std::remove(kSnapshotPath);
+}
+
+std::vector<WalRecord> replayAll(const WalOptions& options = WalOptions()) {
+    std::vector<WalRecord> records;
+    WriteAheadLog wal(kWalPath, options);
+    wal.replay([&records](const WalRecord& record) { records.push_back(record); });
+    return records;
+}
+
+class WalTest : public ::testing::Test {
+protected:
+    void SetUp() override { removeFiles(); }
+    void TearDown() override { removeFiles(); }
+};
+
+}  // namespace
+
+TEST_F(WalTest, AppendAndReplay) {
+    {
+        WalOptions options;
+        options.syncPolicy = WalSyncPolicy::kAlways;
+        WriteAheadLog wal(kWalPath, options);
+        ASSERT_TRUE(wal.open());
+        std::string value("line1\nline2:with colon", 22);
+        wal.appendPut("key", value.data(), value.size());
+        wal.appendDel("key");
+        wal.appendClear();
+        wal.appendClearShard(2, 4);
+        EXPECT_EQ(wal.appendedLsn(), 4u);
+        wal.sync();
+    }
+
+    std::vector<WalRecord> records = replayAll();
+    ASSERT_EQ(records.size(), 4u);
+    EXPECT_EQ(records[0].type, WalRecordType::kPut);
+    EXPECT_EQ(records[0].key, "key");
+    EXPECT_EQ(records[0].value, "line1\nline2:with colon");
+    EXPECT_EQ(records[1].type, WalRecordType::kDel);
+    EXPECT_EQ(records[1].key, "key");
+    EXPECT_EQ(records[2].type, WalRecordType::kClear);
+    EXPECT_EQ(records[3].type, WalRecordType::kClearShard);
+    EXPECT_EQ(records[3].shard, 2u);
+    EXPECT_EQ(records[3].shards, 4u);
+}
+
+TEST_F(WalTest, TornTailIsTruncated) {
+    {
+        WriteAheadLog wal(kWalPath, WalOptions());
+        ASSERT_TRUE(wal.open());
+        wal.appendPut("a", "1", 1);
+        wal.appendPut("b", "2", 1);
+    }
+    // 模拟崩溃时写了一半的记录
+    {
+        std::ofstream out(kWalPath, std::ios::binary | std::ios::app);
+        out.write("\x12\x34\x56\x78\x20\x00\x00\x00\x01partial", 16);
+    }
+
+    EXPECT_EQ(replayAll().size(), 2u);
+
+    // 截断后继续追加的记录可以正常重放
+    {
+        WriteAheadLog wal(kWalPath, WalOptions());
+        ASSERT_TRUE(wal.open());
+        wal.appendDel("a");
+    }
+    std::vector<WalRecord> records = replayAll();
+    ASSERT_EQ(records.size(), 3u);
+    EXPECT_EQ(records[2].type, WalRecordType::kDel);
+    EXPECT_EQ(records[2].key, "a");
+}
+
+TEST_F(WalTest, FailedWriteIsReportedAndLeavesNoTornRecord) {
+    WalOptions options;
+    options.syncPolicy = WalSyncPolicy::kAlways;
+    off_t goodSize = 0;
+    {
+        WriteAheadLog wal(kWalPath, options);
+        ASSERT_TRUE(wal.open());
+        wal.appendPut("a", "1", 1);
+        ASSERT_TRUE(wal.sync());
+        goodSize = fileSize(kWalPath);
+
+        // 文件大小上限卡在下一条记录中间：write 先写出一部分，再以 EFBIG 失败
+        struct rlimit saved;
+        ASSERT_EQ(::getrlimit(RLIMIT_FSIZE, &saved), 0);
+        struct rlimit limit = saved;
+        limit.rlim_cur = static_cast<rlim_t>(goodSize + 16);
+        ::signal(SIGXFSZ, SIG_IGN);
+        ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &limit), 0);
+
+        std::string value(100, 'v');
+        wal.appendPut("b", value.data(), value.size());
+        EXPECT_FALSE(wal.sync());
+        EXPECT_TRUE(wal.failed());
+
+        // 恢复上限后日志仍处于失败状态，不再追加
+        ASSERT_EQ(::setrlimit(RLIMIT_FSIZE, &saved), 0);
+        wal.appendPut("c", "3", 1);
+        EXPECT_FALSE(wal.sync());
+    }
+
+    // 写了一半的记录已被截掉，之后的记录也没有接在它后面
+    EXPECT_EQ(fileSize(kWalPath), goodSize);
+    std::vector<WalRecord> records = replayAll();
+    ASSERT_EQ(records.size(), 1u);
+    EXPECT_EQ(records[0].key, "a");
+}
+
+TEST_F(WalTest, GroupCommitSharesFsync) {
+    WalOptions options;
+    options.syncPolicy = WalSyncPolicy::kAlways;
+    WriteAheadLog wal(kWalPath, options);
+    ASSERT_TRUE(wal.open());
+
+    const int kThreads = 8;
+    const int kWrites = 200;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&wal, t]() {
+            for (int i = 0; i < kWrites; i++) {
+                std::string key = "t" + std::to_string(t) + ":" + std::to_string(i);
+                wal.appendPut(key, "v", 1);
+                wal.sync();
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    EXPECT_EQ(wal.appendedLsn(), static_cast<uint64_t>(kThreads * kWrites));
+    EXPECT_GT(wal.syncCount(), 0u);
+    EXPECT_LT(wal.syncCount(), static_cast<uint64_t>(kThreads * kWrites));
+    wal.close();
+    EXPECT_EQ(replayAll().size(), static_cast<size_t>(kThreads * kWrites));
+}
+
+TEST_F(WalTest, KVStoreRecoversFromSnapshotAndLog) {
+    WalOptions options;
+    options.syncPolicy = WalSyncPolicy::kNever;
+    {
+        KVStore store;
+        ASSERT_TRUE(store.openLog(kWalPath, options));
+        store.put("a", "1");
+        store.put("b", "2");
+        ASSERT_TRUE(store.save(kSnapshotPath));  // 检查点：之前的日志被删除
+
+        store.put("c", "3");
+        store.del("a");
+        store.put("b", std::string(100, 'x'));
+        // 不再 save，模拟崩溃：只有快照 + 日志
+    }
+    EXPECT_NE(access((std::string(kWalPath) + ".old").c_str(), F_OK), 0);
+    EXPECT_EQ(replayAll().size(), 3u);
+
+    KVStore store;
+    ASSERT_TRUE(store.load(kSnapshotPath));
+    ASSERT_TRUE(store.openLog(kWalPath, options));
+    EXPECT_EQ(store.size(), 2);
+    std::string value;
+    EXPECT_FALSE(store.get("a", value));
+    EXPECT_TRUE(store.get("b", value));
+    EXPECT_EQ(value, std::string(100, 'x'));
+    EXPECT_TRUE(store.get("c", value));
+    EXPECT_EQ(value, "3");
+}
+
+TEST_F(WalTest, BatchCommandsReplay) {
+    WalOptions options;
+    options.syncPolicy = WalSyncPolicy::kNever;
+    KVStoreOptions storeOptions;
+    storeOptions.shards = 4;
+    {
+        KVStore store(storeOptions);
+        ASSERT_TRUE(store.openLog(kWalPath, options));
+        std::vector<std::string> keys;
+        std::vector<Value> values;
+        for (int i = 0; i < 50; i++) {
+            keys.push_back("key" + std::to_string(i));
+            values.emplace_back("v" + std::to_string(i));
+        }
+        EXPECT_EQ(store.multiPut(keys, values), 50u);
+        EXPECT_EQ(store.multiDel({"key1", "key2", "missing"}), 2u);
+    }
+    // 只记录生效的写：50 条 PUT + 2 条 DEL
+    EXPECT_EQ(replayAll().size(), 52u);
+
+    KVStore store;
+    ASSERT_TRUE(store.openLog(kWalPath, options));
+    EXPECT_EQ(store.size(), 48);
+    std::string value;
+    EXPECT_FALSE(store.get("key1", value));
+    EXPECT_TRUE(store.get("key49", value));
+    EXPECT_EQ(value, "v49");
+}
+
+TEST_F(WalTest, ExpiryReplays) {
+    WalOptions options;
+    options.syncPolicy = WalSyncPolicy::kNever;
+    const int64_t now = KVStore::nowMs();
+    {
+        KVStore store;
+        ASSERT_TRUE(store.openLog(kWalPath, options));
+        store.put("ttl", Value("v").withExpiry(now + 60000));
+        store.put("a", "1");
+        store.expire("a", now + 30000);
+        store.put("b", "2");
+        store.expire("b", now - 1);          // 已经过期，相当于删除
+        store.put("c", Value("3").withExpiry(now - 1));
+        store.expire("c", now + 30000);      // 对已经过期的 key 无效
+    }
+
+    std::vector<WalRecord> records = replayAll();
+    ASSERT_GE(records.size(), 4u);
+    EXPECT_EQ(records[0].type, WalRecordType::kPutExpire);
+    EXPECT_EQ(records[0].expireAt, now + 60000);
+    EXPECT_EQ(records[0].value, "v");
+    EXPECT_EQ(records[2].type, WalRecordType::kExpire);
+    EXPECT_EQ(records[2].key, "a");
+    EXPECT_EQ(records[2].expireAt, now + 30000);
+
+    KVStore store;
+    ASSERT_TRUE(store.openLog(kWalPath, options));
+    EXPECT_EQ(store.expireAt("ttl"), now + 60000);
+    EXPECT_EQ(store.expireAt("a"), now + 30000);
+    EXPECT_FALSE(store.exists("b"));
+    EXPECT_FALSE(store.exists("c"));
+}
+
+TEST_F(WalTest, ClearShardReplaysWithDifferentShardCount) {
+    KVStoreOptions fourShards;
+    fourShards.shards = 4;
+    {
+        KVStore store(fourShards);
+        ASSERT_TRUE(store.openLog(kWalPath, WalOptions()));
+        for (int i = 0; i < 100; i++) {
+            store.put("key" + std::to_string(i), "v");
+        }
+        store.clearShard(1);
+    }
+    int expected = 0;
+    {
+        KVStore store(fourShards);
+        ASSERT_TRUE(store.openLog(kWalPath, WalOptions()));
+        expected = store.size();
+        EXPECT_EQ(store.shardSize(1), 0);
+    }
+    EXPECT_GT(expected, 0);
+    EXPECT_LT(expected, 100);
+
+    // 用一个分片重放，结果相同
+    KVStore store;
+    ASSERT_TRUE(store.openLog(kWalPath, WalOptions()));
+    EXPECT_EQ(store.size(), expected);
+}